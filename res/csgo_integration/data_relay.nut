@@ -11,115 +11,235 @@
 // CAUTION: Printed messages and some variable names are referenced by
 //          DZSimulator code, keep it with this script compatible!
 
-// Prefix explanation: DZSDR1 <--> Danger Zone Simulator Data Relay Version 1
+// Prefix explanation: DZSDR2 <--> Danger Zone Simulator Data Relay Version 2
 // If you make compatibility-breaking changes to this script, make
 // sure to increase the version number in all function, variable,
 // entity and printed data marker names!
 // This way, different versions of this script running simultaneously
 // don't interfere.
 
-// Purpose of this script: Every game tick, print game data to the console that
-// can then be read by DZSimulator.
+// Purpose of this script: Every game tick, collect game data that is printed
+// to the console and can then be read by DZSimulator.
+
+// ---- Output format ----
+// Data of one or more consecutive ticks is printed in one line:
+//
+//   dzsdr2 <tick> <tick> ...
+//
+// Each <tick> is a list of comma-separated items without spaces:
+//
+//   <seq>,<k|d>[,<group>]...
+//
+// <seq> counts ticks from 0 to 65535, then starts at 0 again. 'k' marks a
+// keyframe: Its data doesn't depend on previous ticks. 'd' marks a delta
+// tick: Its data only describes changes from the previous tick. A group is one
+// of the following:
+//
+//   p,<fx>,<fy>,<fz>,<ez>,<c>,<vx>,<vy>,<vz>  Player state
+//   d,<fx>,<fy>,<fz>,<ez>,<c>,<vx>,<vy>,<vz>  Player state minus the previous one
+//   n                                         There is no player
+//   b,<id>,<x>,<y>,<z>,<pitch>,<yaw>,<roll>   Bump mine state
+//   r,<id>                                    Bump mine was removed
+//   a,<count>,<id>,<id>,...                   IDs of all bump mines (keyframes only)
+//
+// f: feet position, ez: eye position's z, c: 1 if crouched, else 0,
+// v: velocity. All values are integers: Positions and velocities in 1/32
+// units (like CSGO's networked origins), angles in 1/100 degrees.
+// Delta ticks don't repeat unchanged data. Player state is unchanged if the
+// tick has no player group, bump mines are unchanged if they have no 'b' or
+// 'r' group. A keyframe has a 'p' or 'n' group and an 'a' group, but not
+// necessarily a 'b' group for every bump mine, some might come in later ticks.
+
+// Keyframe interval in ticks, receivers can resume after missing data once they
+// get a keyframe
+DZSDR2_KEYFRAME_INTERVAL <- 32
+// How many ticks are printed together. More ticks per print use less console
+// bandwidth, but delay data delivery.
+DZSDR2_TICKS_PER_PRINT <- 2
+// print() can only print ~2000 chars, bump mines that don't fit into a print
+// are sent in one of the next ticks
+DZSDR2_MAX_PRINT_LEN <- 1800
+
+// Rounds to the nearest integer, halfway cases away from zero
+function dzsdr2_round(v) {
+    return (v < 0 ? v - 0.5 : v + 0.5).tointeger()
+}
+
+function dzsdr2_vec_data(v, scale) {
+    return "," + dzsdr2_round(v.x * scale) + "," + dzsdr2_round(v.y * scale) +
+           "," + dzsdr2_round(v.z * scale)
+}
 
-function dzsdr1_get_player() { // human player, no bot
-    { DZSDR1_X = null }
-    while(DZSDR1_X = Entities.FindByClassname(DZSDR1_X, "player")) {
+function dzsdr2_get_player() { // human player, no bot
+    { DZSDR2_X = null }
+    while(DZSDR2_X = Entities.FindByClassname(DZSDR2_X, "player")) {
         // If player is in T or CT team
-        if(DZSDR1_X.GetTeam() == 2 || DZSDR1_X.GetTeam() == 3) {
-            return DZSDR1_X
+        if(DZSDR2_X.GetTeam() == 2 || DZSDR2_X.GetTeam() == 3) {
+            return DZSDR2_X
         }
     }
     return null
 }
 
-function dzsdr1_check_loop_end() {
+function dzsdr2_check_loop_end() {
     // Delete timer and stop loop if we haven't seen a keep-alive signal recently.
     // A keep-alive signal can be sent from the outside like this:
-    //   script DZSDR1_KEEP_ALIVE_UNTIL <- Time() + 5.0
-    if(Time() > DZSDR1_KEEP_ALIVE_UNTIL) {
-        if(DZSDR1_TIMER && DZSDR1_TIMER.IsValid()) {
-            DZSDR1_TIMER.Destroy()
+    //   script DZSDR2_KEEP_ALIVE_UNTIL <- Time() + 5.0
+    if(Time() > DZSDR2_KEEP_ALIVE_UNTIL) {
+        if(DZSDR2_TIMER && DZSDR2_TIMER.IsValid()) {
+            DZSDR2_TIMER.Destroy()
         }
     }
 }
 
-function dzsdr1_loop_tick()
-{
-    local tick_data_msg = ""
-    tick_data_msg += "dzs-dr-v1-tick-start " + DZSDR1_TICK_CNT + "\n"
-    
-    DZSDR1_PLAYER = dzsdr1_get_player()
-    if(DZSDR1_PLAYER)
-    {
-        local feet_pos = DZSDR1_PLAYER.GetOrigin()
-        local eye_pos = DZSDR1_PLAYER.EyePosition()
-        local vel = DZSDR1_PLAYER.GetVelocity()
-
-        tick_data_msg += "player "
-        tick_data_msg += feet_pos.x + " " + feet_pos.y + " " + feet_pos.z + " "
-        tick_data_msg += (eye_pos.z + 0.062561) + " " // eye_pos X and Y is the same as X and Y of feet_pos, don't need to send them again
-        tick_data_msg += (DZSDR1_PLAYER.GetBoundingMaxs().z < 72) + " " // is crouching
-        tick_data_msg += vel.x + " " + vel.y + " " + vel.z + "\n"
+function dzsdr2_player_data(is_keyframe) {
+    local p = dzsdr2_get_player()
+    if(!p) {
+        local had_player = DZSDR2_PREV_PLAYER != null
+        DZSDR2_PREV_PLAYER = null
+        return is_keyframe || had_player ? ",n" : ""
     }
 
-    DZSDR1_CNT = 0
-    DZSDR1_X = null
-    // print() can only print ~2000 chars, limit the message's max length using a bump mine limit
-    while(DZSDR1_CNT < 21 && (DZSDR1_X = Entities.FindByClassname(DZSDR1_X, "bumpmine_projectile"))) {
-        local origin = DZSDR1_X.GetOrigin()
-        local angles = DZSDR1_X.GetAngles()
-        tick_data_msg += "bm " + DZSDR1_X.entindex() + " "
-        tick_data_msg += origin.x + " " + origin.y + " " + origin.z + " "
-        tick_data_msg += angles.x + " " + angles.y + " " + angles.z + "\n"
-        DZSDR1_CNT += 1
+    local feet_pos = p.GetOrigin()
+    local vel = p.GetVelocity()
+    local cur = [
+        dzsdr2_round(feet_pos.x * 32), dzsdr2_round(feet_pos.y * 32),
+        dzsdr2_round(feet_pos.z * 32),
+        // eye_pos X and Y is the same as X and Y of feet_pos, don't need to send them again
+        dzsdr2_round((p.EyePosition().z + 0.062561) * 32),
+        p.GetBoundingMaxs().z < 72 ? 1 : 0, // is crouching
+        dzsdr2_round(vel.x * 32), dzsdr2_round(vel.y * 32),
+        dzsdr2_round(vel.z * 32)
+    ]
+    local prev = DZSDR2_PREV_PLAYER
+    DZSDR2_PREV_PLAYER = cur
+
+    local msg = ""
+    if(is_keyframe || prev == null) {
+        msg = ",p"
+        foreach(v in cur)
+            msg += "," + v
+        return msg
     }
-    tick_data_msg += "dzs-dr-v1-tick-end\n"
 
-    
-    print(tick_data_msg) // Server-side tick data
+    local changed = false
+    msg = ",d"
+    for(local i = 0; i < cur.len(); i += 1) {
+        msg += "," + (cur[i] - prev[i])
+        changed = changed || cur[i] != prev[i]
+    }
+    return changed ? msg : ""
+}
+
+function dzsdr2_bm_data(is_keyframe) {
+    local msg = ""
+    // Bump mine records that the receiver has, after this tick
+    local sent = {}
+
+    if(is_keyframe) {
+        // Receivers drop all bump mines that aren't listed here
+        local ids = ""
+        local cnt = 0
+        DZSDR2_X = null
+        while(DZSDR2_X = Entities.FindByClassname(DZSDR2_X, "bumpmine_projectile")) {
+            ids += "," + DZSDR2_X.entindex()
+            cnt += 1
+        }
+        msg += ",a," + cnt + ids
+        DZSDR2_SENT_BMS = {} // Resend every bump mine
+    }
+
+    DZSDR2_X = null
+    while(DZSDR2_X = Entities.FindByClassname(DZSDR2_X, "bumpmine_projectile")) {
+        local id = DZSDR2_X.entindex()
+        local rec = "," + id + dzsdr2_vec_data(DZSDR2_X.GetOrigin(), 32) +
+                    dzsdr2_vec_data(DZSDR2_X.GetAngles(), 100)
+        local prev_rec = id in DZSDR2_SENT_BMS ? DZSDR2_SENT_BMS[id] : null
+        if(rec != prev_rec &&
+           DZSDR2_MSG.len() + msg.len() + rec.len() < DZSDR2_MAX_PRINT_LEN) {
+            msg += ",b" + rec
+            sent[id] <- rec
+        }
+        else if(prev_rec != null) {
+            sent[id] <- prev_rec // Unchanged, or sent in one of the next ticks
+        }
+    }
+
+    // Report removed bump mines
+    foreach(id, rec in DZSDR2_SENT_BMS)
+        if(!(id in sent))
+            msg += ",r," + id
+
+    DZSDR2_SENT_BMS = sent
+    return msg
+}
+
+function dzsdr2_loop_tick()
+{
+    local is_keyframe = DZSDR2_SEQ % DZSDR2_KEYFRAME_INTERVAL == 0
+
+    local tick_data = " " + DZSDR2_SEQ + (is_keyframe ? ",k" : ",d")
+    tick_data += dzsdr2_player_data(is_keyframe)
+    tick_data += dzsdr2_bm_data(is_keyframe)
+
+    DZSDR2_MSG += tick_data
+    DZSDR2_TICKS_IN_MSG += 1
+    if(DZSDR2_TICKS_IN_MSG >= DZSDR2_TICKS_PER_PRINT ||
+       DZSDR2_MSG.len() > DZSDR2_MAX_PRINT_LEN / 2) {
+        print("dzsdr2" + DZSDR2_MSG + "\n") // Server-side tick data
+        DZSDR2_MSG = ""
+        DZSDR2_TICKS_IN_MSG = 0
+    }
 
     // 'getpos' prints client-side view angles and eye position.
-    // It's cheat-protected, ensure cheats are on with 'sv_cheats 1'.
+    // It's cheat-protected, ensure cheats are on with 'sv_cheats 1' once in a
+    // while.
     // Send 'echo' before to ensure getpos's response is on its own line.
-    SendToConsole("echo;sv_cheats 1;getpos;")
+    if(DZSDR2_SEQ % 64 == 0)
+        SendToConsole("echo;sv_cheats 1;getpos;")
+    else
+        SendToConsole("echo;getpos;")
 
-    DZSDR1_TICK_CNT = (DZSDR1_TICK_CNT + 1) % 100
+    DZSDR2_SEQ = (DZSDR2_SEQ + 1) % 65536
 
-    dzsdr1_check_loop_end()
+    dzsdr2_check_loop_end()
 }
 
-function dzsdr1_start()
+function dzsdr2_start()
 {
-    const DZSDR1_TIMER_NAME = "dzsdr1_timer"
-    DZSDR1_TICK_CNT <- 0
-    DZSDR1_KEEP_ALIVE_UNTIL <- Time() + 10.0
+    const DZSDR2_TIMER_NAME = "dzsdr2_timer"
+    DZSDR2_SEQ <- 0
+    DZSDR2_KEEP_ALIVE_UNTIL <- Time() + 10.0
+
+    DZSDR2_MSG <- ""
+    DZSDR2_TICKS_IN_MSG <- 0
+    DZSDR2_PREV_PLAYER <- null
+    DZSDR2_SENT_BMS <- {}
 
     // Replacement for 'local' variables (.cfg version can't use 'local') 
-    DZSDR1_X <- null
-    DZSDR1_PLAYER <- null
-    DZSDR1_CNT <- 0
+    DZSDR2_X <- null
 
     // Delete previously existing entities with the same name
-    DZSDR1_X = null
-    while(DZSDR1_X = Entities.FindByName(DZSDR1_X, DZSDR1_TIMER_NAME)) {
-        DZSDR1_X.Destroy()
+    DZSDR2_X = null
+    while(DZSDR2_X = Entities.FindByName(DZSDR2_X, DZSDR2_TIMER_NAME)) {
+        DZSDR2_X.Destroy()
     }
     
     // Create a new timer
-    DZSDR1_TIMER <- Entities.CreateByClassname( "logic_timer" )
-    DZSDR1_TIMER.ConnectOutput( "OnTimer", "OnTimer" )
+    DZSDR2_TIMER <- Entities.CreateByClassname( "logic_timer" )
+    DZSDR2_TIMER.ConnectOutput( "OnTimer", "OnTimer" )
 
     // This is a hack that turns our logic_timer into a preserved entity,
     // causing it to NOT get reset/destroyed during a round reset!
-    DZSDR1_TIMER.__KeyValueFromString("classname", "info_target")
+    DZSDR2_TIMER.__KeyValueFromString("classname", "info_target")
 
-    DZSDR1_TIMER.__KeyValueFromString( "targetname", DZSDR1_TIMER_NAME )
-    DZSDR1_TIMER.__KeyValueFromFloat( "refiretime", 0.0 ) // Fire timer every tick
+    DZSDR2_TIMER.__KeyValueFromString( "targetname", DZSDR2_TIMER_NAME )
+    DZSDR2_TIMER.__KeyValueFromFloat( "refiretime", 0.0 ) // Fire timer every tick
 
-    DZSDR1_TIMER.ValidateScriptScope()
-    DZSDR1_TIMER.GetScriptScope().OnTimer <- dzsdr1_loop_tick
+    DZSDR2_TIMER.ValidateScriptScope()
+    DZSDR2_TIMER.GetScriptScope().OnTimer <- dzsdr2_loop_tick
     
-    EntFireByHandle( DZSDR1_TIMER, "Enable", "", 0.0, null, null )
+    EntFireByHandle( DZSDR2_TIMER, "Enable", "", 0.0, null, null )
 }
 
-dzsdr1_start()
+dzsdr2_start()
@@ -28,6 +28,24 @@ uniform highp float min_no_ground_checks_vel_z;
 uniform highp float max_vel; // sv_maxvelocity
 uniform highp float standable_normal; // sv_standable_normal
 
+// Vertex attribute decoding, see src/ren/CompactVertexFormat.h
+// Identity transformation for meshes with float positions.
+uniform highp vec3 position_decode_offset;
+uniform highp vec3 position_decode_scale;
+// If true, only the normal's first 2 components are given, encoded
+// octahedrally
+uniform bool octahedral_normals;
+
+
+// NOTE: The CPU implementation in src/ren/CompactVertexFormat.cpp must be kept
+//       in sync with this function!
+vec3 DecodeOctahedralNormal(in vec2 e) {
+    vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
 // Returns brightness value between 0 and 1 from diffuse lighting
 float CalcDiffuseLight(in vec3 surface_normal) {
@@ -63,6 +81,8 @@ void UseVertexColor(in vec4 col, in vec3 surface_normal) {
         interpolated_color = col;
 }
 
+// NOTE: The CPU implementation in src/sim/Glidability.cpp must be kept in sync
+//       with this function!
 // csgo_vert_pos and csgo_vert_normal must describe a vertex in CSGO coordinate
 // space, i.e. how the triangle's face is positioned and oriented just like in
 // CSGO.
@@ -148,6 +168,12 @@ void CalcVertexColor(in vec4 csgo_vert_pos, in vec3 csgo_vert_normal) {
 }
 
 void main() {
+    // Decode vertex attributes
+    vec4 model_position =
+        vec4(position_decode_offset + position_decode_scale * position.xyz, 1.0);
+    vec3 model_normal = octahedral_normals ?
+        DecodeOctahedralNormal(normal.xy) : normal;
+
     // Determine world position and normal of current vertex
 
 #ifdef INSTANCED_TRANSFORMATION
@@ -155,17 +181,17 @@ void main() {
     // @Optimization Perform 3x3 mult and then translation here instead?
     // @Optimization Perform scaling, quaternion rotation and then translation
     //               here instead?
-    vec4 csgo_vert_position = instanced_model_transformation * position;
+    vec4 csgo_vert_position = instanced_model_transformation * model_position;
 
     // Transform normal using the instance's model transformation. We assume
     // that the model transformation has a uniform scaling (X,Y and Z scalings
     // are identical). This method is incorrect for non-uniform transformations.
     // @Optimization Perform 3x3 mult or quaternion rotation here instead?
     vec3 csgo_vert_normal =
-        normalize((instanced_model_transformation * vec4(normal, 0.0)).xyz);
+        normalize((instanced_model_transformation * vec4(model_normal, 0.0)).xyz);
 #else
-    vec4 csgo_vert_position = position;
-    vec3 csgo_vert_normal   = normal;
+    vec4 csgo_vert_position = model_position;
+    vec3 csgo_vert_normal   = model_normal;
 #endif
 
     // Apply view and projection transformation
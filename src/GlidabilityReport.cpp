@@ -0,0 +1,291 @@
+#include "GlidabilityReport.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <span>
+#include <thread>
+
+#include <Tracy.hpp>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+
+#include <json.hpp>
+
+#include "coll/CollidableWorld_Impl.h"
+#include "csgo_parsing/BrushSeparation.h"
+#include "utils_3d.h"
+#include "WorldCreator.h"
+
+using namespace Magnum;
+using namespace csgo_parsing;
+using json = nlohmann::json;
+
+#define PRINT_PREFIX "[GlidabilityReport]"
+
+// Triangles with a smaller area are skipped, their normal is unreliable
+static const float MIN_TRI_AREA = 0.01f;
+
+// Number of triangles a thread evaluates at a time
+static const size_t TRIS_PER_CHUNK = 4096;
+
+const char* GlidabilityReport::GetSurfaceTypeName(SurfaceType type)
+{
+    switch (type) {
+        case BRUSH:        return "brush";
+        case PLAYERCLIP:   return "playerclip";
+        case DISPLACEMENT: return "displacement";
+        case STATIC_PROP:  return "static_prop";
+        case DYNAMIC_PROP: return "dynamic_prop";
+        default:           return "unknown";
+    }
+}
+
+// Adds a triangle with clockwise vertex winding to the given arrays
+static void AddTri(const Vector3& v1, const Vector3& v2, const Vector3& v3,
+                   GlidabilityReport::SurfaceType type,
+                   std::vector<GlidabilityReport::Surface>& surfaces,
+                   std::vector<Vector3>& normals)
+{
+    float area = 0.5f * Math::cross(v2 - v1, v3 - v1).length();
+    if (!(area >= MIN_TRI_AREA)) // Also catches NaN
+        return;
+    surfaces.push_back({
+        .centroid = (v1 + v2 + v3) / 3.0f,
+        .area     = area,
+        .type     = type,
+        .min_success_speed_idx = GlidabilityReport::NEVER_SLIDABLE,
+        .max_success_speed_idx = GlidabilityReport::NEVER_SLIDABLE,
+    });
+    normals.push_back(utils_3d::CalcNormalCwFront(v1, v2, v3));
+}
+
+// Triangulates convex polygons with clockwise vertex winding
+static void AddFaces(const utils_3d::FaceBuffer& faces,
+                     GlidabilityReport::SurfaceType type,
+                     std::vector<GlidabilityReport::Surface>& surfaces,
+                     std::vector<Vector3>& normals)
+{
+    for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++) {
+        std::span<const Vector3> face = faces.GetFace(face_idx);
+        for (size_t i = 2; i < face.size(); i++)
+            AddTri(face[0], face[i - 1], face[i], type, surfaces, normals);
+    }
+}
+
+static void AddBrushFaces(const BspMap& bsp_map,
+                          BrushSeparation::Category brush_cat,
+                          GlidabilityReport::SurfaceType type,
+                          std::vector<GlidabilityReport::Surface>& surfaces,
+                          std::vector<Vector3>& normals)
+{
+    // Invalid func_brush entities are skipped, WorldCreator reports them
+    utils_3d::FaceBuffer faces;
+    WorldCreator::GetBrushCategoryFaces(bsp_map, brush_cat, &faces);
+    AddFaces(faces, type, surfaces, normals);
+}
+
+static void AddPropTris(const coll::XPropTraceData& xprop_data,
+                        const std::vector<coll::XPropTraceData::Prop>& props,
+                        GlidabilityReport::SurfaceType type,
+                        std::vector<GlidabilityReport::Surface>& surfaces,
+                        std::vector<Vector3>& normals)
+{
+    std::vector<Vector3> world_verts;
+    for (const coll::XPropTraceData::Prop& xprop : props) {
+        float scale = 1.0f / xprop.inv_scale;
+        for (uint32_t i = xprop.first_section;
+             i < xprop.first_section + xprop.num_sections; i++) {
+            const utils_3d::TriMesh& tri_mesh = *xprop_data.sections[i].tri_mesh;
+            world_verts.clear();
+            for (const Vector3& v : tri_mesh.vertices)
+                world_verts.push_back(xprop.origin +
+                    xprop.rotation.transformVectorNormalized(scale * v));
+            for (const utils_3d::TriMesh::Tri& tri : tri_mesh.tris)
+                AddTri(world_verts[tri.verts[0]],
+                       world_verts[tri.verts[1]],
+                       world_verts[tri.verts[2]], type, surfaces, normals);
+        }
+    }
+}
+
+GlidabilityReport GlidabilityReport::Generate(const BspMap& bsp_map,
+                                              const coll::CollidableWorld& c_world,
+                                              const sim::GlidabilityParams& params,
+                                              const Settings& settings)
+{
+    ZoneScoped;
+    auto start_time = std::chrono::steady_clock::now();
+
+    GlidabilityReport report;
+    const std::string& map_path = bsp_map.abs_file_path;
+    report.map_name = map_path.substr(map_path.find_last_of("/\\") + 1);
+    if (report.map_name.ends_with(".bsp"))
+        report.map_name.resize(report.map_name.size() - 4);
+    report.settings = settings;
+    report.params   = params;
+    report.settings.num_speeds = std::clamp<uint32_t>(settings.num_speeds, 1, 255);
+
+    // Gather triangles of all solid surfaces
+    std::vector<Vector3> normals;
+    AddBrushFaces(bsp_map, BrushSeparation::Category::SOLID,      BRUSH,      report.surfaces, normals);
+    AddBrushFaces(bsp_map, BrushSeparation::Category::LADDER,     BRUSH,      report.surfaces, normals);
+    AddBrushFaces(bsp_map, BrushSeparation::Category::PLAYERCLIP, PLAYERCLIP, report.surfaces, normals);
+    utils_3d::FaceBuffer disp_faces;
+    bsp_map.GetDisplacementFaceVertices(&disp_faces);
+    AddFaces(disp_faces, DISPLACEMENT, report.surfaces, normals);
+
+    const auto& xprop_data = c_world.pImpl->xprop_trace_data;
+    assert(xprop_data && "CollidableWorld wasn't fully initialized!");
+    if (xprop_data) {
+        AddPropTris(*xprop_data, xprop_data->sprops, STATIC_PROP,  report.surfaces, normals);
+        AddPropTris(*xprop_data, xprop_data->dprops, DYNAMIC_PROP, report.surfaces, normals);
+    }
+
+    // Evaluate triangles in chunks, each thread bakes a table of one chunk at
+    // a time and only keeps the range of successful speeds
+    std::vector<Surface>& surfaces = report.surfaces;
+    size_t num_chunks = (surfaces.size() + TRIS_PER_CHUNK - 1) / TRIS_PER_CHUNK;
+    std::atomic<size_t> next_chunk = 0;
+    auto worker = [&]() {
+        for (size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+            size_t first = c * TRIS_PER_CHUNK;
+            size_t count = std::min(TRIS_PER_CHUNK, surfaces.size() - first);
+            sim::GlidabilityTable table = sim::BakeGlidabilityTable(params,
+                std::span<const Vector3>(normals).subspan(first, count),
+                report.settings.min_speed_hori, report.settings.max_speed_hori,
+                report.settings.num_speeds, report.settings.impact_speed_vert);
+
+            for (uint32_t t = 0; t < count; t++) {
+                Surface& surface = surfaces[first + t];
+                for (uint32_t s = 0; s < table.num_speeds; s++) {
+                    if (table.glidability[table.GetIdx(t, s)] == 0)
+                        continue; // Rampslide fails
+                    if (surface.min_success_speed_idx == NEVER_SLIDABLE)
+                        surface.min_success_speed_idx = s;
+                    surface.max_success_speed_idx = s;
+                }
+            }
+        }
+    };
+#ifdef DZSIM_WEB_PORT
+    worker(); // No threads in the web port
+#else
+    size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(),
+                                            1, std::max<size_t>(num_chunks, 1));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads)
+        t.join();
+#endif
+
+    // Speed grid, identical to the bake's
+    sim::GlidabilityTable grid = sim::BakeGlidabilityTable(params, {},
+        report.settings.min_speed_hori, report.settings.max_speed_hori,
+        report.settings.num_speeds, report.settings.impact_speed_vert);
+    for (uint32_t s = 0; s < grid.num_speeds; s++)
+        report.speeds.push_back(grid.GetSpeed(s));
+
+    // Aggregate stats per surface type. Since slidable speed ranges might
+    // have holes, this is an approximation of the slidable area per speed.
+    for (TypeStats& stats : report.type_stats)
+        stats.slidable_area_per_speed.resize(report.speeds.size(), 0.0);
+    for (const Surface& surface : surfaces) {
+        TypeStats& stats = report.type_stats[surface.type];
+        stats.num_tris++;
+        stats.total_area += surface.area;
+        if (surface.min_success_speed_idx == NEVER_SLIDABLE) {
+            stats.num_never_slidable_tris++;
+            stats.never_slidable_area += surface.area;
+            continue;
+        }
+        for (uint32_t s = surface.min_success_speed_idx;
+             s <= surface.max_success_speed_idx; s++)
+            stats.slidable_area_per_speed[s] += surface.area;
+    }
+
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start_time;
+    report.generation_time_s = duration.count();
+    Corrade::Utility::Debug{} << PRINT_PREFIX << "Evaluated" << surfaces.size()
+        << "triangles of" << report.map_name.c_str() << "in"
+        << report.generation_time_s << "seconds";
+    return report;
+}
+
+bool GlidabilityReport::WriteJsonFile(const std::string& file_path) const
+{
+    json types = json::object();
+    for (size_t i = 0; i < NUM_SURFACE_TYPES; i++) {
+        const TypeStats& stats = type_stats[i];
+        json j = json::object();
+        j["num_tris"]                = stats.num_tris;
+        j["num_never_slidable_tris"] = stats.num_never_slidable_tris;
+        j["total_area"]              = stats.total_area;
+        j["never_slidable_area"]     = stats.never_slidable_area;
+        j["slidable_area_per_speed"] = stats.slidable_area_per_speed;
+        types[GetSurfaceTypeName((SurfaceType)i)] = std::move(j);
+    }
+
+    json root = json::object();
+    root["map"]               = map_name;
+    root["num_surfaces"]      = surfaces.size();
+    root["generation_time_s"] = generation_time_s;
+    root["impact_speed_vert"] = settings.impact_speed_vert;
+    root["speeds"]            = speeds;
+    root["params"] = {
+        { "gravity",                    params.gravity },
+        { "min_no_ground_checks_vel_z", params.min_no_ground_checks_vel_z },
+        { "max_vel",                    params.max_vel },
+        { "standable_normal",           params.standable_normal },
+    };
+    root["surface_types"] = std::move(types);
+
+    std::string contents = root.dump(2);
+    Corrade::Containers::ArrayView<const char> av = { contents.data(), contents.size() };
+    if (!Corrade::Utility::Path::write(file_path, av)) {
+        Corrade::Utility::Error{} << PRINT_PREFIX << "Failed to write file:"
+                                  << file_path.c_str();
+        return false;
+    }
+    return true;
+}
+
+bool GlidabilityReport::WriteBinaryFile(const std::string& file_path) const
+{
+    std::vector<char> contents;
+    auto append = [&contents](const void* data, size_t size) {
+        const char* bytes = (const char*)data;
+        contents.insert(contents.end(), bytes, bytes + size);
+    };
+    auto append_u32 = [&append](uint32_t val) { append(&val, sizeof(val)); };
+
+    contents.reserve(16 + 4 * speeds.size() + 20 * surfaces.size());
+    append("DZGR", 4);
+    append_u32(BINARY_FILE_VERSION);
+    append_u32((uint32_t)speeds.size());
+    append_u32((uint32_t)surfaces.size());
+    append(speeds.data(), speeds.size() * sizeof(float));
+    for (const Surface& surface : surfaces) {
+        float floats[4] = { surface.centroid.x(), surface.centroid.y(),
+                            surface.centroid.z(), surface.area };
+        uint8_t bytes[4] = { surface.type, surface.min_success_speed_idx,
+                             surface.max_success_speed_idx, 0 };
+        append(floats, sizeof(floats));
+        append(bytes,  sizeof(bytes));
+    }
+
+    Corrade::Containers::ArrayView<const char> av = { contents.data(), contents.size() };
+    if (!Corrade::Utility::Path::write(file_path, av)) {
+        Corrade::Utility::Error{} << PRINT_PREFIX << "Failed to write file:"
+                                  << file_path.c_str();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#ifndef GLIDABILITYREPORT_H_
+#define GLIDABILITYREPORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "coll/CollidableWorld.h"
+#include "csgo_parsing/BspMap.h"
+#include "sim/Glidability.h"
+
+// Offline analysis of every solid surface of a map: For each triangle, the
+// range of horizontal speeds at which a rampslide on it succeeds.
+// Meant for batch runs over many maps, e.g. to track changes across versions.
+class GlidabilityReport {
+public:
+    enum SurfaceType : uint8_t {
+        BRUSH = 0,     // Solid and ladder brushes, including func_brush
+        PLAYERCLIP,    // Playerclip brushes, including func_brush
+        DISPLACEMENT,
+        STATIC_PROP,
+        DYNAMIC_PROP,
+        NUM_SURFACE_TYPES
+    };
+    static const char* GetSurfaceTypeName(SurfaceType type);
+
+    struct Settings {
+        float    min_speed_hori = 100.0f;
+        float    max_speed_hori = 3500.0f;
+        uint32_t num_speeds     = 69; // At most 255
+        float    impact_speed_vert = 0.0f; // See sim::BakeGlidabilityTable()
+    };
+
+    // One triangle of a solid surface
+    struct Surface {
+        Magnum::Vector3 centroid;
+        float       area;
+        SurfaceType type;
+        // Lowest and highest speed index at which the rampslide succeeds, or
+        // NEVER_SLIDABLE if it fails at every speed.
+        // Note: Rampslides might fail at some speeds in between.
+        uint8_t     min_success_speed_idx;
+        uint8_t     max_success_speed_idx;
+    };
+    static constexpr uint8_t NEVER_SLIDABLE = UINT8_MAX;
+
+    struct TypeStats {
+        size_t num_tris = 0;
+        size_t num_never_slidable_tris = 0;
+        double total_area = 0.0;
+        double never_slidable_area = 0.0;
+        // Area that is slidable at each speed, same indexing as speeds
+        std::vector<double> slidable_area_per_speed;
+    };
+
+    std::string map_name;
+    Settings    settings;
+    sim::GlidabilityParams params;
+    std::vector<float>   speeds;   // Evaluated horizontal speeds, ascending
+    std::vector<Surface> surfaces;
+    TypeStats   type_stats[NUM_SURFACE_TYPES];
+    double      generation_time_s = 0.0;
+
+    // Evaluates all solid surfaces of the given map. Uses all CPU cores.
+    static GlidabilityReport Generate(const csgo_parsing::BspMap& bsp_map,
+                                      const coll::CollidableWorld& c_world,
+                                      const sim::GlidabilityParams& params,
+                                      const Settings& settings = {});
+
+    // Writes aggregate stats in human-readable JSON form. Per-surface data is
+    // only written to the binary file. Returns false on failure.
+    bool WriteJsonFile(const std::string& file_path) const;
+
+    // Writes a compact binary file containing all surfaces.
+    // Layout (little-endian):
+    //   char[4]  magic "DZGR"
+    //   uint32   version (BINARY_FILE_VERSION)
+    //   uint32   number of speeds N
+    //   uint32   number of surfaces M
+    //   float[N] speeds
+    //   M times: float[3] centroid, float area, uint8 type,
+    //            uint8 min_success_speed_idx, uint8 max_success_speed_idx,
+    //            uint8 padding
+    // Returns false on failure.
+    bool WriteBinaryFile(const std::string& file_path) const;
+    static constexpr uint32_t BINARY_FILE_VERSION = 1;
+};
+
+#endif // GLIDABILITYREPORT_H_
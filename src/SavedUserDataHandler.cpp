@@ -213,6 +213,26 @@ static gui::GuiState ParseUserDataFromCurrentVersion(const json& user_data,
 
     TryParseInt(g.video.IN_user_gui_scaling_factor_pct, GetNestedValue(s, "VideoSettings", "GUI", "size"));
 
+    std::string disp_cache_mode = "";
+    TryParseString(disp_cache_mode, GetNestedValue(s, "Performance", "DisplacementCaches", "mode"));
+    if (disp_cache_mode.compare("lazy") == 0)        g.perf.IN_disp_cache_mode = g.perf.DISP_CACHE_LAZY;
+    if (disp_cache_mode.compare("prebuild") == 0)    g.perf.IN_disp_cache_mode = g.perf.DISP_CACHE_PREBUILD;
+    if (disp_cache_mode.compare("lazy-budget") == 0) g.perf.IN_disp_cache_mode = g.perf.DISP_CACHE_LAZY_BUDGET;
+    TryParseInt(g.perf.IN_disp_cache_budget_kib, GetNestedValue(s, "Performance", "DisplacementCaches", "budget-kib"));
+
+    std::string xprop_bevel_mode = "";
+    TryParseString(xprop_bevel_mode, GetNestedValue(s, "Performance", "PropBevelPlanes", "mode"));
+    if (xprop_bevel_mode.compare("on-demand") == 0)       g.perf.IN_xprop_bevel_mode = g.perf.XPROP_BEVELS_ON_DEMAND;
+    if (xprop_bevel_mode.compare("near-spawns") == 0)     g.perf.IN_xprop_bevel_mode = g.perf.XPROP_BEVELS_NEAR_SPAWNS;
+    if (xprop_bevel_mode.compare("precompute-all") == 0)  g.perf.IN_xprop_bevel_mode = g.perf.XPROP_BEVELS_PRECOMPUTE_ALL;
+
+    TryParseInt (g.perf.IN_coll_model_cache_budget_mib, GetNestedValue(s, "Performance", "CollisionModelCache", "budget-mib"));
+#ifndef DZSIM_WEB_PORT
+    TryParseBool(g.perf.IN_coll_model_disk_cache,       GetNestedValue(s, "Performance", "CollisionModelCache", "save-to-disk"));
+#endif
+
+    TryParseBool(g.perf.IN_compact_world_vertices, GetNestedValue(s, "Performance", "WorldVertices", "compact"));
+
     return g;
 }
 
@@ -318,6 +338,29 @@ static json ConvertUserSettingsToUserDataJson(const gui::GuiState& gui_state) {
 
     video_settings["GUI"]["size"] = gui_state.video.IN_user_gui_scaling_factor_pct;
 
+    json& disp_caches = settings["Performance"]["DisplacementCaches"];
+    switch (gui_state.perf.IN_disp_cache_mode) {
+        case gui::GuiState::Performance::DISP_CACHE_LAZY:        disp_caches["mode"] = "lazy";        break;
+        case gui::GuiState::Performance::DISP_CACHE_PREBUILD:    disp_caches["mode"] = "prebuild";    break;
+        case gui::GuiState::Performance::DISP_CACHE_LAZY_BUDGET: disp_caches["mode"] = "lazy-budget"; break;
+    }
+    disp_caches["budget-kib"] = gui_state.perf.IN_disp_cache_budget_kib;
+
+    json& xprop_bevels = settings["Performance"]["PropBevelPlanes"];
+    switch (gui_state.perf.IN_xprop_bevel_mode) {
+        case gui::GuiState::Performance::XPROP_BEVELS_ON_DEMAND:      xprop_bevels["mode"] = "on-demand";      break;
+        case gui::GuiState::Performance::XPROP_BEVELS_NEAR_SPAWNS:    xprop_bevels["mode"] = "near-spawns";    break;
+        case gui::GuiState::Performance::XPROP_BEVELS_PRECOMPUTE_ALL: xprop_bevels["mode"] = "precompute-all"; break;
+    }
+
+    json& coll_model_cache = settings["Performance"]["CollisionModelCache"];
+    coll_model_cache["budget-mib"] = gui_state.perf.IN_coll_model_cache_budget_mib;
+#ifndef DZSIM_WEB_PORT
+    coll_model_cache["save-to-disk"] = gui_state.perf.IN_coll_model_disk_cache;
+#endif
+
+    settings["Performance"]["WorldVertices"]["compact"] = gui_state.perf.IN_compact_world_vertices;
+
     return user_data;
 }
 
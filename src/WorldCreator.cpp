@@ -1,11 +1,16 @@
 #include "WorldCreator.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <utility>
 #include <map>
 #include <memory>
 #include <set>
+#include <span>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <Tracy.hpp>
@@ -20,6 +25,7 @@
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Matrix4.h>
+#include <Magnum/Mesh.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/MeshTools/Transform.h>
 #include <Magnum/Primitives/Cylinder.h>
@@ -28,12 +34,16 @@
 
 #include "coll/CollidableWorld.h"
 #include "coll/CollidableWorld_Impl.h"
+#include "coll/CollisionModelCache.h"
+#include "coll/HiddenGeometry.h"
 #include "csgo_parsing/AssetFileReader.h"
 #include "csgo_parsing/AssetFinder.h"
 #include "csgo_parsing/BspMap.h"
 #include "csgo_parsing/PhyModelParsing.h"
 #include "csgo_parsing/utils.h"
+#include "ren/CompactVertexFormat.h"
 #include "ren/GlidabilityShader3D.h"
+#include "ren/MeshSimplification.h"
 #include "ren/RenderableWorld.h"
 #include "utils_3d.h"
 
@@ -50,16 +60,17 @@ using namespace utils_3d;
 // From given faces (with clockwise vertex winding), create a GL::Mesh
 // with vertex buffer with attributes:
 //   - Vertex Position ( Magnum::Shaders::GenericGL3D::Position )
-static GL::Mesh GenMeshWithVertAttr_Position(
-    const std::vector<std::vector<Vector3>>& faces)
+static GL::Mesh GenMeshWithVertAttr_Position(const FaceBuffer& faces)
 {
     struct Vert {
         Vector3 position;
     };
     std::vector<Vert> data_vertbuf;
+    data_vertbuf.reserve(3 * faces.NumTris());
 
     // Turn faces into triangles
-    for (const std::vector<Vector3>& face : faces) {
+    for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++) {
+        std::span<const Vector3> face = faces.GetFace(face_idx);
         for (size_t tri = 0; tri < face.size() - 2; tri++) {
             data_vertbuf.push_back({ face[0]       });
             data_vertbuf.push_back({ face[tri + 1] });
@@ -77,18 +88,16 @@ static GL::Mesh GenMeshWithVertAttr_Position(
 }
 
 // An element of a vertex buffer with a position and a normal attribute
-struct VertBufElem_Pos_Nor {
-    Vector3 position;
-    Vector3 normal;
-};
+using VertBufElem_Pos_Nor = FlatIndexedMesh::Vertex;
 
 // Helper function
 static void _AddFacesToVertBuf_Position_Normal(
-    const std::vector<std::vector<Vector3>>& faces,
+    const FaceBuffer& faces,
     std::vector<VertBufElem_Pos_Nor>& vert_buf)
 {
     // Turn faces into triangles
-    for (const std::vector<Vector3>& face : faces) {
+    for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++) {
+        std::span<const Vector3> face = faces.GetFace(face_idx);
         for (size_t tri = 0; tri < face.size() - 2; tri++) {
             // Individual normal calculation seems to be required, although
             // triangles *should* all face in the same direction?
@@ -123,45 +132,336 @@ static void _AddFacesToVertBuf_Position_Normal(
     }
 }
 
-// Helper function
-static GL::Mesh _CreateMeshFromVertBuf_Position_Normal(
-    std::vector<VertBufElem_Pos_Nor> vert_buf)
+// Helper function. Adds a vertex buffer with the given vertices to a new mesh.
+// If compact_vertices is true, the vertices are stored in the compact vertex
+// format (see ren/CompactVertexFormat.h). The vertex count is not set.
+static WorldMesh _CreateMeshFromVertBuf_Position_Normal(
+    const std::vector<VertBufElem_Pos_Nor>& vert_buf,
+    bool compact_vertices)
 {
-    // @Optimization Is there an unnecessary copy here?
+    using Position = Shaders::GenericGL3D::Position;
+    using Normal   = Shaders::GenericGL3D::Normal;
+
+    WorldMesh world_mesh;
+    world_mesh.mesh = GL::Mesh{};
+    world_mesh.num_vertices = vert_buf.size();
+
     GL::Buffer vertices{ GL::Buffer::TargetHint::Array };
-    vertices.setData(vert_buf);
-    GL::Mesh mesh;
-    mesh.setCount(vertices.size() / sizeof(VertBufElem_Pos_Nor))
-        .addVertexBuffer(std::move(vertices), 0,
-            Shaders::GenericGL3D::Position{},
-            Shaders::GenericGL3D::Normal{});
-    return mesh;
+    if (compact_vertices) {
+        CompactVertexBuffer compact = EncodeCompactVertices(vert_buf);
+        vertices.setData(compact.vertices);
+        world_mesh.decoding = compact.decoding;
+        world_mesh.vertex_buffer_bytes =
+            compact.vertices.size() * sizeof(CompactVertex);
+        world_mesh.mesh.addVertexBuffer(std::move(vertices), 0,
+            Position{ Position::Components::Three, Position::DataType::Short,
+                      Position::DataOption::Normalized },
+            2, // Skip CompactVertex::padding
+            Normal{ Normal::Components::Two, Normal::DataType::Short,
+                    Normal::DataOption::Normalized });
+    }
+    else {
+        vertices.setData(vert_buf);
+        world_mesh.vertex_buffer_bytes =
+            vert_buf.size() * sizeof(VertBufElem_Pos_Nor);
+        world_mesh.mesh.addVertexBuffer(std::move(vertices), 0,
+            Position{},
+            Normal{});
+    }
+    return world_mesh;
 }
 
 // From given faces (with clockwise vertex winding), create a GL::Mesh
 // with vertex buffer with attributes:
 //   - Vertex Position ( Magnum::Shaders::GenericGL3D::Position )
 //   - Vertex Normal   ( Magnum::Shaders::GenericGL3D::Normal   )
-static GL::Mesh GenMeshWithVertAttr_Position_Normal(
-    const std::vector<std::vector<Vector3>>& faces)
+// See _CreateMeshFromVertBuf_Position_Normal() regarding compact_vertices.
+static WorldMesh GenMeshWithVertAttr_Position_Normal(const FaceBuffer& faces,
+                                                     bool compact_vertices)
 {
-    // @Optimization Reserve correct amount of elements for data_vertbuf
     std::vector<VertBufElem_Pos_Nor> data_vertbuf;
+    data_vertbuf.reserve(3 * faces.NumTris());
 
     _AddFacesToVertBuf_Position_Normal(faces, data_vertbuf);
-    return _CreateMeshFromVertBuf_Position_Normal(data_vertbuf);
+    WorldMesh world_mesh =
+        _CreateMeshFromVertBuf_Position_Normal(data_vertbuf, compact_vertices);
+    world_mesh.mesh.setCount(data_vertbuf.size());
+    return world_mesh;
 }
 
 // Same as above, but collects all faces from a list of TriMesh objects.
-static GL::Mesh GenMeshWithVertAttr_Position_Normal(
-    const std::vector<TriMesh>& lists_of_tri_meshes)
+// If given, TriMesh objects whose is_excluded value is true are skipped.
+static WorldMesh GenMeshWithVertAttr_Position_Normal(
+    const std::vector<TriMesh>& lists_of_tri_meshes,
+    bool compact_vertices,
+    std::span<const uint8_t> is_excluded = {})
 {
-    // @Optimization Reserve correct amount of elements for data_vertbuf
+    assert(is_excluded.empty() || is_excluded.size() == lists_of_tri_meshes.size());
+    auto is_included = [&](size_t i) { return is_excluded.empty() || !is_excluded[i]; };
+
+    size_t num_tris = 0;
+    for (size_t i = 0; i < lists_of_tri_meshes.size(); i++)
+        if (is_included(i))
+            num_tris += lists_of_tri_meshes[i].tris.size();
     std::vector<VertBufElem_Pos_Nor> data_vertbuf;
+    data_vertbuf.reserve(3 * num_tris);
+
+    for (size_t i = 0; i < lists_of_tri_meshes.size(); i++)
+        if (is_included(i))
+            _AddFacesToVertBuf_Position_Normal(lists_of_tri_meshes[i], data_vertbuf);
+    WorldMesh world_mesh =
+        _CreateMeshFromVertBuf_Position_Normal(data_vertbuf, compact_vertices);
+    world_mesh.mesh.setCount(data_vertbuf.size());
+    return world_mesh;
+}
+
+// Same as GenMeshWithVertAttr_Position_Normal(), but simplifies the given
+// convex faces and creates an indexed mesh. Fewer vertices mean less work for
+// the per-vertex glidability shader.
+static WorldMesh GenSimplifiedMeshWithVertAttr_Position_Normal(
+    const FaceBuffer& faces,
+    bool compact_vertices,
+    MeshSimplificationStats* stats = nullptr)
+{
+    FlatIndexedMesh simplified = CreateSimplifiedFlatMesh(faces, stats);
+    WorldMesh world_mesh = _CreateMeshFromVertBuf_Position_Normal(
+        simplified.vertices, compact_vertices);
+
+    GL::Buffer indices{ GL::Buffer::TargetHint::ElementArray };
+    MeshIndexType index_type;
+    if (simplified.vertices.size() <= 65536) {
+        std::vector<uint16_t> indices_16bit(simplified.indices.begin(),
+                                            simplified.indices.end());
+        indices.setData(indices_16bit);
+        index_type = MeshIndexType::UnsignedShort;
+    }
+    else {
+        indices.setData(simplified.indices);
+        index_type = MeshIndexType::UnsignedInt;
+    }
+
+    world_mesh.mesh.setCount(simplified.indices.size())
+        .setIndexBuffer(std::move(indices), 0, index_type);
+    return world_mesh;
+}
+
+// Prints the vertex buffer size of the given mesh and adds it to the world's
+// totals
+static void AddToVertexBufferReport(RenderableWorld& r_world,
+                                    const WorldMesh& world_mesh,
+                                    const char* mesh_name)
+{
+    size_t float_bytes = world_mesh.num_vertices * sizeof(VertBufElem_Pos_Nor);
+    r_world.vertex_buffer_bytes       += world_mesh.vertex_buffer_bytes;
+    r_world.float_vertex_buffer_bytes += float_bytes;
+    if (mesh_name)
+        Debug{} << "  Vertex buffer of" << mesh_name << Debug::nospace << ":"
+            << world_mesh.vertex_buffer_bytes << "bytes (float vertices:"
+            << float_bytes << "bytes)";
+}
+
+
+// ------------------------------------------------------------------------
+// -------------- Internal collision model loading functions --------------
+// ------------------------------------------------------------------------
+
+// A PHY file that gets loaded into the collision model of a prop model
+struct PhyLoadJob {
+    std::string mdl_path;
+    std::string phy_path;
+
+    // If the PHY file is packed inside the BSP file. Otherwise, it's loaded
+    // from the game files.
+    bool is_packed = false;
+    size_t packed_file_offset = 0; // Only used if is_packed is true
+    size_t packed_file_len    = 0; // Only used if is_packed is true
+
+    // Content of the PHY file, read ahead of parsing. Stays empty for packed
+    // PHY files of BSP files in memory, these are parsed from there directly.
+    std::vector<uint8_t> file_content;
+
+    // Results
+    std::string error; // Empty means no error occurred
+    bool is_multi_solid = false; // If skipped because it has multiple solids
+    std::shared_ptr<const CollisionModel> coll_model;
+};
+
+// Reads the content of PHY files from disk. The BSP file is opened only once
+// and its packed PHY files are read in order of their position in it.
+static void ReadPhyFiles(std::vector<PhyLoadJob>& jobs, const BspMap& bsp_map)
+{
+    ZoneScoped;
+
+    std::vector<PhyLoadJob*> packed_jobs;
+    for (PhyLoadJob& job : jobs) {
+        if (job.is_packed) {
+            packed_jobs.push_back(&job);
+            continue;
+        }
+        AssetFileReader phy_file_reader;
+        if (!phy_file_reader.OpenFileFromGameFiles(job.phy_path)) {
+            job.error = "Failed to open PHY file from game files";
+            continue;
+        }
+        job.file_content.resize(phy_file_reader.GetSize());
+        if (!phy_file_reader.ReadByteArray(job.file_content.data(), job.file_content.size()))
+            job.error = "Failed to read PHY file from game files";
+    }
+
+    // Depending on where we parsed the original '.bsp' file from, we need to
+    // read its packed files accordingly.
+    switch (bsp_map.file_origin.type) {
+    case BspMap::FileOrigin::FILE_SYSTEM: {
+        if (packed_jobs.empty())
+            break;
+        auto& abs_bsp_file_path = bsp_map.file_origin.abs_file_path;
+        AssetFileReader bsp_file_reader;
+        if (!bsp_file_reader.OpenFileFromAbsolutePath(abs_bsp_file_path)) {
+            for (PhyLoadJob* job : packed_jobs)
+                job->error = "Failed to open BSP file for parsing a packed PHY "
+                    "file: " + abs_bsp_file_path;
+            break;
+        }
+        // Read sequentially instead of seeking back and forth
+        std::sort(packed_jobs.begin(), packed_jobs.end(),
+            [](const PhyLoadJob* a, const PhyLoadJob* b) {
+                return a->packed_file_offset < b->packed_file_offset;
+            });
+        for (PhyLoadJob* job : packed_jobs) {
+            job->file_content.resize(job->packed_file_len);
+            if (!bsp_file_reader.SetPos(job->packed_file_offset) ||
+                !bsp_file_reader.ReadByteArray(job->file_content.data(),
+                                               job->file_content.size()))
+                job->error = "Failed to read packed PHY file from BSP file: "
+                    + abs_bsp_file_path;
+        }
+        break;
+    }
+    case BspMap::FileOrigin::MEMORY:
+        break; // Packed PHY files are parsed directly from memory
+    default:
+        for (PhyLoadJob* job : packed_jobs)
+            job->error = "Failed to read packed PHY file: Unknown BSP file "
+                "origin: " + std::to_string(bsp_map.file_origin.type);
+        break;
+    }
+}
+
+// From the triangle mesh of each section, get its AABB and create the plane of
+// each triangle
+static CollisionModel CreateCollisionModel(std::vector<TriMesh>&& section_tri_meshes)
+{
+    ZoneScopedN("gen collmodel");
+
+    const size_t NUM_SECTIONS = section_tri_meshes.size();
+    std::vector<std::vector<BspMap::Plane>> section_planes(NUM_SECTIONS);
+    std::vector<CollisionModel::AABB>       section_aabbs (NUM_SECTIONS);
+    for (size_t section_idx = 0; section_idx < NUM_SECTIONS; section_idx++) {
+        const TriMesh& section_tri_mesh = section_tri_meshes[section_idx];
+        const std::vector<Vector3>& section_vertices = section_tri_mesh.vertices;
+        auto& planes_of_section = section_planes[section_idx];
+        planes_of_section.reserve(section_tri_mesh.tris.size());
+
+        Vector3 section_aabb_mins = { +HUGE_VALF, +HUGE_VALF, +HUGE_VALF };
+        Vector3 section_aabb_maxs = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
+        for (const Vector3& vert : section_vertices) {
+            for (int axis = 0; axis < 3; axis++) { // Add vertex to section's AABB
+                section_aabb_mins[axis] = Math::min(section_aabb_mins[axis], vert[axis]);
+                section_aabb_maxs[axis] = Math::max(section_aabb_maxs[axis], vert[axis]);
+            }
+        }
+        section_aabbs[section_idx].mins = section_aabb_mins;
+        section_aabbs[section_idx].maxs = section_aabb_maxs;
+
+        for (const TriMesh::Tri& triangle : section_tri_mesh.tris) {
+            const Vector3& v1 = section_vertices[triangle.verts[0]];
+            const Vector3& v2 = section_vertices[triangle.verts[1]];
+            const Vector3& v3 = section_vertices[triangle.verts[2]];
+            Vector3 plane_normal = CalcNormalCwFront(v1, v2, v3);
+            float   plane_dist = Math::dot(plane_normal, v1);
+            planes_of_section.push_back({
+                .normal = plane_normal,
+                .dist   = plane_dist
+            });
+        }
+    }
+    return CollisionModel {
+        .section_tri_meshes = std::move(section_tri_meshes),
+        .section_planes     = std::move(section_planes),
+        .section_aabbs      = std::move(section_aabbs)
+    };
+}
+
+// Gets the collision model of a job from the collision model cache or, if it
+// isn't cached yet, parses the PHY file and creates it. Can be called from
+// multiple threads at once for different jobs.
+static void ParsePhyLoadJob(PhyLoadJob& job, const BspMap& bsp_map)
+{
+    ZoneScopedN("xprop phy load");
+
+    if (!job.error.empty()) // If reading the file failed
+        return;
+
+    std::span<const uint8_t> phy_file_content = job.file_content;
+    if (job.is_packed && bsp_map.file_origin.type == BspMap::FileOrigin::MEMORY) {
+        auto& bsp_file_mem = bsp_map.file_origin.file_content_mem;
+        if (job.packed_file_offset > bsp_file_mem.size() ||
+            job.packed_file_len > bsp_file_mem.size() - job.packed_file_offset) {
+            job.error = "Packed PHY file exceeds the BSP file in memory";
+            return;
+        }
+        phy_file_content = { bsp_file_mem.data() + job.packed_file_offset,
+                             job.packed_file_len };
+    }
+    if (phy_file_content.empty()) {
+        job.error = "PHY file is empty";
+        return;
+    }
 
-    for (const TriMesh& tri_mesh : lists_of_tri_meshes)
-        _AddFacesToVertBuf_Position_Normal(tri_mesh, data_vertbuf);
-    return _CreateMeshFromVertBuf_Position_Normal(data_vertbuf);
+    // Maps often share PHY files, they might have been parsed already
+    CollisionModelCache::Key cache_key =
+        CollisionModelCache::MakeKey(job.phy_path, phy_file_content);
+    job.coll_model = CollisionModelCache::Find(cache_key);
+    if (job.coll_model) {
+        job.file_content = {}; // Not needed anymore
+        return;
+    }
+
+    AssetFileReader phy_file_reader;
+    phy_file_reader.OpenFileFromMemory(
+        { phy_file_content.data(), phy_file_content.size() }
+    ); // This can't fail because the PHY file content isn't empty
+
+    // A collision model consists of one or more "sections".
+    // A "section" is a triangle mesh that describes a convex shape.
+    std::vector<TriMesh> section_tri_meshes;
+    std::string surface_property;
+    // CSGO loads the phy model even if checksum of MDL and PHY are not identical.
+    // NOTE: If you change the way PHY models are parsed, please see
+    //       whether comments surrounding CollisionModel::section_tri_meshes
+    //       need to be updated! E.g. regarding edge duplicate-freeness guarantees.
+    //       Also change FILE_MAGIC in CollisionModelCache.cpp to invalidate
+    //       collision models that were saved to disk!
+    // NOTE: Static props' phy model always have a single solid.
+    //       Dynamic props' phy model very rarely have multiple solids.
+    auto ret = ParseSingleSolidPhyModel(
+        &section_tri_meshes, &surface_property, phy_file_reader);
+    job.file_content = {}; // Not needed anymore
+
+    // Special case: We treat this error as a non-error because maps
+    // rarely have dynamic props with a phy model with multiple solids.
+    // These are mostly hostage/character models or an animated garage
+    // doors. It's not worth supporting these, so skip without error.
+    if (ret.code == csgo_parsing::utils::RetCode::ERROR_PHY_MULTIPLE_SOLIDS) {
+        job.is_multi_solid = true;
+        return;
+    }
+    if (!ret.successful()) { // If parsing failed for other reasons, get error msg
+        job.error = ret.desc_msg;
+        return;
+    }
+    job.coll_model = CollisionModelCache::Insert(
+        cache_key, CreateCollisionModel(std::move(section_tri_meshes)));
 }
 
 
@@ -184,12 +484,72 @@ GL::Mesh WorldCreator::CreateBumpMineMesh()
     return MeshTools::compile(cylinder_along_z);
 }
 
+void WorldCreator::GetBrushCategoryFaces(const BspMap& bsp_map,
+                                         BrushSeparation::Category brush_cat,
+                                         FaceBuffer* dest,
+                                         std::string* dest_errors)
+{
+    auto testFuncs = BrushSeparation::getBrushCategoryTestFuncs(brush_cat);
+    bsp_map.GetBrushFaceVertices(dest, bsp_map.GetModelBrushIndices_worldspawn(),
+        testFuncs.first, testFuncs.second);
+
+    // Special case: grenadeclip brushes don't work in func_brush entities (for unknown reasons)
+    if (brush_cat == BrushSeparation::Category::GRENADECLIP)
+        return;
+
+    // Look for additional brushes from the current category in func_brush entities
+    for (const BspMap::Ent_func_brush& func_brush : bsp_map.entities_func_brush) {
+        if (!func_brush.IsSolid())
+            continue;
+
+        if (func_brush.model.size() == 0 || func_brush.model[0] != '*') continue;
+        std::string idxStr = func_brush.model.substr(1);
+        int64_t modelIdx = utils::ParseIntFromString(idxStr, -1);
+        if (modelIdx <= 0 || modelIdx >= (int64_t)bsp_map.models.size()) {
+            if (dest_errors)
+                *dest_errors += "Failed to load func_brush at origin=("
+                    + std::to_string((int64_t)func_brush.origin.x()) + ","
+                    + std::to_string((int64_t)func_brush.origin.y()) + ","
+                    + std::to_string((int64_t)func_brush.origin.z()) + "), "
+                    "it has an invalid model idx.\n";
+            continue;
+        }
+
+        // Append func_brush's faces
+        size_t first_new_vert = dest->vertices.size();
+        bsp_map.GetBrushFaceVertices(dest, bsp_map.GetModelBrushIndices(modelIdx),
+            testFuncs.first, testFuncs.second);
+
+        // Rotate and translate every vertex with func_brush's origin and angle
+        bool is_func_brush_rotated =
+            func_brush.angles[0] != 0.0f ||
+            func_brush.angles[1] != 0.0f ||
+            func_brush.angles[2] != 0.0f;
+        // Order of axis rotations is important! First roll, then pitch, then yaw rotation!
+        // @Optimization Use 3x3 rotation matrices here, not 4x4, or quaternions
+        Matrix4 rotTransformation = !is_func_brush_rotated ? Matrix4{} :
+            Matrix4::rotationZ(Deg{ func_brush.angles[1] }) * // (yaw)   rotation around z axis
+            Matrix4::rotationY(Deg{ func_brush.angles[0] }) * // (pitch) rotation around y axis
+            Matrix4::rotationX(Deg{ func_brush.angles[2] });  // (roll)  rotation around x axis
+        for (size_t v_idx = first_new_vert; v_idx < dest->vertices.size(); v_idx++) {
+            Vector3& v = dest->vertices[v_idx];
+            // Rotate vertex if func_brush has a non-zero angle
+            if (is_func_brush_rotated)
+                // Rotate point around origin
+                v = rotTransformation.transformVector(v);
+            // Translate point
+            v += func_brush.origin;
+        }
+    }
+}
+
 std::pair<
     std::shared_ptr<RenderableWorld>,
     std::shared_ptr<CollidableWorld>>
 WorldCreator::InitFromBspMap(
     std::shared_ptr<const BspMap> bsp_map,
-    std::string* dest_errors)
+    std::string* dest_errors,
+    bool compact_vertices)
 {
     ZoneScoped;
 
@@ -201,26 +561,19 @@ WorldCreator::InitFromBspMap(
     // self-contained, not requiring any external files.
     bool use_game_dir_assets = !bsp_map->is_embedded_map;
 
-    {
-        ZoneScopedN("GenDispFaceMesh");
-        Debug{} << "Parsing displacement face mesh";
-        auto displacementFaces = bsp_map->GetDisplacementFaceVertices();
-        r_world->mesh_displacements =
-            GenMeshWithVertAttr_Position_Normal(displacementFaces);
-        //MeshGenerator::GenStaticColoredMeshFromFaces(displacementFaces);
-    } // Destruct face array once it's no longer needed (reduce peak RAM usage)
+    // Face buffer that gets reused for all displacement and brush meshes
+    FaceBuffer faces;
 
-    // Idea: Instead of destructing face array, just .clear() it and reuse it
-    // for displacement boundary faces?
+    // NOTE: The displacement face mesh is created at the very end, after
+    //       geometry hidden inside brushes was found.
 
     { // @Optimization Maybe only load when "Show displacement edges" is ticked
         ZoneScopedN("GenDispBoundaryMesh");
         Debug{} << "Parsing displacement boundary mesh";
-        auto displacementBoundaryFaces =
-            bsp_map->GetDisplacementBoundaryFaceVertices();
+        bsp_map->GetDisplacementBoundaryFaceVertices(&faces);
         r_world->mesh_displacement_boundaries =
-            GenMeshWithVertAttr_Position(displacementBoundaryFaces);
-    } // Destruct face array once it's no longer needed (reduce peak RAM usage)
+            GenMeshWithVertAttr_Position(faces);
+    }
 
     // Init required displacement collision structures
     std::vector<CDispCollTree> hull_disp_coll_trees;
@@ -282,13 +635,9 @@ WorldCreator::InitFromBspMap(
     for (const BspMap::Ent_prop_dynamic& dprop : bsp_map->relevant_dynamic_props)
         solid_xprop_mdl_paths.insert(dprop.model);
 
-    // key:   ".mdl" file path referenced by at least one solid prop (static or dynamic)
-    // value: Corresponding collision model mesh
-    std::map<std::string, GL::Mesh> xprop_coll_meshes;
-
     // Collision models used in at least one solid prop (static or dynamic).
     // Keys are MDL paths, values are collision models.
-    std::map<std::string, CollisionModel> xprop_coll_models;
+    std::map<std::string, std::shared_ptr<const CollisionModel>> xprop_coll_models;
 
     // When loading regular (non-embedded) maps, a requirement to consider a
     // prop as solid is the existence of the MDL file it references.
@@ -299,9 +648,9 @@ WorldCreator::InitFromBspMap(
     // embedded file size.
     bool require_existing_mdl_file = !bsp_map->is_embedded_map;
 
-    // Now attempt to load required collision models
+    // Find the PHY files of required collision models
+    std::vector<PhyLoadJob> phy_load_jobs;
     for (const std::string& mdl_path : solid_xprop_mdl_paths) {
-        ZoneScopedN("xprop phy load");
 
         if (mdl_path.length() < 5) // Ensure valid file path
             continue;
@@ -343,41 +692,13 @@ WorldCreator::InitFromBspMap(
             continue;
         }
 
-        // Open the PHY file at the correct location
-        AssetFileReader phy_file_reader;
-        std::string phy_file_read_err = ""; // empty means no error occurred
-
+        PhyLoadJob job;
+        job.mdl_path = mdl_path;
+        job.phy_path = phy_path;
         if (is_phy_in_packed_files) {
-            // Depending on where we parsed the original '.bsp' file from,
-            // we need to read its packed files accordingly.
-            switch (bsp_map->file_origin.type) {
-            case BspMap::FileOrigin::FILE_SYSTEM: {
-                auto& abs_bsp_file_path = bsp_map->file_origin.abs_file_path;
-                if (!phy_file_reader.OpenFileFromAbsolutePath(abs_bsp_file_path))
-                    phy_file_read_err = "Failed to open BSP file for parsing a "
-                    "packed PHY file: " + abs_bsp_file_path;
-                break;
-            }
-            case BspMap::FileOrigin::MEMORY: {
-                auto& bsp_file_mem = bsp_map->file_origin.file_content_mem;
-                if (!phy_file_reader.OpenFileFromMemory(bsp_file_mem))
-                    phy_file_read_err = "Failed to open BSP file from memory to"
-                    " parse packed PHY file";
-                break;
-            }
-            default:
-                phy_file_read_err = "Failed to read packed PHY file: Unknown "
-                    "BSP file origin: " + std::to_string(bsp_map->file_origin.type);
-                break;
-            }
-
-            // If opening the original bsp file succeeded without errors
-            if (phy_file_read_err.empty()) {
-                bool x = phy_file_reader.OpenSubFileFromCurrentlyOpenedFile(
-                    bsp_map->packed_files[*it_packed_phy_idx].file_offset,
-                    bsp_map->packed_files[*it_packed_phy_idx].file_len
-                ); // This can't fail because phy_file_reader is opened in a file
-            }
+            job.is_packed = true;
+            job.packed_file_offset = bsp_map->packed_files[*it_packed_phy_idx].file_offset;
+            job.packed_file_len    = bsp_map->packed_files[*it_packed_phy_idx].file_len;
         }
         else {
             // Look for PHY file in game directory and VPK archives
@@ -387,144 +708,49 @@ WorldCreator::InitFromBspMap(
             // Prop is non-solid if their model's PHY doesn't exist anywhere
             if (!is_phy_in_game_files)
                 continue; // Not an error, we just skip this non-solid model
-
-            if (!phy_file_reader.OpenFileFromGameFiles(phy_path))
-                phy_file_read_err = "Failed to open PHY file from game files";
-        }
-
-        if (phy_file_read_err.empty()) { // If no error occurred on file open
-            // A collision model consists of one or more "sections".
-            // A "section" is a triangle mesh that describes a convex shape.
-            std::vector<TriMesh> section_tri_meshes;
-            std::string surface_property;
-            // CSGO loads the phy model even if checksum of MDL and PHY are not identical.
-            // NOTE: If you change the way PHY models are parsed, please see
-            //       whether comments surrounding CollisionModel::section_tri_meshes
-            //       need to be updated! E.g. regarding edge duplicate-freeness guarantees.
-            // NOTE: Static props' phy model always have a single solid.
-            //       Dynamic props' phy model very rarely have multiple solids.
-            auto ret = ParseSingleSolidPhyModel(
-                &section_tri_meshes, &surface_property, phy_file_reader);
-
-            // Special case: We treat this error as a non-error because maps
-            // rarely have dynamic props with a phy model with multiple solids.
-            // These are mostly hostage/character models or an animated garage
-            // doors. It's not worth supporting these, so skip without error.
-            if (ret.code == csgo_parsing::utils::RetCode::ERROR_PHY_MULTIPLE_SOLIDS) {
-                Debug{} << "Skipped multi-solid collision model:" << phy_path.c_str();
-                continue; // Not an error
-            }
-
-            if (ret.successful()) {
-                ZoneScopedN("gen phy mesh + collmodel");
-                GL::Mesh phy_mesh = GenMeshWithVertAttr_Position_Normal(section_tri_meshes);
-                xprop_coll_meshes[mdl_path] = std::move(phy_mesh);
-
-                // For each section, get its AABB and create plane of each triangle
-                const size_t NUM_SECTIONS = section_tri_meshes.size();
-                std::vector<std::vector<BspMap::Plane>> section_planes(NUM_SECTIONS);
-                std::vector<CollisionModel::AABB>       section_aabbs (NUM_SECTIONS);
-                for (size_t section_idx = 0; section_idx < NUM_SECTIONS; section_idx++) {
-                    const TriMesh& section_tri_mesh = section_tri_meshes[section_idx];
-                    const std::vector<Vector3>& section_vertices = section_tri_mesh.vertices;
-                    auto& planes_of_section = section_planes[section_idx];
-                    planes_of_section.reserve(section_tri_mesh.tris.size());
-
-                    Vector3 section_aabb_mins = { +HUGE_VALF, +HUGE_VALF, +HUGE_VALF };
-                    Vector3 section_aabb_maxs = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
-                    for (const Vector3& vert : section_vertices) {
-                        for (int axis = 0; axis < 3; axis++) { // Add vertex to section's AABB
-                            section_aabb_mins[axis] = Math::min(section_aabb_mins[axis], vert[axis]);
-                            section_aabb_maxs[axis] = Math::max(section_aabb_maxs[axis], vert[axis]);
-                        }
-                    }
-                    section_aabbs[section_idx].mins = section_aabb_mins;
-                    section_aabbs[section_idx].maxs = section_aabb_maxs;
-
-                    for (const TriMesh::Tri& triangle : section_tri_mesh.tris) {
-                        const Vector3& v1 = section_vertices[triangle.verts[0]];
-                        const Vector3& v2 = section_vertices[triangle.verts[1]];
-                        const Vector3& v3 = section_vertices[triangle.verts[2]];
-                        Vector3 plane_normal = CalcNormalCwFront(v1, v2, v3);
-                        float   plane_dist = Math::dot(plane_normal, v1);
-                        planes_of_section.push_back({
-                            .normal = plane_normal,
-                            .dist   = plane_dist
-                        });
-                    }
-                }
-                // Construct CollisionModel object
-                xprop_coll_models[mdl_path] = CollisionModel {
-                    .section_tri_meshes = std::move(section_tri_meshes),
-                    .section_planes     = std::move(section_planes),
-                    .section_aabbs      = std::move(section_aabbs)
-                };
-            }
-            else { // If parsing failed for other reasons, get error msg
-                phy_file_read_err = ret.desc_msg;
-            }
-        }
-
-        if (!phy_file_read_err.empty()) { // If anything failed
-            error_msgs += "All prop_static/prop_dynamic using the model '"
-                + mdl_path + "' will be missing from the world because loading "
-                "their collision model failed:\n    " + phy_file_read_err + "\n";
         }
+        phy_load_jobs.push_back(std::move(job));
     }
 
-    struct InstanceData {
-        // @Optimization Instead, represent transformation using
-        //               scaling + quaternion + translation or
-        //               3x3 rotationscaling matrix + translation?
-        Matrix4 model_transformation; // model scale, rotation, translation
-        //Color3 color; // other attributes are possible
-    };
-    // key is MDL name, value is list of its xprop's transformation matrices
-    std::map<std::string, std::vector<InstanceData>> xprop_instance_data;
+    // File reads happen on this thread, parsing is spread across threads
+    ReadPhyFiles(phy_load_jobs, *bsp_map);
+    {
+        ZoneScopedN("ParsePhyLoadJobs");
+        // Each thread parses different PHY files
+        std::atomic<size_t> next_idx = 0;
+        auto worker = [&phy_load_jobs, &next_idx, &bsp_map]() {
+            for (size_t i = next_idx++; i < phy_load_jobs.size(); i = next_idx++)
+                ParsePhyLoadJob(phy_load_jobs[i], *bsp_map);
+        };
+#ifdef DZSIM_WEB_PORT
+        worker(); // No threads in the web port
+#else
+        size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(),
+                                                1, std::max<size_t>(phy_load_jobs.size(), 1));
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < num_threads; i++)
+            threads.emplace_back(worker);
+        worker();
+        for (std::thread& t : threads)
+            t.join();
+#endif
+    }
 
-    for (const BspMap::StaticProp& sprop : bsp_map->static_props) {
-        const auto& mdl_path = bsp_map->static_prop_model_dict[sprop.model_idx];
-        if (sprop.IsSolidWithVPhysics()) {
-            // We only care about static props with successfully loaded collision models
-            if (xprop_coll_meshes.contains(mdl_path)) {
-                // Compute static prop's transformation matrix
-                xprop_instance_data[mdl_path].push_back(InstanceData{
-                    CalcModelTransformationMatrix(
-                        sprop.origin, sprop.angles, sprop.uniform_scale)
-                });
-            }
+    // Collect results in the order of MDL paths
+    for (PhyLoadJob& job : phy_load_jobs) {
+        if (job.is_multi_solid) {
+            Debug{} << "Skipped multi-solid collision model:" << job.phy_path.c_str();
+            continue; // Not an error
         }
-    }
-    for (const BspMap::Ent_prop_dynamic& dprop : bsp_map->relevant_dynamic_props) {
-        const auto& mdl_path = dprop.model;
-        // We only care about dynamic props with successfully loaded collision models
-        if (xprop_coll_meshes.contains(mdl_path)) {
-            // Compute dynamic prop's transformation matrix
-            xprop_instance_data[mdl_path].push_back(InstanceData{
-                CalcModelTransformationMatrix(dprop.origin, dprop.angles, 1.0f)
-            });
+        if (job.coll_model) {
+            xprop_coll_models[job.mdl_path] = std::move(job.coll_model);
+            continue;
         }
+        error_msgs += "All prop_static/prop_dynamic using the model '"
+            + job.mdl_path + "' will be missing from the world because loading "
+            "their collision model failed:\n    " + job.error + "\n";
     }
 
-    for (auto& kv : xprop_instance_data) {
-        const std::string& mdl_path = kv.first;
-        std::vector<InstanceData>& instances = kv.second;
-        GL::Mesh& mesh = xprop_coll_meshes[mdl_path];
-
-        mesh.setInstanceCount(instances.size())
-            .addVertexBufferInstanced(
-                GL::Buffer{
-                    GL::Buffer::TargetHint::Array,
-                    std::move(instances)
-                },
-                1,
-                0,
-                GlidabilityShader3D::TransformationMatrix{}
-                //, GlidabilityShader3D::Color3{} // other attributes are possible
-        );
-
-        r_world->instanced_xprop_meshes.emplace_back(std::move(mesh));
-    }
     // Precompute collision caches of each solid prop (static or dynamic).
     // MUST HAPPEN AFTER COLL MODEL CREATION!
     Debug{} << "Creating collision caches of static props";
@@ -541,7 +767,7 @@ WorldCreator::InitFromBspMap(
         auto coll_model_it = xprop_coll_models.find(mdl_path);
         if (coll_model_it == xprop_coll_models.end())
             continue; // No collision model
-        const CollisionModel& cmodel = coll_model_it->second;
+        const CollisionModel& cmodel = *coll_model_it->second;
 
         auto sprop_coll_cache = coll::Create_CollisionCache_StaticProp(sprop, cmodel);
         if (sprop_coll_cache == Corrade::Containers::NullOpt)
@@ -557,7 +783,7 @@ WorldCreator::InitFromBspMap(
         auto coll_model_it = xprop_coll_models.find(dprop.model);
         if (coll_model_it == xprop_coll_models.end())
             continue; // No collision model
-        const CollisionModel& cmodel = coll_model_it->second;
+        const CollisionModel& cmodel = *coll_model_it->second;
 
         auto dprop_coll_cache = coll::Create_CollisionCache_DynamicProp(dprop, cmodel);
         if (dprop_coll_cache == Corrade::Containers::NullOpt)
@@ -569,29 +795,12 @@ WorldCreator::InitFromBspMap(
 
     // ----- BRUSHES
     Debug{} << "Parsing model brush indices";
-    std::vector<std::set<size_t>> bmodel_brush_indices;
+    std::vector<std::vector<uint32_t>> bmodel_brush_indices;
+    bmodel_brush_indices.reserve(bsp_map->models.size());
     for (size_t i = 0; i < bsp_map->models.size(); i++)
-        bmodel_brush_indices.push_back(std::move(bsp_map->GetModelBrushIndices(i)));
+        bmodel_brush_indices.push_back(bsp_map->GetModelBrushIndices(i));
     // bmodel at idx 0 is worldspawn, containing most map geometry
     // all other bmodels are tied to brush entities
-    std::set<size_t>& worldspawn_brush_indices = bmodel_brush_indices[0];
-
-    Debug{} << "Calculating func_brush rotation transformations";
-    // Calculate rotation transformation for every SOLID func_brush entity, whose angles are not { 0, 0, 0 }
-    // @Optimization Use 3x3 rotation matrices here, not 4x4, or quaternions
-    std::map<const BspMap::Ent_func_brush*, Matrix4> func_brush_rot_transformations;
-    for (size_t i = 0; i < bsp_map->entities_func_brush.size(); i++) {
-        auto& func_brush = bsp_map->entities_func_brush[i];
-        if (!func_brush.IsSolid()) continue;
-        if (func_brush.angles[0] == 0.0f && func_brush.angles[1] == 0.0f && func_brush.angles[2] == 0.0f)
-            continue;
-
-        // Order of axis rotations is important! First roll, then pitch, then yaw rotation!
-        func_brush_rot_transformations[&func_brush] =
-            Matrix4::rotationZ(Deg{ func_brush.angles[1] }) * // (yaw)   rotation around z axis
-            Matrix4::rotationY(Deg{ func_brush.angles[0] }) * // (pitch) rotation around y axis
-            Matrix4::rotationX(Deg{ func_brush.angles[2] });  // (roll)  rotation around x axis
-    }
 
     // Keep this list in the same order as the enum declaration, so that a brush
     // category can be identified by index
@@ -609,79 +818,38 @@ WorldCreator::InitFromBspMap(
         ZoneScopedN("parse brush cat");
         Debug{} << "Parsing brush category" << brushCat;
 
-        auto testFuncs = BrushSeparation::getBrushCategoryTestFuncs(brushCat);
-        std::vector<std::vector<Vector3>> faces =
-            bsp_map->GetBrushFaceVertices(worldspawn_brush_indices, testFuncs.first,
-                testFuncs.second);
-
-        // Look for additional brushes from the current category in func_brush entities
-        for (auto& func_brush : bsp_map->entities_func_brush) {
-            if (!func_brush.IsSolid())
-                continue;
-            // Special case: grenadeclip brushes don't work in func_brush entities (for unknown reasons)
-            if (brushCat == BrushSeparation::Category::GRENADECLIP)
-                continue;
-
-            if (func_brush.model.size() == 0 || func_brush.model[0] != '*') continue;
-            std::string idxStr = func_brush.model.substr(1);
-            int64_t modelIdx = utils::ParseIntFromString(idxStr, -1);
-            if (modelIdx <= 0 || modelIdx >= (int64_t)bsp_map->models.size()) {
-                error_msgs += "Failed to load func_brush at origin=("
-                    + std::to_string((int64_t)func_brush.origin.x()) + ","
-                    + std::to_string((int64_t)func_brush.origin.y()) + ","
-                    + std::to_string((int64_t)func_brush.origin.z()) + "), "
-                    "it has an invalid model idx.\n";
-                continue;
-            }
-
-            auto& brush_indices = bmodel_brush_indices[modelIdx];
-            auto faces_from_func_brush = bsp_map->GetBrushFaceVertices(brush_indices,
-                testFuncs.first, testFuncs.second);
-            if (faces_from_func_brush.size() == 0) continue;
-
-            // Rotate and translate every vertex with func_brush's origin and angle
-            bool is_func_brush_rotated =
-                func_brush.angles[0] != 0.0f ||
-                func_brush.angles[1] != 0.0f ||
-                func_brush.angles[2] != 0.0f;
-            Matrix4* rotTransformation = is_func_brush_rotated
-                ? &func_brush_rot_transformations[&func_brush]
-                : nullptr;
-            for (auto& face : faces_from_func_brush) {
-                for (auto& v : face) {
-                    // Rotate vertex if func_brush has a non-zero angle
-                    if (is_func_brush_rotated)
-                        // Rotate point around origin
-                        v = (*rotTransformation).transformVector(v);
-                    // Translate point
-                    v += func_brush.origin;
-                }
-            }
-            // Append new faces
-            faces.insert(faces.end(),
-                std::make_move_iterator(faces_from_func_brush.begin()),
-                std::make_move_iterator(faces_from_func_brush.end()));
-        }
+        faces.Clear();
+        GetBrushCategoryFaces(*bsp_map, brushCat, &faces, &error_msgs);
 
         // Remove all water faces that are not facing upwards. We draw water
         // with transparency, so we dont want water faces other than those
         // representing the water surface
         if (brushCat == BrushSeparation::Category::WATER) {
-            std::vector<std::vector<Vector3>> water_surface_faces;
-            for (auto& face : faces) {
+            FaceBuffer water_surface_faces;
+            for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++) {
+                std::span<const Vector3> face = faces.GetFace(face_idx);
                 // faces have clockwise vertex winding
                 if (IsCwTriangleFacingUp(face[0], face[1], face[2]))
-                    water_surface_faces.push_back(std::move(face));
+                    water_surface_faces.AddFace(face);
             }
             faces = std::move(water_surface_faces);
         }
 
+        MeshSimplificationStats simplification_stats;
         r_world->brush_category_meshes[brushCat] =
-            GenMeshWithVertAttr_Position_Normal(faces);
+            GenSimplifiedMeshWithVertAttr_Position_Normal(faces,
+                compact_vertices, &simplification_stats);
+        Debug{} << "  Simplified mesh: tris"
+            << simplification_stats.num_tris_before << "->"
+            << simplification_stats.num_tris_after << ", verts"
+            << simplification_stats.num_verts_before << "->"
+            << simplification_stats.num_verts_after;
+        AddToVertexBufferReport(*r_world,
+            r_world->brush_category_meshes[brushCat], "brush category");
     }
 
     // ----- trigger_push BRUSHES (only use those that push players)
-    std::vector<std::vector<Vector3>> trigger_push_faces;
+    faces.Clear();
     for (const auto& trigger_push : bsp_map->entities_trigger_push) {
         if (!trigger_push.CanPushPlayers())
             continue;
@@ -698,8 +866,8 @@ WorldCreator::InitFromBspMap(
             continue;
         }
         auto& brush_indices = bmodel_brush_indices[model_idx];
-        auto faces_from_trigger_push = bsp_map->GetBrushFaceVertices(brush_indices);
-        if (faces_from_trigger_push.size() == 0) continue;
+        size_t first_new_vert = faces.vertices.size();
+        bsp_map->GetBrushFaceVertices(&faces, brush_indices);
 
         // Rotate and translate model of trigger_push.
         // Elevate non-ladder push triggers above water surface to fix
@@ -713,16 +881,13 @@ WorldCreator::InitFromBspMap(
             trigger_push.origin + z_fighting_resolver,
             trigger_push.angles
         );
-        for (auto& face : faces_from_trigger_push)
-            for (auto& v : face)
-                v = trigger_push_transf.transformPoint(v);
-
-        trigger_push_faces.insert(trigger_push_faces.end(),
-            std::make_move_iterator(faces_from_trigger_push.begin()),
-            std::make_move_iterator(faces_from_trigger_push.end()));
+        for (size_t v_idx = first_new_vert; v_idx < faces.vertices.size(); v_idx++)
+            faces.vertices[v_idx] = trigger_push_transf.transformPoint(faces.vertices[v_idx]);
     }
     r_world->trigger_push_meshes =
-        GenMeshWithVertAttr_Position_Normal(trigger_push_faces);
+        GenMeshWithVertAttr_Position_Normal(faces, compact_vertices);
+    AddToVertexBufferReport(*r_world, r_world->trigger_push_meshes,
+                            "trigger_push mesh");
 
 
     // Create CollidableWorld object and move all collision structures into it.
@@ -731,6 +896,12 @@ WorldCreator::InitFromBspMap(
     c_world->pImpl->xprop_coll_models    = std::move(xprop_coll_models);
     c_world->pImpl->coll_caches_sprop    = std::move(coll_caches_sprop);
     c_world->pImpl->coll_caches_dprop    = std::move(coll_caches_dprop);
+    c_world->pImpl->xprop_trace_data     = Create_XPropTraceData(*bsp_map,
+                                               *c_world->pImpl->xprop_coll_models,
+                                               *c_world->pImpl->coll_caches_sprop,
+                                               *c_world->pImpl->coll_caches_dprop);
+    c_world->pImpl->brush_planes         = Create_BrushPlanesSoA(*bsp_map);
+    c_world->pImpl->func_brush_trace_data = Create_FuncBrushTraceData(*bsp_map);
     // ...
 
     // BVH must be created *after* all other collision structures were created
@@ -739,10 +910,163 @@ WorldCreator::InitFromBspMap(
     assert(c_world->pImpl->xprop_coll_models    != Corrade::Containers::NullOpt);
     assert(c_world->pImpl->coll_caches_sprop    != Corrade::Containers::NullOpt);
     assert(c_world->pImpl->coll_caches_dprop    != Corrade::Containers::NullOpt);
+    assert(c_world->pImpl->xprop_trace_data     != Corrade::Containers::NullOpt);
+    assert(c_world->pImpl->func_brush_trace_data != Corrade::Containers::NullOpt);
     // ...
     c_world->pImpl->bvh = BVH(*c_world);
 
 
+    // ----- Render meshes of displacements and props
+    // Leave out geometry that's hidden inside solid brushes. Finding it
+    // requires the BVH.
+    // NOTE: Hidden geometry is only removed from render meshes, collision
+    //       structures stay untouched. The BVH is built from them and traces
+    //       against hidden geometry might still start inside of it.
+    HiddenGeometryFinder hidden_geo_finder(*bsp_map, *c_world->pImpl->bvh,
+                                           *c_world->pImpl->brush_planes);
+    {
+        ZoneScopedN("GenDispFaceMesh");
+        Debug{} << "Parsing displacement face mesh";
+        faces.Clear();
+        bsp_map->GetDisplacementFaceVertices(&faces);
+
+        std::vector<uint8_t> is_face_hidden = hidden_geo_finder.FindHiddenFaces(faces);
+        FaceBuffer visible_faces;
+        visible_faces.Reserve(faces.NumFaces(), faces.vertices.size());
+        for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++)
+            if (!is_face_hidden[face_idx])
+                visible_faces.AddFace(faces.GetFace(face_idx));
+
+        r_world->mesh_displacements =
+            GenMeshWithVertAttr_Position_Normal(visible_faces, compact_vertices);
+        Debug{} << "  Culled hidden displacement tris:"
+            << faces.NumTris() - visible_faces.NumTris() << "of" << faces.NumTris();
+        AddToVertexBufferReport(*r_world, r_world->mesh_displacements,
+                                "displacement mesh");
+    }
+
+    struct InstanceData {
+        // @Optimization Instead, represent transformation using
+        //               scaling + quaternion + translation or
+        //               3x3 rotationscaling matrix + translation?
+        Matrix4 model_transformation; // model scale, rotation, translation
+        //Color3 color; // other attributes are possible
+    };
+    const std::map<std::string, std::shared_ptr<const CollisionModel>>& coll_models =
+        *c_world->pImpl->xprop_coll_models;
+
+    // Every solid static and dynamic prop with a successfully loaded collision
+    // model, with its MDL path
+    std::vector<const std::string*> xprop_mdl_paths;
+    std::vector<HiddenGeometryFinder::XPropInstance> xprops;
+    for (const BspMap::StaticProp& sprop : bsp_map->static_props) {
+        const auto& mdl_path = bsp_map->static_prop_model_dict[sprop.model_idx];
+        if (sprop.IsSolidWithVPhysics()) {
+            auto coll_model_it = coll_models.find(mdl_path);
+            if (coll_model_it != coll_models.end()) {
+                xprop_mdl_paths.push_back(&coll_model_it->first);
+                xprops.push_back({
+                    .cmodel = coll_model_it->second.get(),
+                    .transformation = CalcModelTransformationMatrix(
+                        sprop.origin, sprop.angles, sprop.uniform_scale)
+                });
+            }
+        }
+    }
+    for (const BspMap::Ent_prop_dynamic& dprop : bsp_map->relevant_dynamic_props) {
+        auto coll_model_it = coll_models.find(dprop.model);
+        if (coll_model_it != coll_models.end()) {
+            xprop_mdl_paths.push_back(&coll_model_it->first);
+            xprops.push_back({
+                .cmodel = coll_model_it->second.get(),
+                .transformation =
+                    CalcModelTransformationMatrix(dprop.origin, dprop.angles, 1.0f)
+            });
+        }
+    }
+    std::vector<std::vector<uint8_t>> is_section_hidden =
+        hidden_geo_finder.FindHiddenXPropSections(xprops);
+
+    // Props of the same MDL are drawn with one instanced mesh. Props that
+    // have hidden sections need a mesh without them, so they are instanced
+    // separately, grouped by which of their sections are hidden.
+    // Key is MDL path and hidden sections, value is list of xprop's
+    // transformation matrices.
+    std::map<
+        std::pair<const std::string*, std::vector<uint8_t>>,
+        std::vector<InstanceData>> xprop_instance_data;
+    size_t num_culled_xprops = 0;
+    size_t num_culled_sections = 0, num_total_sections = 0;
+    size_t num_culled_tris     = 0, num_total_tris     = 0;
+    for (size_t i = 0; i < xprops.size(); i++) {
+        const auto& section_tri_meshes = xprops[i].cmodel->section_tri_meshes;
+        bool all_hidden = true;
+        bool any_hidden = false;
+        for (size_t section_idx = 0; section_idx < section_tri_meshes.size(); section_idx++) {
+            size_t num_tris = section_tri_meshes[section_idx].tris.size();
+            num_total_sections++;
+            num_total_tris += num_tris;
+            if (is_section_hidden[i][section_idx]) {
+                num_culled_sections++;
+                num_culled_tris += num_tris;
+                any_hidden = true;
+            }
+            else {
+                all_hidden = false;
+            }
+        }
+        if (all_hidden) {
+            num_culled_xprops++;
+            continue;
+        }
+
+        // Props without hidden sections share the same key
+        if (!any_hidden)
+            is_section_hidden[i].clear();
+
+        xprop_instance_data[{ xprop_mdl_paths[i], std::move(is_section_hidden[i]) }]
+            .push_back(InstanceData{ xprops[i].transformation });
+    }
+    Debug{} << "  Culled hidden prop sections:" << num_culled_sections << "of"
+        << num_total_sections << "(tris:" << num_culled_tris << "of"
+        << num_total_tris << Debug::nospace << "), entirely hidden props:"
+        << num_culled_xprops << "of" << xprops.size();
+
+    size_t xprop_vertex_bytes_before = r_world->vertex_buffer_bytes;
+    size_t xprop_float_vertex_bytes_before = r_world->float_vertex_buffer_bytes;
+    for (auto& kv : xprop_instance_data) {
+        const std::string& mdl_path = *kv.first.first;
+        const std::vector<uint8_t>& is_excluded = kv.first.second;
+        std::vector<InstanceData>& instances = kv.second;
+        WorldMesh mesh = GenMeshWithVertAttr_Position_Normal(
+            coll_models.at(mdl_path)->section_tri_meshes, compact_vertices,
+            is_excluded);
+        AddToVertexBufferReport(*r_world, mesh, nullptr);
+
+        mesh.mesh.setInstanceCount(instances.size())
+            .addVertexBufferInstanced(
+                GL::Buffer{
+                    GL::Buffer::TargetHint::Array,
+                    std::move(instances)
+                },
+                1,
+                0,
+                GlidabilityShader3D::TransformationMatrix{}
+                //, GlidabilityShader3D::Color3{} // other attributes are possible
+        );
+
+        r_world->instanced_xprop_meshes.emplace_back(std::move(mesh));
+    }
+    Debug{} << "  Vertex buffers of" << r_world->instanced_xprop_meshes.size()
+        << "prop meshes:"
+        << r_world->vertex_buffer_bytes - xprop_vertex_bytes_before
+        << "bytes (float vertices:"
+        << r_world->float_vertex_buffer_bytes - xprop_float_vertex_bytes_before
+        << "bytes)";
+    Debug{} << "Total world vertex buffer size:" << r_world->vertex_buffer_bytes
+        << "bytes (float vertices:" << r_world->float_vertex_buffer_bytes << "bytes)";
+
+
     if (dest_errors)
         *dest_errors = std::move(error_msgs);
     return { r_world, c_world };
@@ -8,8 +8,10 @@
 #include <Magnum/GL/Mesh.h>
 
 #include "coll/CollidableWorld.h"
+#include "csgo_parsing/BrushSeparation.h"
 #include "csgo_parsing/BspMap.h"
 #include "ren/RenderableWorld.h"
+#include "utils_3d.h"
 
 class WorldCreator {
 public:
@@ -17,12 +19,26 @@ public:
     // Creates RenderableWorld and CollidableWorld objects from a parsed CSGO
     // '.bsp' map file.
     // Error messages are put into the string pointed to by dest_errors.
+    // If compact_vertices is true, world meshes use the compact vertex format
+    // (see ren/CompactVertexFormat.h), halving their vertex buffer size.
     static
     std::pair<
         std::shared_ptr<ren::RenderableWorld>,
         std::shared_ptr<coll::CollidableWorld>>
     InitFromBspMap(
         std::shared_ptr<const csgo_parsing::BspMap> bsp_map,
+        std::string* dest_errors = nullptr,
+        bool compact_vertices = false);
+
+    // Appends faces of all brushes of the given category to dest: Those of the
+    // world itself and those of solid func_brush entities, moved to where the
+    // func_brush is placed. This is the brush geometry InitFromBspMap()
+    // creates worlds from.
+    // Error messages are appended to the string pointed to by dest_errors.
+    static void GetBrushCategoryFaces(
+        const csgo_parsing::BspMap& bsp_map,
+        csgo_parsing::BrushSeparation::Category brush_cat,
+        utils_3d::FaceBuffer* dest,
         std::string* dest_errors = nullptr);
 
     // Mesh of Bump Mines thrown/placed into the world
@@ -1,6 +1,7 @@
 #include "coll/BVH.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <cstdint>
@@ -21,6 +22,7 @@
 #include "coll/CollidableWorld-xprop.h"
 #include "coll/Debugger.h"
 #include "coll/Trace.h"
+#include "coll/TraceProfiler.h"
 #include "csgo_parsing/BrushSeparation.h"
 #include "csgo_parsing/BspMap.h"
 #include "csgo_parsing/utils.h"
@@ -37,7 +39,16 @@ using namespace csgo_parsing;
 
 #define PRINT_PREFIX "[BVH]"
 
+// Used to give each BVH a unique ID
+static std::atomic<uint64_t> g_next_bvh_id = 1;
+
+// How far a trace cache's region extends beyond the trace that (re-)filled it.
+static const float TRACE_CACHE_REGION_MARGIN = 48.0f;
+// Traces whose AABB is larger than this on any axis don't use trace caches.
+static const float TRACE_CACHE_MAX_TRACE_SIZE = 160.0f;
+
 BVH::BVH(CollidableWorld& c_world)
+    : id{ g_next_bvh_id++ }
 {
     // @Optimization Is there potential to parallelize BVH creation?
     bool leaf_creation_success = CreateLeaves(c_world);
@@ -107,13 +118,13 @@ BVH::BVH(CollidableWorld& c_world)
     Debug{} << PRINT_PREFIX << nodes.size() << "nodes were constructed";
 }
 
-bool BVH::WasConstructedSuccessfully()
+bool BVH::WasConstructedSuccessfully() const
 {
     // A valid BVH must have at least one node and 2 leaves.
     return nodes.size() != 0 && total_leaf_cnt >= 2;
 }
 
-void BVH::DoTrace(Trace* trace, CollidableWorld& c_world)
+void BVH::DoTrace(Trace* trace, CollidableWorld& c_world, TraceCache* cache)
 {
     ZoneScoped;
 
@@ -134,6 +145,9 @@ void BVH::DoTrace(Trace* trace, CollidableWorld& c_world)
         return;
     }
 
+    if (cache && DoTraceWithCache(trace, c_world, *cache))
+        return;
+
     // @Optimization We should probably assume that the root node is always hit,
     //               tracing outside the world's bounds should never happen.
     float root_node_aabb_hit_fraction;
@@ -180,12 +194,14 @@ void BVH::DoTrace(Trace* trace, CollidableWorld& c_world)
 
             // @Optimization Make sure CDispCollTree code doesn't do the same
             //               AABB check that we already do.
+            coll::TraceProfiler::OnBvhLeafTested(leaf.type);
             coll::Debugger::DebugStart_BroadPhaseLeafHit(leaf, leaf_idx);
             DoTraceAgainstLeaf(trace, leaf, c_world);
             coll::Debugger::DebugFinish_BroadPhaseLeafHit();
         }
         else { // If candidate is a node
             const Node& parent_node = nodes[candidate.node_or_leaf_idx];
+            coll::TraceProfiler::OnBvhNodeVisited();
 
             // New candidate entries of children whose AABB is hit by the trace
             std::vector<TraversalCandidate> child_candidates;
@@ -457,6 +473,127 @@ BVH::NodeSplitDetails BVH::DetermineBeneficialNodeSplit(const Node& node_to_spli
     return split_details;
 }
 
+bool BVH::DoTraceWithCache(Trace* trace, CollidableWorld& c_world,
+                           TraceCache& cache)
+{
+    ZoneScoped;
+
+    // AABB enclosing the entire trace sweep
+    Vector3 trace_mins = Math::min(trace->info.startpos,
+                                   trace->info.startpos + trace->info.delta);
+    Vector3 trace_maxs = Math::max(trace->info.startpos,
+                                   trace->info.startpos + trace->info.delta);
+    trace_mins -= trace->info.extents;
+    trace_maxs += trace->info.extents;
+
+    bool is_trace_in_region = cache.bvh_id == id;
+    for (int axis = 0; axis < 3 && is_trace_in_region; axis++)
+        if (trace_mins[axis] < cache.region_mins[axis] ||
+            trace_maxs[axis] > cache.region_maxs[axis])
+            is_trace_in_region = false;
+
+    if (!is_trace_in_region) {
+        // Large traces would make the cached region huge, don't cache them
+        for (int axis = 0; axis < 3; axis++)
+            if (trace_maxs[axis] - trace_mins[axis] > TRACE_CACHE_MAX_TRACE_SIZE)
+                return false;
+
+        // Move region to the trace's location and collect its leaves. This
+        // doesn't count as BVH traversal in the trace profiler's stats.
+        cache.bvh_id = id;
+        cache.region_mins = trace_mins - Vector3{ TRACE_CACHE_REGION_MARGIN };
+        cache.region_maxs = trace_maxs + Vector3{ TRACE_CACHE_REGION_MARGIN };
+        cache.leaf_indices.clear();
+        GetLeavesTouchingAabb(cache.region_mins, cache.region_maxs,
+                              &cache.leaf_indices);
+    }
+
+    // Every leaf that could be hit by the trace touches the region, hence is
+    // cached. Test against the cached leaves whose AABB is hit, in the order
+    // in which the trace hits their AABB. Just like with BVH traversal, this
+    // lets us skip leaves that are hit after the trace already hit something.
+    cache.candidates.clear();
+    for (uint32_t leaf_idx : cache.leaf_indices) {
+        float aabb_hit_fraction;
+        if (trace->HitsAabb(leaves[leaf_idx].mins, leaves[leaf_idx].maxs,
+                            &aabb_hit_fraction)) {
+            cache.candidates.push_back({
+                .leaf_idx = leaf_idx,
+                .aabb_hit_fraction = aabb_hit_fraction
+            });
+        }
+    }
+    // Stable sort: Leaves hit at the same fraction keep their cached order,
+    // which is the order of BVH traversal
+    std::stable_sort(cache.candidates.begin(), cache.candidates.end(),
+        [](const TraceCache::Candidate& a, const TraceCache::Candidate& b) {
+            return a.aabb_hit_fraction < b.aabb_hit_fraction;
+        }
+    );
+
+    for (const TraceCache::Candidate& candidate : cache.candidates) {
+        if (trace->info.isswept) {
+            // All remaining candidates are hit after what we already hit
+            if (trace->results.fraction < candidate.aabb_hit_fraction)
+                break;
+        } else {
+            // When performing unswept traces, early-out once we hit something
+            if (trace->results.DidHit())
+                break;
+        }
+
+        const Leaf& leaf = leaves[candidate.leaf_idx];
+        coll::TraceProfiler::OnBvhLeafTested(leaf.type);
+        coll::Debugger::DebugStart_BroadPhaseLeafHit(leaf, (int32_t)candidate.leaf_idx);
+        DoTraceAgainstLeaf(trace, leaf, c_world);
+        coll::Debugger::DebugFinish_BroadPhaseLeafHit();
+    }
+    return true;
+}
+
+void BVH::GetBrushesTouchingAabb(const Vector3& mins, const Vector3& maxs,
+                                 std::vector<uint32_t>* brush_indices) const
+{
+    if (!WasConstructedSuccessfully())
+        return;
+
+    thread_local std::vector<uint32_t> leaf_indices;
+    leaf_indices.clear();
+    GetLeavesTouchingAabb(mins, maxs, &leaf_indices);
+    for (uint32_t leaf_idx : leaf_indices)
+        if (leaves[leaf_idx].type == Leaf::Type::Brush)
+            brush_indices->push_back(leaves[leaf_idx].brush_idx);
+}
+
+void BVH::GetLeavesTouchingAabb(const Vector3& mins, const Vector3& maxs,
+                                std::vector<uint32_t>* leaf_indices) const
+{
+    std::stack<int32_t> nodes_to_visit; // Node indices
+    if (!AabbIntersectsAabb(mins, maxs, nodes[0].mins, nodes[0].maxs))
+        return;
+    nodes_to_visit.push(0); // Root node idx
+
+    // Don't call profiling hooks here, this is called by worker threads
+    // (see GetBrushesTouchingAabb())
+    while (!nodes_to_visit.empty()) {
+        const Node& node = nodes[nodes_to_visit.top()];
+        nodes_to_visit.pop();
+
+        for (int32_t child_idx : { node.child_l, node.child_r }) {
+            if (child_idx < 0) { // If child is a leaf
+                const Leaf& leaf = leaves[-child_idx];
+                if (AabbIntersectsAabb(mins, maxs, leaf.mins, leaf.maxs))
+                    leaf_indices->push_back(-child_idx);
+            }
+            else { // If child is a node
+                const Node& child = nodes[child_idx];
+                if (AabbIntersectsAabb(mins, maxs, child.mins, child.maxs))
+                    nodes_to_visit.push(child_idx);
+            }
+        }
+    }
+}
+
 void BVH::DoTraceAgainstLeaf(Trace* trace, const Leaf& leaf,
                              CollidableWorld& c_world) const
 {
@@ -565,16 +702,23 @@ bool BVH::CreateLeaves(CollidableWorld& c_world)
 
     // Collect relevant func_brush entities
     Debug{} << PRINT_PREFIX << "Collecting AABBs of func_brush entities";
-    // If func_brush uses collision caches: TODO Test if fb coll cache exists!
+    // Test if func_brush trace data has been constructed
+    if (c_world.pImpl->func_brush_trace_data == Corrade::Containers::NullOpt) {
+        assert(false && "BVH creation FAILED: func_brush trace data is not "
+                        "created yet.");
+        return false; // Leaf creation failed
+    }
+    const FuncBrushTraceData& fb_trace_data = *c_world.pImpl->func_brush_trace_data;
     for (size_t fb_idx = 0; fb_idx < bsp_map->entities_func_brush.size(); fb_idx++) {
         const BspMap::Ent_func_brush& func_brush = bsp_map->entities_func_brush[fb_idx];
         if (!func_brush.IsSolid())
             continue;
 
-        Vector3 mins, maxs;
-        bool valid_aabb = CalcAabb_FuncBrush(fb_idx, *bsp_map, &mins, &maxs);
-        if (!valid_aabb)
+        const FuncBrushTraceData::FuncBrush& fb = fb_trace_data.func_brushes[fb_idx];
+        if (!fb.has_aabb)
             continue;
+        Vector3 mins = fb.aabb_mins;
+        Vector3 maxs = fb.aabb_maxs;
 
         // Bloat AABB a little to account for collision calculation tolerances
         mins -= Vector3{ 1.0f, 1.0f, 1.0f };
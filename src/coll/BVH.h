@@ -9,6 +9,7 @@
 #include <Magnum/Math/Vector3.h>
 
 #include "coll/CollidableWorld.h"
+#include "coll/TraceCache.h"
 #include "csgo_parsing/BspMap.h"
 
 namespace coll {
@@ -23,17 +24,28 @@ public:
 
     // Check whether an error occurred during BVH construction.
     // If construction failed, traces cannot be performed.
-    bool WasConstructedSuccessfully();
+    bool WasConstructedSuccessfully() const;
 
     // Does nothing if WasConstructedSuccessfully() returns false.
+    // If a trace cache is given, it's used and updated if the trace is small
+    // enough. See TraceCache for details.
     // CAUTION: Not thread-safe yet!
-    void DoTrace(Trace* trace, CollidableWorld& c_world);
+    void DoTrace(Trace* trace, CollidableWorld& c_world,
+                 TraceCache* cache = nullptr);
 
     // Debug function. Does nothing if WasConstructedSuccessfully() returns false.
     void GetAabbsContainingPoint(const Magnum::Vector3& pt,
         std::vector<Magnum::Vector3>* aabb_mins_list,
         std::vector<Magnum::Vector3>* aabb_maxs_list);
 
+    // Collects indices into BspMap::brushes of all worldspawn brushes whose
+    // (bloated) AABB touches the given AABB. Can be called from multiple
+    // threads at once. Does nothing if WasConstructedSuccessfully() returns
+    // false.
+    void GetBrushesTouchingAabb(const Magnum::Vector3& mins,
+                                const Magnum::Vector3& maxs,
+                                std::vector<uint32_t>* brush_indices) const;
+
 private:
     template<std::size_t size> using BitVector = Magnum::Math::BitVector<size>;
 
@@ -87,6 +99,9 @@ private:
     std::vector<Node> nodes;
     size_t total_leaf_cnt; // Not counting dummy leaf, equal to (leaves.size()-1)
 
+    // Unique, non-zero ID of this BVH. Lets trace caches detect map changes.
+    uint64_t id;
+
 private:
     static bool IsPointInAabb(const Magnum::Vector3& pt,
         const Magnum::Vector3& mins, const Magnum::Vector3& maxs);
@@ -120,6 +135,18 @@ private:
     void DoTraceAgainstLeaf(Trace* trace, const Leaf& leaf,
                             CollidableWorld& c_world) const;
 
+    // Traces only against the leaves of the given trace cache, possibly after
+    // refilling it. Returns false without tracing if the trace is too large to
+    // make use of the cache.
+    bool DoTraceWithCache(Trace* trace, CollidableWorld& c_world,
+                          TraceCache& cache);
+
+    // Collects all leaves whose AABB touches the given AABB. Doesn't call any
+    // profiling hooks, hence can be called from multiple threads at once.
+    void GetLeavesTouchingAabb(const Magnum::Vector3& mins,
+                               const Magnum::Vector3& maxs,
+                               std::vector<uint32_t>* leaf_indices) const;
+
     // Fills leaves array with one dummy leaf and further leafs.
     // Returns false if leaf creation failed, true otherwise.
     bool CreateLeaves(CollidableWorld& c_world);
@@ -143,6 +170,8 @@ private:
     friend class Debugger;
     // Benchmarks needs to benchmark, let them access private members.
     friend class Benchmark;
+    // Profiler needs to distinguish leaf types.
+    friend class TraceProfiler;
 };
     
 } // namespace coll
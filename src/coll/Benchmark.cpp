@@ -15,8 +15,12 @@
 #include <chrono>
 #include <cmath>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <optional>
 #include <random>
+#include <utility>
+#include <vector>
 
 #include <Corrade/Containers/StringView.h>
 #include <Corrade/Utility/DebugStl.h>
@@ -25,6 +29,9 @@
 #include <Magnum/Math/Vector3.h>
 
 #include "coll/CollidableWorld_Impl.h"
+#include "coll/CollidableWorld-brush.h"
+#include "coll/SimdMath.h"
+#include "coll/TraceCache.h"
 #include "csgo_parsing/BspMap.h"
 #include "GlobalVars.h"
 
@@ -449,6 +456,378 @@ void Benchmark::StaticPropBevelPlaneGen()
 
 // Format nanosecond duration. Examples: " 2.82s", "978.0ms", " 12.3µs", "811.9ns"
 // TODO This function should be useful elsewhere too, move it out of here.
+static bool AreTraceResultsBitIdentical(const Trace::Results& a,
+                                        const Trace::Results& b)
+{
+    return std::memcmp(&a.fraction,     &b.fraction,     sizeof(a.fraction))     == 0
+        && std::memcmp(&a.plane_normal, &b.plane_normal, sizeof(a.plane_normal)) == 0
+        && a.surface    == b.surface
+        && a.startsolid == b.startsolid
+        && a.allsolid   == b.allsolid;
+}
+
+void Benchmark::BrushTracingSimdVsScalar()
+{
+    if (!g_coll_world) return;
+    CollidableWorld& c_world = *g_coll_world;
+    const BspMap& bsp_map = *c_world.pImpl->origin_bsp_map;
+
+    unsigned int seed = std::random_device{}();
+    Debug{} << "[Benchmark::BrushTracingSimdVsScalar] Used seed:" << seed; // To let user reproduce this benchmark
+    std::mt19937 gen{seed};
+
+    constexpr size_t NUM_TRACES_PER_BRUSH = 32;
+    const Vector3 hull_extents[] = {
+        { 16.0f, 16.0f, 36.0f }, // Standing player
+        { 16.0f, 16.0f, 27.0f }, // Crouching player
+        {  8.0f,  8.0f, 36.0f }, // Player hull quadrant
+        {  2.0f,  2.0f,  2.0f }, // Bump Mine
+    };
+
+    // Build trace corpus: Swept and unswept hull traces hitting brush AABBs
+    struct CorpusEntry { uint32_t brush_idx; Trace::Info info; };
+    std::vector<CorpusEntry> corpus;
+    for (const BVH::Leaf& leaf : c_world.pImpl->bvh->leaves) {
+        if (leaf.type != BVH::Leaf::Type::Brush)
+            continue;
+        size_t num_attempts = 0;
+        size_t num_generated = 0;
+        while (num_generated < NUM_TRACES_PER_BRUSH && num_attempts < 8 * NUM_TRACES_PER_BRUSH) {
+            num_attempts++;
+            const Vector3& ext = hull_extents[gen() % std::size(hull_extents)];
+            bool swept = gen() % 4 != 0;
+            float len = swept ? std::uniform_real_distribution<float>(0.01f, 95.0f)(gen) : 0.0f;
+            // Use axis-aligned deltas sometimes, they are common in movement code
+            Vector3 delta = (gen() % 2) ? len * GenRandomDir(gen)
+                                        : Vector3{ 0.0f, 0.0f, -len };
+            Vector3 start;
+            for (int axis = 0; axis < 3; axis++) {
+                std::uniform_real_distribution<float> distr(
+                    leaf.mins[axis] - ext[axis] - len,
+                    leaf.maxs[axis] + ext[axis] + len);
+                start[axis] = distr(gen);
+            }
+            Trace tr{ start, start + delta, -ext, +ext };
+            if (!tr.HitsAabb(leaf.mins, leaf.maxs))
+                continue;
+            corpus.push_back({ leaf.brush_idx, tr.info });
+            num_generated++;
+        }
+    }
+    Debug{} << "[Benchmark::BrushTracingSimdVsScalar] Generated" << corpus.size()
+            << "traces";
+
+    // Run both implementations
+    std::vector<Trace> traces_simd;
+    std::vector<Trace> traces_scalar;
+    traces_simd  .reserve(corpus.size());
+    traces_scalar.reserve(corpus.size());
+    for (const CorpusEntry& entry : corpus) {
+        traces_simd  .emplace_back(entry.info);
+        traces_scalar.emplace_back(entry.info);
+    }
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    for (size_t i = 0; i < corpus.size(); i++) {
+        const BspMap::Brush& brush = bsp_map.brushes[corpus[i].brush_idx];
+        if (traces_scalar[i].info.isswept) DoSweptTrace_Brush_Scalar  (&traces_scalar[i], brush, bsp_map);
+        else                               DoUnsweptTrace_Brush_Scalar(&traces_scalar[i], brush, bsp_map);
+    }
+    auto t1 = Clock::now();
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (traces_simd[i].info.isswept) c_world.DoSweptTrace_Brush  (&traces_simd[i], corpus[i].brush_idx);
+        else                             c_world.DoUnsweptTrace_Brush(&traces_simd[i], corpus[i].brush_idx);
+    }
+    auto t2 = Clock::now();
+
+    size_t num_mismatches = 0;
+    for (size_t i = 0; i < corpus.size(); i++) {
+        if (!AreTraceResultsBitIdentical(traces_simd[i].results,
+                                         traces_scalar[i].results)) {
+            num_mismatches++;
+            CompareTraceResults(corpus[i].info, traces_scalar[i].results,
+                                traces_simd[i].results);
+        }
+    }
+
+    using nano = std::chrono::nanoseconds;
+    float scalar_ns = std::chrono::duration_cast<nano>(t1 - t0).count();
+    float simd_ns   = std::chrono::duration_cast<nano>(t2 - t1).count();
+    Debug{} << "[Benchmark::BrushTracingSimdVsScalar]" << num_mismatches
+            << "of" << corpus.size() << "traces have differing results";
+    Debug{} << "[Benchmark::BrushTracingSimdVsScalar] scalar:"
+            << GetDurationStr(scalar_ns / corpus.size()) << "per trace, SIMD:"
+            << GetDurationStr(simd_ns / corpus.size()) << "per trace ("
+            << GetPercentStr(simd_ns / scalar_ns - 1.0f, true) << ")";
+}
+
+void Benchmark::DisplacementTracing()
+{
+    if (!g_coll_world || !g_coll_world->pImpl->hull_disp_coll_trees) return;
+    CollidableWorld& c_world = *g_coll_world;
+
+    unsigned int seed = std::random_device{}();
+    Debug{} << "[Benchmark::DisplacementTracing] Used seed:" << seed; // To let user reproduce this benchmark
+    Debug{} << "[Benchmark::DisplacementTracing] SIMD backend:" << SIMD_BACKEND_NAME;
+    std::mt19937 gen{seed};
+
+    // Rampsliding players move fast along the displacement surface and
+    // perform many short hull traces per tick
+    constexpr size_t NUM_TRACES_PER_DISP = 64;
+    constexpr size_t NUM_ITERATIONS = 16;
+    const Vector3 player_extents = { 16.0f, 16.0f, 36.0f };
+
+    std::vector<Trace::Info> corpus_info;
+    std::vector<uint32_t>    corpus_disp_idx;
+    for (const BVH::Leaf& leaf : c_world.pImpl->bvh->leaves) {
+        if (leaf.type != BVH::Leaf::Type::Displacement)
+            continue;
+        size_t num_attempts = 0;
+        size_t num_generated = 0;
+        while (num_generated < NUM_TRACES_PER_DISP && num_attempts < 8 * NUM_TRACES_PER_DISP) {
+            num_attempts++;
+            float len = std::uniform_real_distribution<float>(0.01f, 60.0f)(gen);
+            Vector3 delta = len * GenRandomDir(gen);
+            Vector3 start;
+            for (int axis = 0; axis < 3; axis++) {
+                std::uniform_real_distribution<float> distr(
+                    leaf.mins[axis] - player_extents[axis],
+                    leaf.maxs[axis] + player_extents[axis]);
+                start[axis] = distr(gen);
+            }
+            Trace tr{ start, start + delta, -player_extents, +player_extents };
+            if (!tr.HitsAabb(leaf.mins, leaf.maxs))
+                continue;
+            corpus_info.push_back(tr.info);
+            corpus_disp_idx.push_back(leaf.disp_coll_idx);
+            num_generated++;
+        }
+    }
+    if (corpus_info.empty()) {
+        Debug{} << "[Benchmark::DisplacementTracing] Map has no displacements";
+        return;
+    }
+
+    // Make sure collision caches exist before measuring
+    for (size_t i = 0; i < corpus_info.size(); i++) {
+        Trace tr{ corpus_info[i] };
+        c_world.DoSweptTrace_Displacement(&tr, corpus_disp_idx[i]);
+    }
+
+    std::vector<unsigned long long> durations;
+    size_t num_hits = 0;
+    for (size_t iter = 0; iter < NUM_ITERATIONS; iter++) {
+        num_hits = 0;
+        auto t0 = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < corpus_info.size(); i++) {
+            Trace tr{ corpus_info[i] };
+            c_world.DoSweptTrace_Displacement(&tr, corpus_disp_idx[i]);
+            num_hits += tr.results.DidHit();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        durations.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            t1 - t0).count() / corpus_info.size());
+    }
+
+    BenchmarkStatistics stats = CalcDurationStats(std::move(durations));
+    Debug{} << "[Benchmark::DisplacementTracing]" << corpus_info.size()
+            << "traces," << num_hits << "hits";
+    Debug{} << "[Benchmark::DisplacementTracing] Per trace: mean"
+            << GetDurationStr(stats.mean) << "| median"
+            << GetDurationStr(stats.median) << "| min"
+            << GetDurationStr(stats.min) << "| max"
+            << GetDurationStr(stats.max);
+}
+
+void Benchmark::StaticPropTracing()
+{
+    if (!g_coll_world || !g_coll_world->pImpl->xprop_trace_data) return;
+    CollidableWorld& c_world = *g_coll_world;
+
+    unsigned int seed = std::random_device{}();
+    Debug{} << "[Benchmark::StaticPropTracing] Used seed:" << seed; // To let user reproduce this benchmark
+    std::mt19937 gen{seed};
+
+    constexpr size_t NUM_TRACES_PER_SPROP = 32;
+    constexpr size_t NUM_ITERATIONS = 16;
+
+    std::vector<Trace::Info> corpus_info;
+    std::vector<uint32_t>    corpus_sprop_idx;
+    for (const BVH::Leaf& leaf : c_world.pImpl->bvh->leaves) {
+        if (leaf.type != BVH::Leaf::Type::StaticProp)
+            continue;
+        size_t num_generated = 0;
+        for (size_t i = 0; i < 8 * NUM_TRACES_PER_SPROP; i++) {
+            std::optional<Trace> tr = GenRealisticTrace(gen, leaf);
+            if (!tr)
+                continue;
+            corpus_info.push_back(tr->info);
+            corpus_sprop_idx.push_back(leaf.sprop_idx);
+            if (++num_generated == NUM_TRACES_PER_SPROP)
+                break;
+        }
+    }
+    if (corpus_info.empty()) {
+        Debug{} << "[Benchmark::StaticPropTracing] Map has no solid static props";
+        return;
+    }
+
+    Debug{} << "[Benchmark::StaticPropTracing]" << corpus_info.size() << "traces";
+
+    // Measure each bevel plane mode
+    using BevelMode = CollidableWorld::XPropBevelPlaneMode;
+    const BevelMode prev_bevel_mode = c_world.GetXPropBevelPlaneMode();
+    const std::pair<BevelMode, const char*> bevel_modes[] = {
+        { BevelMode::ON_DEMAND,              "on demand"          },
+        { BevelMode::PRECOMPUTE_NEAR_SPAWNS, "precomputed near spawns" },
+        { BevelMode::PRECOMPUTE_ALL,         "precomputed"        },
+    };
+    for (const auto& [bevel_mode, bevel_mode_name] : bevel_modes) {
+        c_world.SetXPropBevelPlaneMode(bevel_mode);
+
+        std::vector<unsigned long long> durations;
+        size_t num_hits = 0;
+        for (size_t iter = 0; iter < NUM_ITERATIONS; iter++) {
+            num_hits = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < corpus_info.size(); i++) {
+                Trace tr{ corpus_info[i] };
+                c_world.DoSweptTrace_StaticProp(&tr, corpus_sprop_idx[i]);
+                num_hits += tr.results.DidHit();
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            durations.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                t1 - t0).count() / corpus_info.size());
+        }
+
+        BenchmarkStatistics stats = CalcDurationStats(std::move(durations));
+        Debug{} << "[Benchmark::StaticPropTracing] Bevel planes" << bevel_mode_name
+                << "(" << c_world.GetXPropBevelPlaneMemorySize() / 1024 << "KiB):"
+                << num_hits << "hits";
+        Debug{} << "    Per trace: mean"
+                << GetDurationStr(stats.mean) << "| median"
+                << GetDurationStr(stats.median) << "| min"
+                << GetDurationStr(stats.min) << "| max"
+                << GetDurationStr(stats.max);
+    }
+    c_world.SetXPropBevelPlaneMode(prev_bevel_mode);
+
+    Debug{} << "[Benchmark::StaticPropTracing] Flat prop trace data:"
+            << c_world.pImpl->xprop_trace_data->GetMemorySize() / 1024 << "KiB";
+}
+
+void Benchmark::TraceCacheVsBvhTraversal()
+{
+    if (!g_coll_world) return;
+    CollidableWorld& c_world = *g_coll_world;
+    const std::vector<BVH::Leaf>& leaves = c_world.pImpl->bvh->leaves;
+    if (leaves.size() < 2) return;
+
+    unsigned int seed = std::random_device{}();
+    Debug{} << "[Benchmark::TraceCacheVsBvhTraversal] Used seed:" << seed; // To let user reproduce this benchmark
+    std::mt19937 gen{seed};
+
+    constexpr size_t NUM_PLAYERS = 256;
+    constexpr size_t NUM_TICKS_PER_PLAYER = 128;
+    const float tick_interval = 1.0f / 64.0f;
+    const Vector3 player_extents   = { 16.0f, 16.0f, 36.0f };
+    const Vector3 quadrant_extents = {  8.0f,  8.0f, 36.0f };
+
+    // Build trace corpus: For each player, the traces of each tick, similar to
+    // what CsgoMovement does. Players start next to a random BVH leaf and move
+    // in a random direction with a random speed.
+    std::vector<std::vector<Trace::Info>> corpus(NUM_PLAYERS);
+    size_t num_traces = 0;
+    for (std::vector<Trace::Info>& player_traces : corpus) {
+        const BVH::Leaf& leaf = leaves[1 + gen() % (leaves.size() - 1)];
+        Vector3 pos;
+        for (int axis = 0; axis < 3; axis++) {
+            std::uniform_real_distribution<float> distr(
+                leaf.mins[axis] - player_extents[axis],
+                leaf.maxs[axis] + player_extents[axis]);
+            pos[axis] = distr(gen);
+        }
+        float speed = std::uniform_real_distribution<float>(0.0f, 1000.0f)(gen);
+        Vector3 vel = speed * GenRandomDir(gen);
+
+        for (size_t tick = 0; tick < NUM_TICKS_PER_PLAYER; tick++) {
+            Vector3 next_pos = pos + tick_interval * vel;
+            // Ground check, movement and unduck/quadrant checks
+            player_traces.push_back(Trace{ pos, pos - Vector3{ 0.0f, 0.0f, 2.0f },
+                -player_extents, +player_extents }.info);
+            player_traces.push_back(Trace{ pos, next_pos,
+                -player_extents, +player_extents }.info);
+            for (float x : { -8.0f, 8.0f }) {
+                for (float y : { -8.0f, 8.0f }) {
+                    Vector3 quadrant_pos = next_pos + Vector3{ x, y, 0.0f };
+                    player_traces.push_back(Trace{ quadrant_pos, quadrant_pos,
+                        -quadrant_extents, +quadrant_extents }.info);
+                }
+            }
+            pos = next_pos;
+        }
+        num_traces += player_traces.size();
+    }
+    Debug{} << "[Benchmark::TraceCacheVsBvhTraversal] Generated" << num_traces
+            << "traces of" << NUM_PLAYERS << "players";
+
+    std::vector<Trace::Results> results_uncached;
+    std::vector<Trace::Results> results_cached;
+    results_uncached.reserve(num_traces);
+    results_cached  .reserve(num_traces);
+
+    using Clock = std::chrono::steady_clock;
+    auto t0 = Clock::now();
+    for (const std::vector<Trace::Info>& player_traces : corpus) {
+        for (const Trace::Info& info : player_traces) {
+            Trace tr{ info };
+            c_world.DoTrace(&tr);
+            results_uncached.push_back(tr.results);
+        }
+    }
+    auto t1 = Clock::now();
+    TraceCache cache;
+    for (const std::vector<Trace::Info>& player_traces : corpus) {
+        cache.Clear(); // Each player has its own cache
+        for (const Trace::Info& info : player_traces) {
+            Trace tr{ info };
+            c_world.DoTrace(&tr, &cache);
+            results_cached.push_back(tr.results);
+        }
+    }
+    auto t2 = Clock::now();
+
+    // Results may only differ in which of multiple objects hit at the exact
+    // same fraction is reported
+    size_t num_mismatches = 0;
+    size_t num_fraction_mismatches = 0;
+    size_t i = 0;
+    for (const std::vector<Trace::Info>& player_traces : corpus) {
+        for (const Trace::Info& info : player_traces) {
+            if (!AreTraceResultsBitIdentical(results_cached[i], results_uncached[i])) {
+                num_mismatches++;
+                if (results_cached[i].fraction != results_uncached[i].fraction) {
+                    num_fraction_mismatches++;
+                    CompareTraceResults(info, results_uncached[i], results_cached[i]);
+                }
+            }
+            i++;
+        }
+    }
+
+    using nano = std::chrono::nanoseconds;
+    float uncached_ns = std::chrono::duration_cast<nano>(t1 - t0).count();
+    float cached_ns   = std::chrono::duration_cast<nano>(t2 - t1).count();
+    Debug{} << "[Benchmark::TraceCacheVsBvhTraversal]" << num_mismatches
+            << "of" << num_traces << "traces have differing results,"
+            << num_fraction_mismatches << "of them a differing fraction";
+    Debug{} << "[Benchmark::TraceCacheVsBvhTraversal] uncached:"
+            << GetDurationStr(uncached_ns / num_traces) << "per trace, cached:"
+            << GetDurationStr(cached_ns / num_traces) << "per trace ("
+            << GetPercentStr(cached_ns / uncached_ns - 1.0f, true) << ")";
+}
+
 Containers::String Benchmark::GetDurationStr(float duration_ns) {
     float value;
     Containers::String unit;
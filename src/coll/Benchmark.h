@@ -30,6 +30,29 @@ public:
     // NOTE: Other threads shouldn't be running, they might mess up measurements.
     static void StaticPropBevelPlaneGen();
 
+    // Verify that SIMD brush traces produce bit-identical results compared to
+    // the scalar reference implementation, using a corpus of hull traces
+    // around the brushes of the currently loaded map. Also compares speed.
+    static void BrushTracingSimdVsScalar();
+
+    // Measure the speed of player hull traces against displacements, using a
+    // corpus of rampslide-like traces around the displacements of the
+    // currently loaded map. To compare SIMD against plain C++ code, run this
+    // once in a regular build and once in a build that defines
+    // COLL_SIMD_FORCE_SCALAR (see coll/SimdMath.h).
+    static void DisplacementTracing();
+
+    // Measure the speed of player hull traces against static props, using a
+    // corpus of realistic traces around the static props of the currently
+    // loaded map. Prop-heavy maps like dz_arctic are the most relevant.
+    // Reports speed and memory cost of each bevel plane mode.
+    static void StaticPropTracing();
+
+    // Compare player movement traces with and without a TraceCache, using
+    // tick-by-tick trace sequences of players moving around the currently
+    // loaded map. Reports differing results and speed of both.
+    static void TraceCacheVsBvhTraversal();
+
     ////////////////////////////////////////////////////////////////////////////
 
     // TODO This function should be useful elsewhere too, move it out of here.
@@ -1,11 +1,17 @@
 #include "coll/CollidableWorld-brush.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include <Tracy.hpp>
 
 #include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
 
 #include "coll/CollidableWorld.h"
 #include "coll/CollidableWorld_Impl.h"
+#include "coll/SimdMath.h"
 #include "coll/Trace.h"
 #include "csgo_parsing/BrushSeparation.h"
 #include "csgo_parsing/BspMap.h"
@@ -39,18 +45,100 @@ void CollidableWorld::DoSweptTrace_Brush(Trace* trace, uint32_t brush_idx)
     assert(trace->info.isswept);
     ZoneScoped;
 
-    const Brush& brush = pImpl->origin_bsp_map->brushes[brush_idx];
+    const BspMap& bsp_map = *pImpl->origin_bsp_map;
+    const Brush& brush = bsp_map.brushes[brush_idx];
     if (!IsBrushSolidToPlayer(brush))
         return;
 
+    // Ray traces skip bevel planes, the SIMD path doesn't handle that
+    if (trace->info.isray || pImpl->brush_planes == Corrade::Containers::NullOpt) {
+        DoSweptTrace_Brush_Scalar(trace, brush, bsp_map);
+        return;
+    }
+
+    if (!brush.num_sides)
+        return;
+
     // -------- start of source-sdk-2013 code --------
     // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
-    
-    // TODO move these constants' definitions and all their other occurrences
-    //      somewhere else, maybe into CollidableWorld?
-    const float DIST_EPSILON = 0.03125f; // 1/32 epsilon to keep floating point happy
-    const float NEVER_UPDATED = -9999.0f;
+    SweptBrushClipResult clip = ClipSweptBoxToBrushPlanes(
+        *pImpl->brush_planes,
+        pImpl->brush_planes->brush_ranges[brush_idx],
+        trace->info.startpos,
+        trace->info.startpos + trace->info.delta,
+        trace->info.extents);
+
+    if (clip.in_front) // If completely in front of a face, no intersection
+        return;
+
+    if (!clip.startout) { // If original point was inside brush
+        trace->results.startsolid = true;
+        if (!clip.getout)
+            trace->results.allsolid = true;
+        return;
+    }
 
+    if (clip.enterfrac < clip.leavefrac) {
+        if (clip.enterfrac > NEVER_UPDATED && clip.enterfrac < trace->results.fraction) {
+            // New closest object was hit!
+            const BrushPlanesSoA& planes = *pImpl->brush_planes;
+            uint32_t side_idx = planes.side_idx[clip.clip_plane];
+            if (clip.enterfrac < 0.0f)
+                clip.enterfrac = 0.0f;
+            trace->results.fraction     = clip.enterfrac;
+            trace->results.plane_normal = {
+                planes.normal_x[clip.clip_plane],
+                planes.normal_y[clip.clip_plane],
+                planes.normal_z[clip.clip_plane]
+            };
+            trace->results.surface      = bsp_map.brushsides[side_idx].texinfo; // Might be -1
+            //trace->contents = brush.contents; // TODO: Return hit contents in a better way
+        }
+    }
+    // --------- end of source-sdk-2013 code ---------
+}
+
+void CollidableWorld::DoUnsweptTrace_Brush(Trace* trace, uint32_t brush_idx)
+{
+    assert(trace->info.isswept == false);
+    ZoneScoped;
+
+    const BspMap& bsp_map = *pImpl->origin_bsp_map;
+    const Brush& brush = bsp_map.brushes[brush_idx];
+    if (!IsBrushSolidToPlayer(brush))
+        return;
+
+    // Ray traces skip bevel planes, the SIMD path doesn't handle that
+    if (trace->info.isray || pImpl->brush_planes == Corrade::Containers::NullOpt) {
+        DoUnsweptTrace_Brush_Scalar(trace, brush, bsp_map);
+        return;
+    }
+
+    if (!brush.num_sides)
+        return;
+
+    if (!IsBoxBehindBrushPlanes(*pImpl->brush_planes,
+                                pImpl->brush_planes->brush_ranges[brush_idx],
+                                trace->info.startpos, trace->info.extents))
+        return;
+
+    // If we got here, the trace intersects the brush
+    trace->results.startsolid   = true;
+    trace->results.allsolid     = true;
+    // Trace fraction of 1.0 is interpreted as nothing being hit.
+    // -> Need to set fraction to something below 1.0
+    trace->results.fraction     = 0.0f;
+    // Can't report a hit surface
+    trace->results.plane_normal = Vector3(0.0f, 0.0f, 0.0f);
+    trace->results.surface      = -1;
+}
+
+void coll::DoSweptTrace_Brush_Scalar(Trace* trace, const Brush& brush,
+                                     const BspMap& bsp_map)
+{
+    // -------- start of source-sdk-2013 code --------
+    // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
+    
     const Vector3 start = trace->info.startpos;
     const Vector3 end   = trace->info.startpos + trace->info.delta;
     const Vector3 mins = -trace->info.extents; // Box case only (!trace->info.isray)
@@ -71,11 +159,10 @@ void CollidableWorld::DoSweptTrace_Brush(Trace* trace, uint32_t brush_idx)
     float   d1, d2;
     float   f;
 
-    // @Optimization Ensure the 6 axial brushsides/planes are processed first
     for (int i = 0; i < brush.num_sides; i++)
     {
-        const BrushSide& side = pImpl->origin_bsp_map->brushsides[brush.first_side + i];
-        const Plane& plane    = pImpl->origin_bsp_map->planes[side.plane_num];
+        const BrushSide& side = bsp_map.brushsides[brush.first_side + i];
+        const Plane& plane    = bsp_map.planes[side.plane_num];
 
         if (trace->info.isray) // Special point case
         {
@@ -149,15 +236,9 @@ void CollidableWorld::DoSweptTrace_Brush(Trace* trace, uint32_t brush_idx)
     // --------- end of source-sdk-2013 code ---------
 }
 
-void CollidableWorld::DoUnsweptTrace_Brush(Trace* trace, uint32_t brush_idx)
+void coll::DoUnsweptTrace_Brush_Scalar(Trace* trace, const Brush& brush,
+                                       const BspMap& bsp_map)
 {
-    assert(trace->info.isswept == false);
-    ZoneScoped;
-
-    const Brush& brush = pImpl->origin_bsp_map->brushes[brush_idx];
-    if (!IsBrushSolidToPlayer(brush))
-        return;
-
     // -------- start of source-sdk-2013 code --------
     // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
     const Vector3 trace_pos = trace->info.startpos;
@@ -170,11 +251,10 @@ void CollidableWorld::DoUnsweptTrace_Brush(Trace* trace, uint32_t brush_idx)
     float   dist;
     Vector3 ofs;
 
-    // @Optimization Ensure the 6 axial brushsides/planes are processed first
     for (int i = 0; i < brush.num_sides; i++)
     {
-        const BrushSide& side = pImpl->origin_bsp_map->brushsides[brush.first_side + i];
-        const Plane& plane    = pImpl->origin_bsp_map->planes[side.plane_num];
+        const BrushSide& side = bsp_map.brushsides[brush.first_side + i];
+        const Plane& plane    = bsp_map.planes[side.plane_num];
 
         if (trace->info.isray) // Special point case
         {
@@ -213,3 +293,232 @@ void CollidableWorld::DoUnsweptTrace_Brush(Trace* trace, uint32_t brush_idx)
     //trace->contents = brush.contents; // TODO: Return hit contents in a better way
     // --------- end of source-sdk-2013 code ---------
 }
+
+size_t BrushPlanesSoA::GetMemorySize() const
+{
+    return sizeof(BrushPlanesSoA)
+        + brush_ranges.capacity() * sizeof(Range)
+        + normal_x.capacity() * sizeof(float)
+        + normal_y.capacity() * sizeof(float)
+        + normal_z.capacity() * sizeof(float)
+        + dist    .capacity() * sizeof(float)
+        + side_idx.capacity() * sizeof(uint32_t);
+}
+
+BrushPlanesSoA coll::Create_BrushPlanesSoA(const BspMap& bsp_map)
+{
+    ZoneScoped;
+
+    BrushPlanesSoA soa;
+    soa.brush_ranges.reserve(bsp_map.brushes.size());
+
+    // Upper bound of plane count, including padding
+    size_t max_plane_cnt = bsp_map.brushsides.size() + 3 * bsp_map.brushes.size();
+    soa.normal_x.reserve(max_plane_cnt);
+    soa.normal_y.reserve(max_plane_cnt);
+    soa.normal_z.reserve(max_plane_cnt);
+    soa.dist    .reserve(max_plane_cnt);
+    soa.side_idx.reserve(max_plane_cnt);
+
+    auto add_plane = [&soa](const Vector3& normal, float dist, uint32_t side_idx) {
+        soa.normal_x.push_back(normal.x());
+        soa.normal_y.push_back(normal.y());
+        soa.normal_z.push_back(normal.z());
+        soa.dist    .push_back(dist);
+        soa.side_idx.push_back(side_idx);
+    };
+
+    std::vector<uint32_t> side_indices;
+    for (const Brush& brush : bsp_map.brushes) {
+        BrushPlanesSoA::Range range;
+        range.first_plane = soa.normal_x.size();
+
+        // Put axial planes first. They are the most likely ones to let traces
+        // exit early.
+        side_indices.clear();
+        for (uint32_t i = 0; i < brush.num_sides; i++)
+            side_indices.push_back(brush.first_side + i);
+        std::stable_partition(side_indices.begin(), side_indices.end(),
+            [&bsp_map](uint32_t side_idx) {
+                const Vector3& n =
+                    bsp_map.planes[bsp_map.brushsides[side_idx].plane_num].normal;
+                int zero_cnt = (n.x() == 0.0f) + (n.y() == 0.0f) + (n.z() == 0.0f);
+                return zero_cnt == 2;
+            }
+        );
+
+        for (uint32_t side_idx : side_indices) {
+            const Plane& plane =
+                bsp_map.planes[bsp_map.brushsides[side_idx].plane_num];
+            add_plane(plane.normal, plane.dist, side_idx);
+        }
+
+        // Pad with dummy planes. Any box is behind them, so they never make
+        // traces exit early, never get crossed and never affect results.
+        while ((soa.normal_x.size() - range.first_plane) % 4 != 0)
+            add_plane({ 0.0f, 0.0f, 0.0f }, 1.0f, BrushPlanesSoA::INVALID_SIDE_IDX);
+
+        range.num_planes = soa.normal_x.size() - range.first_plane;
+        soa.brush_ranges.push_back(range);
+    }
+    return soa;
+}
+
+SweptBrushClipResult coll::ClipSweptBoxToBrushPlanes(
+    const BrushPlanesSoA& planes, BrushPlanesSoA::Range range,
+    const Vector3& start, const Vector3& end, const Vector3& extents)
+{
+    // -------- start of source-sdk-2013 code --------
+    // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
+
+    // NOTE: This is a SIMD version of the plane loop in
+    //       DoSweptTrace_Brush_Scalar(). Every arithmetic operation is done in
+    //       the same order as in the scalar code to get bit-identical results.
+
+    SweptBrushClipResult r = {
+        .in_front   = false,
+        .startout   = false,
+        .getout     = false,
+        .enterfrac  = NEVER_UPDATED,
+        .leavefrac  = 1.0f,
+        .clip_plane = UINT32_MAX,
+    };
+    uint32_t clip_side_idx = BrushPlanesSoA::INVALID_SIDE_IDX;
+
+    const fltx4 zero    = ReplicateX4(0.0f);
+    const fltx4 epsilon = ReplicateX4(DIST_EPSILON);
+    const fltx4 mins_x  = ReplicateX4(-extents.x());
+    const fltx4 mins_y  = ReplicateX4(-extents.y());
+    const fltx4 mins_z  = ReplicateX4(-extents.z());
+    const fltx4 maxs_x  = ReplicateX4(+extents.x());
+    const fltx4 maxs_y  = ReplicateX4(+extents.y());
+    const fltx4 maxs_z  = ReplicateX4(+extents.z());
+    const fltx4 start_x = ReplicateX4(start.x());
+    const fltx4 start_y = ReplicateX4(start.y());
+    const fltx4 start_z = ReplicateX4(start.z());
+    const fltx4 end_x   = ReplicateX4(end.x());
+    const fltx4 end_y   = ReplicateX4(end.y());
+    const fltx4 end_z   = ReplicateX4(end.z());
+
+    const uint32_t plane_end = range.first_plane + range.num_planes;
+    for (uint32_t i = range.first_plane; i < plane_end; i += 4)
+    {
+        fltx4 n_x = LoadUnalignedSIMD(&planes.normal_x[i]);
+        fltx4 n_y = LoadUnalignedSIMD(&planes.normal_y[i]);
+        fltx4 n_z = LoadUnalignedSIMD(&planes.normal_z[i]);
+
+        // Push the plane out apropriately for mins/maxs
+        fltx4 ofs_x = MaskedAssign(CmpLtSIMD(n_x, zero), maxs_x, mins_x);
+        fltx4 ofs_y = MaskedAssign(CmpLtSIMD(n_y, zero), maxs_y, mins_y);
+        fltx4 ofs_z = MaskedAssign(CmpLtSIMD(n_z, zero), maxs_z, mins_z);
+
+        fltx4 dist = AddSIMD(AddSIMD(MulSIMD(ofs_x, n_x), MulSIMD(ofs_y, n_y)),
+                             MulSIMD(ofs_z, n_z));
+        dist = SubSIMD(LoadUnalignedSIMD(&planes.dist[i]), dist);
+
+        fltx4 d1 = AddSIMD(AddSIMD(MulSIMD(start_x, n_x), MulSIMD(start_y, n_y)),
+                           MulSIMD(start_z, n_z));
+        fltx4 d2 = AddSIMD(AddSIMD(MulSIMD(  end_x, n_x), MulSIMD(  end_y, n_y)),
+                           MulSIMD(  end_z, n_z));
+        d1 = SubSIMD(d1, dist);
+        d2 = SubSIMD(d2, dist);
+
+        int d1_positive = TestSignSIMD(CmpGtSIMD(d1, zero));
+        int d2_positive = TestSignSIMD(CmpGtSIMD(d2, zero));
+
+        // If completely in front of face, no intersection
+        if (d1_positive & d2_positive) {
+            r.in_front = true;
+            return r;
+        }
+
+        if (d2_positive)
+            r.getout = true; // Endpoint is not in solid
+        if (d1_positive)
+            r.startout = true;
+
+        int crosses = d1_positive | d2_positive;
+        if (!crosses)
+            continue;
+
+        int enters = crosses & TestSignSIMD(CmpGtSIMD(d1, d2));
+
+        // Lanes that don't cross their face might get garbage here, but their
+        // values are never used.
+        fltx4 denom = SubSIMD(d1, d2);
+        alignas(16) float enter_f[4];
+        alignas(16) float leave_f[4];
+        StoreAlignedSIMD(enter_f, DivSIMD(SubSIMD(d1, epsilon), denom));
+        StoreAlignedSIMD(leave_f, DivSIMD(AddSIMD(d1, epsilon), denom));
+
+        for (int lane = 0; lane < 4; lane++) {
+            int lane_bit = 1 << lane;
+            if (!(crosses & lane_bit))
+                continue;
+
+            if (enters & lane_bit) {
+                // Resolve ties like the scalar code does: The first plane in
+                // brushside order wins.
+                float f = enter_f[lane];
+                uint32_t side_idx = planes.side_idx[i + lane];
+                bool is_tie = f == r.enterfrac
+                    && clip_side_idx != BrushPlanesSoA::INVALID_SIDE_IDX
+                    && side_idx < clip_side_idx;
+                if (f > r.enterfrac || is_tie) {
+                    r.enterfrac = f;
+                    r.clip_plane = i + lane;
+                    clip_side_idx = side_idx;
+                }
+            }
+            else {
+                if (leave_f[lane] < r.leavefrac)
+                    r.leavefrac = leave_f[lane];
+            }
+        }
+    }
+    return r;
+    // --------- end of source-sdk-2013 code ---------
+}
+
+bool coll::IsBoxBehindBrushPlanes(const BrushPlanesSoA& planes,
+    BrushPlanesSoA::Range range, const Vector3& pos, const Vector3& extents)
+{
+    // SIMD version of the plane loop in DoUnsweptTrace_Brush_Scalar()
+
+    const fltx4 zero   = ReplicateX4(0.0f);
+    const fltx4 mins_x = ReplicateX4(-extents.x());
+    const fltx4 mins_y = ReplicateX4(-extents.y());
+    const fltx4 mins_z = ReplicateX4(-extents.z());
+    const fltx4 maxs_x = ReplicateX4(+extents.x());
+    const fltx4 maxs_y = ReplicateX4(+extents.y());
+    const fltx4 maxs_z = ReplicateX4(+extents.z());
+    const fltx4 pos_x  = ReplicateX4(pos.x());
+    const fltx4 pos_y  = ReplicateX4(pos.y());
+    const fltx4 pos_z  = ReplicateX4(pos.z());
+
+    const uint32_t plane_end = range.first_plane + range.num_planes;
+    for (uint32_t i = range.first_plane; i < plane_end; i += 4)
+    {
+        fltx4 n_x = LoadUnalignedSIMD(&planes.normal_x[i]);
+        fltx4 n_y = LoadUnalignedSIMD(&planes.normal_y[i]);
+        fltx4 n_z = LoadUnalignedSIMD(&planes.normal_z[i]);
+
+        // Push the plane out apropriately for mins/maxs
+        fltx4 ofs_x = MaskedAssign(CmpLtSIMD(n_x, zero), maxs_x, mins_x);
+        fltx4 ofs_y = MaskedAssign(CmpLtSIMD(n_y, zero), maxs_y, mins_y);
+        fltx4 ofs_z = MaskedAssign(CmpLtSIMD(n_z, zero), maxs_z, mins_z);
+
+        fltx4 dist = AddSIMD(AddSIMD(MulSIMD(ofs_x, n_x), MulSIMD(ofs_y, n_y)),
+                             MulSIMD(ofs_z, n_z));
+        dist = SubSIMD(LoadUnalignedSIMD(&planes.dist[i]), dist);
+
+        fltx4 d1 = AddSIMD(AddSIMD(MulSIMD(pos_x, n_x), MulSIMD(pos_y, n_y)),
+                           MulSIMD(pos_z, n_z));
+        d1 = SubSIMD(d1, dist);
+
+        // If completely in front of any face, no intersection
+        if (TestSignSIMD(CmpGtSIMD(d1, zero)))
+            return false;
+    }
+    return true;
+}
@@ -1,11 +1,86 @@
 #ifndef COLL_COLLIDABLEWORLD_BRUSH_H_
 #define COLL_COLLIDABLEWORLD_BRUSH_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "coll/Trace.h"
+#include "csgo_parsing/BspMap.h"
+
 namespace coll {
 
+// Planes of brushes, stored in a structure-of-arrays layout to let traces
+// process 4 planes at once using SIMD.
+// Each brush's planes are ordered such that its axial planes come first, since
+// they are the most likely ones to let traces exit early. Each brush's plane
+// count is padded to a multiple of 4 using dummy planes that never affect trace
+// results.
+struct BrushPlanesSoA {
+    // Which planes belong to a brush
+    struct Range {
+        uint32_t first_plane; // Index into plane arrays
+        uint32_t num_planes;  // Multiple of 4, including dummy planes
+    };
+    std::vector<Range> brush_ranges; // Same indexing as the brushes it was created from
+
+    std::vector<float> normal_x;
+    std::vector<float> normal_y;
+    std::vector<float> normal_z;
+    std::vector<float> dist;
+
+    // Index into BspMap::brushsides of each plane's brushside.
+    // Dummy planes have an index of INVALID_SIDE_IDX.
+    // Within a brush, these indices are not sorted because of the plane order!
+    std::vector<uint32_t> side_idx;
+    static constexpr uint32_t INVALID_SIDE_IDX = UINT32_MAX;
+
+    size_t GetMemorySize() const;
+};
+
+// Creates SoA planes of all brushes of the given map.
+BrushPlanesSoA Create_BrushPlanesSoA(const csgo_parsing::BspMap& bsp_map);
+
+// Intermediate results of clipping a swept box against the planes of a brush.
+// Names and meanings are identical to the variables of source-sdk-2013's brush
+// clipping code (see CollidableWorld::DoSweptTrace_Brush()).
+struct SweptBrushClipResult {
+    bool     in_front;   // If true, trace is entirely in front of a plane and
+                         // none of the other values were computed!
+    bool     startout;
+    bool     getout;
+    float    enterfrac;
+    float    leavefrac;
+    uint32_t clip_plane; // Index into plane arrays, plane that set enterfrac
+                         // (UINT32_MAX if enterfrac was never updated)
+};
+
+// Clips a swept box against the given range of SoA planes. The box is given by
+// start position, end position and extents (half size), all centered.
+// Results are bit-identical to those of source-sdk-2013's scalar plane loop,
+// regardless of plane order: If multiple planes produce the same enterfrac,
+// the plane with the lowest brushside index is chosen, just like the scalar
+// loop would choose the first one in brushside order.
+SweptBrushClipResult ClipSweptBoxToBrushPlanes(const BrushPlanesSoA& planes,
+    BrushPlanesSoA::Range range, const Magnum::Vector3& start,
+    const Magnum::Vector3& end, const Magnum::Vector3& extents);
 
-    // ... (Add further brush-related collision code here)
+// Returns true if a box at the given position with the given extents (half
+// size) is behind or on all planes of the given range of SoA planes.
+bool IsBoxBehindBrushPlanes(const BrushPlanesSoA& planes,
+    BrushPlanesSoA::Range range, const Magnum::Vector3& pos,
+    const Magnum::Vector3& extents);
 
+// Scalar reference implementations of brush traces, ported from
+// source-sdk-2013. Used for ray traces and to verify the SIMD implementation.
+void DoSweptTrace_Brush_Scalar  (Trace* trace,
+                                 const csgo_parsing::BspMap::Brush& brush,
+                                 const csgo_parsing::BspMap& bsp_map);
+void DoUnsweptTrace_Brush_Scalar(Trace* trace,
+                                 const csgo_parsing::BspMap::Brush& brush,
+                                 const csgo_parsing::BspMap& bsp_map);
 
 } // namespace coll
 
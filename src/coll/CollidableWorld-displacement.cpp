@@ -1,10 +1,14 @@
 #include "coll/CollidableWorld-displacement.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <functional> // for std::hash
 #include <string_view>
+#include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include <Tracy.hpp>
 
@@ -85,10 +89,138 @@ void CollidableWorld::DoSweptTrace_Displacement(Trace* trace,
         // AABBTree_SweepAABB.
         // Displacement collision cache might be created.
         // CAUTION: Not thread-safe yet!
+        bool had_cache = hull_dispcoll.IsCacheGenerated();
         hull_dispcoll.AABBTree_SweepAABB(trace); // Returns true on hit
+
+        if (pImpl->disp_cache_policy.mode == DispCachePolicy::Mode::LAZY_BUDGET)
+            pImpl->disp_cache_last_use_tick[dispcoll_idx] = pImpl->disp_cache_tick_cnt;
+
+        if (!had_cache && hull_dispcoll.IsCacheGenerated())
+            OnDispCacheCreated(dispcoll_idx);
+    }
+}
+
+void CollidableWorld::OnDispCacheCreated(uint32_t dispcoll_idx)
+{
+    std::vector<CDispCollTree>& hull_disp_coll_trees = *pImpl->hull_disp_coll_trees;
+    DispCacheStats& stats = pImpl->disp_cache_stats;
+
+    pImpl->disp_cache_builds_cur_tick++;
+    stats.builds_total++;
+    stats.num_cached++;
+    stats.cache_bytes += hull_disp_coll_trees[dispcoll_idx].GetCacheMemorySize();
+
+    if (pImpl->disp_cache_policy.mode == DispCachePolicy::Mode::LAZY_BUDGET)
+        EnforceDispCacheBudget(dispcoll_idx);
+}
+
+void CollidableWorld::EnforceDispCacheBudget(uint32_t keep_dispcoll_idx)
+{
+    ZoneScoped;
+    DispCacheStats& stats = pImpl->disp_cache_stats;
+    if (stats.cache_bytes <= pImpl->disp_cache_policy.budget_bytes)
+        return;
+
+    std::vector<CDispCollTree>& hull_disp_coll_trees = *pImpl->hull_disp_coll_trees;
+    const std::vector<uint64_t>& last_use = pImpl->disp_cache_last_use_tick;
+
+    // Displacements the player recently collided with are near the player.
+    // Destroy caches of the least recently used displacements first.
+    std::vector<uint32_t> candidates;
+    for (uint32_t i = 0; i < hull_disp_coll_trees.size(); i++)
+        if (i != keep_dispcoll_idx && hull_disp_coll_trees[i].IsCacheGenerated())
+            candidates.push_back(i);
+    std::sort(candidates.begin(), candidates.end(),
+        [&last_use](uint32_t a, uint32_t b) {
+            if (last_use[a] != last_use[b]) return last_use[a] < last_use[b];
+            return a < b;
+        }
+    );
+
+    for (uint32_t idx : candidates) {
+        if (stats.cache_bytes <= pImpl->disp_cache_policy.budget_bytes)
+            break;
+        stats.cache_bytes -= hull_disp_coll_trees[idx].GetCacheMemorySize();
+        stats.num_cached--;
+        stats.evictions_total++;
+        hull_disp_coll_trees[idx].Uncache();
     }
 }
 
+void CollidableWorld::PrebuildAllDispCaches()
+{
+    ZoneScoped;
+    std::vector<CDispCollTree>& hull_disp_coll_trees = *pImpl->hull_disp_coll_trees;
+
+    // Each thread creates caches of different displacements
+    std::atomic<size_t> next_idx = 0;
+    auto worker = [&hull_disp_coll_trees, &next_idx]() {
+        for (size_t i = next_idx++; i < hull_disp_coll_trees.size(); i = next_idx++)
+            hull_disp_coll_trees[i].EnsureCacheIsCreated();
+    };
+#ifdef DZSIM_WEB_PORT
+    worker(); // No threads in the web port
+#else
+    size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(),
+                                            1, std::max<size_t>(hull_disp_coll_trees.size(), 1));
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads)
+        t.join();
+#endif
+
+    // Recount, some caches might have existed already
+    DispCacheStats& stats = pImpl->disp_cache_stats;
+    size_t num_new = hull_disp_coll_trees.size() - stats.num_cached;
+    pImpl->disp_cache_builds_cur_tick += num_new;
+    stats.builds_total += num_new;
+    stats.num_cached  = hull_disp_coll_trees.size();
+    stats.cache_bytes = 0;
+    for (const CDispCollTree& dispcoll : hull_disp_coll_trees)
+        stats.cache_bytes += dispcoll.GetCacheMemorySize();
+}
+
+void CollidableWorld::SetDispCachePolicy(const DispCachePolicy& policy)
+{
+    using Mode = DispCachePolicy::Mode;
+    DispCachePolicy& cur = pImpl->disp_cache_policy;
+    if (policy.mode == cur.mode && policy.budget_bytes == cur.budget_bytes)
+        return;
+    cur = policy;
+
+    if (pImpl->hull_disp_coll_trees == Corrade::Containers::NullOpt)
+        return;
+
+    if (cur.mode == Mode::LAZY_BUDGET)
+        pImpl->disp_cache_last_use_tick.resize(pImpl->hull_disp_coll_trees->size(), 0);
+    else
+        pImpl->disp_cache_last_use_tick = {};
+
+    if (cur.mode == Mode::PREBUILD)
+        PrebuildAllDispCaches();
+    else if (cur.mode == Mode::LAZY_BUDGET)
+        EnforceDispCacheBudget(UINT32_MAX);
+}
+
+const CollidableWorld::DispCachePolicy& CollidableWorld::GetDispCachePolicy() const
+{
+    return pImpl->disp_cache_policy;
+}
+
+const CollidableWorld::DispCacheStats& CollidableWorld::GetDispCacheStats() const
+{
+    return pImpl->disp_cache_stats;
+}
+
+void CollidableWorld::OnSimulationTickFinished()
+{
+    pImpl->disp_cache_stats.builds_last_tick = pImpl->disp_cache_builds_cur_tick;
+    pImpl->disp_cache_builds_cur_tick = 0;
+    pImpl->disp_cache_tick_cnt++;
+}
+
 void CollidableWorld::DoUnsweptTrace_Displacement(Trace* trace,
                                                   uint32_t dispcoll_idx)
 {
@@ -704,7 +836,9 @@ private:
 // @Optimization Is 512 a good default bucket count?
 //               Theoretical max of unique keys during current usage is 672.
 //               Test if 512 are enough buckets? Do allocations occur?
-static std::unordered_set<DispCollPlaneIndex_t, CPlaneIndexHashFuncs>
+// NOTE: thread_local to allow creating caches of different displacements in
+//       parallel.
+static thread_local std::unordered_set<DispCollPlaneIndex_t, CPlaneIndexHashFuncs>
                                                   g_DispCollPlaneIndexHash(512);
 
 
@@ -781,9 +915,9 @@ void CDispCollTri::FindMinMax(std::vector<Vector3>& m_aVerts)
     SetMax(2, iMax);
 }
 
-// NOTE: DZSimulator does not support SIMD for now. Furthermore, all CDispVector
-//       that were 16-aligned have been replaced with unaligned std::vector. Is
-//       their alignment necessary for SIMD?
+// NOTE: All CDispVector that were 16-aligned in source-sdk-2013 have been
+//       replaced with std::vector. Node AABBs are still 16-aligned, since
+//       FourVectors is an over-aligned type.
 
 // Intersecting with the quad tree. Returned value explanation:
 // if (retval & 1) then box of SW node child was hit
@@ -791,130 +925,71 @@ void CDispCollTri::FindMinMax(std::vector<Vector3>& m_aVerts)
 // if (retval & 4) then box of NW node child was hit
 // if (retval & 8) then box of NE node child was hit
 static FORCEINLINE int IntersectRayWithFourBoxes(
-    // ==== Original arguments from source-sdk-2013 that utilize SIMD
-    ////const FourVectors& rayStart, const FourVectors& invDelta,
-    ////const FourVectors& rayExtents,
-    ////const FourVectors& boxMins, const FourVectors& boxMaxs
-    // ==== Non-SIMD replacements of the arguments above
-    const Vector3& rayStart, const Vector3& invDelta, const Vector3& rayExtents,
-    const Vector3(&boxMins)[4], const Vector3(&boxMaxs)[4]
-    // ==== end of replacement
-)
+    const FourVectors& rayStart, const FourVectors& invDelta,
+    const FourVectors& rayExtents,
+    const FourVectors& boxMins, const FourVectors& boxMaxs)
 {
-    // ==== The following code is the original function body from source-sdk-2013
-    //      that utilizes SIMD.
-    
-    ////// SIMD Test ray against all four boxes at once.
-    ////// Each node stores the bboxes of its four children.
-    ////FourVectors hitMins = boxMins;
-    ////FourVectors hitMaxs = boxMaxs;
-    ////hitMins -= rayStart;
-    ////hitMaxs -= rayStart;
-    ////
-    ////// Adjust for swept box by enlarging the child bounds to shrink the sweep
-    ////// down to a point
-    ////hitMins -= rayExtents;
-    ////hitMaxs += rayExtents;
-    ////
-    ////// Compute the parametric distance along the ray of intersection in each
-    ////// dimension
-    ////hitMins *= invDelta;
-    ////hitMaxs *= invDelta;
-    ////
-    ////// Find the exit parametric intersection distance in each dimension, for each box
-    ////FourVectors exitT = maximum(hitMins, hitMaxs);
-    ////// Find the entry parametric intersection distance in each dimension, for each box
-    ////FourVectors entryT = minimum(hitMins, hitMaxs);
-    ////
-    ////// Now find the max overall entry distance across all dimensions for each box
-    ////fltx4 minTemp = MaxSIMD(entryT.x, entryT.y);
-    ////fltx4 boxEntryT = MaxSIMD(minTemp, entryT.z);
-    ////// Now find the min overall exit distance across all dimensions for each box
-    ////fltx4 maxTemp = MinSIMD(exitT.x, exitT.y);
-    ////fltx4 boxExitT = MinSIMD(maxTemp, exitT.z);
-    ////
-    ////boxEntryT = MaxSIMD(boxEntryT, Four_Zeros);
-    ////boxExitT  = MinSIMD(boxExitT,  Four_Ones );
-    ////
-    ////// If entry<=exit for the box, we've got a hit.
-    ////fltx4 active = CmpLeSIMD(boxEntryT, boxExitT); // Mask of which boxes are active
-    ////
-    ////// Hit at least one box?
-    ////return TestSignSIMD(active);
-
-    // ==== The following code is the non-SIMD replacement of the code above.
-    int hit_mask = 0;
-    for (int child_idx = 0; child_idx < 4; child_idx++) {
-        Vector3 hit_mins = boxMins[child_idx];
-        Vector3 hit_maxs = boxMaxs[child_idx];
-        // Offset AABB to make trace start at origin
-        hit_mins -= rayStart;
-        hit_maxs -= rayStart;
-        // Adjust for swept box by enlarging the child bounds to shrink the sweep
-        // down to a point
-        hit_mins -= rayExtents;
-        hit_maxs += rayExtents;
-        // Compute the parametric distance along the ray of intersection in each
-        // dimension
-        hit_mins *= invDelta;
-        hit_maxs *= invDelta;
-        // Find the max overall entry time across all dimensions
-        float box_entry_t =                  Math::min(hit_mins.x(), hit_maxs.x());
-        box_entry_t = Math::max(box_entry_t, Math::min(hit_mins.y(), hit_maxs.y()));
-        box_entry_t = Math::max(box_entry_t, Math::min(hit_mins.z(), hit_maxs.z()));
-        // Find the min overall exit time across all dimensions
-        float box_exit_t  =                  Math::max(hit_mins.x(), hit_maxs.x());
-        box_exit_t  = Math::min(box_exit_t,  Math::max(hit_mins.y(), hit_maxs.y()));
-        box_exit_t  = Math::min(box_exit_t,  Math::max(hit_mins.z(), hit_maxs.z()));
-        // Make sure hit check in the end does not succeed if the hit occurs
-        // before the trace start time (t=0) or after the trace end time (t=1).
-        box_entry_t = Math::max(box_entry_t, 0.0f);
-        box_exit_t  = Math::min(box_exit_t,  1.0f);
-
-        if (box_entry_t <= box_exit_t) // If entry <= exit, we've got a hit
-            hit_mask |= 1 << child_idx;
-    }
-    return hit_mask;
+    // SIMD Test ray against all four boxes at once.
+    // Each node stores the bboxes of its four children.
+    FourVectors hitMins = boxMins;
+    FourVectors hitMaxs = boxMaxs;
+    hitMins -= rayStart;
+    hitMaxs -= rayStart;
+
+    // Adjust for swept box by enlarging the child bounds to shrink the sweep
+    // down to a point
+    hitMins -= rayExtents;
+    hitMaxs += rayExtents;
+
+    // Compute the parametric distance along the ray of intersection in each
+    // dimension
+    hitMins *= invDelta;
+    hitMaxs *= invDelta;
+
+    // Find the exit parametric intersection distance in each dimension, for each box
+    FourVectors exitT = maximum(hitMins, hitMaxs);
+    // Find the entry parametric intersection distance in each dimension, for each box
+    FourVectors entryT = minimum(hitMins, hitMaxs);
+
+    // Now find the max overall entry distance across all dimensions for each box
+    fltx4 minTemp = MaxSIMD(entryT.x, entryT.y);
+    fltx4 boxEntryT = MaxSIMD(minTemp, entryT.z);
+    // Now find the min overall exit distance across all dimensions for each box
+    fltx4 maxTemp = MinSIMD(exitT.x, exitT.y);
+    fltx4 boxExitT = MinSIMD(maxTemp, exitT.z);
+
+    boxEntryT = MaxSIMD(boxEntryT, Four_Zeros());
+    boxExitT  = MinSIMD(boxExitT,  Four_Ones ());
+
+    // If entry<=exit for the box, we've got a hit.
+    fltx4 active = CmpLeSIMD(boxEntryT, boxExitT); // Mask of which boxes are active
+
+    // Hit at least one box?
+    return TestSignSIMD(active);
 }
 
 // This does 4 simultaneous box intersections
 // NOTE: This can be used as a 1 vs 4 test by replicating a single box into the
 // one side
 static FORCEINLINE int IntersectFourBoxPairs(
-    // ==== Original arguments from source-sdk-2013 that utilize SIMD
-    ////const FourVectors& mins0, const FourVectors& maxs0,
-    ////const FourVectors& mins1, const FourVectors& maxs1
-    // ==== Non-SIMD replacements of the arguments above
-    const Vector3& mins0, const Vector3& maxs0,
-    const Vector3(&mins1)[4], const Vector3(&maxs1)[4]
-    // ==== end of replacement
-)
+    const FourVectors& mins0, const FourVectors& maxs0,
+    const FourVectors& mins1, const FourVectors& maxs1)
 {
-    // ==== The following code is the original function body from source-sdk-2013
-    //      that utilizes SIMD.
-
-    ////// Find the max mins and min maxs in each dimension
-    ////FourVectors intersectMins = maximum(mins0, mins1);
-    ////FourVectors intersectMaxs = minimum(maxs0, maxs1);
-    //// 
-    ////// If intersectMins <= intersectMaxs then the boxes overlap in this dimension
-    ////fltx4 overlapX = CmpLeSIMD(intersectMins.x, intersectMaxs.x);
-    ////fltx4 overlapY = CmpLeSIMD(intersectMins.y, intersectMaxs.y);
-    ////fltx4 overlapZ = CmpLeSIMD(intersectMins.z, intersectMaxs.z);
-    //// 
-    ////// If the boxes overlap in all three dimensions, they intersect
-    ////fltx4 tmp = AndSIMD(overlapX, overlapY);
-    ////fltx4 active = AndSIMD(tmp, overlapZ);
-    //// 
-    ////// Hit at least one box?
-    ////return TestSignSIMD(active);
-
-    // ==== The following code is the non-SIMD replacement of the code above.
-    int hit_mask = 0;
-    for (int child_idx = 0; child_idx < 4; child_idx++)
-        if (AabbIntersectsAabb(mins0, maxs0, mins1[child_idx], maxs1[child_idx]))
-            hit_mask |= 1 << child_idx;
-    return hit_mask;
+    // Find the max mins and min maxs in each dimension
+    FourVectors intersectMins = maximum(mins0, mins1);
+    FourVectors intersectMaxs = minimum(maxs0, maxs1);
+
+    // If intersectMins <= intersectMaxs then the boxes overlap in this dimension
+    fltx4 overlapX = CmpLeSIMD(intersectMins.x, intersectMaxs.x);
+    fltx4 overlapY = CmpLeSIMD(intersectMins.y, intersectMaxs.y);
+    fltx4 overlapZ = CmpLeSIMD(intersectMins.z, intersectMaxs.z);
+
+    // If the boxes overlap in all three dimensions, they intersect
+    fltx4 tmp = AndSIMD(overlapX, overlapY);
+    fltx4 active = AndSIMD(tmp, overlapZ);
+
+    // Hit at least one box?
+    return TestSignSIMD(active);
 }
 
 int FORCEINLINE CDispCollTree::BuildRayLeafList(int iNode, rayleaflist_t& list)
@@ -1074,16 +1149,10 @@ void CDispCollTree::AABBTree_GenerateBoxes_r(int nodeIndex,
             AddPointToBounds(childMaxs[i], *pMins, *pMaxs);
         }
 
-        // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-        ////m_nodes[nodeIndex].m_mins.LoadAndSwizzle(childMins[0], childMins[1],
-        ////                                         childMins[2], childMins[3]);
-        ////m_nodes[nodeIndex].m_maxs.LoadAndSwizzle(childMaxs[0], childMaxs[1],
-        ////                                         childMaxs[2], childMaxs[3]);
-        // ==== The following is the non-SIMD replacement of the code above.
-        for (int i = 0; i < 4; i++) {
-            m_nodes[nodeIndex].m_mins[i] = childMins[i];
-            m_nodes[nodeIndex].m_maxs[i] = childMaxs[i];
-        }
+        m_nodes[nodeIndex].m_mins.LoadAndSwizzle(childMins[0], childMins[1],
+                                                 childMins[2], childMins[3]);
+        m_nodes[nodeIndex].m_maxs.LoadAndSwizzle(childMaxs[0], childMaxs[1],
+                                                 childMaxs[2], childMaxs[3]);
     }
 }
 
@@ -1129,6 +1198,11 @@ void CDispCollTree::Uncache() {
     m_aEdgePlanes = {};
 }
 
+size_t CDispCollTree::GetCacheMemorySize() const {
+    return m_aTrisCache .capacity() * sizeof(CDispCollTriCache)
+         + m_aEdgePlanes.capacity() * sizeof(Vector3);
+}
+
 bool CDispCollTree::AABBTree_Ray(Trace* trace, bool bSide)
 {
     // Check for ray test.
@@ -1158,15 +1232,9 @@ void CDispCollTree::AABBTree_TreeTrisRayTest(Trace* trace, int iNode,
 {
     rayleaflist_t list;
     // NOTE: This part is loop invariant - should be hoisted up as far as possible
-    // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-    ////list.invDelta.DuplicateVector(trace->info.invdelta);
-    ////list.rayStart.DuplicateVector(trace->info.startpos);
-    ////list.rayExtents.DuplicateVector(trace->info.extents + g_Vec3DispCollEpsilons);
-    // ==== The following is the non-SIMD replacement of the code above.
-    list.invDelta   = trace->info.invdelta;
-    list.rayStart   = trace->info.startpos;
-    list.rayExtents = trace->info.extents + g_Vec3DispCollEpsilons;
-    // ==== end of replacement
+    list.invDelta.DuplicateVector(trace->info.invdelta);
+    list.rayStart.DuplicateVector(trace->info.startpos);
+    list.rayExtents.DuplicateVector(trace->info.extents + g_Vec3DispCollEpsilons);
     
     int listIndex = BuildRayLeafList(iNode, list);
     for (; listIndex <= list.maxIndex; listIndex++) {
@@ -1214,16 +1282,10 @@ bool CDispCollTree::AABBTree_IntersectAABB(const Vector3& absMins,
     int maxIndex = 0;
 
     // NOTE: This part is loop invariant - should be hoisted up as far as possible
-    // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-    ////FourVectors mins0;
-    ////mins0.DuplicateVector(absMins);
-    ////FourVectors maxs0;
-    ////maxs0.DuplicateVector(absMaxs);
-    ////FourVectors rayExtents;
-    // ==== The following is the non-SIMD replacement of the code above.
-    Vector3 mins0 = absMins;
-    Vector3 maxs0 = absMaxs;
-    // ==== end of replacement
+    FourVectors mins0;
+    mins0.DuplicateVector(absMins);
+    FourVectors maxs0;
+    maxs0.DuplicateVector(absMaxs);
 
     while (listIndex <= maxIndex) {
         int iNode = nodeList[listIndex];
@@ -1302,15 +1364,9 @@ bool CDispCollTree::AABBTree_SweepAABB(Trace* trace)
     // Test ray against the triangles in the list.
     rayleaflist_t list;
     // NOTE: This part is loop invariant - should be hoisted up as far as possible
-    // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-    ////list.invDelta.DuplicateVector(trace->info.invdelta);
-    ////list.rayStart.DuplicateVector(trace->info.startpos);
-    ////list.rayExtents.DuplicateVector(trace->info.extents + g_Vec3DispCollEpsilons);
-    // ==== The following is the non-SIMD replacement of the code above.
-    list.invDelta   = trace->info.invdelta;
-    list.rayStart   = trace->info.startpos;
-    list.rayExtents = trace->info.extents + g_Vec3DispCollEpsilons;
-    // ==== end of replacement
+    list.invDelta.DuplicateVector(trace->info.invdelta);
+    list.rayStart.DuplicateVector(trace->info.startpos);
+    list.rayExtents.DuplicateVector(trace->info.extents + g_Vec3DispCollEpsilons);
 
     int listIndex = BuildRayLeafList(0, list);
 
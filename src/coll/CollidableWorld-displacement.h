@@ -8,6 +8,7 @@
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
 
+#include "coll/SimdMath.h"
 #include "coll/Trace.h"
 #include "csgo_parsing/BspMap.h"
 
@@ -92,14 +93,9 @@ public:
 class CDispCollNode
 {
 public:
-    // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-    ////FourVectors m_mins;
-    ////FourVectors m_maxs;
-    
-    // ==== The following is the non-SIMD replacement of the code above.
     // AABBs of all 4 node children, index 0=SW, 1=SE, 2=NW, 3=NE
-    Magnum::Vector3 m_mins[4];
-    Magnum::Vector3 m_maxs[4];
+    FourVectors m_mins;
+    FourVectors m_maxs;
 };
 
 class CDispCollLeaf
@@ -114,15 +110,9 @@ const int MAX_AABB_LIST       = 344;
 
 struct rayleaflist_t
 {
-    // ==== The following is the original source-sdk-2013 code that utilizes SIMD.
-    ////FourVectors rayStart;
-    ////FourVectors rayExtents;
-    ////FourVectors invDelta;
-    // ==== The following is the non-SIMD replacement of the code above.
-    Magnum::Vector3 rayStart;
-    Magnum::Vector3 rayExtents;
-    Magnum::Vector3 invDelta;
-    // ==== end of replacement
+    FourVectors rayStart;
+    FourVectors rayExtents;
+    FourVectors invDelta;
 
     int nodeList[MAX_AABB_LIST];
     int maxIndex;
@@ -167,8 +157,9 @@ public:
     inline int Nodes_GetIndexFromComponents(int x, int y) const;
 
     bool IsCacheGenerated() const;
-    void EnsureCacheIsCreated();
+    void EnsureCacheIsCreated(); // Thread-safe if called on different objects
     void Uncache();
+    size_t GetCacheMemorySize() const; // In bytes
 
 private:
     void AABBTree_Create      (const std::vector<Magnum::Vector3>& disp_vertices);
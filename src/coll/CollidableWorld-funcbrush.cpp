@@ -1,17 +1,20 @@
 #include "coll/CollidableWorld-funcbrush.h"
 
+#include <cassert>
 #include <cstdint>
 #include <string>
 #include <vector>
 
 #include <Tracy.hpp>
 
+#include <Corrade/Containers/Optional.h>
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Angle.h>
 #include <Magnum/Math/Matrix4.h>
 #include <Magnum/Math/Vector3.h>
 
 #include "coll/CollidableWorld.h"
+#include "coll/CollidableWorld-brush.h"
 #include "coll/CollidableWorld_Impl.h"
 #include "coll/Trace.h"
 #include "csgo_parsing/BrushSeparation.h"
@@ -33,239 +36,244 @@ uint64_t CollidableWorld::GetTraceCost_FuncBrush(uint32_t func_brush_idx)
     return 1; // Is func_brush trace cost dependent on total brushside count?
 }
 
-void CollidableWorld::DoSweptTrace_FuncBrush(Trace* trace,
-                                             uint32_t func_brush_idx)
+// NOTE: Collision with func_brush entities was not thoroughly tested and
+//       the Source engine might be using an entirely different collision
+//       algorithm for func_brush specifically. (?)
+//       It's possible that further bevel planes need to be created and
+//       tested against when doing hull traces, in the same way we already
+//       do it for collisions with static/dynamic props.
+//       Maybe like this: https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/map.cpp#L463-L611
+//       Maybe useful:    https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/ivp.cpp#L1340
+
+// Ray traces don't collide with bevel planes, and dummy planes are skipped.
+static bool IsRayTracedPlane(const BrushPlanesSoA& planes, uint32_t plane_idx,
+                             const BspMap& bsp_map)
 {
-    assert(trace->info.isswept);
-    ZoneScoped;
+    uint32_t side_idx = planes.side_idx[plane_idx];
+    return side_idx != BrushPlanesSoA::INVALID_SIDE_IDX
+        && !bsp_map.brushsides[side_idx].bevel;
+}
 
-    // NOTE: Collision with func_brush entities was not thoroughly tested and
-    //       the Source engine might be using an entirely different collision
-    //       algorithm for func_brush specifically. (?)
-    //       It's possible that further bevel planes need to be created and
-    //       tested against when doing hull traces, in the same way we already
-    //       do it for collisions with static/dynamic props.
-    //       Maybe like this: https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/map.cpp#L463-L611
-    //       Maybe useful:    https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/ivp.cpp#L1340
-
-    // @OPTIMIZATION This function is pretty inefficient. However, there are
-    //               only very few func_brush entities in DZ maps, so it might
-    //               not matter.
-
-    std::shared_ptr<const BspMap> bsp_map = pImpl->origin_bsp_map;
-    const Ent_func_brush& func_brush = bsp_map->entities_func_brush[func_brush_idx];
-    if (!func_brush.IsSolid())
-        return; // Skip this func_brush
-
-    Vector3 translated_trace_start = trace->info.startpos - func_brush.origin;
-
-    // Order of axis rotations is important! First roll, then pitch, then yaw rotation!
-    // @Optimization Use 3x3 rotation matrix, not 4x4, or quaternions
-    Matrix4 rot_transformation =
-        Matrix4::rotationZ(Deg{ func_brush.angles[1] }) * // (yaw)   rotation around z axis
-        Matrix4::rotationY(Deg{ func_brush.angles[0] }) * // (pitch) rotation around y axis
-        Matrix4::rotationX(Deg{ func_brush.angles[2] });  // (roll)  rotation around x axis
+// Scalar version of ClipSweptBoxToBrushPlanes() for ray traces, which skip
+// bevel planes.
+static SweptBrushClipResult ClipSweptRayToBrushPlanes(
+    const BrushPlanesSoA& planes, BrushPlanesSoA::Range range,
+    const Vector3& start, const Vector3& end, const BspMap& bsp_map)
+{
+    // -------- start of source-sdk-2013 code --------
+    // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
+    SweptBrushClipResult r = {
+        .in_front   = false,
+        .startout   = false,
+        .getout     = false,
+        .enterfrac  = NEVER_UPDATED,
+        .leavefrac  = 1.0f,
+        .clip_plane = UINT32_MAX,
+    };
+
+    for (uint32_t i = range.first_plane; i < range.first_plane + range.num_planes; i++) {
+        if (!IsRayTracedPlane(planes, i, bsp_map))
+            continue;
 
-    if (func_brush.model.size() == 0 || func_brush.model[0] != '*')
-        return; // Invalid, abort
-    std::string idxStr = func_brush.model.substr(1);
-    int64_t modelIdx = utils::ParseIntFromString(idxStr, -1);
-    if (modelIdx <= 0 || modelIdx >= (int64_t)bsp_map->models.size())
-        return; // Invalid model index, abort
+        Vector3 normal = { planes.normal_x[i], planes.normal_y[i], planes.normal_z[i] };
+        float dist = planes.dist[i];
+        float d1 = Math::dot(start, normal) - dist;
+        float d2 = Math::dot(  end, normal) - dist;
 
-    // NOTE: Rarely in CSGO maps, brushes have invalid brushsides/planes, i.e.
-    //       they result in an AABB where (maxs[i] <= mins[i]) for some i.
-    //       For the most part, we don't care about these rare cases, except for
-    //       one func_brush in CSGO's "Only Up!" map by leander.
-    //       (https://steamcommunity.com/sharedfiles/filedetails/?id=3012684086)
-    bool are_we_in_csgo_only_up_map =
-        bsp_map->map_version == 2915 && bsp_map->sky_name.compare("vertigoblue_hdr") == 0;
+        // If completely in front of face, no intersection
+        if (d1 > 0.0f && d2 > 0.0f) {
+            r.in_front = true;
+            return r;
+        }
 
-    for (size_t brush_idx : bsp_map->GetModelBrushIndices(modelIdx)) {
-        const Brush& brush = bsp_map->brushes[brush_idx];
+        if (d2 > 0.0f)
+            r.getout = true; // Endpoint is not in solid
+        if (d1 > 0.0f)
+            r.startout = true;
 
-        // Special case: grenadeclip brushes don't work in func_brush entities
-        // (for unknown reasons)
-        static auto test_f_exclude =
-            BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::GRENADECLIP);
-        if (test_f_exclude.first && test_f_exclude.first(brush))
+        if (d1 <= 0.0f && d2 <= 0.0f)
             continue;
 
-        static auto test_f_1 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::SOLID);
-        static auto test_f_2 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::PLAYERCLIP);
-        static auto test_f_3 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::LADDER);
-
-        bool solid_to_player = false;
-        if (test_f_1.first && test_f_1.first(brush)) solid_to_player = true;
-        if (test_f_2.first && test_f_2.first(brush)) solid_to_player = true;
-        if (test_f_3.first && test_f_3.first(brush)) solid_to_player = true;
-        if (!solid_to_player)
-            continue;
+        // Crosses face
+        if (d1 > d2) {
+            // Enter
+            float f = (d1 - DIST_EPSILON) / (d1 - d2);
+            if (f > r.enterfrac) {
+                r.enterfrac = f;
+                r.clip_plane = i;
+            }
+        }
+        else {
+            // Leave
+            float f = (d1 + DIST_EPSILON) / (d1 - d2);
+            if (f < r.leavefrac)
+                r.leavefrac = f;
+        }
+    }
+    return r;
+    // --------- end of source-sdk-2013 code ---------
+}
 
-        // @Optimization Ensure the 6 axial brushsides/planes are processed first.
-        std::vector<Plane> planes;
-        for (int i = 0; i < brush.num_sides; i++) {
-            const BrushSide& side = bsp_map->brushsides[brush.first_side + i];
+void CollidableWorld::DoSweptTrace_FuncBrush(Trace* trace,
+                                             uint32_t func_brush_idx)
+{
+    assert(trace->info.isswept);
+    ZoneScoped;
 
-            if (trace->info.isray && side.bevel)
-                continue;
+    if (pImpl->func_brush_trace_data == Corrade::Containers::NullOpt) {
+        assert(false && "func_brush trace data wasn't created!");
+        return;
+    }
+    const FuncBrushTraceData& data = *pImpl->func_brush_trace_data;
+    const FuncBrushTraceData::FuncBrush& func_brush = data.func_brushes[func_brush_idx];
+    const BrushPlanesSoA& planes = data.planes;
 
-            // HACKHACK A specific brush in the CSGO Only Up map (by leander)
-            //          has 2 invalid planes that cause issues, skip these.
-            if (are_we_in_csgo_only_up_map && brush_idx == 2537)
-                if (i == 26 || i == 30)
-                    continue;
+    // Planes are already rotated, only translate the trace
+    const Vector3 start = trace->info.startpos - func_brush.origin;
+    const Vector3 end   = start + trace->info.delta;
 
-            Plane plane = bsp_map->planes[side.plane_num];
-            plane.normal = rot_transformation.transformVector(plane.normal);
-            planes.push_back(plane);
-        }
+    for (uint32_t brush_idx = func_brush.first_brush;
+         brush_idx < func_brush.first_brush + func_brush.num_brushes;
+         brush_idx++)
+    {
+        const BrushPlanesSoA::Range& range = planes.brush_ranges[brush_idx];
 
         // -------- start of source-sdk-2013 code --------
         // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
-        
-        // TODO move these constants' definitions and all their other
-        //      occurrences somewhere else, maybe into CollidableWorld?
-        const float DIST_EPSILON = 0.03125; // 1/32 epsilon to keep floating point happy
-        const float NEVER_UPDATED = -9999;
-
-        const Vector3 start = translated_trace_start;
-        const Vector3 end   = translated_trace_start + trace->info.delta;
-        const Vector3 mins = -trace->info.extents; // Box case only (!trace->info.isray)
-        const Vector3 maxs = +trace->info.extents; // Box case only (!trace->info.isray)
-
-        //const BrushSide* leadside = nullptr;
-        Plane clipplane;
-        float enterfrac = NEVER_UPDATED;
-        float leavefrac = 1.0f;
-        bool  getout = false;
-        bool  startout = false;
-
-        float   dist;
-        Vector3 ofs;
-        float   d1, d2;
-        float   f;
-
-        bool skip_brush = false;
-        for (const Plane& plane : planes) {
-            if (trace->info.isray) // Special point case
-            {
-                // Commented out because bevel planes were sorted out earlier
-                //if (side.bevel == 1) // Don't ray trace against bevel planes
-                //    continue;
-
-                dist = plane.dist;
-            }
-            else // General box case
-            {
-                ofs.x() = (plane.normal.x() < 0.0f) ? maxs.x() : mins.x();
-                ofs.y() = (plane.normal.y() < 0.0f) ? maxs.y() : mins.y();
-                ofs.z() = (plane.normal.z() < 0.0f) ? maxs.z() : mins.z();
-
-                dist = plane.dist - Math::dot(ofs, plane.normal);
-            }
-
-            d1 = Math::dot(start, plane.normal) - dist;
-            d2 = Math::dot(end, plane.normal) - dist;
+        SweptBrushClipResult clip = trace->info.isray ?
+            ClipSweptRayToBrushPlanes(planes, range, start, end, *pImpl->origin_bsp_map) :
+            ClipSweptBoxToBrushPlanes(planes, range, start, end, trace->info.extents);
 
-            // If completely in front of face, no intersection
-            if (d1 > 0 && d2 > 0) {
-                skip_brush = true;
-                break;
-            }
-
-            if (d2 > 0)
-                getout = true; // Endpoint is not in solid
-            if (d1 > 0)
-                startout = true;
-
-            if (d1 <= 0 && d2 <= 0)
-                continue;
-
-            // Crosses face
-            if (d1 > d2) {
-                // Enter
-                f = (d1 - DIST_EPSILON) / (d1 - d2);
-                if (f > enterfrac) {
-                    enterfrac = f;
-                    clipplane = plane;
-                    //leadside = &side;
-                }
-            }
-            else {
-                // Leave
-                f = (d1 + DIST_EPSILON) / (d1 - d2);
-                if (f < leavefrac)
-                    leavefrac = f;
-            }
-        }
-
-        if (skip_brush)
+        if (clip.in_front) // If completely in front of a face, no intersection
             continue;
 
-        if (!startout) { // If original point was inside brush
+        if (!clip.startout) { // If original point was inside brush
             trace->results.startsolid = true;
-            if (!getout)
+            if (!clip.getout)
                 trace->results.allsolid = true;
             continue;
         }
 
-        if (enterfrac < leavefrac) {
-            if (enterfrac > NEVER_UPDATED && enterfrac < trace->results.fraction) {
+        if (clip.enterfrac < clip.leavefrac) {
+            if (clip.enterfrac > NEVER_UPDATED && clip.enterfrac < trace->results.fraction) {
                 // New closest object was hit!
-                if (enterfrac < 0)
-                    enterfrac = 0;
-                trace->results.fraction = enterfrac;
+                if (clip.enterfrac < 0.0f)
+                    clip.enterfrac = 0.0f;
+                trace->results.fraction     = clip.enterfrac;
                 //trace->results.surface = leadside->texinfo; // Might be -1
                 //trace->contents = brush.contents; // TODO: Return hit contents in a better way
-                trace->results.plane_normal = clipplane.normal;
+                trace->results.plane_normal = {
+                    planes.normal_x[clip.clip_plane],
+                    planes.normal_y[clip.clip_plane],
+                    planes.normal_z[clip.clip_plane]
+                };
             }
         }
         // --------- end of source-sdk-2013 code ---------
     }
 }
 
-// This function has an awful amount of  code duplication, but func_brush
-// entities aren't that important and this code won't ever be touched again >:)
 void CollidableWorld::DoUnsweptTrace_FuncBrush(Trace* trace,
                                                uint32_t func_brush_idx)
 {
     assert(trace->info.isswept == false);
     ZoneScoped;
 
-    // NOTE: Collision with func_brush entities was not thoroughly tested and
-    //       the Source engine might be using an entirely different collision
-    //       algorithm for func_brush specifically. (?)
-    //       It's possible that further bevel planes need to be created and
-    //       tested against when doing hull traces, in the same way we already
-    //       do it for collisions with static/dynamic props.
-    //       Maybe like this: https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/map.cpp#L463-L611
-    //       Maybe useful:    https://github.com/ValveSoftware/source-sdk-2013/blob/master/sp/src/utils/vbsp/ivp.cpp#L1340
-
-    // @OPTIMIZATION This function is pretty inefficient. However, there are
-    //               only very few func_brush entities in DZ maps, so it might
-    //               not matter.
-
-    std::shared_ptr<const BspMap> bsp_map = pImpl->origin_bsp_map;
-    const Ent_func_brush& func_brush = bsp_map->entities_func_brush[func_brush_idx];
-    if (!func_brush.IsSolid())
-        return; // Skip this func_brush
-
-    Vector3 translated_trace_start = trace->info.startpos - func_brush.origin;
-
-    // Order of axis rotations is important! First roll, then pitch, then yaw rotation!
-    // @Optimization Use 3x3 rotation matrix, not 4x4, or quaternions
-    Matrix4 rot_transformation =
-        Matrix4::rotationZ(Deg{ func_brush.angles[1] }) * // (yaw)   rotation around z axis
-        Matrix4::rotationY(Deg{ func_brush.angles[0] }) * // (pitch) rotation around y axis
-        Matrix4::rotationX(Deg{ func_brush.angles[2] });  // (roll)  rotation around x axis
+    if (pImpl->func_brush_trace_data == Corrade::Containers::NullOpt) {
+        assert(false && "func_brush trace data wasn't created!");
+        return;
+    }
+    const FuncBrushTraceData& data = *pImpl->func_brush_trace_data;
+    const FuncBrushTraceData::FuncBrush& func_brush = data.func_brushes[func_brush_idx];
+    const BrushPlanesSoA& planes = data.planes;
+
+    // Planes are already rotated, only translate the trace
+    const Vector3 trace_pos = trace->info.startpos - func_brush.origin;
+
+    for (uint32_t brush_idx = func_brush.first_brush;
+         brush_idx < func_brush.first_brush + func_brush.num_brushes;
+         brush_idx++)
+    {
+        const BrushPlanesSoA::Range& range = planes.brush_ranges[brush_idx];
+
+        bool intersects_brush;
+        if (trace->info.isray) {
+            // -------- start of source-sdk-2013 code --------
+            // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
+            intersects_brush = true;
+            for (uint32_t i = range.first_plane; i < range.first_plane + range.num_planes; i++) {
+                if (!IsRayTracedPlane(planes, i, *pImpl->origin_bsp_map))
+                    continue;
+                Vector3 normal = { planes.normal_x[i], planes.normal_y[i], planes.normal_z[i] };
+                // If completely in front of face, no intersection
+                if (Math::dot(trace_pos, normal) - planes.dist[i] > 0.0f) {
+                    intersects_brush = false;
+                    break;
+                }
+            }
+            // --------- end of source-sdk-2013 code ---------
+        }
+        else {
+            intersects_brush = IsBoxBehindBrushPlanes(planes, range, trace_pos,
+                                                      trace->info.extents);
+        }
+        if (!intersects_brush)
+            continue;
+
+        // -------- start of source-sdk-2013 code --------
+        // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
+        // If we got here, the trace intersects the brush
+        trace->results.startsolid   = true;
+        trace->results.allsolid     = true;
+        // Trace fraction of 1.0 is interpreted as nothing being hit.
+        // -> Need to set fraction to something below 1.0
+        trace->results.fraction     = 0.0f;
+        // Can't report a hit surface
+        trace->results.plane_normal = Vector3(0.0f, 0.0f, 0.0f);
+        trace->results.surface      = -1;
+        //trace->contents = brush.contents; // TODO: Return hit contents in a better way
+        // --------- end of source-sdk-2013 code ---------
+
+        break; // Early-out, no point in checking further brushes
+    }
+}
+
+size_t FuncBrushTraceData::GetMemorySize() const
+{
+    return sizeof(FuncBrushTraceData)
+        + func_brushes.capacity() * sizeof(FuncBrush)
+        + planes.GetMemorySize() - sizeof(BrushPlanesSoA);
+}
 
+// Returns index into BspMap::models of the func_brush's brush model, or -1 if
+// its model is invalid.
+static int64_t GetFuncBrushModelIdx(const Ent_func_brush& func_brush,
+                                    const BspMap& bsp_map)
+{
     if (func_brush.model.size() == 0 || func_brush.model[0] != '*')
-        return; // Invalid, abort
-    std::string idxStr = func_brush.model.substr(1);
-    int64_t modelIdx = utils::ParseIntFromString(idxStr, -1);
-    if (modelIdx <= 0 || modelIdx >= (int64_t)bsp_map->models.size())
-        return; // Invalid model index, abort
+        return -1; // Invalid
+    std::string idx_str = func_brush.model.substr(1);
+    int64_t model_idx = utils::ParseIntFromString(idx_str, -1);
+    if (model_idx <= 0 || model_idx >= (int64_t)bsp_map.models.size())
+        return -1; // Invalid model index
+    return model_idx;
+}
+
+FuncBrushTraceData coll::Create_FuncBrushTraceData(const BspMap& bsp_map)
+{
+    ZoneScoped;
+
+    FuncBrushTraceData data;
+    data.func_brushes.reserve(bsp_map.entities_func_brush.size());
+    BrushPlanesSoA& soa = data.planes;
+
+    auto add_plane = [&soa](const Vector3& normal, float dist, uint32_t side_idx) {
+        soa.normal_x.push_back(normal.x());
+        soa.normal_y.push_back(normal.y());
+        soa.normal_z.push_back(normal.z());
+        soa.dist    .push_back(dist);
+        soa.side_idx.push_back(side_idx);
+    };
 
     // NOTE: Rarely in CSGO maps, brushes have invalid brushsides/planes, i.e.
     //       they result in an AABB where (maxs[i] <= mins[i]) for some i.
@@ -273,103 +281,78 @@ void CollidableWorld::DoUnsweptTrace_FuncBrush(Trace* trace,
     //       one func_brush in CSGO's "Only Up!" map by leander.
     //       (https://steamcommunity.com/sharedfiles/filedetails/?id=3012684086)
     bool are_we_in_csgo_only_up_map =
-        bsp_map->map_version == 2915 && bsp_map->sky_name.compare("vertigoblue_hdr") == 0;
+        bsp_map.map_version == 2915 && bsp_map.sky_name.compare("vertigoblue_hdr") == 0;
 
-    for (size_t brush_idx : bsp_map->GetModelBrushIndices(modelIdx)) {
-        const Brush& brush = bsp_map->brushes[brush_idx];
+    static auto test_f_exclude =
+        BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::GRENADECLIP);
+    static auto test_f_1 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::SOLID);
+    static auto test_f_2 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::PLAYERCLIP);
+    static auto test_f_3 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::LADDER);
 
-        // Special case: grenadeclip brushes don't work in func_brush entities
-        // (for unknown reasons)
-        static auto test_f_exclude =
-            BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::GRENADECLIP);
-        if (test_f_exclude.first && test_f_exclude.first(brush))
-            continue;
+    for (size_t fb_idx = 0; fb_idx < bsp_map.entities_func_brush.size(); fb_idx++) {
+        const Ent_func_brush& func_brush = bsp_map.entities_func_brush[fb_idx];
 
-        static auto test_f_1 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::SOLID);
-        static auto test_f_2 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::PLAYERCLIP);
-        static auto test_f_3 = BrushSeparation::getBrushCategoryTestFuncs(BrushSeparation::LADDER);
+        FuncBrushTraceData::FuncBrush& fb = data.func_brushes.emplace_back();
+        fb.origin      = func_brush.origin;
+        fb.has_aabb    = CalcAabb_FuncBrush(fb_idx, bsp_map, &fb.aabb_mins, &fb.aabb_maxs);
+        fb.first_brush = soa.brush_ranges.size();
+        fb.num_brushes = 0;
 
-        bool solid_to_player = false;
-        if (test_f_1.first && test_f_1.first(brush)) solid_to_player = true;
-        if (test_f_2.first && test_f_2.first(brush)) solid_to_player = true;
-        if (test_f_3.first && test_f_3.first(brush)) solid_to_player = true;
-        if (!solid_to_player)
+        if (!func_brush.IsSolid())
+            continue;
+        int64_t model_idx = GetFuncBrushModelIdx(func_brush, bsp_map);
+        if (model_idx == -1)
             continue;
 
-        // @Optimization Ensure the 6 axial brushsides/planes are processed first.
-        std::vector<Plane> planes;
-        for (int i = 0; i < brush.num_sides; i++) {
-            const BrushSide& side = bsp_map->brushsides[brush.first_side + i];
-
-            if (trace->info.isray && side.bevel)
-                continue;
-
-            // HACKHACK A specific brush in the CSGO Only Up map (by leander)
-            //          has 2 invalid planes that cause issues, skip these.
-            if (are_we_in_csgo_only_up_map && brush_idx == 2537)
-                if (i == 26 || i == 30)
-                    continue;
-
-            Plane plane = bsp_map->planes[side.plane_num];
-            plane.normal = rot_transformation.transformVector(plane.normal);
-            planes.push_back(plane);
-        }
-
-        // -------- start of source-sdk-2013 code --------
-        // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
-
-        const Vector3 trace_pos = translated_trace_start;
-        const Vector3 mins = -trace->info.extents; // Box case only (!trace->info.isray)
-        const Vector3 maxs = +trace->info.extents; // Box case only (!trace->info.isray)
+        // Order of axis rotations is important! First roll, then pitch, then yaw rotation!
+        Matrix4 rot_transformation =
+            Matrix4::rotationZ(Deg{ func_brush.angles[1] }) * // (yaw)   rotation around z axis
+            Matrix4::rotationY(Deg{ func_brush.angles[0] }) * // (pitch) rotation around y axis
+            Matrix4::rotationX(Deg{ func_brush.angles[2] });  // (roll)  rotation around x axis
 
-        float   dist;
-        Vector3 ofs;
+        for (size_t brush_idx : bsp_map.GetModelBrushIndices(model_idx)) {
+            const Brush& brush = bsp_map.brushes[brush_idx];
 
-        bool skip_brush = false;
-        for (const Plane& plane : planes) {
-            if (trace->info.isray) // Special point case
-            {
-                // Commented out because bevel planes were sorted out earlier
-                //if (side.bevel == 1) // Don't ray trace against bevel planes
-                //    continue;
+            // Special case: grenadeclip brushes don't work in func_brush entities
+            // (for unknown reasons)
+            if (test_f_exclude.first && test_f_exclude.first(brush))
+                continue;
 
-                dist = plane.dist;
-            }
-            else // General box case
-            {
-                ofs.x() = (plane.normal.x() < 0.0f) ? maxs.x() : mins.x();
-                ofs.y() = (plane.normal.y() < 0.0f) ? maxs.y() : mins.y();
-                ofs.z() = (plane.normal.z() < 0.0f) ? maxs.z() : mins.z();
+            bool solid_to_player = false;
+            if (test_f_1.first && test_f_1.first(brush)) solid_to_player = true;
+            if (test_f_2.first && test_f_2.first(brush)) solid_to_player = true;
+            if (test_f_3.first && test_f_3.first(brush)) solid_to_player = true;
+            if (!solid_to_player)
+                continue;
 
-                dist = plane.dist - Math::dot(ofs, plane.normal);
+            BrushPlanesSoA::Range range;
+            range.first_plane = soa.normal_x.size();
+
+            // Keep brushside order, ray traces rely on it to resolve ties
+            for (int i = 0; i < brush.num_sides; i++) {
+                // HACKHACK A specific brush in the CSGO Only Up map (by leander)
+                //          has 2 invalid planes that cause issues, skip these.
+                if (are_we_in_csgo_only_up_map && brush_idx == 2537)
+                    if (i == 26 || i == 30)
+                        continue;
+
+                uint32_t side_idx = brush.first_side + i;
+                const Plane& plane = bsp_map.planes[bsp_map.brushsides[side_idx].plane_num];
+                add_plane(rot_transformation.transformVector(plane.normal),
+                          plane.dist, side_idx);
             }
 
-            float d1 = Math::dot(trace_pos, plane.normal) - dist;
+            // Pad with dummy planes. Any box is behind them, so they never make
+            // traces exit early, never get crossed and never affect results.
+            while ((soa.normal_x.size() - range.first_plane) % 4 != 0)
+                add_plane({ 0.0f, 0.0f, 0.0f }, 1.0f, BrushPlanesSoA::INVALID_SIDE_IDX);
 
-            // If completely in front of face, no intersection
-            if (d1 > 0) {
-                skip_brush = true;
-                break;
-            }
+            range.num_planes = soa.normal_x.size() - range.first_plane;
+            soa.brush_ranges.push_back(range);
+            fb.num_brushes++;
         }
-
-        if (skip_brush)
-            continue;
-
-        // If we got here, the trace intersects the brush
-        trace->results.startsolid   = true;
-        trace->results.allsolid     = true;
-        // Trace fraction of 1.0 is interpreted as nothing being hit.
-        // -> Need to set fraction to something below 1.0
-        trace->results.fraction     = 0.0f;
-        // Can't report a hit surface
-        trace->results.plane_normal = Vector3(0.0f, 0.0f, 0.0f);
-        trace->results.surface      = -1;
-        //trace->contents = brush.contents; // TODO: Return hit contents in a better way
-        // --------- end of source-sdk-2013 code ---------
-
-        break; // Early-out, no point in checking further brushes
     }
+    return data;
 }
 
 bool coll::CalcAabb_FuncBrush(size_t func_brush_idx, const BspMap& bsp_map,
@@ -378,20 +361,17 @@ bool coll::CalcAabb_FuncBrush(size_t func_brush_idx, const BspMap& bsp_map,
     const Ent_func_brush& func_brush = bsp_map.entities_func_brush[func_brush_idx];
 
     // Get indices of all brushes contained in the func_brush
-    if (func_brush.model.size() == 0 || func_brush.model[0] != '*')
-        return false; // failure, invalid model
-    std::string idx_str = func_brush.model.substr(1);
-    int64_t model_idx = utils::ParseIntFromString(idx_str, -1);
-    if (model_idx <= 0 || model_idx >= (int64_t)bsp_map.models.size())
+    int64_t model_idx = GetFuncBrushModelIdx(func_brush, bsp_map);
+    if (model_idx == -1)
         return false; // failure, invalid model
     const auto& brush_indices = bsp_map.GetModelBrushIndices(model_idx);
 
     // Collect all types of brushes, even if some are irrelevant to DZSimulator.
     // Rather make the AABB too big than too small.
-    std::vector<std::vector<Vector3>> faces =
-        bsp_map.GetBrushFaceVertices(brush_indices);
+    utils_3d::FaceBuffer faces;
+    bsp_map.GetBrushFaceVertices(&faces, brush_indices);
 
-    if (faces.size() == 0)
+    if (faces.NumFaces() == 0)
         return false; // failure, non-existing AABB
 
     // Brush model of func_brush gets rotated and translated
@@ -405,15 +385,13 @@ bool coll::CalcAabb_FuncBrush(size_t func_brush_idx, const BspMap& bsp_map,
     Vector3 maxs = { -HUGE_VALF, -HUGE_VALF, -HUGE_VALF };
 
     // Apply rotation and translation to every vertex
-    for (const std::vector<Vector3>& face : faces) {
-        for (const Vector3& untransformed_v : face) {
-            Vector3 v = func_brush_transf.transformPoint(untransformed_v);
-
-            // Compute AABB of rotated and translated brush model
-            for (int axis = 0; axis < 3; axis++) {
-                if (v[axis] < mins[axis]) mins[axis] = v[axis];
-                if (v[axis] > maxs[axis]) maxs[axis] = v[axis];
-            }
+    for (const Vector3& untransformed_v : faces.vertices) {
+        Vector3 v = func_brush_transf.transformPoint(untransformed_v);
+
+        // Compute AABB of rotated and translated brush model
+        for (int axis = 0; axis < 3; axis++) {
+            if (v[axis] < mins[axis]) mins[axis] = v[axis];
+            if (v[axis] > maxs[axis]) maxs[axis] = v[axis];
         }
     }
 
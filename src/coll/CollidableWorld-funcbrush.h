@@ -1,8 +1,13 @@
 #ifndef COLL_COLLIDABLEWORLD_FUNCBRUSH_H_
 #define COLL_COLLIDABLEWORLD_FUNCBRUSH_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
 #include <Magnum/Math/Vector3.h>
 
+#include "coll/CollidableWorld-brush.h"
 #include "csgo_parsing/BspMap.h"
 
 namespace coll {
@@ -16,7 +21,33 @@ namespace coll {
         Magnum::Vector3* aabb_maxs);
 
 
-    // ... (Add further func_brush-related collision code here)
+    // Collision data of all func_brush entities, created once at map load.
+    // Brush planes are rotated into the func_brush's orientation, but remain
+    // relative to the func_brush's origin. Traces only need to be translated.
+    struct FuncBrushTraceData {
+        struct FuncBrush {
+            Magnum::Vector3 origin;
+            Magnum::Vector3 aabb_mins; // Exact, non-bloated AABB in world space
+            Magnum::Vector3 aabb_maxs;
+            bool            has_aabb;  // False if func_brush model is invalid
+            // Brushes that are solid to players (index into brush_ranges of
+            // planes). 0 if func_brush isn't solid.
+            uint32_t first_brush;
+            uint32_t num_brushes;
+        };
+        // Same indexing as BspMap::entities_func_brush
+        std::vector<FuncBrush> func_brushes;
+
+        // Rotated planes of every func_brush brush, in brushside order.
+        // One brush range per func_brush brush, i.e. a brush that's used by
+        // multiple func_brush entities is stored multiple times.
+        BrushPlanesSoA planes;
+
+        size_t GetMemorySize() const;
+    };
+
+    FuncBrushTraceData Create_FuncBrushTraceData(
+        const csgo_parsing::BspMap& bsp_map);
 
 
 } // namespace coll
@@ -5,6 +5,7 @@
 #include <cassert>
 #include <cmath>
 #include <map>
+#include <memory>
 #include <string>
 #include <span>
 #include <vector>
@@ -173,64 +174,194 @@ Create_CollisionCache_XProp(const CollisionModel& cmodel,
 ////////////////////////////////////////////////////////////////////////////////
 
 
-void DoTrace_XProp(Trace* trace,
-                   const Vector3&       xprop_origin,
-                   CollisionModel       xprop_collmodel,
-                   CollisionCache_XProp xprop_collcache);
+XPropTraceData coll::Create_XPropTraceData(
+    const BspMap& bsp_map,
+    const std::map<std::string, std::shared_ptr<const CollisionModel>>& xprop_coll_models,
+    const std::map<uint32_t, CollisionCache_XProp>& coll_caches_sprop,
+    const std::map<uint32_t, CollisionCache_XProp>& coll_caches_dprop)
+{
+    ZoneScoped;
+    XPropTraceData data;
+
+    // Flatten triangle planes of every collision model once. Remember where
+    // each collision model's planes start.
+    std::map<const CollisionModel*, uint32_t> first_plane_of_cmodel;
+    for (const auto& [mdl_path, cmodel] : xprop_coll_models) {
+        first_plane_of_cmodel[cmodel.get()] = data.plane_dist.size();
+        for (const std::vector<Plane>& section_planes : cmodel->section_planes) {
+            for (const Plane& plane : section_planes) {
+                data.plane_normal_x.push_back(plane.normal.x());
+                data.plane_normal_y.push_back(plane.normal.y());
+                data.plane_normal_z.push_back(plane.normal.z());
+                data.plane_dist    .push_back(plane.dist);
+            }
+        }
+    }
 
-void coll::DoTrace_StaticProp(Trace* trace, uint32_t sprop_idx, CollidableWorld& c_world)
+    auto add_xprop = [&](const Vector3& origin, const std::string& mdl_path,
+                         const CollisionCache_XProp* cache) {
+        XPropTraceData::Prop xprop = {
+            .origin        = origin,
+            .inv_rotation  = {},
+            .rotation      = {},
+            .inv_scale     = 1.0f,
+            .first_section = (uint32_t)data.sections.size(),
+            .num_sections  = 0
+        };
+        auto cmodel_it = xprop_coll_models.find(mdl_path);
+        if (cache == nullptr || cmodel_it == xprop_coll_models.end())
+            return xprop; // Prop has no collision
+
+        const CollisionModel& cmodel = *cmodel_it->second;
+        xprop.inv_rotation = cache->inv_rotation;
+        // Get regular rotation transformation by inverting the inverted
+        // rotation transformation
+        xprop.rotation     = cache->inv_rotation.invertedNormalized();
+        xprop.inv_scale    = cache->inv_scale;
+        xprop.num_sections = cmodel.section_tri_meshes.size();
+
+        uint32_t next_plane = first_plane_of_cmodel[&cmodel];
+        for (size_t i = 0; i < cmodel.section_tri_meshes.size(); i++) {
+            const auto& lut_vals =
+                cache->section_bevel_luts[i].valid_candidate_index_steps_recidx;
+            data.sections.push_back({
+                .mins          = cache->section_aabbs[i].mins,
+                .maxs          = cache->section_aabbs[i].maxs,
+                .model_mins    = cmodel.section_aabbs[i].mins,
+                .model_maxs    = cmodel.section_aabbs[i].maxs,
+                .first_plane   = next_plane,
+                .num_planes    = (uint32_t)cmodel.section_planes[i].size(),
+                .first_lut_val = (uint32_t)data.bevel_lut_vals.size(),
+                .num_lut_vals  = (uint32_t)lut_vals.size(),
+                .first_bevel_plane = XPropTraceData::NO_PRECOMPUTED_BEVEL_PLANES,
+                .num_bevel_planes  = 0,
+                .tri_mesh      = &cmodel.section_tri_meshes[i]
+            });
+            next_plane += cmodel.section_planes[i].size();
+            data.bevel_lut_vals.insert(data.bevel_lut_vals.end(),
+                                       lut_vals.begin(), lut_vals.end());
+        }
+        return xprop;
+    };
+
+    data.sprops.reserve(bsp_map.static_props.size());
+    for (size_t sprop_idx = 0; sprop_idx < bsp_map.static_props.size(); sprop_idx++) {
+        const BspMap::StaticProp& sprop = bsp_map.static_props[sprop_idx];
+        const std::string& mdl_path = bsp_map.static_prop_model_dict[sprop.model_idx];
+        auto cache_it = coll_caches_sprop.find(sprop_idx);
+        bool has_coll = sprop.IsSolidWithVPhysics() && cache_it != coll_caches_sprop.end();
+        data.sprops.push_back(add_xprop(sprop.origin, mdl_path,
+                                        has_coll ? &cache_it->second : nullptr));
+    }
+
+    data.dprops.reserve(bsp_map.relevant_dynamic_props.size());
+    for (size_t dprop_idx = 0; dprop_idx < bsp_map.relevant_dynamic_props.size(); dprop_idx++) {
+        const BspMap::Ent_prop_dynamic& dprop = bsp_map.relevant_dynamic_props[dprop_idx];
+        auto cache_it = coll_caches_dprop.find(dprop_idx);
+        bool has_coll = cache_it != coll_caches_dprop.end();
+        data.dprops.push_back(add_xprop(dprop.origin, dprop.model,
+                                        has_coll ? &cache_it->second : nullptr));
+    }
+
+    data.sections.shrink_to_fit();
+    data.bevel_lut_vals.shrink_to_fit();
+    return data;
+}
+
+size_t XPropTraceData::GetMemorySize() const {
+    return sprops.capacity() * sizeof(Prop)
+        + dprops.capacity() * sizeof(Prop)
+        + sections.capacity() * sizeof(Section)
+        + plane_normal_x.capacity() * sizeof(float)
+        + plane_normal_y.capacity() * sizeof(float)
+        + plane_normal_z.capacity() * sizeof(float)
+        + plane_dist    .capacity() * sizeof(float)
+        + bevel_lut_vals.capacity() * sizeof(XPropSectionBevelPlaneLut::RecIdxType)
+        + GetBevelPlaneMemorySize();
+}
+
+size_t XPropTraceData::GetBevelPlaneMemorySize() const {
+    return (bevel_normal_x.capacity() + bevel_normal_y.capacity() +
+            bevel_normal_z.capacity() + bevel_dist.capacity()) * sizeof(float);
+}
+
+void CollidableWorld::SetXPropBevelPlaneMode(XPropBevelPlaneMode mode)
 {
-    const BspMap::StaticProp& sprop = c_world.pImpl->origin_bsp_map->static_props[sprop_idx];
-    const std::string&     mdl_path = c_world.pImpl->origin_bsp_map->static_prop_model_dict[sprop.model_idx];
-    if (!sprop.IsSolidWithVPhysics()) return; // Skip this static prop
-
-    // Ensure that the required collision model and cache have been created
-    assert(c_world.pImpl->xprop_coll_models != Corrade::Containers::NullOpt);
-    assert(c_world.pImpl->coll_caches_sprop != Corrade::Containers::NullOpt);
-
-    // Get collision model
-    const auto& collmodel_iter = c_world.pImpl->xprop_coll_models->find(mdl_path);
-    if (collmodel_iter == c_world.pImpl->xprop_coll_models->end())
-        return; // This static prop has no collision model, skip
-    const CollisionModel& collmodel = collmodel_iter->second;
-
-    // Get collision cache
-    const auto& collcache_iter = c_world.pImpl->coll_caches_sprop->find(sprop_idx);
-    if (collcache_iter == c_world.pImpl->coll_caches_sprop->end()) {
-        assert(false); // Shouldn't happen
-        return; // This static prop has no collision cache, skip
+    if (mode == pImpl->xprop_bevel_plane_mode)
+        return;
+    pImpl->xprop_bevel_plane_mode = mode;
+    if (pImpl->xprop_trace_data == Corrade::Containers::NullOpt)
+        return;
+
+    ZoneScoped;
+    XPropTraceData& data = *pImpl->xprop_trace_data;
+    const std::vector<BspMap::PlayerSpawn>& spawns =
+        pImpl->origin_bsp_map->player_spawns;
+
+    switch (mode) {
+    case XPropBevelPlaneMode::ON_DEMAND:
+        data.PrecomputeBevelPlanes([](const Vector3&, const Vector3&) {
+            return false;
+        });
+        break;
+    case XPropBevelPlaneMode::PRECOMPUTE_NEAR_SPAWNS:
+        data.PrecomputeBevelPlanes([&spawns](const Vector3& mins, const Vector3& maxs) {
+            // Squared distance between spawn and section AABB
+            for (const BspMap::PlayerSpawn& spawn : spawns) {
+                Vector3 closest = Math::clamp(spawn.origin, mins, maxs);
+                if ((closest - spawn.origin).dot() <= NEAR_SPAWN_RADIUS * NEAR_SPAWN_RADIUS)
+                    return true;
+            }
+            return false;
+        });
+        break;
+    case XPropBevelPlaneMode::PRECOMPUTE_ALL:
+        data.PrecomputeBevelPlanes([](const Vector3&, const Vector3&) {
+            return true;
+        });
+        break;
     }
-    const CollisionCache_XProp& collcache = collcache_iter->second;
+}
+
+CollidableWorld::XPropBevelPlaneMode CollidableWorld::GetXPropBevelPlaneMode() const
+{
+    return pImpl->xprop_bevel_plane_mode;
+}
 
-    // Do trace
-    DoTrace_XProp(trace, sprop.origin, collmodel, collcache);
+size_t CollidableWorld::GetXPropBevelPlaneMemorySize() const
+{
+    if (pImpl->xprop_trace_data == Corrade::Containers::NullOpt)
+        return 0;
+    return pImpl->xprop_trace_data->GetBevelPlaneMemorySize();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+
+
+static void DoTrace_XProp(Trace* trace, const XPropTraceData& data,
+                          const XPropTraceData::Prop& xprop);
+
+void coll::DoTrace_StaticProp(Trace* trace, uint32_t sprop_idx, CollidableWorld& c_world)
+{
+    assert(c_world.pImpl->xprop_trace_data != Corrade::Containers::NullOpt);
+    const XPropTraceData& data = *c_world.pImpl->xprop_trace_data;
+    const XPropTraceData::Prop& sprop = data.sprops[sprop_idx];
+    if (sprop.num_sections == 0)
+        return; // Static prop isn't solid or has no collision model, skip
+
+    DoTrace_XProp(trace, data, sprop);
 }
 
 void coll::DoTrace_DynamicProp(Trace* trace, uint32_t dprop_idx, CollidableWorld& c_world)
 {
-    const BspMap::Ent_prop_dynamic& dprop =
-        c_world.pImpl->origin_bsp_map->relevant_dynamic_props[dprop_idx];
-
-    // Ensure that the required collision model and cache have been created
-    assert(c_world.pImpl->xprop_coll_models != Corrade::Containers::NullOpt);
-    assert(c_world.pImpl->coll_caches_dprop != Corrade::Containers::NullOpt);
-
-    // Get collision model
-    const auto& collmodel_iter = c_world.pImpl->xprop_coll_models->find(dprop.model);
-    if (collmodel_iter == c_world.pImpl->xprop_coll_models->end())
-        return; // This dynamic prop has no collision model, skip
-    const CollisionModel& collmodel = collmodel_iter->second;
-
-    // Get collision cache
-    const auto& collcache_iter = c_world.pImpl->coll_caches_dprop->find(dprop_idx);
-    if (collcache_iter == c_world.pImpl->coll_caches_dprop->end()) {
-        assert(false); // Shouldn't happen
-        return; // This dynamic prop has no collision cache, skip
-    }
-    const CollisionCache_XProp& collcache = collcache_iter->second;
+    assert(c_world.pImpl->xprop_trace_data != Corrade::Containers::NullOpt);
+    const XPropTraceData& data = *c_world.pImpl->xprop_trace_data;
+    const XPropTraceData::Prop& dprop = data.dprops[dprop_idx];
+    if (dprop.num_sections == 0)
+        return; // Dynamic prop has no collision model, skip
 
-    // Do trace
-    DoTrace_XProp(trace, dprop.origin, collmodel, collcache);
+    DoTrace_XProp(trace, data, dprop);
 }
 
 // NOTE: DoTrace_XProp() checks whether the trace is swept or not and handles it
@@ -260,12 +391,10 @@ void CollidableWorld::DoUnsweptTrace_DynamicProp(Trace *trace, uint32_t dprop_id
     DoTrace_DynamicProp(trace, dprop_idx, *this);
 }
 
-void DoTrace_XProp(Trace* trace,
-                   const Vector3&       xprop_origin,
-                   CollisionModel       xprop_collmodel,
-                   CollisionCache_XProp xprop_collcache)
+static void DoTrace_XProp(Trace* trace, const XPropTraceData& data,
+                          const XPropTraceData::Prop& xprop)
 {
-    const size_t NUM_SECTIONS = xprop_collmodel.section_tri_meshes.size();
+    const Vector3& xprop_origin = xprop.origin;
 
     // TODO: Look at https://doc.magnum.graphics/magnum/transformations.html to
     //       possibly improve/optimize the transformations in this method.
@@ -290,16 +419,16 @@ void DoTrace_XProp(Trace* trace,
     // Reverse xprop translation (opposite of CalcModelTransformationMatrix())
     transformed_trace_start -= xprop_origin;
     // Reverse xprop rotation (opposite of CalcModelTransformationMatrix())
-    const auto& inv_rot = xprop_collcache.inv_rotation;
+    const auto& inv_rot = xprop.inv_rotation;
     transformed_trace_start = inv_rot.transformVectorNormalized(transformed_trace_start);
     transformed_trace_dir   = inv_rot.transformVectorNormalized(transformed_trace_dir);
     unit_vec_0              = inv_rot.transformVectorNormalized(unit_vec_0);
     unit_vec_1              = inv_rot.transformVectorNormalized(unit_vec_1);
     unit_vec_2              = inv_rot.transformVectorNormalized(unit_vec_2);
     // Reverse xprop scaling (opposite of CalcModelTransformationMatrix())
-    transformed_trace_start *= xprop_collcache.inv_scale;
-    transformed_trace_dir   *= xprop_collcache.inv_scale;
-    transformed_extents     *= xprop_collcache.inv_scale;
+    transformed_trace_start *= xprop.inv_scale;
+    transformed_trace_dir   *= xprop.inv_scale;
+    transformed_extents     *= xprop.inv_scale;
 
 
     enum PlaneCategory {
@@ -324,37 +453,74 @@ void DoTrace_XProp(Trace* trace,
         :
         std::span<const PlaneCategory>(HULL_TRACE_CAT_LIST.begin(), HULL_TRACE_CAT_LIST.size());
 
+    // ======== Collect sections whose bloated AABB is hit ========
+    struct SectionCandidate {
+        float    aabb_hit_fraction;
+        uint32_t section_idx;
+    };
+    // Scratch memory to avoid allocations on every trace
+    thread_local std::vector<SectionCandidate> section_candidates;
+    section_candidates.clear();
+
+    if (xprop.num_sections == 1) {
+        // The BVH leaf AABB of a single-section xprop is identical to the
+        // section's bloated AABB (see BVH::CreateLeaves()). The trace already
+        // hit it, no need to test it again.
+        section_candidates.push_back({ 0.0f, xprop.first_section });
+    }
+    else {
+        for (uint32_t section_idx = xprop.first_section;
+             section_idx < xprop.first_section + xprop.num_sections;
+             section_idx++)
+        {
+            const XPropTraceData::Section& section = data.sections[section_idx];
+            // Bloat AABB a little to account for collision calculation tolerances
+            Vector3 bloated_xprop_section_mins = section.mins - Vector3{1.0f, 1.0f, 1.0f };
+            Vector3 bloated_xprop_section_maxs = section.maxs + Vector3{1.0f, 1.0f, 1.0f };
+            float aabb_hit_fraction;
+            if (trace->HitsAabb(bloated_xprop_section_mins,
+                                bloated_xprop_section_maxs, &aabb_hit_fraction))
+                section_candidates.push_back({ aabb_hit_fraction, section_idx });
+        }
+
+        // Process sections front to back, so that sections behind an earlier
+        // hit can be skipped. Ties are processed in section order.
+        if (trace->info.isswept) {
+            std::sort(section_candidates.begin(), section_candidates.end(),
+                [](const SectionCandidate& a, const SectionCandidate& b) {
+                    if (a.aabb_hit_fraction != b.aabb_hit_fraction)
+                        return a.aabb_hit_fraction < b.aabb_hit_fraction;
+                    return a.section_idx < b.section_idx;
+                }
+            );
+        }
+    }
+
+    // A section whose bloated AABB is hit after the trace's current fraction
+    // can't lower the fraction any further: Hull traces clip against the
+    // section's AABB planes, which pull enterfrac back by DIST_EPSILON model
+    // units at most. That's less than the AABB bloat of 1 unit, as long as
+    // the xprop isn't scaled up by more than 1/DIST_EPSILON. Ray traces don't
+    // clip against AABB planes, so they can't skip sections.
+    const bool can_skip_late_sections = trace->info.isswept &&
+        !trace->info.isray && xprop.inv_scale >= DIST_EPSILON;
+
     // ======== Go through each section independently ========
-    // @Optimization Process sections front to back? Skip section if AABB hit
-    //               time is past trace's fraction?
-    for (size_t section_idx = 0; section_idx < NUM_SECTIONS; section_idx++)
+    for (const SectionCandidate& candidate : section_candidates)
     {
-        const Vector3& xprop_section_mins = xprop_collcache.section_aabbs[section_idx].mins;
-        const Vector3& xprop_section_maxs = xprop_collcache.section_aabbs[section_idx].maxs;
-        // Bloat AABB a little to account for collision calculation tolerances
-        Vector3 bloated_xprop_section_mins = xprop_section_mins - Vector3{1.0f, 1.0f, 1.0f };
-        Vector3 bloated_xprop_section_maxs = xprop_section_maxs + Vector3{1.0f, 1.0f, 1.0f };
-        // Early-out if trace doesn't hit section's bloated AABB
-        // @Optimization If the xprop only has 1 section, isn't this check
-        //               redundant, as it's already done by BVH code?
-        if (!trace->HitsAabb(bloated_xprop_section_mins,
-                             bloated_xprop_section_maxs))
-            continue;
+        if (can_skip_late_sections &&
+            trace->results.fraction < candidate.aabb_hit_fraction)
+            break; // All remaining sections are hit even later
 
-        const std::vector<Plane>& tri_planes_of_section =
-            xprop_collmodel.section_planes[section_idx];
+        const XPropTraceData::Section& section = data.sections[candidate.section_idx];
+        const Vector3& xprop_section_mins = section.mins;
+        const Vector3& xprop_section_maxs = section.maxs;
 
-        XPropSectionBevelPlaneGenerator bevel_gen(
-            xprop_collmodel, xprop_collcache, section_idx);
+        XPropSectionBevelPlaneGenerator bevel_gen(data, xprop, section);
 
         // -------- start of source-sdk-2013 code --------
         // (taken and modified from source-sdk-2013/<...>/src/utils/vrad/trace.cpp)
 
-        // TODO Move these constants' definitions and all their other
-        //      occurrences somewhere else, maybe into CollidableWorld?
-        const float DIST_EPSILON = 0.03125f; // 1/32 epsilon to keep floating point happy
-        const float NEVER_UPDATED = -9999;
-
         const Vector3 start = transformed_trace_start;
         const Vector3 end   = transformed_trace_start + transformed_trace_dir;
 
@@ -381,22 +547,29 @@ void DoTrace_XProp(Trace* trace,
                 if (cur_plane_cat == PlaneCategory::MODEL_TRIANGLES)
                 {
                     // Get a triangle's plane
-                    if (plane_idx < tri_planes_of_section.size())
-                        next_plane = tri_planes_of_section[plane_idx];
+                    if (plane_idx < section.num_planes)
+                        next_plane = data.GetPlane(section.first_plane + plane_idx);
                     else
                         break; // Exit this category
                 }
                 else if (cur_plane_cat == PlaneCategory::EDGE_BEVELS)
                 {
-                    // @Optimization Note: Precomputing and storing all bevel
-                    //                     planes for each prop would require up
-                    //                     to a couple megabytes for a CSGO map.
+                    // Bevel planes might have been precomputed, see
+                    // CollidableWorld::SetXPropBevelPlaneMode().
                     // Note: This bevel plane generation for props doesn't lead
                     //       to hull trace results exactly matching those of
                     //       CSGO, but it should be good enough.
-                    bool success = bevel_gen.GetNext(&next_plane);
-                    if (!success)
-                        break; // Exit this category
+                    if (section.first_bevel_plane != XPropTraceData::NO_PRECOMPUTED_BEVEL_PLANES) {
+                        if (plane_idx < section.num_bevel_planes)
+                            next_plane = data.GetBevelPlane(section.first_bevel_plane + plane_idx);
+                        else
+                            break; // Exit this category
+                    }
+                    else {
+                        bool success = bevel_gen.GetNext(&next_plane);
+                        if (!success)
+                            break; // Exit this category
+                    }
                 }
                 else if (cur_plane_cat == PlaneCategory::AABB_TRANSFORMED)
                 {
@@ -404,12 +577,12 @@ void DoTrace_XProp(Trace* trace,
                     // @Optimization Should these planes be checked last?
                     if (plane_idx > 5) break; // Exit this category
                     switch(plane_idx) {
-                        case 0: next_plane = { +unit_vec_0,  (xprop_section_maxs[0] - xprop_origin[0]) * xprop_collcache.inv_scale }; break;
-                        case 1: next_plane = { -unit_vec_0, -(xprop_section_mins[0] - xprop_origin[0]) * xprop_collcache.inv_scale }; break;
-                        case 2: next_plane = { +unit_vec_1,  (xprop_section_maxs[1] - xprop_origin[1]) * xprop_collcache.inv_scale }; break;
-                        case 3: next_plane = { -unit_vec_1, -(xprop_section_mins[1] - xprop_origin[1]) * xprop_collcache.inv_scale }; break;
-                        case 4: next_plane = { +unit_vec_2,  (xprop_section_maxs[2] - xprop_origin[2]) * xprop_collcache.inv_scale }; break;
-                        case 5: next_plane = { -unit_vec_2, -(xprop_section_mins[2] - xprop_origin[2]) * xprop_collcache.inv_scale }; break;
+                        case 0: next_plane = { +unit_vec_0,  (xprop_section_maxs[0] - xprop_origin[0]) * xprop.inv_scale }; break;
+                        case 1: next_plane = { -unit_vec_0, -(xprop_section_mins[0] - xprop_origin[0]) * xprop.inv_scale }; break;
+                        case 2: next_plane = { +unit_vec_1,  (xprop_section_maxs[1] - xprop_origin[1]) * xprop.inv_scale }; break;
+                        case 3: next_plane = { -unit_vec_1, -(xprop_section_mins[1] - xprop_origin[1]) * xprop.inv_scale }; break;
+                        case 4: next_plane = { +unit_vec_2,  (xprop_section_maxs[2] - xprop_origin[2]) * xprop.inv_scale }; break;
+                        case 5: next_plane = { -unit_vec_2, -(xprop_section_mins[2] - xprop_origin[2]) * xprop.inv_scale }; break;
                     }
                 }
                 else if (cur_plane_cat == PlaneCategory::AABB_NON_TRANSFORMED)
@@ -424,8 +597,8 @@ void DoTrace_XProp(Trace* trace,
                     //               a bit with these removed. Keeping them for
                     //               now. I'm not sure how thorough those earlier
                     //               comparisons with CSGO trace results were.
-                    const Vector3& non_transf_aabb_mins = xprop_collmodel.section_aabbs[section_idx].mins;
-                    const Vector3& non_transf_aabb_maxs = xprop_collmodel.section_aabbs[section_idx].maxs;
+                    const Vector3& non_transf_aabb_mins = section.model_mins;
+                    const Vector3& non_transf_aabb_maxs = section.model_maxs;
                     if (plane_idx > 5) break; // Exit this category
                     switch(plane_idx) {
                         case 0: next_plane = { Vector3{ +1.0f,  0.0f,  0.0f },  non_transf_aabb_maxs[0] }; break;
@@ -533,14 +706,9 @@ void DoTrace_XProp(Trace* trace,
                     //trace->results.surface = leadside->texinfo; // Might be -1
                     //trace->contents = brush.contents; // TODO: Return hit contents in a better way
 
-                    // Get regular rotation transformation by inverting the inverted
-                    // rotation transformation
-                    Quaternion xprop_rotation =
-                        xprop_collcache.inv_rotation.invertedNormalized();
-
                     // Transform plane normal back to regular coordinate system
                     trace->results.plane_normal =
-                        xprop_rotation.transformVectorNormalized(clipplane.normal);
+                        xprop.rotation.transformVectorNormalized(clipplane.normal);
                 }
             }
         }
@@ -784,6 +952,21 @@ XPropSectionBevelPlaneGenerator::XPropSectionBevelPlaneGenerator(
 {
 }
 
+XPropSectionBevelPlaneGenerator::XPropSectionBevelPlaneGenerator(
+    const XPropTraceData&          trace_data,
+    const XPropTraceData::Prop&    xprop,
+    const XPropTraceData::Section& xprop_section)
+    : cur_candidate_idx { 0 }
+    , cur_lut_pos       { 0 }
+    , xprop_inv_rotation{ xprop.inv_rotation }
+    , tri_mesh_of_xprop_section{ *xprop_section.tri_mesh }
+    , valid_candidate_index_steps_recidx{
+        trace_data.bevel_lut_vals.data() + xprop_section.first_lut_val,
+        xprop_section.num_lut_vals
+    }
+{
+}
+
 bool XPropSectionBevelPlaneGenerator::GetNext(BspMap::Plane* out)
 {
     assert(out != nullptr);
@@ -1,6 +1,12 @@
 #ifndef COLL_COLLIDABLEWORLD_XPROP_H_
 #define COLL_COLLIDABLEWORLD_XPROP_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
 #include <Corrade/Containers/Optional.h>
@@ -61,6 +67,9 @@ public:
 
     size_t GetMemorySize() const;
 
+    // 'Recursive indexing' int type, see valid_candidate_index_steps_recidx
+    using RecIdxType = uint8_t;
+
 private:
     // Essentially, this LUT represents the information of whether a 'bevel
     // plane candidate' (identified by its index OR generation parameters) is
@@ -102,14 +111,14 @@ private:
     // instead as a list of the step sizes between those indices, and using the
     // 'recursive indexing' technique.
     // See the LUT creation code for an explanation of this.
-    // 2024-02-01 Note: This elementary 'recursive index' type's size and the
+    // 2024-02-01 Note: The elementary 'recursive index' type's size and the
     //                  LUT's layout were chosen to optimize memory usage and
     //                  lookup time when used for static props as found inside
     //                  CSGO DZ maps.
-    using RecIdxType = uint8_t; // 'Recursive indexing' int type
     std::vector<RecIdxType> valid_candidate_index_steps_recidx; // <- LUT representation
 
     friend class XPropSectionBevelPlaneGenerator;
+    friend struct XPropTraceData;
 };
 
 // Precomputed data per static/dynamic prop to speed up collision calculations
@@ -158,6 +167,96 @@ Corrade::Containers::Optional<CollisionCache_XProp>
         const CollisionModel& cmodel);
 
 
+// Flat, immutable collision data of all solid static and dynamic props, created
+// from their collision models and collision caches. Everything a trace against
+// a prop needs is reached by index, without map lookups, and traces against
+// props don't allocate memory.
+struct XPropTraceData {
+    struct Section {
+        // Exact, non-bloated AABB of the scaled, rotated and translated section
+        Magnum::Vector3 mins, maxs;
+        // AABB of the section of the unscaled, unrotated and untranslated
+        // collision model
+        Magnum::Vector3 model_mins, model_maxs;
+
+        uint32_t first_plane;   // Index into plane arrays, section's tri planes
+        uint32_t num_planes;
+        uint32_t first_lut_val; // Index into bevel_lut_vals, section's LUT
+        uint32_t num_lut_vals;
+
+        // If this section's bevel planes were precomputed, index into bevel
+        // plane arrays. Otherwise, NO_PRECOMPUTED_BEVEL_PLANES.
+        uint32_t first_bevel_plane;
+        uint32_t num_bevel_planes;
+
+        // Section's triangle mesh inside the collision model, required to
+        // generate bevel planes
+        const utils_3d::TriMesh* tri_mesh;
+    };
+    struct Prop {
+        Magnum::Vector3    origin;
+        Magnum::Quaternion inv_rotation; // Normalized. Reverses prop rotation
+        Magnum::Quaternion rotation;     // Normalized
+        float              inv_scale;    // (1 / scale)
+        uint32_t first_section; // Index into sections
+        uint32_t num_sections;  // 0 if prop isn't solid or has no coll model
+    };
+
+    std::vector<Prop> sprops; // Same indexing as BspMap::static_props
+    std::vector<Prop> dprops; // Same indexing as BspMap::relevant_dynamic_props
+    std::vector<Section> sections;
+
+    // Triangle planes of all collision model sections. Props that use the same
+    // collision model share the same planes.
+    std::vector<float> plane_normal_x;
+    std::vector<float> plane_normal_y;
+    std::vector<float> plane_normal_z;
+    std::vector<float> plane_dist;
+
+    // Bevel plane LUTs of all sections, concatenated
+    std::vector<XPropSectionBevelPlaneLut::RecIdxType> bevel_lut_vals;
+
+    // Optional, precomputed bevel planes of some sections. Trades memory for
+    // hull trace speed, since bevel planes otherwise get generated on every
+    // hull trace.
+    static constexpr uint32_t NO_PRECOMPUTED_BEVEL_PLANES = UINT32_MAX;
+    std::vector<float> bevel_normal_x;
+    std::vector<float> bevel_normal_y;
+    std::vector<float> bevel_normal_z;
+    std::vector<float> bevel_dist;
+
+    // Discards all precomputed bevel planes, then precomputes bevel planes of
+    // all sections of all props for which the given predicate returns true.
+    // The predicate gets passed a section's world AABB mins and maxs.
+    template<class Predicate>
+    void PrecomputeBevelPlanes(Predicate section_needs_precomputation);
+    size_t GetBevelPlaneMemorySize() const; // Of precomputed bevel planes, in bytes
+
+    csgo_parsing::BspMap::Plane GetPlane(uint32_t plane_idx) const {
+        return { .normal = { plane_normal_x[plane_idx],
+                             plane_normal_y[plane_idx],
+                             plane_normal_z[plane_idx] },
+                 .dist = plane_dist[plane_idx] };
+    }
+    csgo_parsing::BspMap::Plane GetBevelPlane(uint32_t bevel_plane_idx) const {
+        return { .normal = { bevel_normal_x[bevel_plane_idx],
+                             bevel_normal_y[bevel_plane_idx],
+                             bevel_normal_z[bevel_plane_idx] },
+                 .dist = bevel_dist[bevel_plane_idx] };
+    }
+
+    size_t GetMemorySize() const;
+};
+
+// CAUTION: The returned object references the collision models! They must
+//          outlive it without modifications.
+XPropTraceData Create_XPropTraceData(
+    const csgo_parsing::BspMap& bsp_map,
+    const std::map<std::string, std::shared_ptr<const CollisionModel>>& xprop_coll_models,
+    const std::map<uint32_t, CollisionCache_XProp>& coll_caches_sprop,
+    const std::map<uint32_t, CollisionCache_XProp>& coll_caches_dprop);
+
+
 // Responsible for efficiently generating all bevel planes of a specific section
 // of a specific static/dynamic prop. Bevel planes are calculated on demand.
 class XPropSectionBevelPlaneGenerator {
@@ -174,6 +273,12 @@ public:
         const CollisionCache_XProp& xprop_coll_cache,
         size_t idx_of_xprop_section);
 
+    // Same as above, using flat data. Same cautions apply.
+    XPropSectionBevelPlaneGenerator(
+        const XPropTraceData&          trace_data,
+        const XPropTraceData::Prop&    xprop,
+        const XPropTraceData::Section& xprop_section);
+
     // If successful, sets plane to next bevel plane and returns true.
     // If no more bevel planes can be generated, returns false.
     bool GetNext(csgo_parsing::BspMap::Plane* out);
@@ -186,10 +291,51 @@ private:
     // Stored info for generation
     const Magnum::Quaternion xprop_inv_rotation; // Normalized
     const utils_3d::TriMesh& tri_mesh_of_xprop_section;
-    const std::vector<XPropSectionBevelPlaneLut::RecIdxType>&
+    const std::span<const XPropSectionBevelPlaneLut::RecIdxType>
                                              valid_candidate_index_steps_recidx;
 };
 
+
+template<class Predicate>
+void XPropTraceData::PrecomputeBevelPlanes(Predicate section_needs_precomputation)
+{
+    bevel_normal_x.clear();
+    bevel_normal_y.clear();
+    bevel_normal_z.clear();
+    bevel_dist    .clear();
+
+    for (const std::vector<Prop>* props : { &sprops, &dprops }) {
+        for (const Prop& xprop : *props) {
+            for (uint32_t i = xprop.first_section;
+                 i < xprop.first_section + xprop.num_sections; i++) {
+                Section& section = sections[i];
+                section.first_bevel_plane = NO_PRECOMPUTED_BEVEL_PLANES;
+                section.num_bevel_planes  = 0;
+                if (!section_needs_precomputation(section.mins, section.maxs))
+                    continue;
+
+                // Use the generator to get exactly the same planes as traces
+                // would generate
+                section.first_bevel_plane = bevel_dist.size();
+                XPropSectionBevelPlaneGenerator bevel_gen(*this, xprop, section);
+                csgo_parsing::BspMap::Plane plane;
+                while (bevel_gen.GetNext(&plane)) {
+                    bevel_normal_x.push_back(plane.normal.x());
+                    bevel_normal_y.push_back(plane.normal.y());
+                    bevel_normal_z.push_back(plane.normal.z());
+                    bevel_dist    .push_back(plane.dist);
+                    section.num_bevel_planes++;
+                }
+            }
+        }
+    }
+
+    bevel_normal_x.shrink_to_fit();
+    bevel_normal_y.shrink_to_fit();
+    bevel_normal_z.shrink_to_fit();
+    bevel_dist    .shrink_to_fit();
+}
+
 } // namespace coll
 
 #endif // COLL_COLLIDABLEWORLD_XPROP_H_
@@ -9,6 +9,7 @@
 
 #include "coll/CollidableWorld_Impl.h"
 #include "coll/Debugger.h"
+#include "coll/TraceProfiler.h"
 
 using namespace coll;
 using namespace Magnum;
@@ -20,7 +21,7 @@ CollidableWorld::CollidableWorld(std::shared_ptr<const BspMap> bsp_map)
 {
 }
 
-void CollidableWorld::DoTrace(Trace* trace)
+void CollidableWorld::DoTrace(Trace* trace, TraceCache* cache)
 {
     ZoneScoped;
 
@@ -30,9 +31,11 @@ void CollidableWorld::DoTrace(Trace* trace)
         return;
     }
 
+    uint64_t profiler_start = coll::TraceProfiler::OnTraceStart();
     coll::Debugger::DebugStart_Trace(trace->info);
-    pImpl->bvh->DoTrace(trace, *this);
+    pImpl->bvh->DoTrace(trace, *this, cache);
     coll::Debugger::DebugFinish_Trace(trace->results);
+    coll::TraceProfiler::OnTraceFinish(profiler_start);
 }
 
 bool coll::AabbIntersectsAabb(
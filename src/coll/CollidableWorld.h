@@ -1,16 +1,20 @@
 #ifndef COLL_COLLIDABLEWORLD_H_
 #define COLL_COLLIDABLEWORLD_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
 
 #include "coll/Trace.h"
+#include "coll/TraceCache.h"
 #include "csgo_parsing/BspMap.h"
 
-// Forward-declare WorldCreator outside namespace to avoid ambiguity
+// Forward-declare these outside namespace to avoid ambiguity
 class WorldCreator;
+class GlidabilityReport;
 
 namespace coll {
 
@@ -26,8 +30,54 @@ public:
     CollidableWorld(std::shared_ptr<const csgo_parsing::BspMap> bsp_map);
 
     // Perform a swept or unswept trace against the entire world.
+    // Optionally, a trace cache can be given to speed up repeated traces in
+    // the same area. See TraceCache for details.
     // CAUTION: Not thread-safe yet!
-    void DoTrace(Trace* trace);
+    void DoTrace(Trace* trace, TraceCache* cache = nullptr);
+
+    // Policy of creating and destroying displacement collision caches.
+    // Hull traces against a displacement require its collision cache.
+    struct DispCachePolicy {
+        enum class Mode {
+            LAZY,       // Create caches when first needed, never destroy them
+            PREBUILD,   // Create all caches up front, using multiple threads
+            LAZY_BUDGET // Create caches when first needed, destroy least
+                        // recently used ones when exceeding a memory budget
+        } mode = Mode::LAZY;
+        size_t budget_bytes = 4 * 1024 * 1024; // Only used in LAZY_BUDGET mode
+    };
+    struct DispCacheStats {
+        uint64_t builds_last_tick = 0; // Caches created during last tick
+        uint64_t builds_total     = 0; // Caches created since world creation
+        uint64_t evictions_total  = 0; // Caches destroyed since world creation
+        size_t   num_cached       = 0; // Number of displacements with a cache
+        size_t   cache_bytes      = 0; // Memory of all current caches
+    };
+
+    // Switching to PREBUILD mode blocks until all caches were created.
+    // Switching to LAZY_BUDGET mode immediately enforces the budget.
+    void SetDispCachePolicy(const DispCachePolicy& policy);
+    const DispCachePolicy& GetDispCachePolicy() const;
+    const DispCacheStats&  GetDispCacheStats() const;
+
+    // Must be called once whenever a game tick is finalized, not after every
+    // simulation of it. Drives the tick clock of displacement cache stats and
+    // of LAZY_BUDGET eviction order.
+    void OnSimulationTickFinished();
+
+    // Whether bevel planes of static/dynamic prop sections are generated on
+    // every hull trace or precomputed once, trading memory for speed.
+    enum class XPropBevelPlaneMode {
+        ON_DEMAND,              // Generate on every hull trace
+        PRECOMPUTE_NEAR_SPAWNS, // Precompute for props near player spawns
+        PRECOMPUTE_ALL          // Precompute for all props
+    };
+    static constexpr float NEAR_SPAWN_RADIUS = 1024.0f;
+
+    // Blocks until precomputation is done. Trace results don't change.
+    void SetXPropBevelPlaneMode(XPropBevelPlaneMode mode);
+    XPropBevelPlaneMode GetXPropBevelPlaneMode() const;
+    size_t GetXPropBevelPlaneMemorySize() const; // Of precomputed planes, in bytes
 
 private:
     // Estimate trace cost of each object type
@@ -44,6 +94,13 @@ private:
     void DoSweptTrace_StaticProp  (Trace* trace, uint32_t      sprop_idx); // idx into BspMap.static_props
     void DoSweptTrace_DynamicProp (Trace* trace, uint32_t      dprop_idx); // idx into BspMap.relevant_dynamic_props
 
+    // Displacement collision cache management
+    void OnDispCacheCreated(uint32_t dispcoll_idx); // idx into CDispCollTree array
+    // Destroy least recently used caches until the budget is met, except for
+    // the cache of the given displacement
+    void EnforceDispCacheBudget(uint32_t keep_dispcoll_idx);
+    void PrebuildAllDispCaches();
+
     // Non-moving trace (static intersection test) against single objects
     void DoUnsweptTrace_Brush       (Trace* trace, uint32_t      brush_idx); // idx into BspMap.brushes
     void DoUnsweptTrace_Displacement(Trace* trace, uint32_t   dispcoll_idx); // idx into CDispCollTree array
@@ -58,6 +115,7 @@ private:
 
     // Let some classes access private members:
     friend class ::WorldCreator; // WorldCreator initializes this class
+    friend class ::GlidabilityReport; // Reports need all prop triangles
     friend class BVH;            // BVH is heavily tied to this class
     friend class Debugger;       // Debugger needs to debug
     friend class Benchmark;      // Benchmarks need to benchmark
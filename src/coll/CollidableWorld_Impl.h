@@ -4,17 +4,24 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <Corrade/Containers/Optional.h>
 
 #include "coll/BVH.h"
 #include "coll/CollidableWorld.h"
+#include "coll/CollidableWorld-brush.h"
+#include "coll/CollidableWorld-funcbrush.h"
 #include "coll/CollidableWorld-xprop.h"
 #include "coll/CollidableWorld-displacement.h"
 #include "csgo_parsing/BspMap.h"
 
 namespace coll {
 
+// Constants shared by brush, func_brush and static/dynamic prop collision code
+inline constexpr float DIST_EPSILON  = 0.03125f; // 1/32 epsilon to keep floating point happy
+inline constexpr float NEVER_UPDATED = -9999.0f;
+
 struct CollidableWorld::Impl {
     Impl(std::shared_ptr<const csgo_parsing::BspMap> bsp_map)
         : origin_bsp_map{ bsp_map }
@@ -34,8 +41,9 @@ struct CollidableWorld::Impl {
                                                { Corrade::Containers::NullOpt };
 
     // Collision models used in at least one solid prop (solid or dynamic).
-    // Keys are MDL paths, values are collision models.
-    Optional< std::map<std::string, CollisionModel> > xprop_coll_models =
+    // Keys are MDL paths, values are collision models. These are shared with
+    // other worlds through coll::CollisionModelCache.
+    Optional< std::map<std::string, std::shared_ptr<const CollisionModel>> > xprop_coll_models =
                                                { Corrade::Containers::NullOpt };
 
     // Collision caches of each solid *static* prop.
@@ -48,6 +56,30 @@ struct CollidableWorld::Impl {
     Optional< std::map<uint32_t, CollisionCache_XProp> > coll_caches_dprop =
                                                { Corrade::Containers::NullOpt };
 
+    // Flat collision data of all solid props, used by traces against props.
+    // References collision models in xprop_coll_models!
+    Optional< XPropTraceData > xprop_trace_data =
+                                               { Corrade::Containers::NullOpt };
+
+    XPropBevelPlaneMode xprop_bevel_plane_mode = XPropBevelPlaneMode::ON_DEMAND;
+
+    // Planes of all brushes in BspMap::brushes, laid out for SIMD processing.
+    Optional< BrushPlanesSoA > brush_planes =
+                                               { Corrade::Containers::NullOpt };
+
+    // Rotated brush planes and AABBs of all func_brush entities.
+    Optional< FuncBrushTraceData > func_brush_trace_data =
+                                               { Corrade::Containers::NullOpt };
+
+    // Displacement collision cache management, see SetDispCachePolicy()
+    DispCachePolicy disp_cache_policy;
+    DispCacheStats  disp_cache_stats;
+    uint64_t        disp_cache_builds_cur_tick = 0;
+    uint64_t        disp_cache_tick_cnt        = 0;
+    // Index of the last tick each hull_disp_coll_trees element was traced in.
+    // Only maintained in LAZY_BUDGET mode.
+    std::vector<uint64_t> disp_cache_last_use_tick;
+
     // Bounding volume hierarchy (BVH) that accelerates traces.
     // NOTE: This BVH must only be created after all other collision data
     //       (collision models, caches, etc., see above) was created!
@@ -0,0 +1,465 @@
+#include "coll/CollisionModelCache.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include <Tracy.hpp>
+
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "csgo_parsing/BspMap.h"
+#include "utils_3d.h"
+
+using namespace Corrade;
+using namespace Magnum;
+using namespace coll;
+using namespace utils_3d;
+using Plane = csgo_parsing::BspMap::Plane;
+using Key = CollisionModelCache::Key;
+
+#define PRINT_PREFIX "[CollisionModelCache]"
+
+// Must be changed whenever PHY parsing or the CollisionModel struct changes.
+// This invalidates collision models that older versions saved to disk.
+static constexpr std::string_view FILE_MAGIC = "DZSCM001";
+
+struct CacheEntry {
+    std::shared_ptr<const CollisionModel> cmodel;
+    size_t   bytes;
+    uint64_t last_use; // Value of g_use_counter when last found or inserted
+};
+
+static std::mutex g_mutex; // Guards all following variables
+static std::map<Key, CacheEntry> g_entries;
+static uint64_t    g_use_counter = 0;
+static size_t      g_unused_budget_bytes = 64 * 1024 * 1024;
+static std::string g_disk_cache_dir; // Empty if disk caching is disabled
+static std::string g_requested_disk_cache_dir; // Last one passed by the user
+static uint64_t    g_memory_hits_total = 0;
+static uint64_t    g_disk_hits_total   = 0;
+static uint64_t    g_misses_total      = 0;
+
+// ----------------------------------------------------------------------------
+// Checksums
+
+static constexpr std::array<uint32_t, 256> CRC32_TABLE = [] {
+    std::array<uint32_t, 256> table = {};
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        table[i] = c;
+    }
+    return table;
+}();
+
+// The common CRC-32 variant, e.g. used by ZIP files
+static uint32_t CalcCrc32(std::span<const uint8_t> data) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (uint8_t byte : data)
+        crc = CRC32_TABLE[(crc ^ byte) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// ----------------------------------------------------------------------------
+// Little-endian encoding
+
+template<class T>
+static void WriteInt(std::vector<char>& buf, T val) {
+    auto u = static_cast<std::make_unsigned_t<T>>(val);
+    for (size_t i = 0; i < sizeof(T); i++)
+        buf.push_back((char)(uint8_t)(u >> (8 * i)));
+}
+
+static void WriteFloat(std::vector<char>& buf, float f) {
+    WriteInt(buf, std::bit_cast<uint32_t>(f));
+}
+
+static void WriteVector3(std::vector<char>& buf, const Vector3& v) {
+    for (size_t i = 0; i < 3; i++)
+        WriteFloat(buf, v[i]);
+}
+
+// Reads from a byte range. Once reading fails, all following reads fail too.
+class ByteReader {
+public:
+    ByteReader(const char* begin, const char* end) : _pos{ begin }, _end{ end } {}
+
+    template<class T>
+    bool ReadInt(T* out) {
+        if (_end - _pos < (ptrdiff_t)sizeof(T)) {
+            _pos = _end;
+            return false;
+        }
+        std::make_unsigned_t<T> u = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            u |= (std::make_unsigned_t<T>)(uint8_t)_pos[i] << (8 * i);
+        _pos += sizeof(T);
+        *out = static_cast<T>(u);
+        return true;
+    }
+
+    bool ReadFloat(float* out) {
+        uint32_t bits;
+        if (!ReadInt(&bits)) return false;
+        *out = std::bit_cast<float>(bits);
+        return true;
+    }
+
+    bool ReadVector3(Vector3* out) {
+        for (size_t i = 0; i < 3; i++)
+            if (!ReadFloat(&(*out)[i])) return false;
+        return true;
+    }
+
+    // Reads an element count. Fails if the remaining bytes can't possibly hold
+    // that many elements of the given size, to not allocate absurd amounts of
+    // memory for corrupted files.
+    bool ReadCount(uint32_t* out, size_t elem_size) {
+        if (!ReadInt(out))
+            return false;
+        if (*out > (size_t)(_end - _pos) / elem_size) {
+            _pos = _end;
+            return false;
+        }
+        return true;
+    }
+
+    bool ReadString(std::string* out, size_t len) {
+        if ((size_t)(_end - _pos) < len) {
+            _pos = _end;
+            return false;
+        }
+        out->assign(_pos, len);
+        _pos += len;
+        return true;
+    }
+
+    bool IsAtEnd() const { return _pos == _end; }
+
+private:
+    const char* _pos;
+    const char* _end;
+};
+
+// ----------------------------------------------------------------------------
+// Disk cache files
+
+static std::vector<char> SerializeCollisionModel(const Key& key,
+                                                 const CollisionModel& cmodel)
+{
+    std::vector<char> buf(FILE_MAGIC.begin(), FILE_MAGIC.end());
+    WriteInt(buf, (uint32_t)key.phy_path.size());
+    buf.insert(buf.end(), key.phy_path.begin(), key.phy_path.end());
+    WriteInt(buf, key.file_size);
+    WriteInt(buf, key.file_crc32);
+
+    WriteInt(buf, (uint32_t)cmodel.section_tri_meshes.size());
+    for (size_t i = 0; i < cmodel.section_tri_meshes.size(); i++) {
+        const TriMesh& mesh = cmodel.section_tri_meshes[i];
+        WriteInt(buf, (uint32_t)mesh.vertices.size());
+        for (const Vector3& vert : mesh.vertices)
+            WriteVector3(buf, vert);
+        WriteInt(buf, (uint32_t)mesh.edges.size());
+        for (const TriMesh::Edge& edge : mesh.edges)
+            for (TriMesh::VertIdx v : edge.verts)
+                WriteInt(buf, v);
+        WriteInt(buf, (uint32_t)mesh.tris.size());
+        for (const TriMesh::Tri& tri : mesh.tris)
+            for (TriMesh::VertIdx v : tri.verts)
+                WriteInt(buf, v);
+
+        WriteInt(buf, (uint32_t)cmodel.section_planes[i].size());
+        for (const Plane& plane : cmodel.section_planes[i]) {
+            WriteVector3(buf, plane.normal);
+            WriteFloat(buf, plane.dist);
+        }
+        WriteVector3(buf, cmodel.section_aabbs[i].mins);
+        WriteVector3(buf, cmodel.section_aabbs[i].maxs);
+    }
+    return buf;
+}
+
+// Returns NullOpt if the data is invalid or belongs to another key
+static Containers::Optional<CollisionModel> DeserializeCollisionModel(
+    const Key& key, Containers::ArrayView<const char> data)
+{
+    if (!std::string_view{ data.data(), data.size() }.starts_with(FILE_MAGIC))
+        return Containers::NullOpt;
+    ByteReader reader{ data.data() + FILE_MAGIC.size(), data.data() + data.size() };
+
+    uint32_t path_len;
+    Key file_key;
+    if (!reader.ReadCount(&path_len, 1) ||
+        !reader.ReadString(&file_key.phy_path, path_len) ||
+        !reader.ReadInt(&file_key.file_size) ||
+        !reader.ReadInt(&file_key.file_crc32) ||
+        file_key != key)
+        return Containers::NullOpt;
+
+    CollisionModel cmodel;
+    uint32_t num_sections;
+    if (!reader.ReadCount(&num_sections, 40)) // Min size of a section
+        return Containers::NullOpt;
+    cmodel.section_tri_meshes.resize(num_sections);
+    cmodel.section_planes    .resize(num_sections);
+    cmodel.section_aabbs     .resize(num_sections);
+    for (size_t i = 0; i < num_sections; i++) {
+        TriMesh& mesh = cmodel.section_tri_meshes[i];
+        uint32_t num_verts, num_edges, num_tris, num_planes;
+
+        if (!reader.ReadCount(&num_verts, 12) || num_verts > TriMesh::MAX_VERTICES)
+            return Containers::NullOpt;
+        mesh.vertices.resize(num_verts);
+        for (Vector3& vert : mesh.vertices)
+            if (!reader.ReadVector3(&vert))
+                return Containers::NullOpt;
+
+        if (!reader.ReadCount(&num_edges, 4))
+            return Containers::NullOpt;
+        mesh.edges.resize(num_edges);
+        for (TriMesh::Edge& edge : mesh.edges)
+            for (TriMesh::VertIdx& v : edge.verts)
+                if (!reader.ReadInt(&v) || v >= num_verts)
+                    return Containers::NullOpt;
+
+        if (!reader.ReadCount(&num_tris, 6))
+            return Containers::NullOpt;
+        mesh.tris.resize(num_tris);
+        for (TriMesh::Tri& tri : mesh.tris)
+            for (TriMesh::VertIdx& v : tri.verts)
+                if (!reader.ReadInt(&v) || v >= num_verts)
+                    return Containers::NullOpt;
+
+        // Every triangle has a plane
+        if (!reader.ReadCount(&num_planes, 16) || num_planes != num_tris)
+            return Containers::NullOpt;
+        cmodel.section_planes[i].resize(num_planes);
+        for (Plane& plane : cmodel.section_planes[i])
+            if (!reader.ReadVector3(&plane.normal) || !reader.ReadFloat(&plane.dist))
+                return Containers::NullOpt;
+
+        if (!reader.ReadVector3(&cmodel.section_aabbs[i].mins) ||
+            !reader.ReadVector3(&cmodel.section_aabbs[i].maxs))
+            return Containers::NullOpt;
+    }
+    if (!reader.IsAtEnd())
+        return Containers::NullOpt;
+    return cmodel;
+}
+
+static std::string GetDiskCacheFilePath(const std::string& dir_path, const Key& key)
+{
+    // PHY paths can't be used as file names, use their checksum instead
+    std::span<const uint8_t> path_bytes = {
+        (const uint8_t*)key.phy_path.data(), key.phy_path.size() };
+    char file_name[64];
+    snprintf(file_name, sizeof(file_name), "%08x-%08x-%llx.dzscm",
+             (unsigned)CalcCrc32(path_bytes), (unsigned)key.file_crc32,
+             (unsigned long long)key.file_size);
+    return Utility::Path::join(dir_path, file_name);
+}
+
+static Containers::Optional<CollisionModel> LoadFromDisk(const std::string& dir_path,
+                                                         const Key& key)
+{
+    std::string file_path = GetDiskCacheFilePath(dir_path, key);
+    if (!Utility::Path::exists(file_path))
+        return Containers::NullOpt;
+
+    Containers::Optional<Containers::Array<char>> data =
+        Utility::Path::read(file_path);
+    if (!data)
+        return Containers::NullOpt;
+
+    Containers::Optional<CollisionModel> cmodel =
+        DeserializeCollisionModel(key, *data);
+    if (!cmodel)
+        Utility::Debug{} << PRINT_PREFIX << "Ignoring invalid cache file:"
+                         << file_path.c_str();
+    return cmodel;
+}
+
+static void SaveToDisk(const std::string& dir_path, const Key& key,
+                       const CollisionModel& cmodel)
+{
+    std::string file_path = GetDiskCacheFilePath(dir_path, key);
+    std::vector<char> buf = SerializeCollisionModel(key, cmodel);
+    Containers::ArrayView<const char> av = { buf.data(), buf.size() };
+    if (!Utility::Path::write(file_path, av))
+        Utility::Error{} << PRINT_PREFIX << "Failed to write cache file:"
+                         << file_path.c_str();
+}
+
+// ----------------------------------------------------------------------------
+// Cache
+
+static size_t GetMemorySize(const CollisionModel& cmodel)
+{
+    size_t bytes = sizeof(CollisionModel);
+    for (const TriMesh& mesh : cmodel.section_tri_meshes) {
+        bytes += sizeof(TriMesh);
+        bytes += mesh.vertices.capacity() * sizeof(Vector3);
+        bytes += mesh.edges   .capacity() * sizeof(TriMesh::Edge);
+        bytes += mesh.tris    .capacity() * sizeof(TriMesh::Tri);
+    }
+    for (const std::vector<Plane>& planes : cmodel.section_planes)
+        bytes += sizeof(planes) + planes.capacity() * sizeof(Plane);
+    bytes += cmodel.section_aabbs.capacity() * sizeof(CollisionModel::AABB);
+    return bytes;
+}
+
+// Caller must hold g_mutex. Returns the cached collision model of that key.
+static std::shared_ptr<const CollisionModel> AddEntry(const Key& key,
+                                                      CollisionModel&& cmodel)
+{
+    auto [it, inserted] = g_entries.try_emplace(key);
+    CacheEntry& entry = it->second;
+    if (inserted) {
+        entry.bytes = GetMemorySize(cmodel);
+        entry.cmodel = std::make_shared<const CollisionModel>(std::move(cmodel));
+    }
+    entry.last_use = ++g_use_counter;
+    return entry.cmodel;
+}
+
+// Caller must hold g_mutex
+static void TrimToBudget(size_t budget_bytes)
+{
+    // Collision models only referenced by the cache itself are unused
+    std::vector<std::map<Key, CacheEntry>::iterator> unused;
+    size_t unused_bytes = 0;
+    for (auto it = g_entries.begin(); it != g_entries.end(); ++it) {
+        if (it->second.cmodel.use_count() == 1) {
+            unused.push_back(it);
+            unused_bytes += it->second.bytes;
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) {
+        return a->second.last_use < b->second.last_use;
+    });
+    for (auto it : unused) { // Least recently used first
+        if (unused_bytes <= budget_bytes)
+            break;
+        unused_bytes -= it->second.bytes;
+        g_entries.erase(it);
+    }
+}
+
+Key CollisionModelCache::MakeKey(const std::string& phy_path,
+                                 std::span<const uint8_t> phy_file_content)
+{
+    return {
+        .phy_path   = phy_path,
+        .file_size  = phy_file_content.size(),
+        .file_crc32 = CalcCrc32(phy_file_content)
+    };
+}
+
+std::shared_ptr<const CollisionModel> CollisionModelCache::Find(const Key& key)
+{
+    ZoneScoped;
+    std::string disk_cache_dir;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        auto it = g_entries.find(key);
+        if (it != g_entries.end()) {
+            it->second.last_use = ++g_use_counter;
+            g_memory_hits_total++;
+            return it->second.cmodel;
+        }
+        disk_cache_dir = g_disk_cache_dir;
+    }
+
+    // Don't block other threads during file access
+    Containers::Optional<CollisionModel> cmodel = Containers::NullOpt;
+    if (!disk_cache_dir.empty())
+        cmodel = LoadFromDisk(disk_cache_dir, key);
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (!cmodel) {
+        g_misses_total++;
+        return nullptr;
+    }
+    g_disk_hits_total++;
+    return AddEntry(key, std::move(*cmodel));
+}
+
+std::shared_ptr<const CollisionModel> CollisionModelCache::Insert(
+    const Key& key, CollisionModel&& cmodel)
+{
+    std::shared_ptr<const CollisionModel> cached;
+    std::string disk_cache_dir;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        cached = AddEntry(key, std::move(cmodel));
+        disk_cache_dir = g_disk_cache_dir;
+    }
+    if (!disk_cache_dir.empty())
+        SaveToDisk(disk_cache_dir, key, *cached);
+    return cached;
+}
+
+void CollisionModelCache::SetUnusedMemoryBudget(size_t budget_bytes)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_unused_budget_bytes = budget_bytes;
+}
+
+void CollisionModelCache::Trim()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    TrimToBudget(g_unused_budget_bytes);
+}
+
+void CollisionModelCache::SetDiskCacheDirectory(const std::string& dir_path)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (dir_path == g_requested_disk_cache_dir)
+        return;
+    g_requested_disk_cache_dir = dir_path;
+    if (!dir_path.empty() && !Utility::Path::make(dir_path)) {
+        Utility::Error{} << PRINT_PREFIX << "Failed to create cache directory:"
+                         << dir_path.c_str();
+        g_disk_cache_dir.clear();
+        return;
+    }
+    g_disk_cache_dir = dir_path;
+}
+
+void CollisionModelCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    TrimToBudget(0);
+}
+
+CollisionModelCache::Stats CollisionModelCache::GetStats()
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    Stats stats;
+    for (const auto& [key, entry] : g_entries) {
+        stats.num_models++;
+        stats.model_bytes += entry.bytes;
+        if (entry.cmodel.use_count() == 1) {
+            stats.num_unused_models++;
+            stats.unused_model_bytes += entry.bytes;
+        }
+    }
+    stats.memory_hits_total = g_memory_hits_total;
+    stats.disk_hits_total   = g_disk_hits_total;
+    stats.misses_total      = g_misses_total;
+    return stats;
+}
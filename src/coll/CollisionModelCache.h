@@ -0,0 +1,72 @@
+#ifndef COLL_COLLISIONMODELCACHE_H_
+#define COLL_COLLISIONMODELCACHE_H_
+
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "coll/CollidableWorld-xprop.h"
+
+// Process-wide cache of collision models created from PHY files. Maps often
+// share the same props from CSGO's VPK archives, so loading another map can
+// reuse collision models that were created for a previous one.
+namespace coll {
+
+class CollisionModelCache {
+public:
+    // All methods are thread-safe.
+
+    // Identifies a PHY file by its path and content
+    struct Key {
+        std::string phy_path;
+        uint64_t    file_size;
+        uint32_t    file_crc32;
+
+        auto operator<=>(const Key&) const = default;
+    };
+    static Key MakeKey(const std::string& phy_path,
+                       std::span<const uint8_t> phy_file_content);
+
+    // Returns nullptr if no collision model with this key is cached in memory
+    // or on disk.
+    static std::shared_ptr<const CollisionModel> Find(const Key& key);
+
+    // Caches the given collision model and returns the cached object. If a
+    // collision model with this key is cached already, that one is returned
+    // instead.
+    static std::shared_ptr<const CollisionModel> Insert(const Key& key,
+                                                        CollisionModel&& cmodel);
+
+    // Collision models are kept in memory as long as a loaded world references
+    // them. Unreferenced collision models stay in memory too, until their
+    // total size exceeds this budget. Then, the least recently used ones are
+    // freed on the next call to Trim().
+    static void SetUnusedMemoryBudget(size_t budget_bytes);
+    static void Trim();
+
+    // If a directory is set, collision models are additionally saved to it
+    // and loaded from it when not found in memory. An empty path disables
+    // this. The directory is created if it doesn't exist.
+    static void SetDiskCacheDirectory(const std::string& dir_path);
+
+    // Frees all unreferenced collision models, regardless of the budget
+    static void Clear();
+
+    struct Stats {
+        size_t   num_models        = 0; // Cached in memory
+        size_t   num_unused_models = 0; // Not referenced by a loaded world
+        size_t   model_bytes       = 0;
+        size_t   unused_model_bytes = 0;
+        uint64_t memory_hits_total = 0;
+        uint64_t disk_hits_total   = 0;
+        uint64_t misses_total      = 0;
+    };
+    static Stats GetStats();
+};
+
+} // namespace coll
+
+#endif // COLL_COLLISIONMODELCACHE_H_
@@ -0,0 +1,170 @@
+#include "coll/HiddenGeometry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include <Tracy.hpp>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+
+#include "csgo_parsing/BrushSeparation.h"
+
+using namespace coll;
+using namespace Magnum;
+using namespace csgo_parsing;
+using namespace utils_3d;
+
+HiddenGeometryFinder::HiddenGeometryFinder(const BspMap& bsp_map,
+                                           const BVH& bvh,
+                                           const BrushPlanesSoA& brush_planes)
+    : bvh{ bvh }
+    , brush_planes{ brush_planes }
+{
+    ZoneScoped;
+
+    // Only brushes that are drawn entirely and that can't be seen through hide
+    // geometry. Sky and trigger brushsides aren't drawn with solid brushes.
+    auto test_funcs = BrushSeparation::getBrushCategoryTestFuncs(
+        BrushSeparation::Category::SOLID);
+    is_brush_opaque.resize(bsp_map.brushes.size(), false);
+    for (size_t brush_idx = 0; brush_idx < bsp_map.brushes.size(); brush_idx++) {
+        const BspMap::Brush& brush = bsp_map.brushes[brush_idx];
+        if (!brush.num_sides)
+            continue;
+        if (brush.HasFlags(BspMap::Brush::WINDOW) || brush.HasFlags(BspMap::Brush::GRATE))
+            continue;
+        if (test_funcs.first && !test_funcs.first(brush))
+            continue;
+
+        bool all_sides_drawn = true;
+        for (uint32_t i = 0; i < brush.num_sides; i++) {
+            const BspMap::BrushSide& side = bsp_map.brushsides[brush.first_side + i];
+            if (side.bevel)
+                continue; // Bevel sides don't produce faces
+            if (test_funcs.second && !test_funcs.second(side, bsp_map)) {
+                all_sides_drawn = false;
+                break;
+            }
+        }
+        is_brush_opaque[brush_idx] = all_sides_drawn;
+    }
+}
+
+bool HiddenGeometryFinder::IsConvexShapeHidden(std::span<const Vector3> points,
+    std::vector<uint32_t>* brush_idx_buf) const
+{
+    if (points.empty())
+        return false;
+
+    Vector3 mins = points[0];
+    Vector3 maxs = points[0];
+    for (const Vector3& p : points) {
+        mins = Math::min(mins, p);
+        maxs = Math::max(maxs, p);
+    }
+
+    brush_idx_buf->clear();
+    bvh.GetBrushesTouchingAabb(mins, maxs, brush_idx_buf);
+
+    for (uint32_t brush_idx : *brush_idx_buf) {
+        if (!is_brush_opaque[brush_idx])
+            continue;
+
+        // Brushes are convex, if all points are inside, their hull is as well.
+        const BrushPlanesSoA::Range& range = brush_planes.brush_ranges[brush_idx];
+        const uint32_t plane_end = range.first_plane + range.num_planes;
+        bool all_points_inside = true;
+        for (uint32_t i = range.first_plane; i < plane_end && all_points_inside; i++) {
+            if (brush_planes.side_idx[i] == BrushPlanesSoA::INVALID_SIDE_IDX)
+                continue; // Dummy plane
+            Vector3 normal = { brush_planes.normal_x[i],
+                               brush_planes.normal_y[i],
+                               brush_planes.normal_z[i] };
+            // Plane normals point out of the brush
+            float max_dist = brush_planes.dist[i] - HIDDEN_MARGIN;
+            for (const Vector3& p : points) {
+                if (Math::dot(normal, p) > max_dist) {
+                    all_points_inside = false;
+                    break;
+                }
+            }
+        }
+        if (all_points_inside)
+            return true;
+    }
+    return false;
+}
+
+template<class Func>
+void HiddenGeometryFinder::ParallelFor(size_t count, size_t chunk_size, Func func)
+{
+    if (count == 0)
+        return;
+    size_t num_chunks = (count + chunk_size - 1) / chunk_size;
+
+    // Each thread processes different chunks
+    std::atomic<size_t> next_chunk = 0;
+    auto worker = [&]() {
+        for (size_t c = next_chunk++; c < num_chunks; c = next_chunk++) {
+            size_t end = std::min(count, (c + 1) * chunk_size);
+            for (size_t i = c * chunk_size; i < end; i++)
+                func(i);
+        }
+    };
+#ifdef DZSIM_WEB_PORT
+    worker(); // No threads in the web port
+#else
+    size_t num_threads = std::clamp<size_t>(std::thread::hardware_concurrency(),
+                                            1, num_chunks);
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; i++)
+        threads.emplace_back(worker);
+    worker();
+    for (std::thread& t : threads)
+        t.join();
+#endif
+}
+
+std::vector<uint8_t> HiddenGeometryFinder::FindHiddenFaces(
+    const FaceBuffer& faces) const
+{
+    ZoneScoped;
+
+    // Not std::vector<bool>, threads write to neighbouring elements
+    std::vector<uint8_t> is_face_hidden(faces.NumFaces(), false);
+    const size_t CHUNK_SIZE = 1024;
+    ParallelFor(faces.NumFaces(), CHUNK_SIZE, [&](size_t face_idx) {
+        thread_local std::vector<uint32_t> brush_idx_buf;
+        is_face_hidden[face_idx] =
+            IsConvexShapeHidden(faces.GetFace(face_idx), &brush_idx_buf);
+    });
+    return is_face_hidden;
+}
+
+std::vector<std::vector<uint8_t>> HiddenGeometryFinder::FindHiddenXPropSections(
+    std::span<const XPropInstance> xprops) const
+{
+    ZoneScoped;
+
+    std::vector<std::vector<uint8_t>> is_section_hidden(xprops.size());
+    const size_t CHUNK_SIZE = 16;
+    ParallelFor(xprops.size(), CHUNK_SIZE, [&](size_t xprop_idx) {
+        thread_local std::vector<uint32_t> brush_idx_buf;
+        thread_local std::vector<Vector3>  world_verts;
+
+        const XPropInstance& xprop = xprops[xprop_idx];
+        const auto& section_tri_meshes = xprop.cmodel->section_tri_meshes;
+        std::vector<uint8_t>& hidden = is_section_hidden[xprop_idx];
+        hidden.resize(section_tri_meshes.size(), false);
+
+        for (size_t i = 0; i < section_tri_meshes.size(); i++) {
+            world_verts.clear();
+            for (const Vector3& v : section_tri_meshes[i].vertices)
+                world_verts.push_back(xprop.transformation.transformPoint(v));
+            hidden[i] = IsConvexShapeHidden(world_verts, &brush_idx_buf);
+        }
+    });
+    return is_section_hidden;
+}
@@ -0,0 +1,71 @@
+#ifndef COLL_HIDDENGEOMETRY_H_
+#define COLL_HIDDENGEOMETRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "coll/BVH.h"
+#include "coll/CollidableWorld-brush.h"
+#include "coll/CollidableWorld-xprop.h"
+#include "csgo_parsing/BspMap.h"
+#include "utils_3d.h"
+
+namespace coll {
+
+// Finds map geometry that can never be seen because it's enclosed by a solid,
+// opaque worldspawn brush, e.g. displacement triangles below brush floors or
+// prop sections that are sunk into walls. Such geometry can be left out of
+// render meshes.
+// A convex shape is considered hidden if all of its vertices lie inside one and
+// the same brush, at least HIDDEN_MARGIN units away from its surface. Shapes
+// that are only enclosed by multiple brushes together are not detected.
+class HiddenGeometryFinder {
+public:
+    // CAUTION: The given objects must outlive this HiddenGeometryFinder!
+    HiddenGeometryFinder(const csgo_parsing::BspMap& bsp_map, const BVH& bvh,
+                         const BrushPlanesSoA& brush_planes);
+
+    // Returns true if the convex hull of the given points is hidden.
+    // brush_idx_buf is a scratch buffer that avoids allocations in repeated
+    // calls. Thread-safe.
+    bool IsConvexShapeHidden(std::span<const Magnum::Vector3> points,
+                             std::vector<uint32_t>* brush_idx_buf) const;
+
+    // Returns whether each of the given convex faces is hidden. Uses all CPU
+    // cores.
+    std::vector<uint8_t> FindHiddenFaces(const utils_3d::FaceBuffer& faces) const;
+
+    struct XPropInstance {
+        const CollisionModel* cmodel;
+        Magnum::Matrix4 transformation; // Model scale, rotation, translation
+    };
+    // Returns whether each collision model section of each of the given props
+    // is hidden. Uses all CPU cores.
+    std::vector<std::vector<uint8_t>> FindHiddenXPropSections(
+        std::span<const XPropInstance> xprops) const;
+
+    // How far points must at least be inside a brush to be hidden. Keeps faces
+    // that lie on a brush's surface, these might not be covered entirely.
+    static constexpr float HIDDEN_MARGIN = 0.1f;
+
+private:
+    // Calls func(i) for every i in [0, count), distributed across all CPU cores.
+    template<class Func>
+    static void ParallelFor(size_t count, size_t chunk_size, Func func);
+
+    const BVH&            bvh;
+    const BrushPlanesSoA& brush_planes;
+
+    // Whether each brush hides the geometry inside of it. Same indexing as
+    // BspMap::brushes.
+    std::vector<uint8_t> is_brush_opaque;
+};
+
+} // namespace coll
+
+#endif // COLL_HIDDENGEOMETRY_H_
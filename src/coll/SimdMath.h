@@ -0,0 +1,313 @@
+#ifndef COLL_SIMDMATH_H_
+#define COLL_SIMDMATH_H_
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include <Magnum/Math/Vector3.h>
+
+// Minimal 4-wide float SIMD abstraction used by collision code.
+//
+// Function names and semantics follow source-sdk-2013's mathlib/ssemath.h, so
+// that SIMD code ported from source-sdk-2013 can be used nearly unchanged.
+// Supported backends: SSE2 (x86/x64), NEON (AArch64), WebAssembly SIMD128 and
+// a plain C++ fallback. All backends produce bit-identical results for the
+// arithmetic operations provided here (IEEE single precision, no fused ops).
+//
+// Masks returned by Cmp*SIMD() have all bits of a lane set if the comparison
+// is true for that lane and all bits cleared otherwise.
+//
+// Define COLL_SIMD_FORCE_SCALAR to always use the plain C++ backend.
+
+#if defined(COLL_SIMD_FORCE_SCALAR)
+    #define COLL_SIMD_NONE 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COLL_SIMD_SSE 1
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    #define COLL_SIMD_NEON 1
+    #include <arm_neon.h>
+#elif defined(__wasm_simd128__)
+    #define COLL_SIMD_WASM 1
+    #include <wasm_simd128.h>
+#else
+    #define COLL_SIMD_NONE 1
+#endif
+
+#if defined(_MSC_VER)
+    #define COLL_SIMD_INLINE __forceinline
+#else
+    #define COLL_SIMD_INLINE inline __attribute__((always_inline))
+#endif
+
+namespace coll {
+
+// Name of the SIMD backend this file was compiled with
+#if COLL_SIMD_SSE
+    constexpr const char* SIMD_BACKEND_NAME = "SSE2";
+#elif COLL_SIMD_NEON
+    constexpr const char* SIMD_BACKEND_NAME = "NEON";
+#elif COLL_SIMD_WASM
+    constexpr const char* SIMD_BACKEND_NAME = "WebAssembly SIMD128";
+#else
+    constexpr const char* SIMD_BACKEND_NAME = "None (plain C++)";
+#endif
+
+// -------- start of source-sdk-2013 code --------
+// (taken and modified from source-sdk-2013/<...>/src/public/mathlib/ssemath.h)
+
+#if COLL_SIMD_SSE
+    using fltx4 = __m128;
+#elif COLL_SIMD_NEON
+    using fltx4 = float32x4_t;
+#elif COLL_SIMD_WASM
+    using fltx4 = v128_t;
+#else
+    struct fltx4 { alignas(16) float m128_f32[4]; };
+#endif
+
+#if COLL_SIMD_NONE
+// Helpers of the plain C++ backend
+namespace simd_detail {
+    COLL_SIMD_INLINE uint32_t AsBits(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+    COLL_SIMD_INLINE float AsFloat(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+    COLL_SIMD_INLINE float Mask(bool b) { return AsFloat(b ? 0xFFFFFFFFu : 0u); }
+}
+#define COLL_SIMD_LANEWISE(expr) \
+    fltx4 r; for (int i = 0; i < 4; i++) { r.m128_f32[i] = (expr); } return r;
+#endif
+
+// Load 4 floats from 16-byte aligned memory
+COLL_SIMD_INLINE fltx4 LoadAlignedSIMD(const float* p) {
+#if COLL_SIMD_SSE
+    return _mm_load_ps(p);
+#elif COLL_SIMD_NEON
+    return vld1q_f32(p);
+#elif COLL_SIMD_WASM
+    return wasm_v128_load(p);
+#else
+    COLL_SIMD_LANEWISE(p[i])
+#endif
+}
+
+// Load 4 floats from memory with any alignment
+COLL_SIMD_INLINE fltx4 LoadUnalignedSIMD(const float* p) {
+#if COLL_SIMD_SSE
+    return _mm_loadu_ps(p);
+#elif COLL_SIMD_NEON
+    return vld1q_f32(p);
+#elif COLL_SIMD_WASM
+    return wasm_v128_load(p);
+#else
+    COLL_SIMD_LANEWISE(p[i])
+#endif
+}
+
+// Store 4 floats to 16-byte aligned memory
+COLL_SIMD_INLINE void StoreAlignedSIMD(float* p, const fltx4& a) {
+#if COLL_SIMD_SSE
+    _mm_store_ps(p, a);
+#elif COLL_SIMD_NEON
+    vst1q_f32(p, a);
+#elif COLL_SIMD_WASM
+    wasm_v128_store(p, a);
+#else
+    for (int i = 0; i < 4; i++) p[i] = a.m128_f32[i];
+#endif
+}
+
+// Store 4 floats to memory with any alignment
+COLL_SIMD_INLINE void StoreUnalignedSIMD(float* p, const fltx4& a) {
+#if COLL_SIMD_SSE
+    _mm_storeu_ps(p, a);
+#elif COLL_SIMD_NEON
+    vst1q_f32(p, a);
+#elif COLL_SIMD_WASM
+    wasm_v128_store(p, a);
+#else
+    for (int i = 0; i < 4; i++) p[i] = a.m128_f32[i];
+#endif
+}
+
+// Returns (f, f, f, f)
+COLL_SIMD_INLINE fltx4 ReplicateX4(float f) {
+#if COLL_SIMD_SSE
+    return _mm_set1_ps(f);
+#elif COLL_SIMD_NEON
+    return vdupq_n_f32(f);
+#elif COLL_SIMD_WASM
+    return wasm_f32x4_splat(f);
+#else
+    COLL_SIMD_LANEWISE(f)
+#endif
+}
+
+// Returns (x, y, z, w)
+COLL_SIMD_INLINE fltx4 LoadSIMD(float x, float y, float z, float w) {
+    alignas(16) float v[4] = { x, y, z, w };
+    return LoadAlignedSIMD(v);
+}
+
+COLL_SIMD_INLINE float SubFloat(const fltx4& a, int idx) {
+    alignas(16) float v[4];
+    StoreAlignedSIMD(v, a);
+    return v[idx];
+}
+
+// Defines a function taking two fltx4 'a' and 'b'. One expression per backend.
+// The plain C++ expression is evaluated per lane, with lanes A[i] and B[i].
+#if COLL_SIMD_SSE
+    #define COLL_SIMD_BINARY_OP(name, sse, neon, wasm, scalar) \
+        COLL_SIMD_INLINE fltx4 name(const fltx4& a, const fltx4& b) { return sse; }
+#elif COLL_SIMD_NEON
+    #define COLL_SIMD_BINARY_OP(name, sse, neon, wasm, scalar) \
+        COLL_SIMD_INLINE fltx4 name(const fltx4& a, const fltx4& b) { return neon; }
+#elif COLL_SIMD_WASM
+    #define COLL_SIMD_BINARY_OP(name, sse, neon, wasm, scalar) \
+        COLL_SIMD_INLINE fltx4 name(const fltx4& a, const fltx4& b) { return wasm; }
+#else
+    #define COLL_SIMD_BINARY_OP(name, sse, neon, wasm, scalar) \
+        COLL_SIMD_INLINE fltx4 name(const fltx4& a, const fltx4& b) { \
+            using namespace simd_detail; \
+            const float* A = a.m128_f32; const float* B = b.m128_f32; \
+            COLL_SIMD_LANEWISE(scalar) \
+        }
+#endif
+
+#define U32(x) vreinterpretq_u32_f32(x)
+#define F32(x) vreinterpretq_f32_u32(x)
+
+// Arithmetic
+COLL_SIMD_BINARY_OP(AddSIMD, _mm_add_ps(a, b), vaddq_f32(a, b), wasm_f32x4_add(a, b), A[i] + B[i])
+COLL_SIMD_BINARY_OP(SubSIMD, _mm_sub_ps(a, b), vsubq_f32(a, b), wasm_f32x4_sub(a, b), A[i] - B[i])
+COLL_SIMD_BINARY_OP(MulSIMD, _mm_mul_ps(a, b), vmulq_f32(a, b), wasm_f32x4_mul(a, b), A[i] * B[i])
+COLL_SIMD_BINARY_OP(DivSIMD, _mm_div_ps(a, b), vdivq_f32(a, b), wasm_f32x4_div(a, b), A[i] / B[i])
+
+// Lane-wise max/min. Like SSE, if lanes compare equal or unordered, the lane
+// of b is returned.
+COLL_SIMD_BINARY_OP(MaxSIMD, _mm_max_ps(a, b), vbslq_f32(vcgtq_f32(a, b), a, b),
+                    wasm_f32x4_pmax(b, a), A[i] > B[i] ? A[i] : B[i])
+COLL_SIMD_BINARY_OP(MinSIMD, _mm_min_ps(a, b), vbslq_f32(vcltq_f32(a, b), a, b),
+                    wasm_f32x4_pmin(b, a), A[i] < B[i] ? A[i] : B[i])
+
+// Comparisons, returning masks
+COLL_SIMD_BINARY_OP(CmpEqSIMD, _mm_cmpeq_ps(a, b), F32(vceqq_f32(a, b)), wasm_f32x4_eq(a, b), Mask(A[i] == B[i]))
+COLL_SIMD_BINARY_OP(CmpGtSIMD, _mm_cmpgt_ps(a, b), F32(vcgtq_f32(a, b)), wasm_f32x4_gt(a, b), Mask(A[i] >  B[i]))
+COLL_SIMD_BINARY_OP(CmpGeSIMD, _mm_cmpge_ps(a, b), F32(vcgeq_f32(a, b)), wasm_f32x4_ge(a, b), Mask(A[i] >= B[i]))
+COLL_SIMD_BINARY_OP(CmpLtSIMD, _mm_cmplt_ps(a, b), F32(vcltq_f32(a, b)), wasm_f32x4_lt(a, b), Mask(A[i] <  B[i]))
+COLL_SIMD_BINARY_OP(CmpLeSIMD, _mm_cmple_ps(a, b), F32(vcleq_f32(a, b)), wasm_f32x4_le(a, b), Mask(A[i] <= B[i]))
+
+// Bitwise operations
+COLL_SIMD_BINARY_OP(AndSIMD, _mm_and_ps(a, b), F32(vandq_u32(U32(a), U32(b))),
+                    wasm_v128_and(a, b), AsFloat(AsBits(A[i]) & AsBits(B[i])))
+COLL_SIMD_BINARY_OP(OrSIMD,  _mm_or_ps(a, b),  F32(vorrq_u32(U32(a), U32(b))),
+                    wasm_v128_or(a, b),  AsFloat(AsBits(A[i]) | AsBits(B[i])))
+// Returns (~a & b)
+COLL_SIMD_BINARY_OP(AndNotSIMD, _mm_andnot_ps(a, b), F32(vbicq_u32(U32(b), U32(a))),
+                    wasm_v128_andnot(b, a), AsFloat(~AsBits(A[i]) & AsBits(B[i])))
+
+#undef U32
+#undef F32
+#undef COLL_SIMD_BINARY_OP
+
+// Returns (mask ? a : b), lane-wise. Lanes of mask must be all ones or zeros.
+COLL_SIMD_INLINE fltx4 MaskedAssign(const fltx4& mask, const fltx4& a,
+                                    const fltx4& b) {
+    return OrSIMD(AndSIMD(mask, a), AndNotSIMD(mask, b));
+}
+
+// Lane-wise square root
+COLL_SIMD_INLINE fltx4 SqrtSIMD(const fltx4& a) {
+#if COLL_SIMD_SSE
+    return _mm_sqrt_ps(a);
+#elif COLL_SIMD_NEON
+    return vsqrtq_f32(a);
+#elif COLL_SIMD_WASM
+    return wasm_f32x4_sqrt(a);
+#else
+    COLL_SIMD_LANEWISE(std::sqrt(a.m128_f32[i]))
+#endif
+}
+
+// Returns a 4-bit integer whose bit i is the sign bit of lane i. Applied to a
+// mask, bit i is set if the comparison was true for lane i.
+COLL_SIMD_INLINE int TestSignSIMD(const fltx4& a) {
+#if COLL_SIMD_SSE
+    return _mm_movemask_ps(a);
+#elif COLL_SIMD_NEON
+    static const int32_t shifts[4] = { 0, 1, 2, 3 };
+    uint32x4_t sign_bits = vshrq_n_u32(vreinterpretq_u32_f32(a), 31);
+    return (int)vaddvq_u32(vshlq_u32(sign_bits, vld1q_s32(shifts)));
+#elif COLL_SIMD_WASM
+    return (int)wasm_i32x4_bitmask(a);
+#else
+    int result = 0;
+    for (int i = 0; i < 4; i++)
+        result |= (int)(simd_detail::AsBits(a.m128_f32[i]) >> 31) << i;
+    return result;
+#endif
+}
+
+// Returns true if the sign bit of any lane is set
+COLL_SIMD_INLINE bool IsAnyNegative(const fltx4& a) {
+    return TestSignSIMD(a) != 0;
+}
+
+// Constants
+COLL_SIMD_INLINE fltx4 Four_Zeros() { return ReplicateX4(0.0f); }
+COLL_SIMD_INLINE fltx4 Four_Ones () { return ReplicateX4(1.0f); }
+
+// 4 three-dimensional vectors, stored as one fltx4 per component.
+struct alignas(16) FourVectors {
+    fltx4 x, y, z;
+
+    // Set all 4 vectors to v
+    COLL_SIMD_INLINE void DuplicateVector(const Magnum::Vector3& v) {
+        x = ReplicateX4(v.x());
+        y = ReplicateX4(v.y());
+        z = ReplicateX4(v.z());
+    }
+
+    // Set the 4 vectors to a, b, c and d
+    COLL_SIMD_INLINE void LoadAndSwizzle(const Magnum::Vector3& a,
+        const Magnum::Vector3& b, const Magnum::Vector3& c,
+        const Magnum::Vector3& d) {
+        x = LoadSIMD(a.x(), b.x(), c.x(), d.x());
+        y = LoadSIMD(a.y(), b.y(), c.y(), d.y());
+        z = LoadSIMD(a.z(), b.z(), c.z(), d.z());
+    }
+
+    // Returns the vector at index idx (0 to 3)
+    COLL_SIMD_INLINE Magnum::Vector3 Vec(int idx) const {
+        return { SubFloat(x, idx), SubFloat(y, idx), SubFloat(z, idx) };
+    }
+
+    COLL_SIMD_INLINE void operator+=(const FourVectors& b) {
+        x = AddSIMD(x, b.x); y = AddSIMD(y, b.y); z = AddSIMD(z, b.z);
+    }
+    COLL_SIMD_INLINE void operator-=(const FourVectors& b) {
+        x = SubSIMD(x, b.x); y = SubSIMD(y, b.y); z = SubSIMD(z, b.z);
+    }
+    COLL_SIMD_INLINE void operator*=(const FourVectors& b) {
+        x = MulSIMD(x, b.x); y = MulSIMD(y, b.y); z = MulSIMD(z, b.z);
+    }
+};
+
+// Component-wise maximum/minimum of 4 vector pairs
+COLL_SIMD_INLINE FourVectors maximum(const FourVectors& a, const FourVectors& b) {
+    return { MaxSIMD(a.x, b.x), MaxSIMD(a.y, b.y), MaxSIMD(a.z, b.z) };
+}
+COLL_SIMD_INLINE FourVectors minimum(const FourVectors& a, const FourVectors& b) {
+    return { MinSIMD(a.x, b.x), MinSIMD(a.y, b.y), MinSIMD(a.z, b.z) };
+}
+
+// --------- end of source-sdk-2013 code ---------
+
+} // namespace coll
+
+#if COLL_SIMD_NONE
+#undef COLL_SIMD_LANEWISE
+#endif
+
+#endif // COLL_SIMDMATH_H_
@@ -26,10 +26,10 @@ bool Trace::HitsAabb(const Magnum::Vector3 &aabb_mins,
     // (taken and modified from source-sdk-2013/<...>/src/public/dispcoll_common.cpp)
     // (AABB trace code was originally found in IntersectRayWithFourBoxes())
 
-    // NOTE: The original code was SIMD optimized. DZSimulator does not utilize
-    //       SIMD for now. Furthermore, all CDispVector that were 16-aligned
-    //       have been replaced with unaligned std::vector. Is their alignment
-    //       necessary for SIMD?
+    // NOTE: The original code tested four AABBs at once using SIMD. Its SIMD
+    //       version lives on in displacement collision code, see
+    //       IntersectRayWithFourBoxes() and coll/SimdMath.h. This method tests
+    //       a single AABB and stays scalar.
 
     Vector3 hit_mins = aabb_mins;
     Vector3 hit_maxs = aabb_maxs;
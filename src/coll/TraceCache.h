@@ -0,0 +1,60 @@
+#ifndef COLL_TRACECACHE_H_
+#define COLL_TRACECACHE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+namespace coll {
+
+// Temporal trace cache of a single moving object (e.g. a player).
+//
+// An object that stands still or moves slowly performs many traces per tick
+// that are near-identical to the traces of previous ticks (ground checks,
+// unduck checks, etc.). Instead of traversing the entire BVH for each of them,
+// the cache remembers all BVH leaves that overlap a region around the object.
+// Traces that stay inside that region are only tested against those leaves.
+// Once a trace leaves the region, the region is moved and its leaves are
+// collected again.
+//
+// Pass a TraceCache to CollidableWorld::DoTrace() to make use of it. A cache
+// automatically invalidates itself once it's used with a different map.
+// Trace results are identical to uncached traces, except for which of
+// multiple objects hit at the exact same fraction is reported.
+// Caches can't be copied, they're meant to be owned by whoever simulates the
+// object, not by copyable simulation state.
+// CAUTION: Not thread-safe, don't use the same cache in multiple threads!
+class TraceCache {
+public:
+    TraceCache() = default;
+    TraceCache(const TraceCache&) = delete;
+    TraceCache& operator=(const TraceCache&) = delete;
+
+    // Invalidate cached data. The next trace refills the cache.
+    void Clear() { bvh_id = 0; leaf_indices.clear(); }
+
+private:
+    // ID of the BVH the cached data refers to. 0 means invalid cache.
+    uint64_t bvh_id = 0;
+
+    // Region around the object. Every BVH leaf whose AABB touches this region
+    // is cached.
+    Magnum::Vector3 region_mins;
+    Magnum::Vector3 region_maxs;
+    // Indices into BVH::leaves, in BVH traversal order
+    std::vector<uint32_t> leaf_indices;
+
+    // Scratch memory to avoid allocations on every cached trace
+    struct Candidate {
+        uint32_t leaf_idx;
+        float aabb_hit_fraction;
+    };
+    std::vector<Candidate> candidates;
+
+    friend class BVH;
+};
+
+} // namespace coll
+
+#endif // COLL_TRACECACHE_H_
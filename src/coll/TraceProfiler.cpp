@@ -0,0 +1,309 @@
+#include "coll/TraceProfiler.h"
+
+#include <cfloat>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/ImGuiIntegration/Context.hpp>
+
+#include <json.hpp>
+
+#include "coll/BVH.h"
+
+using namespace coll;
+using namespace Corrade;
+using json = nlohmann::json;
+
+#define PRINT_PREFIX "[TraceProfiler]"
+
+// Number of most recent ticks whose individual stats are kept
+static const size_t MAX_RECENT_TICKS = 128;
+
+bool                       TraceProfiler::s_enabled       = false;
+TraceProfiler::CallSite    TraceProfiler::s_cur_call_site = CallSite::Other;
+TraceProfiler::TickStats   TraceProfiler::s_cur_tick      = {};
+
+static uint64_t                          g_finished_tick_cnt = 0;
+static TraceProfiler::TickStats          g_accumulated_ticks = {};
+static TraceProfiler::TickStats          g_most_expensive_tick = {};
+static uint64_t                          g_most_expensive_tick_duration_ns = 0;
+static std::deque<TraceProfiler::TickStats> g_recent_ticks; // Newest at the back
+
+static uint64_t GetTimestampNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(
+        steady_clock::now().time_since_epoch()).count();
+}
+
+const char* TraceProfiler::GetCallSiteName(CallSite call_site)
+{
+    switch (call_site) {
+    case CallSite::Other:                     return "Other";
+    case CallSite::TryPlayerMove:             return "TryPlayerMove";
+    case CallSite::CategorizePosition:        return "CategorizePosition";
+    case CallSite::TryTouchGroundInQuadrants: return "TryTouchGroundInQuadrants";
+    case CallSite::StayOnGround:              return "StayOnGround";
+    case CallSite::CanUnduck:                 return "CanUnduck";
+    case CallSite::BumpMine:                  return "BumpMine";
+    default:                                  return "Unknown";
+    }
+}
+
+const char* TraceProfiler::GetLeafTypeName(size_t leaf_type)
+{
+    switch (leaf_type) {
+    case BVH::Leaf::Type::Brush:        return "Brush";
+    case BVH::Leaf::Type::Displacement: return "Displacement";
+    case BVH::Leaf::Type::StaticProp:   return "StaticProp";
+    case BVH::Leaf::Type::DynamicProp:  return "DynamicProp";
+    case BVH::Leaf::Type::FuncBrush:    return "FuncBrush";
+    default:                            return "Unknown";
+    }
+}
+
+TraceProfiler::ScopedCallSite::ScopedCallSite(CallSite call_site)
+    : _prev_call_site{ s_cur_call_site }
+{
+    s_cur_call_site = call_site;
+}
+
+TraceProfiler::ScopedCallSite::~ScopedCallSite()
+{
+    s_cur_call_site = _prev_call_site;
+}
+
+TraceProfiler::ScopedSuspend::ScopedSuspend()
+    : _was_enabled{ s_enabled }
+{
+    // Don't use SetEnabled(), stats of the current tick must be kept
+    s_enabled = false;
+}
+
+TraceProfiler::ScopedSuspend::~ScopedSuspend()
+{
+    s_enabled = _was_enabled;
+}
+
+void TraceProfiler::SetEnabled(bool enabled)
+{
+    if (enabled == s_enabled)
+        return;
+    s_enabled = enabled;
+    // Don't let a partially recorded tick leak into the stats
+    s_cur_tick = {};
+}
+
+void TraceProfiler::Reset()
+{
+    s_cur_tick = {};
+    g_finished_tick_cnt = 0;
+    g_accumulated_ticks = {};
+    g_most_expensive_tick = {};
+    g_most_expensive_tick_duration_ns = 0;
+    g_recent_ticks.clear();
+}
+
+uint64_t TraceProfiler::OnTraceStart()
+{
+    if (!s_enabled)
+        return 0;
+    return GetTimestampNs();
+}
+
+void TraceProfiler::OnTraceFinish(uint64_t start_timestamp_ns)
+{
+    if (!s_enabled)
+        return;
+    CallSiteStats& stats = s_cur_tick.call_sites[(size_t)s_cur_call_site];
+    stats.trace_cnt++;
+    // If profiling was enabled during this trace, we have no start time stamp
+    if (start_timestamp_ns != 0)
+        stats.duration_ns += GetTimestampNs() - start_timestamp_ns;
+}
+
+void TraceProfiler::OnTickFinished()
+{
+    if (!s_enabled)
+        return;
+
+    g_finished_tick_cnt++;
+    for (size_t i = 0; i < (size_t)CallSite::COUNT; i++)
+        g_accumulated_ticks.call_sites[i].Add(s_cur_tick.call_sites[i]);
+
+    uint64_t tick_duration_ns = s_cur_tick.GetTotal().duration_ns;
+    if (tick_duration_ns >= g_most_expensive_tick_duration_ns) {
+        g_most_expensive_tick_duration_ns = tick_duration_ns;
+        g_most_expensive_tick = s_cur_tick;
+    }
+
+    g_recent_ticks.push_back(s_cur_tick);
+    if (g_recent_ticks.size() > MAX_RECENT_TICKS)
+        g_recent_ticks.pop_front();
+
+    s_cur_tick = {};
+}
+
+uint64_t TraceProfiler::CallSiteStats::GetTotalLeavesTested() const
+{
+    uint64_t sum = 0;
+    for (uint64_t cnt : leaves_tested)
+        sum += cnt;
+    return sum;
+}
+
+void TraceProfiler::CallSiteStats::Add(const CallSiteStats& other)
+{
+    trace_cnt         += other.trace_cnt;
+    bvh_nodes_visited += other.bvh_nodes_visited;
+    for (size_t i = 0; i < TraceProfiler::NUM_LEAF_TYPES; i++)
+        leaves_tested[i] += other.leaves_tested[i];
+    duration_ns       += other.duration_ns;
+}
+
+TraceProfiler::CallSiteStats TraceProfiler::TickStats::GetTotal() const
+{
+    CallSiteStats total;
+    for (const CallSiteStats& stats : call_sites)
+        total.Add(stats);
+    return total;
+}
+
+static json CallSiteStatsToJson(const TraceProfiler::CallSiteStats& stats)
+{
+    json leaves = json::object();
+    for (size_t i = 0; i < TraceProfiler::NUM_LEAF_TYPES; i++)
+        leaves[TraceProfiler::GetLeafTypeName(i)] = stats.leaves_tested[i];
+
+    json j = json::object();
+    j["trace_cnt"]         = stats.trace_cnt;
+    j["bvh_nodes_visited"] = stats.bvh_nodes_visited;
+    j["leaves_tested"]     = std::move(leaves);
+    j["duration_ns"]       = stats.duration_ns;
+    return j;
+}
+
+static json TickStatsToJson(const TraceProfiler::TickStats& tick)
+{
+    using CallSite = TraceProfiler::CallSite;
+    json j = json::object();
+    for (size_t i = 0; i < (size_t)CallSite::COUNT; i++) {
+        const char* name = TraceProfiler::GetCallSiteName((CallSite)i);
+        j[name] = CallSiteStatsToJson(tick.call_sites[i]);
+    }
+    j["Total"] = CallSiteStatsToJson(tick.GetTotal());
+    return j;
+}
+
+std::string TraceProfiler::GetStatsAsJson()
+{
+    json recent = json::array();
+    for (const TickStats& tick : g_recent_ticks)
+        recent.push_back(TickStatsToJson(tick));
+
+    json root = json::object();
+    root["tick_cnt"]           = g_finished_tick_cnt;
+    root["accumulated_ticks"]  = TickStatsToJson(g_accumulated_ticks);
+    root["most_expensive_tick"] = TickStatsToJson(g_most_expensive_tick);
+    root["recent_ticks"]       = std::move(recent); // Oldest first
+    return root.dump(2);
+}
+
+bool TraceProfiler::DumpStatsToJsonFile(Containers::StringView file_path)
+{
+    std::string contents = GetStatsAsJson();
+    Containers::ArrayView<const char> av = { contents.data(), contents.size() };
+    if (!Utility::Path::write(file_path, av)) {
+        Utility::Error{} << PRINT_PREFIX << "Failed to write stats to file:"
+                         << file_path;
+        return false;
+    }
+    Utility::Debug{} << PRINT_PREFIX << "Wrote stats to file:" << file_path;
+    return true;
+}
+
+void TraceProfiler::DrawImGuiElements()
+{
+    bool enabled = s_enabled;
+    if (ImGui::Checkbox("Profile traces", &enabled))
+        SetEnabled(enabled);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Reset"))
+        Reset();
+
+#ifndef DZSIM_WEB_PORT
+    ImGui::SameLine();
+    if (ImGui::Button("Dump to JSON file")) {
+        Containers::Optional<Containers::String> cfg_dir =
+            Utility::Path::configurationDirectory("DZSimulator");
+        if (cfg_dir && Utility::Path::make(*cfg_dir))
+            DumpStatsToJsonFile(
+                Utility::Path::join(*cfg_dir, "TraceProfile.json"));
+    }
+#endif
+
+    ImGui::Text("Profiled ticks: %llu", (unsigned long long)g_finished_tick_cnt);
+    if (g_finished_tick_cnt == 0)
+        return;
+
+    // Trace time of recent ticks
+    float recent_tick_durations_us[MAX_RECENT_TICKS];
+    size_t recent_tick_cnt = g_recent_ticks.size();
+    for (size_t i = 0; i < recent_tick_cnt; i++)
+        recent_tick_durations_us[i] =
+            1e-3f * g_recent_ticks[i].GetTotal().duration_ns;
+    ImGui::PlotLines("Trace time per tick (us)", recent_tick_durations_us,
+                     (int)recent_tick_cnt, 0, nullptr, 0.0f, FLT_MAX,
+                     ImVec2(0.0f, 60.0f));
+
+    ImGui::Text("Most expensive tick: %.1f us",
+                1e-3f * g_most_expensive_tick_duration_ns);
+
+    // Per-call-site averages over all profiled ticks
+    const float tick_cnt = (float)g_finished_tick_cnt;
+    const float total_duration_ns =
+        (float)g_accumulated_ticks.GetTotal().duration_ns;
+
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_SizingFixedFit;
+    const int column_cnt = 5 + TraceProfiler::NUM_LEAF_TYPES;
+    if (!ImGui::BeginTable("trace_profiler_table", column_cnt, flags))
+        return;
+
+    ImGui::TableSetupColumn("Call site (avg per tick)");
+    ImGui::TableSetupColumn("Traces");
+    ImGui::TableSetupColumn("us");
+    ImGui::TableSetupColumn("Time %");
+    ImGui::TableSetupColumn("Nodes");
+    for (size_t i = 0; i < TraceProfiler::NUM_LEAF_TYPES; i++)
+        ImGui::TableSetupColumn(GetLeafTypeName(i));
+    ImGui::TableHeadersRow();
+
+    auto draw_row = [&](const char* name, const CallSiteStats& stats) {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn(); ImGui::Text("%s", name);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", stats.trace_cnt / tick_cnt);
+        ImGui::TableNextColumn(); ImGui::Text("%.2f", 1e-3f * stats.duration_ns / tick_cnt);
+        ImGui::TableNextColumn(); ImGui::Text("%.1f", total_duration_ns == 0.0f ?
+            0.0f : 100.0f * stats.duration_ns / total_duration_ns);
+        ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.bvh_nodes_visited / tick_cnt);
+        for (size_t i = 0; i < TraceProfiler::NUM_LEAF_TYPES; i++) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", stats.leaves_tested[i] / tick_cnt);
+        }
+    };
+
+    for (size_t i = 0; i < (size_t)CallSite::COUNT; i++)
+        draw_row(GetCallSiteName((CallSite)i), g_accumulated_ticks.call_sites[i]);
+    draw_row("Total", g_accumulated_ticks.GetTotal());
+
+    ImGui::EndTable();
+}
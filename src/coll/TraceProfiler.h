@@ -0,0 +1,133 @@
+#ifndef COLL_TRACEPROFILER_H_
+#define COLL_TRACEPROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <Corrade/Containers/StringView.h>
+
+#include "coll/BVH.h"
+
+// Trace cost profiler. Attributes the cost of every CollidableWorld::DoTrace()
+// call to the game code location (call site) that requested it.
+namespace coll {
+
+class TraceProfiler {
+public:
+    // CAUTION: coll::TraceProfiler is not thread-safe yet! Only traces of the
+    //          main thread are allowed to be profiled.
+
+    // Game code locations that perform traces. Whenever a trace is performed,
+    // its cost is attributed to the innermost call site that's currently
+    // active (see ScopedCallSite).
+    // COUNT must remain the last enum entry.
+    enum class CallSite {
+        Other, // Traces outside of any explicitly marked call site
+        TryPlayerMove,
+        CategorizePosition,
+        TryTouchGroundInQuadrants,
+        StayOnGround,
+        CanUnduck,
+        BumpMine,
+        COUNT
+    };
+    static const char* GetCallSiteName(CallSite call_site);
+
+    static constexpr size_t NUM_LEAF_TYPES = BVH::Leaf::Type::COUNT;
+    static const char* GetLeafTypeName(size_t leaf_type);
+
+    // Marks all traces performed during this object's lifetime as originating
+    // from the given call site. Can be nested, the innermost one wins.
+    class ScopedCallSite {
+    public:
+        ScopedCallSite(CallSite call_site);
+        ~ScopedCallSite();
+        ScopedCallSite(const ScopedCallSite&) = delete;
+        ScopedCallSite& operator=(const ScopedCallSite&) = delete;
+    private:
+        CallSite _prev_call_site;
+    };
+
+    // Excludes all traces performed during this object's lifetime from the
+    // stats, e.g. traces of simulations that aren't part of the game's ticks.
+    // Can be nested.
+    class ScopedSuspend {
+    public:
+        ScopedSuspend();
+        ~ScopedSuspend();
+        ScopedSuspend(const ScopedSuspend&) = delete;
+        ScopedSuspend& operator=(const ScopedSuspend&) = delete;
+    private:
+        bool _was_enabled;
+    };
+
+    // Profiling is turned off by default. When turned off, all profiling hooks
+    // return immediately.
+    static bool IsEnabled() { return s_enabled; }
+    static void SetEnabled(bool enabled);
+
+    // Discard all recorded stats
+    static void Reset();
+
+    // -------------------------------------------------------------------------
+
+    // Profiling hooks, called by collision code.
+
+    // Must be called around each trace. Returns the trace's start time stamp
+    // that must be passed to OnTraceFinish().
+    static uint64_t OnTraceStart();
+    static void     OnTraceFinish(uint64_t start_timestamp_ns);
+
+    // Called by BVH traversal
+    static void OnBvhNodeVisited() {
+        if (s_enabled) s_cur_tick.call_sites[(size_t)s_cur_call_site].bvh_nodes_visited++;
+    }
+    static void OnBvhLeafTested(BVH::Leaf::Type type) {
+        if (s_enabled) s_cur_tick.call_sites[(size_t)s_cur_call_site].leaves_tested[type]++;
+    }
+
+    // Must be called once whenever a game tick is finalized, not after every
+    // simulation of it. Finalizes stats of the current tick. These include
+    // all traces since the previous call, e.g. those of re-simulated
+    // predictions of that tick.
+    static void OnTickFinished();
+
+    // -------------------------------------------------------------------------
+
+    // Stats of all traces of one call site, accumulated over one or more ticks
+    struct CallSiteStats {
+        uint64_t trace_cnt         = 0;
+        uint64_t bvh_nodes_visited = 0;
+        uint64_t leaves_tested[NUM_LEAF_TYPES] = {}; // Indexed by BVH leaf type
+        uint64_t duration_ns       = 0;
+
+        uint64_t GetTotalLeavesTested() const;
+        void Add(const CallSiteStats& other);
+    };
+    struct TickStats {
+        CallSiteStats call_sites[(size_t)CallSite::COUNT];
+
+        CallSiteStats GetTotal() const;
+    };
+
+    // Returns stats as JSON string. Contains accumulated stats of all ticks
+    // since the last reset, stats of the most expensive tick and stats of
+    // recent ticks.
+    static std::string GetStatsAsJson();
+
+    // Writes GetStatsAsJson() to the given file. Returns success.
+    static bool DumpStatsToJsonFile(Corrade::Containers::StringView file_path);
+
+    // Handle/show the trace profiler menu elements
+    static void DrawImGuiElements();
+
+private:
+    static bool     s_enabled;
+    static CallSite s_cur_call_site;
+    static TickStats s_cur_tick; // Unfinished stats of the current tick
+};
+
+} // namespace coll
+
+#endif // COLL_TRACEPROFILER_H_
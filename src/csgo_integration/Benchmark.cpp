@@ -0,0 +1,350 @@
+#include "csgo_integration/Benchmark.h"
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED // When disabled, don't waste time compiling this file
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <Corrade/Utility/Debug.h>
+#include <json.hpp>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "csgo_integration/ConsoleParsing.h"
+#include "csgo_integration/DataRelayDecoder.h"
+#include "csgo_integration/Handler.h"
+#include "csgo_parsing/utils.h"
+
+using namespace csgo_integration;
+using namespace Magnum;
+
+using ServerTick = Handler::CsgoServerTickData;
+using ClientData = Handler::CsgoClientsideData;
+
+namespace {
+
+// Game data extracted from a relay log
+struct ParseOutput {
+    std::deque<ServerTick> server_ticks;
+    std::deque<ClientData> client_data;
+    ServerTick incomplete_tick;
+    DataRelayDecoder relay_decoder;
+
+    void Clear() {
+        server_ticks.clear();
+        client_data.clear();
+        incomplete_tick = ServerTick();
+        relay_decoder.Reset();
+    }
+};
+
+// ConsoleParsing::ParseGameDataLine() before it was made allocation-free. Only
+// understands data relay v1 output.
+void ParseLine_Old(const std::string& line, ParseOutput& out)
+{
+    bool is_server_data_start_marker = line.starts_with("dzs-dr-v1-tick-start ");
+    bool is_server_player_data       = line.starts_with("player ");
+    bool is_server_bump_mine_data    = line.starts_with("bm ");
+    bool is_server_data_end_marker   = line.starts_with("dzs-dr-v1-tick-end");
+    bool is_client_player_data       = line.starts_with("setpos ");
+
+    if (is_server_data_start_marker || is_server_player_data || is_server_bump_mine_data) {
+        std::vector<std::string> tokens =
+            csgo_parsing::utils::SplitString(line, ' ');
+        try {
+            if (is_server_data_start_marker) {
+                if (tokens.size() < 2) return;
+                out.incomplete_tick.tick_id = std::stoi(tokens[1]);
+            }
+            else if (is_server_player_data) {
+                if (tokens.size() < 9) return;
+                Vector3 feet_pos = { std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]) };
+                Vector3 eye_pos  = { feet_pos.x(), feet_pos.y(), std::stof(tokens[4]) };
+                Vector3 vel      = { std::stof(tokens[6]), std::stof(tokens[7]), std::stof(tokens[8]) };
+                out.incomplete_tick.player_pos_feet = feet_pos;
+                out.incomplete_tick.player_pos_eye = eye_pos;
+                out.incomplete_tick.player_vel = vel;
+                out.incomplete_tick.is_player_crouched = tokens[5].compare("true") == 0;
+            }
+            else { // is_server_bump_mine_data
+                if (tokens.size() < 8) return;
+                int bm_id = std::stoi(tokens[1]);
+                ServerTick::BumpMineData bm_data;
+                bm_data.pos    = { std::stof(tokens[2]), std::stof(tokens[3]), std::stof(tokens[4]) };
+                bm_data.angles = { std::stof(tokens[5]), std::stof(tokens[6]), std::stof(tokens[7]) };
+                out.incomplete_tick.bump_mines[bm_id] = bm_data;
+            }
+        }
+        catch (const std::invalid_argument&) {}
+        catch (const std::out_of_range&) {}
+        return;
+    }
+    if (is_server_data_end_marker) {
+        out.server_ticks.push_back(std::move(out.incomplete_tick));
+        out.incomplete_tick = ServerTick();
+        return;
+    }
+    if (is_client_player_data) {
+        std::regex regex(R"(-?[0-9]+\.[0-9]+)");
+        auto vals_begin = std::sregex_iterator(line.begin(), line.end(), regex);
+        auto vals_end = std::sregex_iterator();
+        std::vector<float> vals;
+        for (std::sregex_iterator iter = vals_begin; iter != vals_end; ++iter)
+            vals.push_back(std::stof(iter->str()));
+        if (vals.size() < 6)
+            return;
+        ClientData client_data;
+        client_data.player_pos_eye = { vals[0], vals[1], vals[2] };
+        client_data.player_angles  = { vals[3], vals[4], vals[5] };
+        out.client_data.push_back(client_data);
+    }
+}
+
+bool AreOutputsEqual(const ParseOutput& a, const ParseOutput& b)
+{
+    if (a.server_ticks.size() != b.server_ticks.size()) return false;
+    if (a.client_data.size()  != b.client_data.size())  return false;
+    for (size_t i = 0; i < a.server_ticks.size(); i++) {
+        const ServerTick& ta = a.server_ticks[i];
+        const ServerTick& tb = b.server_ticks[i];
+        if (ta.tick_id            != tb.tick_id)            return false;
+        if (ta.is_player_crouched != tb.is_player_crouched) return false;
+        if (ta.player_pos_feet    != tb.player_pos_feet)    return false;
+        if (ta.player_pos_eye     != tb.player_pos_eye)     return false;
+        if (ta.player_vel         != tb.player_vel)         return false;
+        if (ta.bump_mines.size()  != tb.bump_mines.size())  return false;
+        for (const auto& [id, bm] : ta.bump_mines) {
+            auto it = tb.bump_mines.find(id);
+            if (it == tb.bump_mines.end())   return false;
+            if (it->second.pos    != bm.pos)    return false;
+            if (it->second.angles != bm.angles) return false;
+        }
+    }
+    for (size_t i = 0; i < a.client_data.size(); i++) {
+        if (a.client_data[i].player_pos_eye != b.client_data[i].player_pos_eye) return false;
+        if (a.client_data[i].player_angles  != b.client_data[i].player_angles)  return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void Benchmark::ConsoleParsing(const std::string& relay_log_path)
+{
+    // Benchmark settings
+    constexpr size_t NUM_ITERATIONS = 20; // How often to parse the entire log per method
+
+    std::ifstream file(relay_log_path, std::ios::binary);
+    if (!file) {
+        Debug{} << "[Benchmark::ConsoleParsing] Failed to open" << relay_log_path.c_str();
+        return;
+    }
+    std::string log_content{ std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>() };
+
+    // Split the log into lines like RemoteConsole does
+    std::vector<std::string_view> line_views;
+    std::vector<std::string> line_strings; // What the old parser received
+    size_t num_v2_lines = 0;
+    for (size_t pos = 0; pos < log_content.size(); ) {
+        size_t nl_pos = log_content.find('\n', pos);
+        if (nl_pos == std::string::npos)
+            nl_pos = log_content.size();
+        std::string_view line{ log_content.data() + pos, nl_pos - pos };
+        if (line.ends_with('\r'))
+            line.remove_suffix(1);
+        line_views.push_back(line);
+        if (line.starts_with(DataRelayDecoder::LINE_PREFIX))
+            num_v2_lines++;
+        line_strings.emplace_back(line);
+        pos = nl_pos + 1;
+    }
+    if (line_views.empty()) {
+        Debug{} << "[Benchmark::ConsoleParsing] Relay log is empty";
+        return;
+    }
+
+    ParseOutput outputs[2];
+    unsigned long long duration_sums_ns[2] = { 0, 0 };
+    const char* METHOD_NAMES[2] = { "current", "old (SplitString, stof, regex)" };
+    for (size_t method_idx = 0; method_idx < 2; method_idx++) {
+        ParseOutput& out = outputs[method_idx];
+        for (size_t iter = 0; iter < NUM_ITERATIONS; iter++) {
+            out.Clear();
+            auto start = std::chrono::high_resolution_clock::now();
+            if (method_idx == 0)
+                for (std::string_view line : line_views)
+                    csgo_integration::ConsoleParsing::ParseGameDataLine(
+                        line, {}, &out.relay_decoder, &out.incomplete_tick,
+                        &out.server_ticks, &out.client_data);
+            else
+                for (const std::string& line : line_strings)
+                    ParseLine_Old(line, out);
+            auto end = std::chrono::high_resolution_clock::now();
+            duration_sums_ns[method_idx] +=
+                std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        }
+    }
+
+    Debug{} << "[Benchmark::ConsoleParsing]" << line_views.size() << "lines,"
+        << log_content.size() << "bytes," << outputs[0].server_ticks.size()
+        << "server ticks," << outputs[0].client_data.size() << "client-side updates";
+    for (size_t method_idx = 0; method_idx < 2; method_idx++) {
+        double secs = 1e-9 * duration_sums_ns[method_idx] / NUM_ITERATIONS;
+        Debug{} << "  Method" << METHOD_NAMES[method_idx] << ":"
+            << 1e9 * secs / line_views.size() << "ns per line,"
+            << line_views.size() / secs << "lines/s,"
+            << log_content.size() / secs / (1024 * 1024) << "MiB/s";
+    }
+    if (duration_sums_ns[0] > 0)
+        Debug{} << "  Speedup:" << (double)duration_sums_ns[1] / duration_sums_ns[0];
+
+    if (num_v2_lines > 0)
+        Debug{} << "  Log contains" << num_v2_lines << "data relay v2 lines,"
+            << "the old parser ignores them. Not comparing game data.";
+    else if (AreOutputsEqual(outputs[0], outputs[1]))
+        Debug{} << "  Both methods produced identical game data";
+    else
+        Debug{} << "  ERROR: Methods produced different game data!";
+}
+
+static float MillisecondsBetween(WallClock::time_point a, WallClock::time_point b)
+{
+    return 1e-3f * std::chrono::duration_cast<std::chrono::microseconds>(b - a).count();
+}
+
+void IntegrationLoadTest::Start(float duration_secs, const std::string& gsi_host,
+                                int gsi_port, const std::string& gsi_auth_token)
+{
+    _num_updates = 0;
+    _num_server_ticks = 0;
+    _num_missing_server_ticks = 0;
+    _last_server_tick_id = SIZE_MAX;
+    _num_client_updates = 0;
+    _num_gsi_states = 0;
+    _max_server_ticks_per_update = 0;
+    for (LatencyStats* stats : { &_server_tick_latency, &_client_data_latency,
+            &_display_latency, &_gsi_latency, &_gsi_receive_latency,
+            &_gsi_poll_duration })
+        stats->samples_ms.clear();
+
+    _is_running = true;
+    _duration = std::chrono::duration_cast<WallClock::duration>(
+        std::chrono::duration<float>(duration_secs));
+    _gsi.Stop();
+    _gsi.SetKeepRawPayloads(true); // To get send times
+    if (!_gsi.Start(gsi_host, gsi_port, gsi_auth_token))
+        Debug{} << "[IntegrationLoadTest] Failed to start GSI, only measuring console data";
+    Debug{} << "[IntegrationLoadTest] Measuring for" << duration_secs << "seconds."
+        << "tools/FakeCsgoNetcon.py must already be running.";
+    _start_time = WallClock::now();
+}
+
+bool IntegrationLoadTest::IsFinished() const
+{
+    return _is_running && WallClock::now() - _start_time >= _duration;
+}
+
+void IntegrationLoadTest::AddUpdate(
+    const std::deque<Handler::CsgoServerTickData>& server_ticks,
+    const std::deque<Handler::CsgoClientsideData>& client_data)
+{
+    if (!_is_running)
+        return;
+    WallClock::time_point now = WallClock::now();
+    _num_updates++;
+
+    for (const Handler::CsgoServerTickData& tick : server_ticks) {
+        _server_tick_latency.samples_ms.push_back(MillisecondsBetween(tick.receive_time, now));
+        if (_last_server_tick_id != SIZE_MAX && tick.tick_id > _last_server_tick_id + 1)
+            _num_missing_server_ticks += tick.tick_id - _last_server_tick_id - 1;
+        _last_server_tick_id = tick.tick_id;
+    }
+    _num_server_ticks += server_ticks.size();
+    _max_server_ticks_per_update = std::max(_max_server_ticks_per_update, server_ticks.size());
+
+    for (const Handler::CsgoClientsideData& data : client_data)
+        _client_data_latency.samples_ms.push_back(MillisecondsBetween(data.receive_time, now));
+    _num_client_updates += client_data.size();
+
+    if (!_gsi.IsRunning())
+        return;
+    WallClock::time_point poll_start = WallClock::now();
+    std::optional<GsiState> gsi_state = _gsi.GetNewestGsiState();
+    WallClock::time_point poll_end = WallClock::now();
+    _gsi_poll_duration.samples_ms.push_back(MillisecondsBetween(poll_start, poll_end));
+    if (!gsi_state)
+        return;
+    _num_gsi_states++;
+    _gsi_receive_latency.samples_ms.push_back(
+        MillisecondsBetween(gsi_state->receive_time, now));
+
+    // Send time is only present in payloads from FakeCsgoNetcon.py
+    auto payload = nlohmann::json::parse(gsi_state->json_payload, nullptr, false);
+    if (payload.is_discarded() || !payload.contains("dzs_loadtest"))
+        return;
+    const auto& sent_ns = payload["dzs_loadtest"]["sent_ns"];
+    if (!sent_ns.is_number_integer())
+        return;
+    WallClock::time_point sent_time{ std::chrono::duration_cast<WallClock::duration>(
+        std::chrono::nanoseconds(sent_ns.get<int64_t>())) };
+    _gsi_latency.samples_ms.push_back(MillisecondsBetween(sent_time, now));
+}
+
+void IntegrationLoadTest::AddDisplayLatency(float latency_ms)
+{
+    if (_is_running)
+        _display_latency.samples_ms.push_back(latency_ms);
+}
+
+void IntegrationLoadTest::Finish(uint64_t num_dropped_console_lines)
+{
+    if (!_is_running)
+        return;
+    _is_running = false;
+    uint64_t num_gsi_payloads = _gsi.GetNumReceivedPayloads();
+    _gsi.Stop();
+
+    float secs = 1e-3f * MillisecondsBetween(_start_time, WallClock::now());
+    Debug{} << "[IntegrationLoadTest] Results of" << secs << "seconds:";
+    Debug{} << "  DoUpdate() calls:" << _num_updates / secs << "per second";
+    Debug{} << "  Server ticks:" << _num_server_ticks / secs << "per second,"
+        << _num_missing_server_ticks << "missing, at most"
+        << _max_server_ticks_per_update << "per DoUpdate()";
+    Debug{} << "  Client-side updates:" << _num_client_updates / secs << "per second";
+    Debug{} << "  GSI payloads:" << num_gsi_payloads / secs << "per second,"
+        << _num_gsi_states / secs << "per second after coalescing";
+    Debug{} << "  Dropped console lines:" << num_dropped_console_lines;
+    _server_tick_latency.Print("Server tick arrival -> DoUpdate()");
+    _client_data_latency.Print("Client-side data arrival -> DoUpdate()");
+    _display_latency    .Print("Client-side data arrival -> displayed");
+    _gsi_latency        .Print("GSI payload sent -> DoUpdate()");
+    _gsi_receive_latency.Print("GSI payload parsed -> DoUpdate()");
+    _gsi_poll_duration  .Print("Gsi::GetNewestGsiState() duration");
+}
+
+void IntegrationLoadTest::LatencyStats::Print(const char* name) const
+{
+    if (samples_ms.empty()) {
+        Debug{} << " " << name << ": no samples";
+        return;
+    }
+    std::vector<float> sorted = samples_ms;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](float p) {
+        return sorted[std::min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+    };
+    Debug{} << " " << name << "in ms: median" << percentile(0.5f)
+        << "| p99" << percentile(0.99f) << "| max" << sorted.back()
+        << "|" << sorted.size() << "samples";
+}
+
+#endif // #if CSGO_INTEGRATION_BENCHMARK_ENABLED
@@ -0,0 +1,89 @@
+#ifndef CSGO_INTEGRATION_BENCHMARK_H_
+#define CSGO_INTEGRATION_BENCHMARK_H_
+
+// CAUTION: Remember to disable this when making a public release!
+#define CSGO_INTEGRATION_BENCHMARK_ENABLED 0 // Turn compilation of console benchmarks on/off
+
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "csgo_integration/Gsi.h"
+#include "csgo_integration/Handler.h"
+
+namespace csgo_integration {
+
+class Benchmark {
+public:
+
+    // Measure the throughput of parsing CSGO console output, using a recorded
+    // relay log: A text file with console output of a running data relay, e.g.
+    // captured with "nc localhost <netconport> > relay.log" while DZSimulator
+    // visualizes a CSGO session. Compares the current parser against the old
+    // one that split lines into std::strings and used std::stof and std::regex,
+    // and verifies that both produce the same game data. Logs of data relay v2
+    // are only understood by the current parser.
+    // NOTE: Other threads shouldn't be running, they might mess up measurements.
+    static void ConsoleParsing(const std::string& relay_log_path);
+};
+
+// Measures throughput and latency of CSGO game data while DZSimulator receives
+// it as usual, e.g. from tools/FakeCsgoNetcon.py at high tick rates, bump mine
+// counts and GSI rates. Console data latency is measured from when a line
+// arrived on the console's I/O thread until DoUpdate() got the data, and until
+// the frame showing it was displayed. GSI latency is measured from the send
+// time that FakeCsgoNetcon.py puts into each payload. That send time is only
+// comparable to WallClock time if both run on the same Linux machine.
+class IntegrationLoadTest {
+public:
+    // Starts a GSI http server and measures for the given duration
+    void Start(float duration_secs, const std::string& gsi_host, int gsi_port,
+               const std::string& gsi_auth_token);
+    bool IsRunning() const { return _is_running; }
+    bool IsFinished() const;
+
+    // Call once per DoUpdate() with newly received console data
+    void AddUpdate(const std::deque<Handler::CsgoServerTickData>& server_ticks,
+                   const std::deque<Handler::CsgoClientsideData>& client_data);
+    // Call when a frame that shows newly received client-side data was displayed
+    void AddDisplayLatency(float latency_ms);
+
+    // Stops measuring and prints results
+    void Finish(uint64_t num_dropped_console_lines);
+
+private:
+    struct LatencyStats {
+        std::vector<float> samples_ms;
+        void Print(const char* name) const;
+    };
+
+    bool _is_running = false;
+    WallClock::time_point _start_time;
+    WallClock::duration _duration;
+    Gsi _gsi;
+
+    size_t _num_updates = 0;
+    size_t _num_server_ticks = 0;
+    size_t _num_missing_server_ticks = 0; // Gaps in tick IDs
+    size_t _last_server_tick_id = SIZE_MAX;
+    size_t _num_client_updates = 0;
+    size_t _num_gsi_states = 0; // Retrieved, after coalescing
+    size_t _max_server_ticks_per_update = 0;
+
+    LatencyStats _server_tick_latency;  // Arrival until DoUpdate()
+    LatencyStats _client_data_latency;  // Arrival until DoUpdate()
+    LatencyStats _display_latency;      // Arrival until frame was displayed
+    LatencyStats _gsi_latency;          // Sending until DoUpdate()
+    LatencyStats _gsi_receive_latency;  // Parsed on receive until DoUpdate()
+    LatencyStats _gsi_poll_duration;    // Time spent in Gsi::GetNewestGsiState()
+};
+
+} // namespace csgo_integration
+#endif // #if CSGO_INTEGRATION_BENCHMARK_ENABLED
+
+#endif // CSGO_INTEGRATION_BENCHMARK_H_
@@ -0,0 +1,190 @@
+#include "csgo_integration/ConsoleParsing.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <utility>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+using namespace Magnum;
+using namespace csgo_integration;
+using namespace csgo_integration::ConsoleParsing;
+
+// Reads the next 3 tokens as floats
+static bool NextVector3(Tokenizer& tokenizer, Vector3* out) {
+    Vector3 v;
+    if (!tokenizer.NextNumber(&v.x())) return false;
+    if (!tokenizer.NextNumber(&v.y())) return false;
+    if (!tokenizer.NextNumber(&v.z())) return false;
+    *out = v;
+    return true;
+}
+
+size_t ConsoleParsing::ParseFloatPrefix(std::string_view s, float* out)
+{
+    // std::strtof() needs a null-terminated string. Numbers in console output
+    // and GSI payloads are short, longer ones are rejected.
+    char buf[64];
+    size_t len = 0;
+    while (len < s.size() && len < sizeof(buf) - 1 &&
+           std::string_view{ "0123456789.-+eE" }.find(s[len]) != std::string_view::npos)
+        len++;
+    // Like std::from_chars(), don't accept a leading plus sign
+    if (len == 0 || len == sizeof(buf) - 1 || s[0] == '+')
+        return 0;
+    s.copy(buf, len);
+    buf[len] = '\0';
+
+    // NOTE: strtof() uses the C locale's decimal point, DZSimulator never
+    //       changes the default "C" locale.
+    char* end;
+    errno = 0;
+    float val = std::strtof(buf, &end);
+    if (end == buf || (errno == ERANGE && std::isinf(val)))
+        return 0;
+    *out = val;
+    return end - buf;
+}
+
+LineType ConsoleParsing::GetLineType(std::string_view line)
+{
+    // Ordered by frequency
+    if (line.starts_with("dzsdr2 "))                return LineType::SERVER_TICKS_V2;
+    if (line.starts_with("bm "))                    return LineType::SERVER_BUMP_MINE;
+    if (line.starts_with("player "))                return LineType::SERVER_PLAYER;
+    if (line.starts_with("dzs-dr-v1-tick-start "))  return LineType::SERVER_TICK_START;
+    if (line.starts_with("dzs-dr-v1-tick-end"))     return LineType::SERVER_TICK_END;
+    if (line.starts_with("setpos "))                return LineType::CLIENT_SETPOS;
+    return LineType::UNKNOWN;
+}
+
+// e.g. "dzs-dr-v1-tick-start 85"
+bool ConsoleParsing::ParseServerTickStart(std::string_view line, size_t* tick_id)
+{
+    Tokenizer tokenizer{ line };
+    return tokenizer.Skip() && tokenizer.NextNumber(tick_id);
+}
+
+// e.g. "player -4634.38 271.376 1571.43 1635.43 false -322.528 -979.985 -442.433"
+bool ConsoleParsing::ParseServerPlayer(std::string_view line,
+                                       Handler::CsgoServerTickData* tick_data)
+{
+    Tokenizer tokenizer{ line };
+    Vector3 feet_pos, vel;
+    float eye_pos_z;
+    std::string_view crouched;
+    if (!tokenizer.Skip()) return false;
+    if (!NextVector3(tokenizer, &feet_pos)) return false;
+    if (!tokenizer.NextNumber(&eye_pos_z)) return false;
+    if (!tokenizer.Next(&crouched)) return false;
+    if (!NextVector3(tokenizer, &vel)) return false;
+
+    // Only accept and set data if nothing went wrong during parsing
+    tick_data->player_pos_feet = feet_pos;
+    // Eye position only differs from feet position in z
+    tick_data->player_pos_eye = { feet_pos.x(), feet_pos.y(), eye_pos_z };
+    tick_data->player_vel = vel;
+    tick_data->is_player_crouched = crouched == "true";
+    return true;
+}
+
+// e.g. "bm 920 -1153.88 -1005.98 997.602 -3.27541 -2.71377 5.52694"
+bool ConsoleParsing::ParseServerBumpMine(std::string_view line, int* bm_id,
+    Handler::CsgoServerTickData::BumpMineData* bm_data)
+{
+    Tokenizer tokenizer{ line };
+    int id;
+    Vector3 pos, angles;
+    if (!tokenizer.Skip()) return false;
+    if (!tokenizer.NextNumber(&id)) return false;
+    if (!NextVector3(tokenizer, &pos)) return false;
+    if (!NextVector3(tokenizer, &angles)) return false; // pitch, yaw, roll
+
+    *bm_id = id;
+    bm_data->pos = pos;
+    bm_data->angles = angles;
+    return true;
+}
+
+// e.g. "setpos -1338.681030 -1089.463989 1070.809204;setang 21.053974 -10.723428 0.000000"
+bool ConsoleParsing::ParseClientSetpos(std::string_view line,
+                                       Handler::CsgoClientsideData* client_data)
+{
+    Tokenizer tokenizer{ line, " ;" };
+    Vector3 pos, angles;
+    if (!tokenizer.Skip()) return false; // "setpos"
+    if (!NextVector3(tokenizer, &pos)) return false;
+    if (!tokenizer.Skip()) return false; // "setang"
+    if (!NextVector3(tokenizer, &angles)) return false;
+
+    client_data->player_pos_eye = pos;
+    client_data->player_angles = angles;
+    return true;
+}
+
+bool ConsoleParsing::ParseChangeGameUIState(std::string_view line,
+                                            std::string_view* new_ui_state)
+{
+    Tokenizer tokenizer{ line };
+    std::string_view tokens[4];
+    for (std::string_view& t : tokens)
+        if (!tokenizer.Next(&t))
+            return false;
+    if (tokenizer.Skip()) // Exactly 4 tokens expected
+        return false;
+    if (tokens[0] != "ChangeGameUIState:" || tokens[2] != "->")
+        return false;
+    *new_ui_state = tokens[3];
+    return true;
+}
+
+void ConsoleParsing::ParseGameDataLine(std::string_view line,
+    WallClock::time_point receive_time,
+    DataRelayDecoder* relay_decoder,
+    Handler::CsgoServerTickData* incomplete_server_tick,
+    std::deque<Handler::CsgoServerTickData>* server_ticks,
+    std::deque<Handler::CsgoClientsideData>* client_data)
+{
+    switch (GetLineType(line)) {
+    // Server-side data of data relay v2
+    case LineType::SERVER_TICKS_V2:
+        relay_decoder->DecodeLine(line, receive_time, server_ticks);
+        return;
+    // Server-side data of data relay v1
+    case LineType::SERVER_TICK_START:
+        ParseServerTickStart(line, &incomplete_server_tick->tick_id);
+        return;
+    case LineType::SERVER_PLAYER:
+        ParseServerPlayer(line, incomplete_server_tick);
+        return;
+    case LineType::SERVER_BUMP_MINE: {
+        int bm_id;
+        Handler::CsgoServerTickData::BumpMineData bm_data;
+        if (ParseServerBumpMine(line, &bm_id, &bm_data))
+            incomplete_server_tick->bump_mines[bm_id] = bm_data;
+        return;
+    }
+    case LineType::SERVER_TICK_END:
+        // Data of next server tick is complete, put it on the queue
+        incomplete_server_tick->receive_time = receive_time;
+        server_ticks->push_back(std::move(*incomplete_server_tick));
+        *incomplete_server_tick = Handler::CsgoServerTickData(); // construct for reuse
+        return;
+    // Client-side data that is parsed and handled separately from server data.
+    // Parse response of the 'getpos' command.
+    case LineType::CLIENT_SETPOS: {
+        Handler::CsgoClientsideData new_client_data;
+        if (ParseClientSetpos(line, &new_client_data)) {
+            // Next client-side data is complete, put it on the queue
+            new_client_data.receive_time = receive_time;
+            client_data->push_back(new_client_data);
+        }
+        return;
+    }
+    case LineType::UNKNOWN:
+        return;
+    }
+}
@@ -0,0 +1,135 @@
+#ifndef CSGO_INTEGRATION_CONSOLEPARSING_H_
+#define CSGO_INTEGRATION_CONSOLEPARSING_H_
+
+#include <charconv>
+#include <cstddef>
+#include <deque>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+#include "common.h"
+#include "csgo_integration/DataRelayDecoder.h"
+#include "csgo_integration/Handler.h"
+
+// Allocation-free parsing of CSGO console output lines. Everything here works
+// on string views that point directly into the received console text, no
+// strings are copied and no exceptions are thrown.
+namespace csgo_integration::ConsoleParsing {
+
+    // Splits a line into tokens that are separated by any of the given
+    // delimiter chars. Empty tokens are skipped.
+    class Tokenizer {
+    public:
+        Tokenizer(std::string_view line, std::string_view delimiters = " ")
+            : _remaining{ line }, _delimiters{ delimiters } {}
+
+        // Returns false if there are no more tokens.
+        bool Next(std::string_view* token) {
+            size_t start = _remaining.find_first_not_of(_delimiters);
+            if (start == std::string_view::npos) {
+                _remaining = {};
+                return false;
+            }
+            size_t end = _remaining.find_first_of(_delimiters, start);
+            if (end == std::string_view::npos)
+                end = _remaining.size();
+            *token = _remaining.substr(start, end - start);
+            _remaining.remove_prefix(end);
+            return true;
+        }
+
+        // Returns false if there are no more tokens or if the next token isn't
+        // entirely a number. The token is consumed either way.
+        template<class T>
+        bool NextNumber(T* out);
+
+        // Returns false if there are no more tokens.
+        bool Skip() { std::string_view unused; return Next(&unused); }
+
+    private:
+        std::string_view _remaining;
+        std::string_view _delimiters;
+    };
+
+    // Parses a decimal float at the start of s, like std::from_chars() would.
+    // Returns the number of chars it consists of, or 0 if s doesn't start with
+    // a float. Leaves out unchanged on failure.
+    // std::from_chars() isn't used for floats since some standard libraries
+    // we build with don't support it (e.g. Emscripten's and Apple's libc++).
+    size_t ParseFloatPrefix(std::string_view s, float* out);
+
+    // Parses an int or float that makes up the entire string. Returns false
+    // and leaves out unchanged if that's not possible.
+    template<class T>
+    bool ParseNumber(std::string_view s, T* out) {
+        T val;
+        size_t len;
+        if constexpr (std::is_same_v<T, float>) {
+            len = ParseFloatPrefix(s, &val);
+        } else {
+            static_assert(std::is_integral_v<T>, "Only ints and floats are supported");
+            auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), val);
+            len = ec == std::errc{} ? ptr - s.data() : 0;
+        }
+        if (len == 0 || len != s.size())
+            return false;
+        *out = val;
+        return true;
+    }
+
+    template<class T>
+    bool Tokenizer::NextNumber(T* out) {
+        std::string_view token;
+        return Next(&token) && ParseNumber(token, out);
+    }
+
+    // Lines printed by the data relay and by the 'getpos' command. Lines of
+    // version 1 of the data relay are still recognized.
+    enum class LineType {
+        UNKNOWN,
+        SERVER_TICKS_V2,   // "dzsdr2 <tick> <tick> ...", see DataRelayDecoder
+        SERVER_TICK_START, // "dzs-dr-v1-tick-start <tick id>"
+        SERVER_PLAYER,     // "player <feet x y z> <eye z> <crouched> <vel x y z>"
+        SERVER_BUMP_MINE,  // "bm <id> <pos x y z> <pitch yaw roll>"
+        SERVER_TICK_END,   // "dzs-dr-v1-tick-end"
+        CLIENT_SETPOS,     // "setpos <x y z>;setang <pitch yaw roll>"
+    };
+    LineType GetLineType(std::string_view line);
+
+    // The following functions parse a line of the respective type. They return
+    // false and leave their outputs unchanged if the line is malformed.
+
+    bool ParseServerTickStart(std::string_view line, size_t* tick_id);
+
+    // Sets player position, velocity and crouch state of the tick data
+    bool ParseServerPlayer(std::string_view line,
+                           Handler::CsgoServerTickData* tick_data);
+
+    bool ParseServerBumpMine(std::string_view line, int* bm_id,
+        Handler::CsgoServerTickData::BumpMineData* bm_data);
+
+    bool ParseClientSetpos(std::string_view line,
+                           Handler::CsgoClientsideData* client_data);
+
+    // Parses a line of game data printed by the data relay or the 'getpos'
+    // command. Completed server ticks and client-side data are appended to the
+    // given queues with the given receive time. Data relay v1 prints a server
+    // tick over multiple lines, it's gathered in incomplete_server_tick.
+    // Called for every line the data relay prints, i.e. several times per
+    // server tick. Parsing must be quick and must not allocate.
+    void ParseGameDataLine(std::string_view line,
+                           WallClock::time_point receive_time,
+                           DataRelayDecoder* relay_decoder,
+                           Handler::CsgoServerTickData* incomplete_server_tick,
+                           std::deque<Handler::CsgoServerTickData>* server_ticks,
+                           std::deque<Handler::CsgoClientsideData>* client_data);
+
+    // Parses e.g. "ChangeGameUIState: CSGO_GAME_UI_STATE_MAINMENU -> CSGO_GAME_UI_STATE_LOADINGSCREEN"
+    // new_ui_state points into the given line.
+    bool ParseChangeGameUIState(std::string_view line,
+                                std::string_view* new_ui_state);
+
+} // namespace csgo_integration::ConsoleParsing
+
+#endif // CSGO_INTEGRATION_CONSOLEPARSING_H_
@@ -0,0 +1,313 @@
+#include "csgo_integration/DataRelayDecoder.h"
+
+#include <algorithm>
+
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Magnum.h>
+
+#include "csgo_integration/ConsoleParsing.h"
+
+using namespace Magnum;
+using namespace csgo_integration;
+using ConsoleParsing::Tokenizer;
+
+// Fixed-point precision of transmitted values
+static const float POSITION_SCALE = 32.0f;  // 1/32 units, also used for velocities
+static const float ANGLE_SCALE    = 100.0f; // 1/100 degrees
+
+// Ticks that are older than this are no duplicates, but ticks of a restarted
+// data relay
+static const int RESTART_SEQ_DISTANCE = 256;
+
+// Signed distance from sequence number a to b, taking wrap-around into account
+static int SeqDistance(uint16_t a, uint16_t b) {
+    return (int16_t)(uint16_t)(b - a);
+}
+
+template<size_t N>
+static bool NextInts(Tokenizer& tokenizer, std::array<int32_t, N>* out) {
+    for (int32_t& v : *out)
+        if (!tokenizer.NextNumber(&v))
+            return false;
+    return true;
+}
+
+void DataRelayDecoder::DecodeLine(std::string_view line,
+                                  WallClock::time_point receive_time,
+                                  std::deque<Handler::CsgoServerTickData>* dest)
+{
+    if (!line.starts_with(LINE_PREFIX))
+        return;
+    line.remove_prefix(LINE_PREFIX.size());
+
+    // Each tick's data is separated by spaces
+    Tokenizer tokenizer{ line };
+    std::string_view tick_text;
+    while (tokenizer.Next(&tick_text)) {
+        if (!ParseTick(tick_text, &_parsed_tick)) {
+            _stats.num_malformed_ticks++;
+            continue;
+        }
+        ProcessTick(_parsed_tick, receive_time, dest);
+    }
+}
+
+void DataRelayDecoder::Reset()
+{
+    Desync();
+    _next_seq = 0;
+    _next_tick_id = 0;
+    _has_received_keyframe = false;
+    _has_player = false;
+    _bump_mines.clear();
+}
+
+bool DataRelayDecoder::ParseTick(std::string_view text, TickRecord* rec)
+{
+    Tokenizer tokenizer{ text, "," };
+    std::string_view kind;
+    if (!tokenizer.NextNumber(&rec->seq)) return false;
+    if (!tokenizer.Next(&kind))           return false;
+    if (kind == "k")      rec->is_keyframe = true;
+    else if (kind == "d") rec->is_keyframe = false;
+    else                  return false;
+
+    rec->player_info = TickRecord::PLAYER_UNCHANGED;
+    rec->bump_mines.clear();
+    rec->removed_bump_mines.clear();
+    rec->has_bump_mine_list = false;
+    rec->bump_mine_list.clear();
+
+    std::string_view tag;
+    while (tokenizer.Next(&tag)) {
+        if (tag.size() != 1)
+            return false;
+        switch (tag[0]) {
+        case 'p': // Player state
+        case 'd': // Player state delta
+            if (rec->player_info != TickRecord::PLAYER_UNCHANGED) return false;
+            rec->player_info = tag[0] == 'p' ?
+                TickRecord::PLAYER_ABSOLUTE : TickRecord::PLAYER_DELTA;
+            if (!NextInts(tokenizer, &rec->player_vals)) return false;
+            break;
+        case 'n': // No player
+            if (rec->player_info != TickRecord::PLAYER_UNCHANGED) return false;
+            rec->player_info = TickRecord::PLAYER_NONE;
+            break;
+        case 'b': { // Bump mine state
+            TickRecord::BumpMine bm;
+            if (!tokenizer.NextNumber(&bm.id)) return false;
+            if (!NextInts(tokenizer, &bm.vals)) return false;
+            rec->bump_mines.push_back(bm);
+            break;
+        }
+        case 'r': { // Bump mine removal
+            int id;
+            if (!tokenizer.NextNumber(&id)) return false;
+            rec->removed_bump_mines.push_back(id);
+            break;
+        }
+        case 'a': { // List of all bump mines
+            size_t count;
+            if (rec->has_bump_mine_list) return false;
+            if (!tokenizer.NextNumber(&count)) return false;
+            rec->has_bump_mine_list = true;
+            for (size_t i = 0; i < count; i++) {
+                int id;
+                if (!tokenizer.NextNumber(&id)) return false;
+                rec->bump_mine_list.push_back(id);
+            }
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+
+    // Keyframes must not depend on previous ticks
+    if (rec->is_keyframe) {
+        if (!rec->has_bump_mine_list) return false;
+        if (rec->player_info == TickRecord::PLAYER_UNCHANGED) return false;
+        if (rec->player_info == TickRecord::PLAYER_DELTA)     return false;
+    }
+    return true;
+}
+
+bool DataRelayDecoder::ApplyTick(const TickRecord& rec)
+{
+    if (rec.player_info == TickRecord::PLAYER_DELTA && !_has_player)
+        return false;
+
+    switch (rec.player_info) {
+    case TickRecord::PLAYER_UNCHANGED:
+        break;
+    case TickRecord::PLAYER_ABSOLUTE:
+        _has_player = true;
+        _player_vals = rec.player_vals;
+        break;
+    case TickRecord::PLAYER_DELTA:
+        for (size_t i = 0; i < NUM_PLAYER_VALS; i++)
+            _player_vals[i] += rec.player_vals[i];
+        break;
+    case TickRecord::PLAYER_NONE:
+        _has_player = false;
+        break;
+    }
+
+    if (rec.has_bump_mine_list) {
+        const auto& list = rec.bump_mine_list;
+        std::erase_if(_bump_mines, [&list](const auto& id_and_vals) {
+            return std::find(list.begin(), list.end(), id_and_vals.first) == list.end();
+        });
+    }
+    for (const TickRecord::BumpMine& bm : rec.bump_mines)
+        _bump_mines[bm.id] = bm.vals;
+    for (int id : rec.removed_bump_mines)
+        _bump_mines.erase(id);
+    return true;
+}
+
+void DataRelayDecoder::EmitTick(WallClock::time_point receive_time,
+                                std::deque<Handler::CsgoServerTickData>* dest)
+{
+    _stats.num_decoded_ticks++;
+
+    Handler::CsgoServerTickData& tick = dest->emplace_back();
+    tick.tick_id = _next_tick_id;
+    tick.receive_time = receive_time;
+    if (_has_player) {
+        const PlayerVals& v = _player_vals;
+        tick.player_pos_feet = Vector3{ (float)v[0], (float)v[1], (float)v[2] } / POSITION_SCALE;
+        // Eye position only differs from feet position in z
+        tick.player_pos_eye = { tick.player_pos_feet.x(), tick.player_pos_feet.y(),
+                                v[3] / POSITION_SCALE };
+        tick.is_player_crouched = v[4] != 0;
+        tick.player_vel = Vector3{ (float)v[5], (float)v[6], (float)v[7] } / POSITION_SCALE;
+    }
+    for (const auto& [id, v] : _bump_mines) {
+        Handler::CsgoServerTickData::BumpMineData& bm = tick.bump_mines[id];
+        bm.pos    = Vector3{ (float)v[0], (float)v[1], (float)v[2] } / POSITION_SCALE;
+        bm.angles = Vector3{ (float)v[3], (float)v[4], (float)v[5] } / ANGLE_SCALE;
+    }
+}
+
+void DataRelayDecoder::ProcessTick(TickRecord& rec,
+                                   WallClock::time_point receive_time,
+                                   std::deque<Handler::CsgoServerTickData>* dest)
+{
+    int dist = SeqDistance(_next_seq, rec.seq);
+
+    // While not synced, _next_seq is the first tick that wasn't decoded
+    if (_has_received_keyframe && dist < 0) {
+        if (!rec.is_keyframe || dist > -RESTART_SEQ_DISTANCE) {
+            _stats.num_duplicate_ticks++;
+            return;
+        }
+        // A keyframe from far in the past, the data relay was restarted
+        Debug{} << "[DataRelayDecoder] Data relay restarted";
+        Desync();
+        _has_received_keyframe = false; // Restarted sequence, nothing skipped
+    }
+    if (_is_synced && dist > 0) {
+        // Ticks are missing, wait for them
+        if (dist < (int)REORDER_WINDOW) {
+            size_t slot = rec.seq % REORDER_WINDOW;
+            if (_is_pending[slot]) {
+                _stats.num_duplicate_ticks++;
+            }
+            else {
+                std::swap(_pending_ticks[slot], rec); // Keeps both allocations
+                _is_pending[slot] = true;
+            }
+            return;
+        }
+        // Give up on the missing ticks. Continue with a held back keyframe or
+        // with this tick if it's a keyframe.
+        Debug{} << "[DataRelayDecoder]" << dist << "ticks missing, skipping them";
+        if (ResyncWithPendingKeyframe(receive_time, dest)) {
+            ProcessTick(rec, receive_time, dest);
+            return;
+        }
+        Desync();
+    }
+
+    if (!_is_synced) {
+        if (!rec.is_keyframe)
+            return; // Counted as skipped once decoding resumes
+        // Keep counting tick IDs across skipped ticks
+        if (_has_received_keyframe)
+            SkipTicks((uint16_t)(rec.seq - _next_seq));
+        _has_received_keyframe = true;
+        _next_seq = rec.seq;
+    }
+
+    // rec is the next tick in order
+    if (DecodeNextTick(rec, receive_time, dest))
+        DecodePendingTicks(receive_time, dest);
+}
+
+bool DataRelayDecoder::DecodeNextTick(const TickRecord& rec,
+                                      WallClock::time_point receive_time,
+                                      std::deque<Handler::CsgoServerTickData>* dest)
+{
+    if (!ApplyTick(rec)) {
+        _stats.num_malformed_ticks++;
+        Desync();
+        return false;
+    }
+    EmitTick(receive_time, dest);
+    _is_synced = true;
+    _next_seq++;
+    _next_tick_id++;
+    return true;
+}
+
+void DataRelayDecoder::DecodePendingTicks(WallClock::time_point receive_time,
+    std::deque<Handler::CsgoServerTickData>* dest)
+{
+    while (_is_synced) {
+        size_t slot = _next_seq % REORDER_WINDOW;
+        if (!_is_pending[slot] || _pending_ticks[slot].seq != _next_seq)
+            return;
+        _is_pending[slot] = false;
+        _stats.num_reordered_ticks++;
+        DecodeNextTick(_pending_ticks[slot], receive_time, dest);
+    }
+}
+
+bool DataRelayDecoder::ResyncWithPendingKeyframe(WallClock::time_point receive_time,
+    std::deque<Handler::CsgoServerTickData>* dest)
+{
+    for (uint16_t i = 1; i < REORDER_WINDOW; i++) {
+        uint16_t seq = _next_seq + i;
+        size_t slot = seq % REORDER_WINDOW;
+        if (!_is_pending[slot] || _pending_ticks[slot].seq != seq)
+            continue;
+        if (!_pending_ticks[slot].is_keyframe)
+            continue;
+        // Drop held back ticks before the keyframe, they can't be decoded
+        for (uint16_t j = 0; j < i; j++)
+            _is_pending[(_next_seq + j) % REORDER_WINDOW] = false;
+        SkipTicks(i);
+        _next_seq = seq;
+        _is_pending[slot] = false;
+        _stats.num_reordered_ticks++;
+        if (DecodeNextTick(_pending_ticks[slot], receive_time, dest))
+            DecodePendingTicks(receive_time, dest);
+        return true;
+    }
+    return false;
+}
+
+void DataRelayDecoder::SkipTicks(size_t num_ticks)
+{
+    _stats.num_skipped_ticks += num_ticks;
+    _next_tick_id += num_ticks;
+}
+
+void DataRelayDecoder::Desync()
+{
+    // The current state can't be updated anymore, wait for the next keyframe
+    _is_synced = false;
+    _is_pending = {};
+}
@@ -0,0 +1,124 @@
+#ifndef CSGO_INTEGRATION_DATARELAYDECODER_H_
+#define CSGO_INTEGRATION_DATARELAYDECODER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string_view>
+#include <vector>
+
+#include "common.h"
+#include "csgo_integration/Handler.h"
+
+namespace csgo_integration {
+
+// Streaming decoder of the data relay's version 2 output. The output format is
+// described in res/csgo_integration/data_relay.nut.
+// Reconstructs the complete data of every server tick from keyframes and delta
+// ticks. Ticks that arrive out of order are held back until the ticks before
+// them arrive. If ticks are missing for too long, they are skipped and decoding
+// resumes at the next keyframe.
+class DataRelayDecoder {
+public:
+    // Line prefix of the data relay's version 2 output
+    static constexpr std::string_view LINE_PREFIX = "dzsdr2 ";
+
+    // How many ticks after a missing tick are held back while waiting for it
+    static constexpr size_t REORDER_WINDOW = 8;
+
+    struct Stats {
+        uint64_t num_decoded_ticks   = 0;
+        uint64_t num_malformed_ticks = 0;
+        uint64_t num_duplicate_ticks = 0; // Already decoded or skipped
+        uint64_t num_reordered_ticks = 0; // Decoded after waiting for others
+        uint64_t num_skipped_ticks   = 0; // Missing or not decodable,
+                                          // counted when decoding resumes
+    };
+
+    // Decodes a line that starts with LINE_PREFIX and appends the data of
+    // completed ticks to dest, in tick order. Their receive time is set to the
+    // given one. Their tick_id counts up continuously, it doesn't wrap around
+    // like the relay's sequence numbers.
+    void DecodeLine(std::string_view line, WallClock::time_point receive_time,
+                    std::deque<Handler::CsgoServerTickData>* dest);
+
+    // Forgets all received data, e.g. after a new data relay was started
+    void Reset();
+
+    const Stats& GetStats() const { return _stats; }
+
+private:
+    static constexpr size_t NUM_PLAYER_VALS = 8;
+    static constexpr size_t NUM_BUMP_MINE_VALS = 6;
+    using PlayerVals = std::array<int32_t, NUM_PLAYER_VALS>;
+    using BumpMineVals = std::array<int32_t, NUM_BUMP_MINE_VALS>;
+
+    // Undecoded data of one tick, as received
+    struct TickRecord {
+        uint16_t seq = 0;
+        bool is_keyframe = false;
+
+        enum PlayerInfo {
+            PLAYER_UNCHANGED,
+            PLAYER_ABSOLUTE, // player_vals holds player state
+            PLAYER_DELTA,    // player_vals holds change of player state
+            PLAYER_NONE      // There's no player
+        } player_info = PLAYER_UNCHANGED;
+        PlayerVals player_vals = {};
+
+        struct BumpMine {
+            int id;
+            BumpMineVals vals;
+        };
+        std::vector<BumpMine> bump_mines;
+        std::vector<int> removed_bump_mines;
+        bool has_bump_mine_list = false;
+        std::vector<int> bump_mine_list; // IDs of all bump mines
+    };
+
+    static bool ParseTick(std::string_view text, TickRecord* rec);
+
+    // Returns false if the tick isn't consistent with the current state
+    bool ApplyTick(const TickRecord& rec);
+    void EmitTick(WallClock::time_point receive_time,
+                  std::deque<Handler::CsgoServerTickData>* dest);
+    void ProcessTick(TickRecord& rec, WallClock::time_point receive_time,
+                     std::deque<Handler::CsgoServerTickData>* dest);
+    // Returns false if decoding failed and the decoder desynced
+    bool DecodeNextTick(const TickRecord& rec, WallClock::time_point receive_time,
+                        std::deque<Handler::CsgoServerTickData>* dest);
+    // Decodes held back ticks that are next in order
+    void DecodePendingTicks(WallClock::time_point receive_time,
+                            std::deque<Handler::CsgoServerTickData>* dest);
+    // Skips missing ticks up to the first held back keyframe and continues
+    // decoding from there. Returns false if no keyframe is held back.
+    bool ResyncWithPendingKeyframe(WallClock::time_point receive_time,
+                                   std::deque<Handler::CsgoServerTickData>* dest);
+    void SkipTicks(size_t num_ticks);
+    void Desync();
+
+    Stats _stats;
+
+    // If the current state is complete and the next tick can be applied
+    bool _is_synced = false;
+    bool _has_received_keyframe = false;
+    uint16_t _next_seq = 0; // Of the next tick in order, or the first missing one
+    size_t _next_tick_id = 0;
+
+    bool _has_player = false;
+    PlayerVals _player_vals = {};
+    std::map<int, BumpMineVals> _bump_mines;
+
+    // Ticks that arrived before the next tick in order. Index is seq modulo
+    // REORDER_WINDOW.
+    std::array<TickRecord, REORDER_WINDOW> _pending_ticks;
+    std::array<bool, REORDER_WINDOW> _is_pending = {};
+
+    TickRecord _parsed_tick; // Reused to avoid allocations
+};
+
+} // namespace csgo_integration
+
+#endif // CSGO_INTEGRATION_DATARELAYDECODER_H_
@@ -0,0 +1,263 @@
+#include "csgo_integration/FramePacer.h"
+
+#ifndef DZSIM_WEB_PORT
+#ifdef _WIN32
+#define NOMINMAX // Don't break std::min and std::max
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <thread>
+
+using namespace std::chrono_literals;
+using namespace csgo_integration;
+
+// Number of recent intervals between updates the prediction is based on
+static const size_t NUM_INTERVAL_SAMPLES = 32;
+static const size_t MIN_INTERVAL_SAMPLES = 4;
+// Updates arriving closer together than this were received in the same burst,
+// e.g. in the same TCP segment. They don't tell anything about the update rate.
+static const auto BURST_THRESHOLD = 500us;
+// Longer intervals are pauses in the data stream, not the update rate
+static const auto MAX_INTERVAL = 200ms;
+// If no update arrived for this long, the data stream is considered stopped
+static const auto STREAM_TIMEOUT = 500ms;
+
+// How long to sleep at once. The OS might sleep considerably longer.
+static const auto SLEEP_STEP = 1ms;
+// Polling for new data starts at least this long before the expected arrival
+static const auto MIN_EARLY_MARGIN = 1ms;
+// Polling for new data continues at least this long after the expected arrival
+static const auto MIN_LATE_MARGIN = 2ms;
+// Longest wait, so window events still get processed regularly
+static const auto MAX_WAIT = 50ms;
+// Wait time when no data stream is active, to check for new data regularly
+static const auto IDLE_WAIT = 10ms;
+
+// Period over which CPU usage is measured
+static const auto CPU_USAGE_PERIOD = 250ms;
+
+static float ToMs(WallClock::duration d) {
+    return std::chrono::duration<float, std::milli>(d).count();
+}
+
+// CPU time used by the calling thread so far, if the platform supports it
+static std::optional<WallClock::duration> GetThreadCpuTime() {
+#ifdef DZSIM_WEB_PORT
+    return std::nullopt;
+#elif defined(_WIN32)
+    FILETIME creation_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(),
+                        &creation_time, &exit_time, &kernel_time, &user_time))
+        return std::nullopt;
+    auto to_100ns = [](const FILETIME& ft) {
+        return ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    };
+    std::chrono::duration<uint64_t, std::ratio<1, 10'000'000>> cpu_time{
+        to_100ns(kernel_time) + to_100ns(user_time) };
+    return std::chrono::duration_cast<WallClock::duration>(cpu_time);
+#else
+    timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0)
+        return std::nullopt;
+    return std::chrono::duration_cast<WallClock::duration>(
+        std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Histogram
+
+Histogram::Histogram(float min, float max, size_t num_buckets)
+    : _min{ min }
+    , _max{ max }
+    , _bucket_counts(num_buckets, 0.0f)
+{
+    assert(max > min && num_buckets > 0);
+}
+
+void Histogram::Add(float val)
+{
+    if (std::isnan(val))
+        return;
+    float rel = (val - _min) / (_max - _min);
+    float idx = std::clamp(rel * _bucket_counts.size(),
+                           0.0f, (float)(_bucket_counts.size() - 1));
+    _bucket_counts[(size_t)idx] += 1.0f;
+    _num_values++;
+}
+
+void Histogram::Clear()
+{
+    std::fill(_bucket_counts.begin(), _bucket_counts.end(), 0.0f);
+    _num_values = 0;
+}
+
+float Histogram::GetPercentile(float fraction) const
+{
+    if (_num_values == 0)
+        return 0.0f;
+    float bucket_width = (_max - _min) / _bucket_counts.size();
+    float target_count = fraction * _num_values;
+    float count = 0.0f;
+    for (size_t i = 0; i < _bucket_counts.size(); i++) {
+        count += _bucket_counts[i];
+        if (count >= target_count)
+            return _min + (i + 1) * bucket_width;
+    }
+    return _max;
+}
+
+// ----------------------------------------------------------------------------
+// FramePacer
+
+FramePacer::FramePacer()
+    : _sleep_step_mean_ms{ 2.0f * ToMs(SLEEP_STEP) } // Pessimistic guess
+    , _sleep_step_dev_ms{ 0.0f }
+    , _latency_hist{ 0.0f, 32.0f, 64 }    // 0.5 ms wide buckets
+    , _cpu_usage_hist{ 0.0f, 100.0f, 20 } // 5 % wide buckets
+{
+    _intervals.reserve(NUM_INTERVAL_SAMPLES);
+}
+
+void FramePacer::AddArrival(WallClock::time_point arrival_time)
+{
+    if (_last_arrival != WallClock::time_point{}) {
+        WallClock::duration interval = arrival_time - _last_arrival;
+        if (interval >= 0s && interval < BURST_THRESHOLD)
+            return;
+        if (interval >= BURST_THRESHOLD && interval <= MAX_INTERVAL) {
+            if (_intervals.size() < NUM_INTERVAL_SAMPLES)
+                _intervals.push_back(interval);
+            else
+                _intervals[_next_interval_idx] = interval;
+            _next_interval_idx = (_next_interval_idx + 1) % NUM_INTERVAL_SAMPLES;
+            UpdatePrediction();
+        }
+    }
+    _last_arrival = arrival_time;
+}
+
+void FramePacer::UpdatePrediction()
+{
+    if (_intervals.size() < MIN_INTERVAL_SAMPLES)
+        return;
+
+    // The median isn't thrown off by single late or dropped updates
+    std::vector<WallClock::duration> sorted = _intervals;
+    auto median_it = sorted.begin() + sorted.size() / 2;
+    std::nth_element(sorted.begin(), median_it, sorted.end());
+    _predicted_interval = *median_it;
+
+    WallClock::duration total_deviation{ 0 };
+    for (WallClock::duration interval : _intervals) {
+        WallClock::duration deviation = interval - _predicted_interval;
+        total_deviation += deviation < 0s ? -deviation : deviation;
+    }
+    _jitter = total_deviation / (WallClock::rep)_intervals.size();
+}
+
+void FramePacer::WaitForNextArrival(const std::function<bool()>& has_new_data)
+{
+    WallClock::time_point now = WallClock::now();
+
+    bool is_stream_active = _predicted_interval > 0s
+        && now - _last_arrival < STREAM_TIMEOUT;
+    if (!is_stream_active) {
+        // Nothing to predict, just check for new data now and then. Precise
+        // timing doesn't matter here.
+        WallClock::time_point wake_time = now + IDLE_WAIT;
+        while (!has_new_data() && WallClock::now() < wake_time)
+            std::this_thread::sleep_for(SLEEP_STEP);
+        return;
+    }
+
+    // Allow for jitter, but keep the polling window inside one interval
+    WallClock::duration early_margin = std::min(
+        std::max<WallClock::duration>(MIN_EARLY_MARGIN, 2 * _jitter),
+        _predicted_interval / 2);
+    WallClock::duration late_margin = std::min(
+        std::max<WallClock::duration>(MIN_LATE_MARGIN, 2 * _jitter),
+        _predicted_interval / 2);
+
+    WallClock::time_point expected_arrival = _last_arrival + _predicted_interval;
+    // If updates went missing, expect the next one in the same rhythm
+    if (now > expected_arrival + late_margin) {
+        auto num_missed = (now - expected_arrival - late_margin) / _predicted_interval;
+        expected_arrival += (num_missed + 1) * _predicted_interval;
+    }
+
+    WallClock::time_point poll_end = std::min(expected_arrival + late_margin,
+                                              now + MAX_WAIT);
+    WallClock::time_point poll_start = std::min(expected_arrival - early_margin,
+                                                poll_end);
+
+    if (SleepUntil(poll_start, has_new_data))
+        return;
+
+    // Spin until the data lands
+    while (!has_new_data() && WallClock::now() < poll_end)
+        std::this_thread::yield();
+}
+
+bool FramePacer::SleepUntil(WallClock::time_point wake_time,
+                            const std::function<bool()>& has_new_data)
+{
+    for (;;) {
+        if (has_new_data())
+            return true;
+
+        // Stop sleeping if another step might overshoot the wake time
+        WallClock::time_point step_start = WallClock::now();
+        float remaining_ms = ToMs(wake_time - step_start);
+        if (remaining_ms <= _sleep_step_mean_ms + 2.0f * _sleep_step_dev_ms)
+            return false;
+
+        std::this_thread::sleep_for(SLEEP_STEP);
+
+        float step_ms = ToMs(WallClock::now() - step_start);
+        float deviation_ms = std::abs(step_ms - _sleep_step_mean_ms);
+        _sleep_step_mean_ms = 0.95f * _sleep_step_mean_ms + 0.05f * step_ms;
+        _sleep_step_dev_ms  = 0.95f * _sleep_step_dev_ms  + 0.05f * deviation_ms;
+    }
+}
+
+void FramePacer::UpdateCpuUsage()
+{
+    WallClock::time_point now = WallClock::now();
+    WallClock::duration elapsed = now - _cpu_measure_start_time;
+    if (elapsed < CPU_USAGE_PERIOD)
+        return;
+
+    std::optional<WallClock::duration> cpu_time = GetThreadCpuTime();
+    if (!cpu_time)
+        return;
+
+    // Periods in which this wasn't called regularly don't only show the CPU
+    // usage of paced main loop iterations
+    if (elapsed < 2 * CPU_USAGE_PERIOD) {
+        _cpu_usage_percent = 100.0f
+            * ToMs(*cpu_time - _cpu_measure_start_cpu_time) / ToMs(elapsed);
+        _cpu_usage_hist.Add(_cpu_usage_percent);
+    }
+    _cpu_measure_start_time = now;
+    _cpu_measure_start_cpu_time = *cpu_time;
+}
+
+void FramePacer::AddReceiveToDisplayLatency(float latency_ms)
+{
+    _latency_hist.Add(latency_ms);
+}
+
+void FramePacer::ClearHistograms()
+{
+    _latency_hist.Clear();
+    _cpu_usage_hist.Clear();
+}
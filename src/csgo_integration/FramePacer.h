@@ -0,0 +1,103 @@
+#ifndef CSGO_INTEGRATION_FRAMEPACER_H_
+#define CSGO_INTEGRATION_FRAMEPACER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "common.h"
+
+namespace csgo_integration {
+
+// Histogram with equally wide buckets. Values outside of the histogram's range
+// are counted in the first or last bucket.
+class Histogram {
+public:
+    Histogram(float min, float max, size_t num_buckets);
+
+    void Add(float val);
+    void Clear();
+
+    uint64_t GetNumValues() const { return _num_values; }
+    float GetMin() const { return _min; }
+    float GetMax() const { return _max; }
+    // Bucket counts are floats so they can be plotted directly
+    const std::vector<float>& GetBucketCounts() const { return _bucket_counts; }
+    // Upper bound of the first bucket below which the given fraction of all
+    // values lie. Returns 0 if the histogram is empty.
+    float GetPercentile(float fraction) const;
+
+private:
+    float _min;
+    float _max;
+    std::vector<float> _bucket_counts;
+    uint64_t _num_values = 0;
+};
+
+// Schedules main loop iterations in "sparing low latency draw mode", where a
+// new frame is drawn as soon as new client-side data from CSGO arrived.
+//
+// Instead of running the main loop at a fixed high frequency, the arrival time
+// of the next data update is predicted from the measured time between recent
+// updates. The main thread sleeps until shortly before that point, then polls
+// for new data until it arrives, so the frame showing it can be drawn right
+// away. Sleeping happens in short steps whose actual duration is measured,
+// because the OS might oversleep. The remaining time is spun away.
+class FramePacer {
+public:
+    FramePacer();
+
+    // Must be called with the receive time of every client-side data update
+    void AddArrival(WallClock::time_point arrival_time);
+
+    // Blocks until new data is expected to arrive soon, then keeps calling
+    // has_new_data until it returns true or the expected update is overdue.
+    // Without recent updates, blocks for a short, fixed time instead.
+    void WaitForNextArrival(const std::function<bool()>& has_new_data);
+
+    // Median time between recent updates, 0 if unknown
+    WallClock::duration GetPredictedInterval() const { return _predicted_interval; }
+
+    // Must be called once per main loop iteration. Measures the CPU usage of
+    // the calling thread.
+    void UpdateCpuUsage();
+    // In percent of one core, measured over the most recent period
+    float GetCpuUsagePercent() const { return _cpu_usage_percent; }
+
+    // Time from receiving client-side data until the frame showing it got
+    // presented
+    void AddReceiveToDisplayLatency(float latency_ms);
+
+    const Histogram& GetLatencyHistogram() const { return _latency_hist; }
+    const Histogram& GetCpuUsageHistogram() const { return _cpu_usage_hist; }
+    void ClearHistograms();
+
+private:
+    void UpdatePrediction();
+    // Sleeps in short steps until shortly before wake_time. Returns early if
+    // has_new_data returns true.
+    bool SleepUntil(WallClock::time_point wake_time,
+                    const std::function<bool()>& has_new_data);
+
+    WallClock::time_point _last_arrival;
+    std::vector<WallClock::duration> _intervals; // Ring buffer of recent samples
+    size_t _next_interval_idx = 0;
+    WallClock::duration _predicted_interval{ 0 };
+    WallClock::duration _jitter{ 0 }; // Mean deviation of intervals from median
+
+    // Measured duration of a sleep step, in milliseconds
+    float _sleep_step_mean_ms;
+    float _sleep_step_dev_ms;
+
+    WallClock::time_point _cpu_measure_start_time;
+    WallClock::duration _cpu_measure_start_cpu_time{ 0 };
+    float _cpu_usage_percent = 0.0f;
+
+    Histogram _latency_hist;
+    Histogram _cpu_usage_hist;
+};
+
+} // namespace csgo_integration
+
+#endif // CSGO_INTEGRATION_FRAMEPACER_H_
@@ -4,13 +4,11 @@
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <queue>
-#include <regex>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
-#include <vector>
 
 #include <Corrade/Utility/Debug.h>
 // Include httplib.h before Windows.h or include Windows.h by defining
@@ -20,6 +18,7 @@
 #include <Magnum/Magnum.h>
 
 #include "common.h"
+#include "csgo_integration/ConsoleParsing.h"
 
 using namespace std::chrono;
 using namespace std::chrono_literals;
@@ -34,13 +33,125 @@ struct Gsi::impl {
     httplib::Server server;
     std::atomic<bool> is_stopping_server = false;
     std::atomic<bool> server_exited_unexpectedly = false;
-    
-    std::mutex packet_queue_mutex;
-    std::queue<std::string> packet_queue;
+    std::atomic<bool> keep_raw_payloads = false;
+
+    std::mutex newest_state_mutex;
+    std::optional<GsiState> newest_state;
+    uint64_t num_received_payloads = 0;
 
     std::string auth_token;
 };
 
+// Parses e.g. "-1021.08, 1553.60, 64.03"
+static std::optional<Vector3> ParseGsiVector3(std::string_view s)
+{
+    Vector3 v;
+    for (size_t i = 0; i < 3; i++) {
+        size_t start = s.find_first_not_of(", ");
+        if (start == std::string_view::npos)
+            return {};
+        s.remove_prefix(start);
+        size_t len = ConsoleParsing::ParseFloatPrefix(s, &v[i]);
+        if (len == 0)
+            return {};
+        s.remove_prefix(len);
+    }
+    if (s.find_first_not_of(", ") != std::string_view::npos)
+        return {}; // More than 3 values
+    return v;
+}
+
+// Extracts the values we need from a JSON payload while it's being parsed,
+// without building a DOM of the entire payload. String values are passed in
+// the parser's reused token buffer, only extracted ones are copied.
+class GsiPayloadExtractor : public nlohmann::json_sax<json> {
+public:
+    GsiState state;
+    std::string auth_token; // No token is an empty token
+    std::string error_msg;
+
+    bool null() override { return true; }
+    bool boolean(bool) override { return true; }
+    bool number_integer(number_integer_t) override { return true; }
+    bool number_unsigned(number_unsigned_t) override { return true; }
+    bool number_float(number_float_t, const string_t&) override { return true; }
+    bool binary(binary_t&) override { return true; }
+
+    bool string(string_t& val) override {
+        if (_depth != 2) // Only look at values of objects in the root object
+            return true;
+        switch (_section) {
+        case AUTH: // Take the first string value we find, from whatever key
+            if (!_has_auth_token) {
+                auth_token = val;
+                _has_auth_token = true;
+            }
+            break;
+        case MAP:
+            if (_key == "name" && !state.map_name)
+                state.map_name = val;
+            break;
+        case PLAYER:
+            if (_key == "position")
+                state.spec_pos = ParseGsiVector3(val);
+            else if (_key == "forward")
+                state.spec_forward = ParseGsiVector3(val);
+            break;
+        default:
+            break;
+        }
+        return true;
+    }
+
+    bool key(string_t& val) override {
+        if (_depth == 1) {
+            if      (val == "auth")   _root_key_section = AUTH;
+            else if (val == "map")    _root_key_section = MAP;
+            else if (val == "player") _root_key_section = PLAYER;
+            else                      _root_key_section = OTHER;
+        }
+        else if (_depth == 2 && _section != OTHER) {
+            _key.assign(val); // Reuses _key's allocation
+        }
+        return true;
+    }
+
+    bool start_object(std::size_t) override {
+        _depth++;
+        if (_depth == 2)
+            _section = _root_key_section;
+        return true;
+    }
+    bool end_object() override {
+        _depth--;
+        if (_depth == 1)
+            _section = OTHER;
+        return true;
+    }
+    bool start_array(std::size_t) override {
+        _depth++;
+        return true;
+    }
+    bool end_array() override {
+        _depth--;
+        return true;
+    }
+
+    bool parse_error(std::size_t, const std::string&,
+                     const nlohmann::detail::exception& ex) override {
+        error_msg = ex.what();
+        return false;
+    }
+
+private:
+    enum Section { OTHER, AUTH, MAP, PLAYER };
+    Section _root_key_section = OTHER; // Section of the last key in root object
+    Section _section = OTHER; // Section we're currently in
+    int _depth = 0;
+    std::string _key; // Last key inside a section
+    bool _has_auth_token = false;
+};
+
 
 Gsi::Gsi()
     : _pImpl{ std::make_unique<impl>() }
@@ -60,16 +171,37 @@ bool Gsi::Start(const std::string& host, int port, const std::string& auth_token
 
     _pImpl->is_stopping_server = false;
     _pImpl->server_exited_unexpectedly = false;
-    _pImpl->packet_queue = {}; // Reset queue without mutex since thread is stopped
+    // Reset without mutex since thread is stopped
+    _pImpl->newest_state.reset();
+    _pImpl->num_received_payloads = 0;
     _pImpl->auth_token = auth_token;
 
     auto http_handler = [this]
         (const httplib::Request& request, httplib::Response& response)
     {
-        std::string req_body = request.body;
-        {
-            std::lock_guard<std::mutex> lock(_pImpl->packet_queue_mutex);
-            _pImpl->packet_queue.push(std::move(req_body));
+        WallClock::time_point receive_time = WallClock::now();
+
+        // Parse on the http server's thread, the main thread only picks up
+        // the newest result
+        GsiPayloadExtractor extractor;
+        if (!json::sax_parse(request.body, &extractor)) {
+            Debug{} << "[GSI] JSON parse error:" << extractor.error_msg.c_str();
+            Debug{} << "[GSI] Payload contents:";
+            Debug{} << request.body.c_str();
+            Debug{} << "[GSI] end of payload contents";
+        }
+        else if (extractor.auth_token != _pImpl->auth_token) {
+            Debug{} << "[GSI] Received JSON payload with wrong auth token:"
+                << extractor.auth_token.c_str();
+        }
+        else {
+            extractor.state.receive_time = receive_time;
+            if (_pImpl->keep_raw_payloads)
+                extractor.state.json_payload = request.body;
+
+            std::lock_guard<std::mutex> lock(_pImpl->newest_state_mutex);
+            _pImpl->newest_state = std::move(extractor.state);
+            _pImpl->num_received_payloads++;
         }
         response.set_content("{}", "application/json");
         response.status = 200;
@@ -77,6 +209,11 @@ bool Gsi::Start(const std::string& host, int port, const std::string& auth_token
 
     _pImpl->server.Post("/", http_handler);
 
+    // CSGO waits for each response before sending its next payload. Without
+    // this, response header and body writes get delayed by Nagle's algorithm
+    // and delayed ACKs, taking ~40 ms per payload.
+    _pImpl->server.set_tcp_nodelay(true);
+
     Debug{} << ("[GSI] Starting http server on " + host + ":"
         + std::to_string(port) + " ...").c_str();
 
@@ -146,101 +283,23 @@ bool Gsi::HasHttpServerUnexpectedlyClosed()
     return _pImpl->server_exited_unexpectedly;
 }
 
-std::vector<GsiState> Gsi::GetNewestGsiStates()
+std::optional<GsiState> Gsi::GetNewestGsiState()
 {
-    // Quickly retrieve packet queue contents
-    std::queue<std::string> packet_q;
+    std::optional<GsiState> state;
     {
-        std::lock_guard<std::mutex> lock(_pImpl->packet_queue_mutex);
-        _pImpl->packet_queue.swap(packet_q);
-    }
-
-    // Parse gamestate data
-    std::vector<GsiState> states;
-    while (!packet_q.empty()) {
-        GsiState s;
-        s.json_payload = std::move(packet_q.front());
-        packet_q.pop();
-
-        // Parse without throwing exceptions
-        json gamestate = json::parse(s.json_payload, nullptr, false);
-
-        // If parse error occurred
-        if (gamestate.is_discarded()) {
-            Debug{} << "[GSI] JSON parse error! payload contents:";
-            Debug{} << s.json_payload.c_str();
-            Debug{} << "[GSI] end of payload contents";
-            continue;
-        }
-
-        std::string payload_auth_token = ""; // Default token is no token
-
-        // Iterate through json object
-        for (auto& elem : gamestate.items()) {
-            if (elem.value().is_object()) {
-                // Get auth token value
-                if (elem.key() == "auth") {
-                    json& auth_obj = elem.value();
-                    // Take the first string value we find, from whatever key
-                    for (auto& e : auth_obj.items()) {
-                        if (e.value().is_string()) {
-                            payload_auth_token = e.value();
-                            break;
-                        }
-                    }
-                }
-                // Get map name value
-                if (elem.key() == "map") {
-                    json& map_obj = elem.value();
-                    for (auto& e : map_obj.items()) {
-                        if (e.key() == "name" && e.value().is_string()) {
-                            s.map_name = e.value();
-                            break;
-                        }
-                    }
-                }
-                // Get player values
-                if (elem.key() == "player") {
-                    json& player_obj = elem.value();
-                    for (auto& e : player_obj.items()) {
-                        if (e.key() == "position" && e.value().is_string())
-                            s.spec_pos = ParseGsiVector3(e.value());
-                        else if (e.key() == "forward" && e.value().is_string())
-                            s.spec_forward = ParseGsiVector3(e.value());
-                    }
-                }
-            }
-        }
-
-        if (payload_auth_token != _pImpl->auth_token) {
-            Debug{} << "[GSI] Received JSON payload with wrong auth token:"
-                << payload_auth_token.c_str();
-            continue;
-        }
-
-        states.push_back(std::move(s));
+        std::lock_guard<std::mutex> lock(_pImpl->newest_state_mutex);
+        state.swap(_pImpl->newest_state);
     }
+    return state;
+}
 
-    return states;
+uint64_t Gsi::GetNumReceivedPayloads()
+{
+    std::lock_guard<std::mutex> lock(_pImpl->newest_state_mutex);
+    return _pImpl->num_received_payloads;
 }
 
-std::optional<Vector3> Gsi::ParseGsiVector3(std::string s)
+void Gsi::SetKeepRawPayloads(bool keep)
 {
-    // Match separate float values with ONLY the following formats:
-    // -0.14
-    // 1.0
-    // -782.1314
-    std::regex regex(R"(-?[0-9]+\.[0-9]+)");
-    auto vals_begin = std::sregex_iterator(s.begin(), s.end(), regex);
-    auto vals_end   = std::sregex_iterator(); // end-of-sequence iterator
-
-    std::vector<float> vals;
-    for (std::sregex_iterator iter = vals_begin; iter != vals_end; ++iter) {
-        // std::stof can't fail with used regex
-        vals.push_back(std::stof(iter->str()));
-    }
-    if (vals.size() != 3)
-        return std::optional<Vector3>(); // empty
-    else
-        return std::optional<Vector3>(std::in_place, vals[0], vals[1], vals[2]);
+    _pImpl->keep_raw_payloads = keep;
 }
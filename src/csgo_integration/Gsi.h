@@ -1,23 +1,28 @@
 #ifndef CSGO_INTEGRATION_GSI_H_
 #define CSGO_INTEGRATION_GSI_H_
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
-#include <vector>
 
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
 
+#include "common.h"
+
 namespace csgo_integration {
 
     struct GsiState {
-        // Unparsed
+        // Unparsed, only kept if enabled with Gsi::SetKeepRawPayloads()
         std::string json_payload;
         // Parsed
         std::optional<std::string> map_name;
         std::optional<Magnum::Vector3> spec_pos; // X, Y, Z
         std::optional<Magnum::Vector3> spec_forward;
+
+        // When the payload was received
+        WallClock::time_point receive_time;
     };
 
     // CSGO's Game State Integration
@@ -35,12 +40,19 @@ namespace csgo_integration {
         bool IsRunning();
         bool HasHttpServerUnexpectedlyClosed();
 
-        // Returns empty vector if nothing new is available
-        std::vector<GsiState> GetNewestGsiStates();
+        // Payloads are parsed as they arrive. Only the newest game state is
+        // kept, older ones that weren't retrieved yet are discarded.
+        // Returns nothing if no new game state is available.
+        std::optional<GsiState> GetNewestGsiState();
 
-    private:
-        std::optional<Magnum::Vector3> ParseGsiVector3(std::string s);
+        // Number of payloads with valid auth token received since Start(),
+        // including discarded ones
+        uint64_t GetNumReceivedPayloads();
 
+        // For debugging: Keep the unparsed JSON payload in each GsiState
+        void SetKeepRawPayloads(bool keep);
+
+    private:
         // Put private member variables into forward-declared struct that's
         // defined in the cpp to reduce size of this header file. (PImpl
         // programming technique) The main reason for that is usage of big
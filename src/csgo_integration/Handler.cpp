@@ -1,13 +1,14 @@
 #include "csgo_integration/Handler.h"
 
-#include <regex>
-#include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include <Corrade/Utility/Debug.h>
 #include <Magnum/Magnum.h>
 
 #include "common.h"
+#include "csgo_integration/ConsoleParsing.h"
+#include "csgo_integration/DataRelayDecoder.h"
 #include "csgo_parsing/utils.h"
 
 using namespace Magnum;
@@ -37,15 +38,16 @@ const auto DATA_RELAY_TIMEOUT = std::chrono::milliseconds(100);
 
 // Console command to tell the data relay to keep running for a specified duration
 static std::string DATA_RELAY_KEEP_ALIVE_CMD(float duration_secs) {
-    return "script DZSDR1_KEEP_ALIVE_UNTIL<-Time()+" + std::to_string(duration_secs);
+    return "script DZSDR2_KEEP_ALIVE_UNTIL<-Time()+" + std::to_string(duration_secs);
 }
-#define DATA_RELAY_STOP_CMD "script DZSDR1_KEEP_ALIVE_UNTIL<-0.0"
+#define DATA_RELAY_STOP_CMD "script DZSDR2_KEEP_ALIVE_UNTIL<-0.0"
 
 
 Handler::Handler(Corrade::Utility::Resource& res, RemoteConsole& con,
     gui::GuiState& gui_state)
     : _con(con)
     , _gui_state(gui_state)
+    , _relay_decoder(std::make_unique<DataRelayDecoder>())
 {
     // Get CSGO console commands that create a "data relay" that runs inside
     // CSGO and continously prints game data to the console.
@@ -81,6 +83,8 @@ Handler::Handler(Corrade::Utility::Resource& res, RemoteConsole& con,
     }
 }
 
+Handler::~Handler() = default; // DataRelayDecoder is complete here
+
 void Handler::Update()
 {
     WallClock::time_point time_now = WallClock::now();
@@ -88,20 +92,18 @@ void Handler::Update()
     // Parse received CSGO console output
     size_t pre_parse_server_q_len = _new_server_ticks_data_q.size();
     bool received_host_server_check_response = false;
-    auto received_lines = _con.ReadLines();
-    for (const std::string& line : received_lines) {
-        if (line.compare(HOST_SERVER_CHECK_RESPONSE) == 0) {
+    for (const SpscLineQueue::Line& received_line : _con.ReadLines()) {
+        std::string_view line = received_line.text;
+        if (line == HOST_SERVER_CHECK_RESPONSE) {
             received_host_server_check_response = true;
             continue;
         }
 
         // e.g. "ChangeGameUIState: CSGO_GAME_UI_STATE_MAINMENU -> CSGO_GAME_UI_STATE_LOADINGSCREEN\n"
         if (line.starts_with("ChangeGameUIState:")) { // CSGO UI state transition
-            std::vector<std::string> tokens =
-                csgo_parsing::utils::SplitString(line, ' ');
-            if (tokens.size() == 4 && tokens[2].compare("->") == 0) {
-                std::string& new_ui_state = tokens[3];
-                if (new_ui_state.compare("CSGO_GAME_UI_STATE_LOADINGSCREEN") == 0) {
+            std::string_view new_ui_state;
+            if (ConsoleParsing::ParseChangeGameUIState(line, &new_ui_state)) {
+                if (new_ui_state == "CSGO_GAME_UI_STATE_LOADINGSCREEN") {
                     _csgo_ui_state = LOADINGSCREEN;
                 }
                 else {
@@ -118,7 +120,7 @@ void Handler::Update()
             continue;
         }
 
-        ParseConsoleOutput(line);
+        ParseConsoleOutput(line, received_line.arrival_time);
     }
     size_t post_parse_server_q_len = _new_server_ticks_data_q.size();
 
@@ -202,6 +204,7 @@ void Handler::Update()
                 auto time_since_last_setup = time_now - _last_data_relay_setup_time;
                 if (time_since_last_setup > std::chrono::milliseconds(3000)) {
                     _con.WriteLines(_data_relay_setup_cmds);
+                    _relay_decoder->Reset(); // New relay, new tick sequence
                     Debug{} << "[CsgoHandler] Data relay setup";
                     _last_data_relay_setup_time = time_now;
                 }
@@ -243,122 +246,13 @@ void Handler::Update()
     _prev_is_console_connected = true; // Remember for next call to Update()
 }
 
-void Handler::ParseConsoleOutput(const std::string& line)
+void Handler::ParseConsoleOutput(std::string_view line,
+                                 WallClock::time_point receive_time)
 {
-    // Server-side data
-    bool is_server_data_start_marker = line.starts_with("dzs-dr-v1-tick-start ");
-    bool is_server_player_data       = line.starts_with("player ");
-    bool is_server_bump_mine_data    = line.starts_with("bm ");
-    bool is_server_data_end_marker   = line.starts_with("dzs-dr-v1-tick-end");
-
-    // Client-side data
-    bool is_client_player_data       = line.starts_with("setpos ");
-    
-    if (is_server_data_start_marker || is_server_player_data || is_server_bump_mine_data) {
-        // Get values separated by spaces
-        std::vector<std::string> tokens =
-            csgo_parsing::utils::SplitString(line, ' ');
-
-        if (is_server_data_start_marker) { // e.g. "dzs-dr-v1-tick-start 85\n"
-            if (tokens.size() < 2) return;
-            try {
-                int tick_id = std::stoi(tokens[1]);
-                _incomplete_next_server_tick_data.tick_id = tick_id;
-            }
-            catch (const std::invalid_argument&) {}
-            catch (const std::out_of_range&) {}
-            return;
-        }
-        if (is_server_player_data) { // e.g. "player -4634.38 271.376 1571.43 1635.43 false -322.528 -979.985 -442.433\n"
-            if (tokens.size() < 9) return;
-            bool crouched = tokens[5].compare("true") == 0;
-            try {
-                Vector3 feet_pos = {
-                    std::stof(tokens[1]), // x
-                    std::stof(tokens[2]), // y
-                    std::stof(tokens[3])  // z
-                };
-                Vector3 eye_pos = {
-                    feet_pos.x(), // x, same as feet_pos.x
-                    feet_pos.y(), // y, same as feet_pos.y
-                    std::stof(tokens[4])  // z, different from feet_pos.z
-                };
-                Vector3 vel = {
-                    std::stof(tokens[6]), // x
-                    std::stof(tokens[7]), // y
-                    std::stof(tokens[8])  // z
-                };
-
-                // Only accept and set data if nothing went wrong during parsing
-                _incomplete_next_server_tick_data.player_pos_feet = feet_pos;
-                _incomplete_next_server_tick_data.player_pos_eye = eye_pos;
-                _incomplete_next_server_tick_data.player_vel = vel;
-                _incomplete_next_server_tick_data.is_player_crouched = crouched;
-            }
-            catch (const std::invalid_argument&) {}
-            catch (const std::out_of_range&) {}
-            return;
-        }
-        if (is_server_bump_mine_data) { // e.g. "bm 920 -1153.88 -1005.98 997.602 -3.27541 -2.71377 5.52694\n"
-            if (tokens.size() < 8) return;
-            try {
-                int bm_id = std::stoi(tokens[1]);
-                Handler::CsgoServerTickData::BumpMineData bm_data;
-                bm_data.pos = {
-                    std::stof(tokens[2]), // x
-                    std::stof(tokens[3]), // y
-                    std::stof(tokens[4])  // z
-                };
-                bm_data.angles = {
-                    std::stof(tokens[5]), // pitch
-                    std::stof(tokens[6]), // yaw
-                    std::stof(tokens[7])  // roll
-                };
-
-                // Only accept and set data if nothing went wrong during parsing
-                _incomplete_next_server_tick_data.bump_mines[bm_id] = std::move(bm_data);
-            }
-            catch (const std::invalid_argument&) {}
-            catch (const std::out_of_range&) {}
-            return;
-        }
-    }
-    
-    if (is_server_data_end_marker) { // e.g. "dzs-dr-v1-tick-end\n"
-        // Data of next server tick is complete, put it on the queue
-        _new_server_ticks_data_q.push_back(std::move(_incomplete_next_server_tick_data));
-        _incomplete_next_server_tick_data = CsgoServerTickData(); // construct for reuse
-        return;
-    }
-
-    // Client-side data that is parsed and handled separately from server data.
-    // Parse response of the 'getpos' command.
-    if (is_client_player_data) { // e.g. "setpos -1338.681030 -1089.463989 1070.809204;setang 21.053974 -10.723428 0.000000\n"
-        // Match separate float values with ONLY the following formats:
-        // -0.14
-        // 1.0
-        // -782.1314
-        std::regex regex(R"(-?[0-9]+\.[0-9]+)");
-        auto vals_begin = std::sregex_iterator(line.begin(), line.end(), regex);
-        auto vals_end = std::sregex_iterator(); // end-of-sequence iterator
-
-        std::vector<float> vals;
-        for (std::sregex_iterator iter = vals_begin; iter != vals_end; ++iter) {
-            // std::stof can't fail with used regex
-            vals.push_back(std::stof(iter->str()));
-        }
-
-        if (vals.size() < 6)
-            return;
-
-        CsgoClientsideData new_client_data;
-        new_client_data.player_pos_eye = { vals[0], vals[1], vals[2] };
-        new_client_data.player_angles  = { vals[3], vals[4], vals[5] };
-
-        // Next client-side data is complete, put it on the queue
-        _new_client_side_data_q.push_back(std::move(new_client_data));
-        return;
-    }
+    ConsoleParsing::ParseGameDataLine(line, receive_time, _relay_decoder.get(),
+                                      &_incomplete_next_server_tick_data,
+                                      &_new_server_ticks_data_q,
+                                      &_new_client_side_data_q);
 }
 
 std::deque<Handler::CsgoServerTickData> Handler::DequeNewCsgoServerTicksData()
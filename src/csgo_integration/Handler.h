@@ -3,7 +3,9 @@
 
 #include <deque>
 #include <map>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <Corrade/Utility/Resource.h>
@@ -16,6 +18,8 @@
 
 namespace csgo_integration {
 
+    class DataRelayDecoder;
+
     // Communicates with the ingame console of a running CSGO process.
     // Sends console commands and receives their output in order to attain game
     // data such as player position, speed, etc...
@@ -39,6 +43,9 @@ namespace csgo_integration {
             // Caution: IDs of no longer existing bump mines may get reused for
             //          new bump mines!
             std::map<int, BumpMineData> bump_mines;
+
+            // When the last console line of this tick's data was received
+            WallClock::time_point receive_time;
         };
 
         // Client-side positional data in CSGO, receive rate is variable 
@@ -50,12 +57,16 @@ namespace csgo_integration {
             // This eye position is subject to client-side prediction.
             // It can differ substantially from server-side eye position!
             Magnum::Vector3 player_pos_eye;
+
+            // When the console line with this data was received
+            WallClock::time_point receive_time;
         };
 
         Handler(
             Corrade::Utility::Resource& res,
             RemoteConsole& con,
             gui::GuiState& gui_state);
+        ~Handler();
 
         // Reads and writes from/to CSGO's console if it's connected.
         // Attains new csgo client and server data.
@@ -65,7 +76,8 @@ namespace csgo_integration {
         std::deque<CsgoClientsideData> DequeNewCsgoClientsideData();
 
     private:
-        void ParseConsoleOutput(const std::string& line);
+        void ParseConsoleOutput(std::string_view line,
+                                WallClock::time_point receive_time);
 
         RemoteConsole& _con;
         gui::GuiState& _gui_state;
@@ -89,9 +101,12 @@ namespace csgo_integration {
         std::deque<CsgoServerTickData> _new_server_ticks_data_q;
         std::deque<CsgoClientsideData> _new_client_side_data_q;
 
-        // Data of next server tick data still being received
+        // Data of next server tick data still being received (data relay v1)
         CsgoServerTickData _incomplete_next_server_tick_data;
 
+        // Decodes server ticks from data relay v2 output
+        std::unique_ptr<DataRelayDecoder> _relay_decoder;
+
         // The last time we tested if user is hosting a local server
         WallClock::time_point _last_host_server_check_time;
 
@@ -0,0 +1,198 @@
+#include "csgo_integration/PlayerExtrapolator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <utility>
+
+#include <Magnum/Math/Angle.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Time.h>
+#include <Magnum/Math/TimeStl.h>
+#include <Magnum/Math/Vector2.h>
+
+#include "coll/TraceProfiler.h"
+#include "GlobalVars.h"
+#include "sim/CsgoConstants.h"
+#include "sim/PlayerInput.h"
+#include "sim/Sim.h"
+
+using namespace Magnum;
+using namespace Magnum::Math::Literals;
+using namespace csgo_integration;
+
+// Duration of a CSGO server tick
+static const sim::SimTimeDur SIM_TIME_STEP_SIZE = 1.0_sec / sim::CSGO_TICKRATE;
+
+// The tick clock may drift this much later per received tick, in case the
+// server's tick rate is slightly slower than nominal
+static const auto TICK_CLOCK_DRIFT = std::chrono::microseconds(10);
+// Ticks that deviate further from the tick clock restart it, e.g. after the
+// server restarted
+static const auto TICK_CLOCK_RESET_THRESHOLD = std::chrono::seconds(1);
+
+// Horizontal speed below which the player is assumed to not hold movement keys
+static const float MIN_MOVING_SPEED = 1.0f;
+// Players that slowed down more than this since the previous tick are assumed
+// to have released movement keys
+static const float MIN_SLOWDOWN = 1.0f;
+// cos(67.5 deg). Diagonal movement directions are guessed to be caused by
+// holding two movement keys.
+static const float KEY_DIRECTION_THRESHOLD = 0.38f;
+
+PlayerExtrapolator::PlayerExtrapolator()
+    : _tick_interval{ std::chrono::nanoseconds{ Nanoseconds{ SIM_TIME_STEP_SIZE } } }
+    , _error_hist{ 0.0f, 16.0f, 64 } // 0.25 units wide buckets
+{
+}
+
+void PlayerExtrapolator::Reset()
+{
+    _has_tick_clock = false;
+    _has_base = false;
+    _base = {};
+    _predicted = {};
+    _next_predicted = {};
+    _predicted_positions.clear();
+    _error_hist.Clear();
+    _mean_error = 0.0f;
+    _mean_error_without_extrapolation = 0.0f;
+}
+
+WallClock::time_point PlayerExtrapolator::GetTickTime(size_t tick_id) const
+{
+    return _tick_clock_start + (WallClock::rep)tick_id * _tick_interval;
+}
+
+void PlayerExtrapolator::UpdateTickClock(const Handler::CsgoServerTickData& tick)
+{
+    WallClock::time_point clock_start =
+        tick.receive_time - (WallClock::rep)tick.tick_id * _tick_interval;
+    WallClock::duration deviation = clock_start - _tick_clock_start;
+    if (!_has_tick_clock || deviation > TICK_CLOCK_RESET_THRESHOLD
+                         || deviation < -TICK_CLOCK_RESET_THRESHOLD) {
+        _tick_clock_start = clock_start;
+        _has_tick_clock = true;
+        return;
+    }
+    // Keep the earliest estimate, ticks can only be delayed
+    _tick_clock_start = std::min(_tick_clock_start + TICK_CLOCK_DRIFT, clock_start);
+}
+
+void PlayerExtrapolator::AddServerTick(const Handler::CsgoServerTickData& tick,
+                                       const Vector3& view_angles,
+                                       const sim::Entities::Player::Loadout& loadout)
+{
+    // Extrapolated ticks aren't game ticks, keep them out of the trace stats.
+    // They don't advance CollidableWorld's tick clock either, see
+    // CollidableWorld::OnSimulationTickFinished().
+    coll::TraceProfiler::ScopedSuspend profiler_suspend;
+
+    UpdateTickClock(tick);
+
+    // Measure how well the previous tick predicted this one
+    bool is_newer_tick = _has_base && tick.tick_id > _base_tick_id;
+    if (is_newer_tick && tick.tick_id - _base_tick_id <= MAX_EXTRAPOLATED_TICKS) {
+        while (_predicted_tick_id < tick.tick_id)
+            StepPrediction();
+        const Vector3& predicted_pos =
+            _predicted_positions[tick.tick_id - _base_tick_id - 1];
+        float error = (predicted_pos - tick.player_pos_feet).length();
+        float error_without_extrapolation =
+            (_base.csgo_mv.m_vecAbsOrigin - tick.player_pos_feet).length();
+
+        _error_hist.Add(error);
+        if (_error_hist.GetNumValues() == 1) {
+            _mean_error = error;
+            _mean_error_without_extrapolation = error_without_extrapolation;
+        }
+        else {
+            _mean_error = 0.99f * _mean_error + 0.01f * error;
+            _mean_error_without_extrapolation =
+                0.99f * _mean_error_without_extrapolation + 0.01f * error_without_extrapolation;
+        }
+    }
+
+    // Guess which movement keys the player is holding
+    sim::PlayerInput::State input;
+    input.sample_time = tick.receive_time;
+    input.viewing_angles = { view_angles.x(), view_angles.y(), 0.0f };
+
+    Vector2 hori_vel = { tick.player_vel.x(), tick.player_vel.y() };
+    float hori_speed = hori_vel.length();
+    bool is_slowing_down = is_newer_tick && hori_speed <
+        Vector2{ _base.csgo_mv.m_vecVelocity.x(), _base.csgo_mv.m_vecVelocity.y() }.length()
+        - MIN_SLOWDOWN;
+    if (hori_speed > MIN_MOVING_SPEED && !is_slowing_down) {
+        auto yaw_sincos = Math::sincos(Deg{ view_angles.y() });
+        Vector2 forward = { yaw_sincos.second(),  yaw_sincos.first() };
+        Vector2 right   = { yaw_sincos.first(), -yaw_sincos.second() };
+        Vector2 move_dir = hori_vel / hori_speed;
+        float forward_part = Math::dot(move_dir, forward);
+        float right_part   = Math::dot(move_dir, right);
+        if (forward_part >  KEY_DIRECTION_THRESHOLD) input.nButtons |= IN_FORWARD;
+        if (forward_part < -KEY_DIRECTION_THRESHOLD) input.nButtons |= IN_BACK;
+        if (right_part   >  KEY_DIRECTION_THRESHOLD) input.nButtons |= IN_MOVERIGHT;
+        if (right_part   < -KEY_DIRECTION_THRESHOLD) input.nButtons |= IN_MOVELEFT;
+    }
+    if (tick.is_player_crouched)
+        input.nButtons |= IN_DUCK;
+
+    // Rewind the prediction to the new tick
+    sim::WorldState new_base;
+    new_base.prev_input = input;
+    new_base.player.loadout = loadout;
+    sim::CsgoMovement& mv = new_base.csgo_mv;
+    mv.m_loadout = loadout;
+    mv.m_vecAbsOrigin = tick.player_pos_feet;
+    mv.m_vecVelocity = tick.player_vel;
+    mv.m_vecViewAngles = input.viewing_angles;
+    mv.m_nButtons = input.nButtons;
+    mv.m_nOldButtons = input.nButtons;
+    mv.SetDuckStateInstantly(tick.is_player_crouched);
+    mv.m_vecViewOffset = tick.player_pos_eye - tick.player_pos_feet;
+    if (g_coll_world) {
+        mv.m_traceCache = &_trace_cache;
+        mv.CategorizePosition((float)Seconds{ SIM_TIME_STEP_SIZE });
+        mv.m_traceCache = nullptr;
+    }
+
+    _base = std::move(new_base);
+    _base_tick_id = tick.tick_id;
+    _has_base = true;
+
+    // Then replay from there
+    _predicted = _base;
+    _predicted_tick_id = _base_tick_id;
+    _next_predicted = _base;
+    _next_predicted.AdvanceSimulation(SIM_TIME_STEP_SIZE, {}, &_trace_cache);
+    _predicted_positions.clear();
+}
+
+void PlayerExtrapolator::StepPrediction()
+{
+    coll::TraceProfiler::ScopedSuspend profiler_suspend; // See AddServerTick()
+    _predicted = std::move(_next_predicted);
+    _predicted_tick_id++;
+    _predicted_positions.push_back(_predicted.csgo_mv.m_vecAbsOrigin);
+
+    _next_predicted = _predicted;
+    _next_predicted.AdvanceSimulation(SIM_TIME_STEP_SIZE, {}, &_trace_cache);
+}
+
+sim::WorldState PlayerExtrapolator::GetExtrapolatedWorldState(WallClock::time_point time)
+{
+    assert(_has_base);
+
+    size_t last_tick_id = _base_tick_id + MAX_EXTRAPOLATED_TICKS;
+    while (_predicted_tick_id < last_tick_id && GetTickTime(_predicted_tick_id + 1) <= time)
+        StepPrediction();
+    if (_predicted_tick_id == last_tick_id)
+        return _predicted;
+
+    using nano = std::chrono::nanoseconds;
+    float phase =
+        (float)std::chrono::duration_cast<nano>(time - GetTickTime(_predicted_tick_id)).count() /
+        (float)std::chrono::duration_cast<nano>(_tick_interval).count();
+    return sim::WorldState::Interpolate(_predicted, _next_predicted, phase);
+}
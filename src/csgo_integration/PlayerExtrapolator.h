@@ -0,0 +1,100 @@
+#ifndef CSGO_INTEGRATION_PLAYEREXTRAPOLATOR_H_
+#define CSGO_INTEGRATION_PLAYEREXTRAPOLATOR_H_
+
+#include <cstddef>
+#include <vector>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "coll/TraceCache.h"
+#include "common.h"
+#include "csgo_integration/FramePacer.h" // For Histogram
+#include "csgo_integration/Handler.h"
+#include "sim/Entities/Player.h"
+#include "sim/WorldState.h"
+
+namespace csgo_integration {
+
+// Extrapolates the player's server-side movement state from the latest
+// received CSGO server tick to the present, using DZSimulator's own movement
+// simulation. This hides the delay of server ticks relayed through CSGO's
+// console, similar to how sim::CsgoGame predicts its drawable world state.
+//
+// Server ticks don't contain the player's inputs, so they are guessed: The
+// player is assumed to keep holding the movement keys that move them into
+// their current direction, unless they slowed down since the previous tick.
+//
+// When a new server tick arrives, the prediction is rewound to it and then
+// replayed from there. Before that, the prediction for that tick is compared
+// to the actual tick, giving an error metric of the extrapolation.
+class PlayerExtrapolator {
+public:
+    // Extrapolation stops this many ticks after the latest server tick
+    static const size_t MAX_EXTRAPOLATED_TICKS = 16;
+
+    PlayerExtrapolator();
+
+    // Forgets all received ticks and error metrics. Must be called when
+    // another map is loaded.
+    void Reset();
+
+    // Must be called with every newly received server tick, in order. The
+    // player's view angles and loadout aren't part of server ticks, but are
+    // needed to simulate the player.
+    void AddServerTick(const Handler::CsgoServerTickData& tick,
+                       const Magnum::Vector3& view_angles,
+                       const sim::Entities::Player::Loadout& loadout);
+    bool HasServerTick() const { return _has_base; }
+
+    // Returns the player's predicted movement state at the given time. Must
+    // only be called if HasServerTick() returns true.
+    // CAUTION: Only the player's position and view offset are interpolated
+    //          between predicted ticks!
+    sim::WorldState GetExtrapolatedWorldState(WallClock::time_point time);
+
+    // Distance between predicted and actual player position of received ticks
+    const Histogram& GetPositionErrorHistogram() const { return _error_hist; }
+    float GetMeanPositionError() const { return _mean_error; }
+    // Same, but if the previous tick was shown instead of extrapolating
+    float GetMeanPositionErrorWithoutExtrapolation() const {
+        return _mean_error_without_extrapolation;
+    }
+
+private:
+    // Estimated time at which CSGO's server simulated the given tick
+    WallClock::time_point GetTickTime(size_t tick_id) const;
+    void UpdateTickClock(const Handler::CsgoServerTickData& tick);
+    // Advances the prediction by one tick
+    void StepPrediction();
+
+    WallClock::duration _tick_interval;
+
+    // Tick times are estimated from the receive time of ticks that were
+    // relayed the fastest. Time at which tick 0 would have been simulated:
+    WallClock::time_point _tick_clock_start;
+    bool _has_tick_clock = false;
+
+    // Latest received server tick, the prediction's starting point
+    bool _has_base = false;
+    size_t _base_tick_id = 0;
+    sim::WorldState _base;
+
+    // Predicted ticks directly after the base tick
+    size_t _predicted_tick_id = 0;
+    sim::WorldState _predicted;      // Tick _predicted_tick_id
+    sim::WorldState _next_predicted; // Tick _predicted_tick_id + 1
+    // Player positions of predicted ticks _base_tick_id + 1, + 2, ...
+    std::vector<Magnum::Vector3> _predicted_positions;
+
+    // Used for all of the player's movement traces
+    coll::TraceCache _trace_cache;
+
+    Histogram _error_hist;
+    float _mean_error = 0.0f;
+    float _mean_error_without_extrapolation = 0.0f;
+};
+
+} // namespace csgo_integration
+
+#endif // CSGO_INTEGRATION_PLAYEREXTRAPOLATOR_H_
@@ -12,10 +12,17 @@
 #include <asio/read_until.hpp>
 #include <asio/write.hpp>
 
+#include "common.h"
+
 using asio::ip::tcp;
 
 using namespace csgo_integration;
 
+// Capacity of the received line queue. At the data relay's output rate, this
+// lasts for multiple seconds without ReadLines() calls, e.g. during map loads.
+static const size_t READ_LINE_QUEUE_ARENA_SIZE = 1024 * 1024;
+static const size_t READ_LINE_QUEUE_MAX_LINES  = 16 * 1024;
+
 RemoteConsole::RemoteConsole(size_t max_received_line_len)
     : _connected(false)
     , _connecting(false)
@@ -26,7 +33,8 @@ RemoteConsole::RemoteConsole(size_t max_received_line_len)
     , _io_context()
     , _socket(_io_context)
     , _read_buf_pos(0)
-    , _discard_current_read_line(false) {
+    , _discard_current_read_line(false)
+    , _read_line_q(READ_LINE_QUEUE_ARENA_SIZE, READ_LINE_QUEUE_MAX_LINES) {
     // _read_buf will not change size throughout its lifetime and the
     // underlying memory must remain valid while read operations are running
     _read_buf.resize(max_received_line_len);
@@ -85,7 +93,7 @@ void RemoteConsole::StartConnecting(const std::string& host, int port) {
 
     // Clear the message queues. No synchronization needed here since I/O thread
     // is not running.
-    _read_msg_q.clear();
+    _read_line_q.Clear();
     _write_msg_q.clear();
 
     _connected = false;
@@ -137,13 +145,12 @@ void RemoteConsole::Disconnect() {
     // I/O thread might still be running for a while after returning here!
 }
 
-std::deque<std::string> RemoteConsole::ReadLines() {
-    std::deque<std::string> ret;
-    {
-        std::lock_guard<std::mutex> lock(_read_msg_q_mutex);
-        _read_msg_q.swap(ret);
-    }
-    return ret;
+std::span<const SpscLineQueue::Line> RemoteConsole::ReadLines() {
+    return _read_line_q.PopAll();
+}
+
+uint64_t RemoteConsole::GetNumDroppedReadLines() {
+    return _read_line_q.GetNumDroppedLines();
 }
 
 void RemoteConsole::WriteLine(const std::string& msg) {
@@ -282,6 +289,9 @@ void RemoteConsole::do_read() {
             return;
         }
 
+        // All lines of this read arrived at the same time
+        WallClock::time_point arrival_time = WallClock::now();
+
         // Extract new-line delimited lines if possible
         const char* new_chars_end = _read_buf.data() + _read_buf_pos + n;
         const char* cur_line_start = _read_buf.data();
@@ -315,12 +325,9 @@ void RemoteConsole::do_read() {
                 size_t line_len = p - cur_line_start;
                 if (line_len > 0 && *(p - 1) == '\r')
                     line_len--;
-                std::string line(cur_line_start, line_len);
-                // Add line to the queue in a thread-safe fashion
-                {
-                    std::lock_guard<std::mutex> lock(_read_msg_q_mutex);
-                    _read_msg_q.push_back(std::move(line));
-                }
+                // Copy line into the queue. If the user thread hasn't read
+                // lines for a long time and the queue is full, it's dropped.
+                _read_line_q.Push({ cur_line_start, line_len }, arrival_time);
             }
             else {
                 // We received a NL, now we can continue reading lines without
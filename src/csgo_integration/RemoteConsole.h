@@ -2,14 +2,18 @@
 #define CSGO_INTEGRATION_REMOTECONSOLE_H_
 
 #include <atomic>
+#include <cstdint>
 #include <deque>
 #include <mutex>
+#include <span>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include <asio/ip/tcp.hpp>
 
+#include "csgo_integration/SpscLineQueue.h"
+
 namespace csgo_integration {
 
 // An asynchronous tcp client that connects to the ingame console of a running
@@ -42,10 +46,21 @@ public:
     // Non-blocking. Starts the asynchronous disconnect process if possible.
     void Disconnect();
 
-    // Non-blocking. Dequeues and returns the newest received lines. Received
-    // lines can be preceded by random text from previous lines that were too
-    // long and had been cut off and discarded.
-    std::deque<std::string> ReadLines();
+    // Non-blocking. Dequeues and returns the newest received lines, without
+    // CR and NL chars. Received lines can be preceded by random text from
+    // previous lines that were too long and had been cut off and discarded.
+    // Each line carries the time at which the I/O thread received it.
+    // The returned lines remain valid until the next call to ReadLines() or
+    // StartConnecting(). Must always be called from the same thread.
+    std::span<const SpscLineQueue::Line> ReadLines();
+
+    // Non-blocking. If new lines were received since the last ReadLines() call.
+    // Must be called from the thread that calls ReadLines().
+    bool HasNewReadLines() const { return _read_line_q.HasNewLines(); }
+
+    // Number of received lines that were dropped since connecting because
+    // ReadLines() wasn't called frequently enough.
+    uint64_t GetNumDroppedReadLines();
 
     // Non-blocking. Writes the message and appends a new-line character.
     // Does nothing if IsConnected() returns false. If you will read your
@@ -103,10 +118,8 @@ private:
     // until we receive a NL. Then we reset this flag and receive normally again.
     bool _discard_current_read_line;
 
-    // Received messages, accessed by both the I/O thread and user thread
-    // -> mutex required
-    std::mutex _read_msg_q_mutex; // Protects _read_msg_q
-    std::deque<std::string> _read_msg_q;
+    // Received lines, pushed by the I/O thread and popped by the user thread
+    SpscLineQueue _read_line_q;
 
     // Messages to be written, only accessed by I/O thread -> no mutex required
     std::deque<std::string> _write_msg_q;
@@ -0,0 +1,334 @@
+#include "csgo_integration/SessionRecording.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <limits>
+#include <string_view>
+
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+using namespace Magnum;
+using namespace csgo_integration;
+
+static constexpr std::string_view LOG_MAGIC = "DZSREC01";
+
+enum RecordType : uint8_t {
+    SERVER_TICK = 1,
+    CLIENTSIDE  = 2,
+};
+
+// Buffered data is written at least this often, so little is lost on a crash
+static const auto MAX_FLUSH_INTERVAL = std::chrono::seconds(1);
+static const size_t MAX_BUFFERED_BYTES = 64 * 1024;
+
+// ----------------------------------------------------------------------------
+// Little-endian encoding
+
+template<class T>
+static void WriteInt(std::vector<char>& buf, T val) {
+    auto u = static_cast<std::make_unsigned_t<T>>(val);
+    for (size_t i = 0; i < sizeof(T); i++)
+        buf.push_back((char)(uint8_t)(u >> (8 * i)));
+}
+
+static void WriteVector3(std::vector<char>& buf, const Vector3& v) {
+    for (size_t i = 0; i < 3; i++)
+        WriteInt(buf, std::bit_cast<uint32_t>(v[i]));
+}
+
+// Reads from a byte range. Once reading fails, all following reads fail too.
+class ByteReader {
+public:
+    ByteReader(const char* begin, const char* end) : _pos{ begin }, _end{ end } {}
+
+    template<class T>
+    bool ReadInt(T* out) {
+        if (_end - _pos < (ptrdiff_t)sizeof(T)) {
+            _pos = _end;
+            return false;
+        }
+        std::make_unsigned_t<T> u = 0;
+        for (size_t i = 0; i < sizeof(T); i++)
+            u |= (std::make_unsigned_t<T>)(uint8_t)_pos[i] << (8 * i);
+        _pos += sizeof(T);
+        *out = static_cast<T>(u);
+        return true;
+    }
+
+    bool ReadVector3(Vector3* out) {
+        for (size_t i = 0; i < 3; i++) {
+            uint32_t bits;
+            if (!ReadInt(&bits)) return false;
+            (*out)[i] = std::bit_cast<float>(bits);
+        }
+        return true;
+    }
+
+    bool IsAtEnd() const { return _pos == _end; }
+
+private:
+    const char* _pos;
+    const char* _end;
+};
+
+// ----------------------------------------------------------------------------
+// SessionRecorder
+
+SessionRecorder::~SessionRecorder()
+{
+    Stop();
+}
+
+bool SessionRecorder::Start(const std::string& file_path)
+{
+    Stop();
+    _file.open(file_path, std::ios::binary | std::ios::trunc);
+    if (!_file) {
+        Debug{} << "[SessionRecorder] Failed to open" << file_path.c_str();
+        return false;
+    }
+    _buf.assign(LOG_MAGIC.begin(), LOG_MAGIC.end());
+    _start_time = WallClock::now();
+    _last_flush_time = _start_time;
+    Debug{} << "[SessionRecorder] Recording to" << file_path.c_str();
+    return true;
+}
+
+void SessionRecorder::Stop()
+{
+    if (!IsRecording())
+        return;
+    Flush();
+    _file.close();
+    Debug{} << "[SessionRecorder] Stopped recording";
+}
+
+void SessionRecorder::Record(const std::deque<Handler::CsgoServerTickData>& server_ticks)
+{
+    if (!IsRecording())
+        return;
+    for (const Handler::CsgoServerTickData& tick : server_ticks) {
+        BeginRecord(SERVER_TICK, tick.receive_time);
+        WriteInt(_buf, (uint64_t)tick.tick_id);
+        WriteInt(_buf, (uint8_t)tick.is_player_crouched);
+        WriteVector3(_buf, tick.player_pos_feet);
+        WriteVector3(_buf, tick.player_pos_eye);
+        WriteVector3(_buf, tick.player_vel);
+
+        size_t num_bump_mines = std::min(tick.bump_mines.size(),
+            (size_t)std::numeric_limits<uint16_t>::max());
+        WriteInt(_buf, (uint16_t)num_bump_mines);
+        for (const auto& [id, bm] : tick.bump_mines) {
+            if (num_bump_mines-- == 0)
+                break;
+            WriteInt(_buf, (int32_t)id);
+            WriteVector3(_buf, bm.pos);
+            WriteVector3(_buf, bm.angles);
+        }
+    }
+    FlushIfNeeded();
+}
+
+void SessionRecorder::Record(const std::deque<Handler::CsgoClientsideData>& client_data)
+{
+    if (!IsRecording())
+        return;
+    for (const Handler::CsgoClientsideData& data : client_data) {
+        BeginRecord(CLIENTSIDE, data.receive_time);
+        WriteVector3(_buf, data.player_pos_eye);
+        WriteVector3(_buf, data.player_angles);
+    }
+    FlushIfNeeded();
+}
+
+void SessionRecorder::BeginRecord(uint8_t type, WallClock::time_point receive_time)
+{
+    // Data received before the recording started is recorded at time 0
+    auto time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        receive_time - _start_time).count();
+    WriteInt(_buf, type);
+    WriteInt(_buf, (uint64_t)std::max(time_ns, (decltype(time_ns))0));
+}
+
+void SessionRecorder::FlushIfNeeded()
+{
+    WallClock::time_point now = WallClock::now();
+    if (_buf.size() >= MAX_BUFFERED_BYTES || now - _last_flush_time > MAX_FLUSH_INTERVAL) {
+        Flush();
+        _last_flush_time = now;
+    }
+}
+
+void SessionRecorder::Flush()
+{
+    _file.write(_buf.data(), _buf.size());
+    _file.flush();
+    _buf.clear();
+    if (!_file) {
+        Debug{} << "[SessionRecorder] Failed to write session log, stopping";
+        _file.close();
+    }
+}
+
+// ----------------------------------------------------------------------------
+// SessionReplayer
+
+bool SessionReplayer::Load(const std::string& file_path)
+{
+    _is_replaying = false;
+    _server_ticks.clear();
+    _client_data.clear();
+
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file) {
+        Debug{} << "[SessionReplayer] Failed to open" << file_path.c_str();
+        return false;
+    }
+    std::vector<char> content{ std::istreambuf_iterator<char>(file),
+                               std::istreambuf_iterator<char>() };
+    if (!std::string_view{ content.data(), content.size() }.starts_with(LOG_MAGIC)) {
+        Debug{} << "[SessionReplayer]" << file_path.c_str() << "is not a session log";
+        return false;
+    }
+
+    ByteReader reader{ content.data() + LOG_MAGIC.size(), content.data() + content.size() };
+    bool is_complete = true;
+    while (!reader.IsAtEnd()) {
+        uint8_t type;
+        uint64_t time_ns;
+        if (!reader.ReadInt(&type) || !reader.ReadInt(&time_ns)) {
+            is_complete = false;
+            break;
+        }
+        WallClock::time_point log_time{
+            std::chrono::duration_cast<WallClock::duration>(std::chrono::nanoseconds(time_ns)) };
+
+        if (type == SERVER_TICK) {
+            Handler::CsgoServerTickData tick;
+            uint64_t tick_id;
+            uint8_t is_crouched;
+            uint16_t num_bump_mines;
+            bool success =
+                reader.ReadInt(&tick_id) &&
+                reader.ReadInt(&is_crouched) &&
+                reader.ReadVector3(&tick.player_pos_feet) &&
+                reader.ReadVector3(&tick.player_pos_eye) &&
+                reader.ReadVector3(&tick.player_vel) &&
+                reader.ReadInt(&num_bump_mines);
+            for (size_t i = 0; success && i < num_bump_mines; i++) {
+                int32_t id;
+                Handler::CsgoServerTickData::BumpMineData bm;
+                success = reader.ReadInt(&id) &&
+                    reader.ReadVector3(&bm.pos) && reader.ReadVector3(&bm.angles);
+                if (!success)
+                    break;
+                tick.bump_mines[id] = bm;
+            }
+            if (!success) {
+                is_complete = false;
+                break;
+            }
+            tick.tick_id = tick_id;
+            tick.is_player_crouched = is_crouched != 0;
+            tick.receive_time = log_time;
+            _server_ticks.push_back(std::move(tick));
+        }
+        else if (type == CLIENTSIDE) {
+            Handler::CsgoClientsideData data;
+            if (!reader.ReadVector3(&data.player_pos_eye) ||
+                !reader.ReadVector3(&data.player_angles)) {
+                is_complete = false;
+                break;
+            }
+            data.receive_time = log_time;
+            _client_data.push_back(data);
+        }
+        else {
+            Debug{} << "[SessionReplayer] Unknown record type" << (int)type << ", ignoring the rest";
+            is_complete = false;
+            break;
+        }
+    }
+
+    Debug{} << "[SessionReplayer] Loaded" << _server_ticks.size() << "server ticks and"
+        << _client_data.size() << "client-side updates from" << file_path.c_str();
+    if (!is_complete)
+        Debug{} << "[SessionReplayer] Last record is incomplete and was ignored";
+    return true;
+}
+
+void SessionReplayer::Start(float speed)
+{
+    _is_replaying = true;
+    _speed = speed > 0.0f ? speed : 1.0f;
+    _start_time = WallClock::now();
+    _next_server_tick_idx = 0;
+    _next_client_data_idx = 0;
+}
+
+bool SessionReplayer::IsFinished() const
+{
+    return _next_server_tick_idx >= _server_ticks.size()
+        && _next_client_data_idx >= _client_data.size();
+}
+
+std::deque<Handler::CsgoServerTickData> SessionReplayer::DequeNewCsgoServerTicksData()
+{
+    std::deque<Handler::CsgoServerTickData> ret;
+    if (!_is_replaying)
+        return ret;
+    WallClock::duration replayed_log_time = GetReplayedLogTime();
+    while (_next_server_tick_idx < _server_ticks.size()) {
+        const auto& tick = _server_ticks[_next_server_tick_idx];
+        if (tick.receive_time.time_since_epoch() > replayed_log_time)
+            break;
+        ret.push_back(tick);
+        ret.back().receive_time = GetReplayTime(tick.receive_time.time_since_epoch());
+        _next_server_tick_idx++;
+    }
+    return ret;
+}
+
+std::deque<Handler::CsgoClientsideData> SessionReplayer::DequeNewCsgoClientsideData()
+{
+    std::deque<Handler::CsgoClientsideData> ret;
+    if (!_is_replaying)
+        return ret;
+    WallClock::duration replayed_log_time = GetReplayedLogTime();
+    while (_next_client_data_idx < _client_data.size()) {
+        const auto& data = _client_data[_next_client_data_idx];
+        if (data.receive_time.time_since_epoch() > replayed_log_time)
+            break;
+        ret.push_back(data);
+        ret.back().receive_time = GetReplayTime(data.receive_time.time_since_epoch());
+        _next_client_data_idx++;
+    }
+    return ret;
+}
+
+bool SessionReplayer::HasDueData() const
+{
+    if (!_is_replaying)
+        return false;
+    WallClock::duration replayed_log_time = GetReplayedLogTime();
+    if (_next_server_tick_idx < _server_ticks.size() &&
+        _server_ticks[_next_server_tick_idx].receive_time.time_since_epoch() <= replayed_log_time)
+        return true;
+    return _next_client_data_idx < _client_data.size() &&
+        _client_data[_next_client_data_idx].receive_time.time_since_epoch() <= replayed_log_time;
+}
+
+WallClock::time_point SessionReplayer::GetReplayTime(WallClock::duration log_time) const
+{
+    return _start_time +
+        std::chrono::duration_cast<WallClock::duration>(log_time / (double)_speed);
+}
+
+WallClock::duration SessionReplayer::GetReplayedLogTime() const
+{
+    return std::chrono::duration_cast<WallClock::duration>(
+        (WallClock::now() - _start_time) * (double)_speed);
+}
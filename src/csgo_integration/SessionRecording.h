@@ -0,0 +1,95 @@
+#ifndef CSGO_INTEGRATION_SESSIONRECORDING_H_
+#define CSGO_INTEGRATION_SESSIONRECORDING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "csgo_integration/Handler.h"
+
+// Recording and replaying of game data received from a CSGO session, so the
+// CSGO overlay can be run and profiled without a running game.
+//
+// Session log format: An 8 byte magic "DZSREC01", followed by records. Each
+// record starts with a 1 byte record type and the 8 byte time since the start
+// of the recording in nanoseconds, at which the data was received. Then:
+//   SERVER_TICK: 8 byte tick ID, 1 byte crouch state, 9 floats (feet pos, eye
+//                pos, velocity), 2 byte bump mine count, and for every bump
+//                mine: 4 byte ID and 6 floats (pos, angles)
+//   CLIENTSIDE:  6 floats (eye pos, angles)
+// Values are stored in little-endian byte order. The log is only ever appended
+// to. If the recording process crashed, a partially written last record is
+// ignored when reading the log.
+namespace csgo_integration {
+
+    class SessionRecorder {
+    public:
+        // Flushes remaining data to the log file
+        ~SessionRecorder();
+
+        // Creates or overwrites the session log at the given path and starts a
+        // new recording. Returns false if the file couldn't be opened.
+        bool Start(const std::string& file_path);
+        void Stop(); // Flushes remaining data to the log file
+        bool IsRecording() const { return _file.is_open(); }
+
+        // Append received data to the log. Does nothing if not recording.
+        void Record(const std::deque<Handler::CsgoServerTickData>& server_ticks);
+        void Record(const std::deque<Handler::CsgoClientsideData>& client_data);
+
+    private:
+        void BeginRecord(uint8_t type, WallClock::time_point receive_time);
+        void FlushIfNeeded();
+        void Flush();
+
+        std::ofstream _file;
+        std::vector<char> _buf; // Encoded records that weren't written yet
+        WallClock::time_point _start_time;
+        WallClock::time_point _last_flush_time;
+    };
+
+    class SessionReplayer {
+    public:
+        // Reads an entire session log. Returns false if the file couldn't be
+        // read or isn't a session log.
+        bool Load(const std::string& file_path);
+
+        // Starts replaying the loaded log from the beginning. Data is replayed
+        // speed times faster than it was recorded.
+        void Start(float speed = 1.0f);
+        bool IsReplaying() const { return _is_replaying; }
+        // If all loaded data has been replayed
+        bool IsFinished() const;
+
+        // Returns data that is due for replay. Its receive_time is set to the
+        // point in time when it is due, so receive-to-display latency can be
+        // measured as if it was received live.
+        std::deque<Handler::CsgoServerTickData> DequeNewCsgoServerTicksData();
+        std::deque<Handler::CsgoClientsideData> DequeNewCsgoClientsideData();
+        // If any data is due for replay
+        bool HasDueData() const;
+
+    private:
+        // Converts time since the recording started to replay time
+        WallClock::time_point GetReplayTime(WallClock::duration log_time) const;
+        // Time since the recording started that has been replayed so far
+        WallClock::duration GetReplayedLogTime() const;
+
+        // Loaded data, receive_time holds the time since the recording started
+        std::vector<Handler::CsgoServerTickData> _server_ticks;
+        std::vector<Handler::CsgoClientsideData> _client_data;
+        size_t _next_server_tick_idx = 0;
+        size_t _next_client_data_idx = 0;
+
+        bool _is_replaying = false;
+        float _speed = 1.0f;
+        WallClock::time_point _start_time;
+    };
+
+}
+
+#endif // CSGO_INTEGRATION_SESSIONRECORDING_H_
@@ -0,0 +1,94 @@
+#include "csgo_integration/SpscLineQueue.h"
+
+#include <cassert>
+#include <cstring>
+
+using namespace csgo_integration;
+
+SpscLineQueue::SpscLineQueue(size_t arena_size, size_t max_lines)
+    : _arena(arena_size)
+    , _slots(max_lines)
+{
+    assert(arena_size > 0 && max_lines > 0);
+    _popped_lines.reserve(max_lines); // Avoid allocations in PopAll()
+    Clear();
+}
+
+bool SpscLineQueue::Push(std::string_view text,
+                         WallClock::time_point arrival_time)
+{
+    const size_t arena_size = _arena.size();
+    if (text.size() > arena_size) {
+        _num_dropped_lines++;
+        return false;
+    }
+
+    size_t slot_pos = _slot_head.load(std::memory_order_relaxed);
+    if (slot_pos - _slot_tail.load(std::memory_order_acquire) == _slots.size()) {
+        _num_dropped_lines++; // No free slot
+        return false;
+    }
+
+    // Lines are stored contiguously. If the line doesn't fit in before the
+    // arena's end, skip the remaining bytes and start at the arena's beginning.
+    size_t byte_pos = _byte_head;
+    size_t arena_idx = byte_pos % arena_size;
+    if (arena_idx + text.size() > arena_size) {
+        byte_pos += arena_size - arena_idx;
+        arena_idx = 0;
+    }
+    size_t byte_end = byte_pos + text.size();
+    if (byte_end - _byte_tail.load(std::memory_order_acquire) > arena_size) {
+        _num_dropped_lines++; // Not enough free bytes
+        return false;
+    }
+
+    std::memcpy(_arena.data() + arena_idx, text.data(), text.size());
+    _slots[slot_pos % _slots.size()] = {
+        .byte_pos = byte_pos,
+        .len = (uint32_t)text.size(),
+        .arrival_time = arrival_time
+    };
+    _byte_head = byte_end;
+
+    // Publish the line. Release order makes the written arena bytes and slot
+    // visible to the consumer before the new head is.
+    _slot_head.store(slot_pos + 1, std::memory_order_release);
+    return true;
+}
+
+std::span<const SpscLineQueue::Line> SpscLineQueue::PopAll()
+{
+    // Hand the previously returned lines back to the producer
+    if (!_popped_lines.empty()) {
+        _popped_lines.clear();
+        _byte_tail.store(_popped_byte_end, std::memory_order_release);
+        _slot_tail.store(_popped_slot_end, std::memory_order_release);
+    }
+
+    size_t slot_pos = _slot_tail.load(std::memory_order_relaxed);
+    size_t slot_end = _slot_head.load(std::memory_order_acquire);
+    for (; slot_pos < slot_end; ++slot_pos) {
+        const Slot& slot = _slots[slot_pos % _slots.size()];
+        const char* text = _arena.data() + slot.byte_pos % _arena.size();
+        _popped_lines.push_back({
+            .text = std::string_view(text, slot.len),
+            .arrival_time = slot.arrival_time
+        });
+        _popped_byte_end = slot.byte_pos + slot.len;
+    }
+    _popped_slot_end = slot_end;
+    return _popped_lines;
+}
+
+void SpscLineQueue::Clear()
+{
+    _slot_head = 0;
+    _byte_head = 0;
+    _num_dropped_lines = 0;
+    _slot_tail = 0;
+    _byte_tail = 0;
+    _popped_lines.clear();
+    _popped_slot_end = 0;
+    _popped_byte_end = 0;
+}
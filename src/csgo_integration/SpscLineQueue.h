@@ -0,0 +1,86 @@
+#ifndef CSGO_INTEGRATION_SPSCLINEQUEUE_H_
+#define CSGO_INTEGRATION_SPSCLINEQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "common.h"
+
+namespace csgo_integration {
+
+// Lock-free queue of text lines between exactly one producer thread and exactly
+// one consumer thread. Line contents are copied into a fixed-size byte arena
+// that is used as a ring buffer, so neither pushing nor popping allocates
+// memory. Lines that don't fit into the queue anymore are dropped.
+class SpscLineQueue {
+public:
+    struct Line {
+        std::string_view text; // Points into the queue's arena
+        WallClock::time_point arrival_time;
+    };
+
+    // arena_size: Total number of line bytes the queue can hold
+    // max_lines:  Total number of lines the queue can hold
+    SpscLineQueue(size_t arena_size, size_t max_lines);
+
+    SpscLineQueue(const SpscLineQueue& other) = delete;
+    SpscLineQueue& operator=(const SpscLineQueue& other) = delete;
+
+    // Producer thread only. Copies the line into the queue. Returns false if
+    // the queue is full, the line is dropped then.
+    bool Push(std::string_view text, WallClock::time_point arrival_time);
+
+    // Consumer thread only. Releases the lines that were returned by the
+    // previous call, then returns all lines that were pushed since, in order.
+    // The returned lines remain valid until the next call to PopAll() or
+    // Clear().
+    std::span<const Line> PopAll();
+
+    // Consumer thread only. If lines were pushed since the last PopAll() call.
+    bool HasNewLines() const {
+        return _slot_head.load(std::memory_order_acquire) != _popped_slot_end;
+    }
+
+    // Discards all lines. Must only be called while neither the producer nor
+    // the consumer thread accesses the queue.
+    void Clear();
+
+    // Number of lines that were dropped because the queue was full. Callable
+    // from any thread.
+    uint64_t GetNumDroppedLines() const { return _num_dropped_lines; }
+
+private:
+    struct Slot {
+        size_t byte_pos; // Position of the line in the arena, see _byte_head
+        uint32_t len;
+        WallClock::time_point arrival_time;
+    };
+
+    std::vector<char> _arena;
+    std::vector<Slot> _slots;
+
+    // Positions in _slots and _arena are counted continuously, they never wrap
+    // around. The actual index is the position modulo the container size.
+
+    // Written by the producer only
+    alignas(64) std::atomic<size_t> _slot_head; // Next slot to be pushed
+    size_t _byte_head; // Arena position of the next pushed line
+    std::atomic<uint64_t> _num_dropped_lines;
+
+    // Written by the consumer only
+    alignas(64) std::atomic<size_t> _slot_tail; // First slot not yet released
+    std::atomic<size_t> _byte_tail; // First arena byte not yet released
+
+    // Consumer-owned lines that were returned by the last PopAll() call
+    std::vector<Line> _popped_lines;
+    size_t _popped_slot_end;
+    size_t _popped_byte_end;
+};
+
+} // namespace csgo_integration
+
+#endif // CSGO_INTEGRATION_SPSCLINEQUEUE_H_
@@ -111,6 +111,13 @@ bool AssetFileReader::IsOpenedInFile()
     return _impl->file;
 }
 
+size_t AssetFileReader::GetSize()
+{
+    if (!_impl->file)
+        return 0;
+    return _impl->file.GetSize();
+}
+
 size_t AssetFileReader::GetPos()
 {
     return _impl->pos;
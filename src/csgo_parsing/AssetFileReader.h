@@ -42,6 +42,9 @@ namespace csgo_parsing {
         // operation was successful.
         bool IsOpenedInFile();
 
+        // Size of the currently opened file in bytes, 0 if none is opened
+        size_t GetSize();
+
         // Get and set read position relative to beginning of file
         size_t GetPos();
         bool SetPos(size_t pos); // aka seek operation
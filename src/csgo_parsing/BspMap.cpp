@@ -4,7 +4,6 @@
 #include <cmath>
 #include <algorithm>
 #include <vector>
-#include <set>
 #include <iterator>
 #include <functional>
 
@@ -159,9 +158,14 @@ std::vector<Vector3> BspMap::GetDisplacementVertices(size_t disp_info_idx) const
     return verts;
 }
 
-std::vector<std::vector<Vector3>> BspMap::GetDisplacementFaceVertices() const
+void BspMap::GetDisplacementFaceVertices(utils_3d::FaceBuffer* dest) const
 {
-    std::vector<std::vector<Vector3>> finalFaces; // will be returned in the end
+    // Count triangles beforehand to allocate only once
+    size_t num_tris = 0;
+    for (const BspMap::DispInfo& dispinfo : this->dispinfos)
+        if (!dispinfo.HasFlag_NO_HULL_COLL())
+            num_tris += (size_t)2 << (2 * dispinfo.power);
+    dest->Reserve(dest->NumFaces() + num_tris, dest->vertices.size() + 3 * num_tris);
 
     for (size_t i = 0; i < this->dispinfos.size(); ++i) {
         const BspMap::DispInfo& dispinfo = this->dispinfos[i];
@@ -182,32 +186,32 @@ std::vector<std::vector<Vector3>> BspMap::GetDisplacementFaceVertices() const
                 Vector3 vertTopRight = verts[(tileY    ) * num_row_verts + (tileX    )];
 
                 // Switch up triangle seperating diagonal each tile
-                std::vector<Vector3> triangle1, triangle2;
                 if ((tileX + tileY) % 2 == 0) {
-                    triangle1 = { vertTopLeft, vertTopRight, vertBotLeft  };
-                    triangle2 = { vertBotLeft, vertTopRight, vertBotRight };
+                    dest->AddFace({ vertTopLeft, vertTopRight, vertBotLeft  });
+                    dest->AddFace({ vertBotLeft, vertTopRight, vertBotRight });
                 } else {
-                    triangle1 = { vertTopLeft, vertBotRight, vertBotLeft  };
-                    triangle2 = { vertTopLeft, vertTopRight, vertBotRight };
+                    dest->AddFace({ vertTopLeft, vertBotRight, vertBotLeft  });
+                    dest->AddFace({ vertTopLeft, vertTopRight, vertBotRight });
                 }
-                finalFaces.push_back(std::move(triangle1));
-                finalFaces.push_back(std::move(triangle2));
             }
         }
     }
-    
-    return finalFaces;
 }
 
 // @OPTIMIZATION: Merge boundary faces that can be merged (e.g. in displacement walls)
-std::vector<std::vector<Vector3>> BspMap::GetDisplacementBoundaryFaceVertices() const
+void BspMap::GetDisplacementBoundaryFaceVertices(utils_3d::FaceBuffer* dest) const
 {
     // By how much the boundary faces are placed above the displacement faces
     const float BOUNDARY_HOVER_DIST = 2.0f;
     // Ratio of boundary width to displacement tile width
     const float BOUNDARY_THICKNESS = 0.1f; // between 0.0 and 1.0
 
-    std::vector<std::vector<Vector3>> total_faces; // will be returned in the end
+    // Count triangles beforehand to allocate only once
+    size_t num_tris = 0;
+    for (const BspMap::DispInfo& dispinfo : this->dispinfos)
+        if (!dispinfo.HasFlag_NO_HULL_COLL())
+            num_tris += 4 * 2 * ((size_t)1 << dispinfo.power);
+    dest->Reserve(dest->NumFaces() + num_tris, dest->vertices.size() + 3 * num_tris);
 
     for (size_t disp_idx = 0; disp_idx < this->dispinfos.size(); disp_idx++) {
         const BspMap::DispInfo& dispinfo = this->dispinfos[disp_idx];
@@ -339,23 +343,22 @@ std::vector<std::vector<Vector3>> BspMap::GetDisplacementBoundaryFaceVertices()
 
             // Make boundary mesh vertices into triangles
             for (size_t tile = 0; tile < num_row_verts - 1; tile++) {
-                total_faces.push_back({
+                dest->AddFace({
                     boundary_mesh_vertices[1][tile],
                     boundary_mesh_vertices[1][tile + 1],
                     boundary_mesh_vertices[0][tile + 1] });
-                total_faces.push_back({
+                dest->AddFace({
                     boundary_mesh_vertices[0][tile + 1],
                     boundary_mesh_vertices[0][tile],
                     boundary_mesh_vertices[1][tile] });
             }
         }
     }
-
-    return total_faces;
 }
 
 // Returns faces with clockwise vertex winding
-std::vector<std::vector<Vector3>> BspMap::GetBrushFaceVertices(const std::set<size_t>& brush_indices,
+void BspMap::GetBrushFaceVertices(utils_3d::FaceBuffer* dest,
+    const std::vector<uint32_t>& brush_indices,
     bool (*pred_Brush)(const Brush&),
     bool (*pred_BrushSide)(const BrushSide&, const BspMap&)) const
 {
@@ -375,8 +378,6 @@ std::vector<std::vector<Vector3>> BspMap::GetBrushFaceVertices(const std::set<si
     //  - Delete redundant vertices that are on the line from the last to to the next vertex
     //  - Remove redundant faces inside other faces?
 
-    std::vector<std::vector<Vector3>> finalFaces; // This vector will be returned
-
     // When checking what vertices fall behind a plane, vertices on the plane are
     // treated pretty much randomly (float inaccuracy). Therefore cut a fraction
     // more behind the plane and then connect edges back up exactly with the plane.
@@ -616,12 +617,11 @@ std::vector<std::vector<Vector3>> BspMap::GetBrushFaceVertices(const std::set<si
         // Clear brush faces that did not fit the predicate
         for (size_t i : unwantedBrushFaceIndices)
             brushFaces[i].clear();
-        // Append non-empty faces of this brush to finalFaces
+        // Append non-empty faces of this brush
         for (std::vector<Vector3>& face : brushFaces)
             if(!face.empty())
-                finalFaces.push_back(std::move(face));
+                dest->AddFace(face);
     }
-    return finalFaces;
 }
 
 bool BspMap::GetBrushAABB(size_t brush_idx,
@@ -672,19 +672,19 @@ bool BspMap::GetBrushAABB(size_t brush_idx,
 
 // The first model in the models array is "worldspawn", containing the geometry of the whole map
 // excluding entities (but including func_detail brushes)
-std::set<size_t> BspMap::GetModelBrushIndices_worldspawn() const
+std::vector<uint32_t> BspMap::GetModelBrushIndices_worldspawn() const
 {
     return GetModelBrushIndices(0);
 }
 
-std::set<size_t> BspMap::GetModelBrushIndices(uint32_t model_idx) const
+std::vector<uint32_t> BspMap::GetModelBrushIndices(uint32_t model_idx) const
 {
     const Model& m = this->models[model_idx];
     //std::vector<std::vector<Vector3>> totalFaces;
 
     std::vector<int32_t> pendingNodesAndLeafs = { m.head_node };
 
-    std::set<size_t> brush_indices; // indices of all brushes that we find
+    std::vector<uint32_t> brush_indices; // indices of all brushes that we find
 
     while (!pendingNodesAndLeafs.empty()) {
         int32_t nextEntry = pendingNodesAndLeafs.back();
@@ -708,12 +708,15 @@ std::set<size_t> BspMap::GetModelBrushIndices(uint32_t model_idx) const
             }*/
             // Go through leafbrushes of this leaf
             for (size_t lbrush = leaf.first_leaf_brush; lbrush < (size_t)leaf.first_leaf_brush + leaf.num_leaf_brushes; ++lbrush) {
-                size_t brush_idx = this->leafbrushes[lbrush];
-                brush_indices.insert(brush_idx); // std::set -> only inserts if it doesn't already contain the element
+                brush_indices.push_back(this->leafbrushes[lbrush]);
             }
         }
     }
-    
+
+    // Brushes can be in multiple leafs, remove duplicates
+    std::sort(brush_indices.begin(), brush_indices.end());
+    brush_indices.erase(std::unique(brush_indices.begin(), brush_indices.end()),
+                        brush_indices.end());
     return brush_indices;
 }
 
@@ -2,7 +2,7 @@
 #define CSGO_PARSING_BSPMAP_H_
 
 #include <cfloat>
-#include <set>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -10,6 +10,8 @@
 #include <Magnum/Magnum.h>
 #include <Magnum/Math/Vector3.h>
 
+#include "utils_3d.h"
+
 namespace csgo_parsing {
 
 class BspMap {
@@ -379,12 +381,13 @@ public:
     // the BSP map file's DISP_VERTS lump
     std::vector<Magnum::Vector3> GetDisplacementVertices(size_t disp_info_idx) const;
 
-    std::vector<std::vector<Magnum::Vector3>> GetDisplacementFaceVertices() const;
-    std::vector<std::vector<Magnum::Vector3>> GetDisplacementBoundaryFaceVertices() const;
-
-    // A returned face (std::vector<Magnum::Vector3>) is never empty
-    std::vector<std::vector<Magnum::Vector3>> GetBrushFaceVertices(
-        const std::set<size_t>& brush_indices, // list of all brush indices that we want to look at
+    // The following functions append faces with clockwise vertex winding to
+    // the given face buffer, allowing callers to reuse and preallocate it.
+    void GetDisplacementFaceVertices(utils_3d::FaceBuffer* dest) const;
+    void GetDisplacementBoundaryFaceVertices(utils_3d::FaceBuffer* dest) const;
+    void GetBrushFaceVertices(
+        utils_3d::FaceBuffer* dest,
+        const std::vector<uint32_t>& brush_indices, // list of all brush indices that we want to look at
         bool (*pred_Brush)(const Brush&) = nullptr, // brush selection function
         bool (*pred_BrushSide)(const BrushSide&, const BspMap&) = nullptr) // brushside selection function
         const;
@@ -394,8 +397,9 @@ public:
     bool GetBrushAABB(size_t brush_idx,
         Magnum::Vector3* aabb_mins, Magnum::Vector3* aabb_maxs) const;
 
-    std::set<size_t> GetModelBrushIndices_worldspawn() const; // worldspawn is model idx 0
-    std::set<size_t> GetModelBrushIndices(uint32_t model_index) const;
+    // Return sorted, duplicate-free brush indices
+    std::vector<uint32_t> GetModelBrushIndices_worldspawn() const; // worldspawn is model idx 0
+    std::vector<uint32_t> GetModelBrushIndices(uint32_t model_index) const;
 
 };
 
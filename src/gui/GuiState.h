@@ -170,6 +170,37 @@ public:
         bool OUT_has_connect_failed = false;
         bool OUT_is_disconnecting = false;
         std::string OUT_fail_msg = "";
+        // Average time from receiving CSGO's client-side data until drawing it
+        float OUT_receive_to_display_latency_ms = 0.0f;
+        // Received console lines that were dropped because they weren't read
+        // quickly enough
+        uint64_t OUT_num_dropped_lines = 0;
+
+        // Frame pacing while DZSimulator's window is unfocused, see
+        // csgo_integration::FramePacer
+        bool IN_clear_frame_pacing_stats = false;
+        float OUT_predicted_update_interval_ms = 0.0f; // 0 if unknown
+        // Receive-to-display latency histogram, buckets range from 0 to max
+        std::vector<float> OUT_latency_hist;
+        float OUT_latency_hist_max_ms = 0.0f;
+        float OUT_latency_p50_ms = 0.0f;
+        float OUT_latency_p99_ms = 0.0f;
+        // Main thread CPU usage histogram, buckets range from 0 to 100 %
+        float OUT_cpu_usage_percent = 0.0f; // Most recent measurement
+        std::vector<float> OUT_cpu_usage_hist;
+        float OUT_cpu_usage_p50_percent = 0.0f;
+
+        // Extrapolation of the player's server-side position to the present,
+        // see csgo_integration::PlayerExtrapolator
+        bool  IN_extrapolate_player = true;
+        float IN_extrapolation_lead_ms = 0.0f; // Added to the present
+        // Mean distance between predicted and actual position of server ticks
+        float OUT_extrapolation_error = 0.0f;
+        float OUT_extrapolation_error_without = 0.0f; // If not extrapolating
+        float OUT_extrapolation_error_p99 = 0.0f;
+        // Error histogram, buckets range from 0 to max
+        std::vector<float> OUT_extrapolation_error_hist;
+        float OUT_extrapolation_error_hist_max = 0.0f;
     } rcon;
 
     struct GameStateIntegration {
@@ -187,6 +218,44 @@ public:
 
         // Last frame's game simulation calc time (Changes every frame)
         float OUT_last_sim_calc_time_us = 0.0f;
+
+        // Displacement collision caches
+        enum DispCacheMode {
+            DISP_CACHE_LAZY,        // Create when needed
+            DISP_CACHE_PREBUILD,    // Create all on map load
+            DISP_CACHE_LAZY_BUDGET  // Create when needed, limit memory usage
+        } IN_disp_cache_mode = DISP_CACHE_LAZY;
+        int IN_disp_cache_budget_kib = 4096; // Only used in DISP_CACHE_LAZY_BUDGET mode
+        uint64_t OUT_disp_cache_builds_last_tick = 0;
+        uint64_t OUT_disp_cache_builds_total     = 0;
+        uint64_t OUT_disp_cache_evictions_total  = 0;
+        size_t   OUT_disp_cache_num_cached       = 0;
+        size_t   OUT_disp_cache_bytes            = 0;
+
+        // Bevel planes of static/dynamic props
+        enum XPropBevelPlaneMode {
+            XPROP_BEVELS_ON_DEMAND,       // Generate on every trace
+            XPROP_BEVELS_NEAR_SPAWNS,     // Precompute near player spawns
+            XPROP_BEVELS_PRECOMPUTE_ALL   // Precompute for all props
+        } IN_xprop_bevel_mode = XPROP_BEVELS_ON_DEMAND;
+        size_t OUT_xprop_bevel_bytes = 0;
+
+        // Collision models of props, shared between loaded maps. Settings take
+        // effect on the next map load.
+        int  IN_coll_model_cache_budget_mib = 64; // Of unused collision models
+        bool IN_coll_model_disk_cache = false; // Not available in the web port
+        size_t   OUT_coll_model_cache_num_models   = 0;
+        size_t   OUT_coll_model_cache_num_unused   = 0;
+        size_t   OUT_coll_model_cache_bytes        = 0;
+        size_t   OUT_coll_model_cache_unused_bytes = 0;
+        uint64_t OUT_coll_model_cache_memory_hits  = 0;
+        uint64_t OUT_coll_model_cache_disk_hits    = 0;
+        uint64_t OUT_coll_model_cache_misses       = 0;
+
+        // Vertex format of world meshes, takes effect on the next map load
+        bool IN_compact_world_vertices = false;
+        size_t OUT_world_vertex_bytes       = 0; // Of the loaded map
+        size_t OUT_world_float_vertex_bytes = 0; // Same, but with float vertices
     } perf;
 
     struct MovementDebugging { // Only available in Debug builds
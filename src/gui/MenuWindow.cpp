@@ -1,5 +1,6 @@
 #include "gui/MenuWindow.h"
 
+#include <cfloat>
 #include <cstdio>
 
 #ifndef DZSIM_WEB_PORT
@@ -13,6 +14,7 @@
 
 #include "build_info.h"
 #include "coll/Debugger.h"
+#include "coll/TraceProfiler.h"
 #include "GlobalVars.h"
 #include "gui/Gui.h"
 #include "gui/GuiState.h"
@@ -157,6 +159,11 @@ void MenuWindow::Draw()
         }
     }
 
+    if (ImGui::CollapsingHeader("Trace Profiler"))
+    {
+        DrawTraceProfiler();
+    }
+
 #ifndef NDEBUG
     if (ImGui::CollapsingHeader("Collision Debugging (Debug only)"))
     {
@@ -758,6 +765,76 @@ void MenuWindow::DrawVisualizations()
         if (_gui_state.rcon.OUT_fail_msg.length() > 0)
             ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f),
                                "%s", _gui_state.rcon.OUT_fail_msg.c_str());
+        if (_gui_state.rcon.OUT_is_connected) {
+            ImGui::Text("Receive-to-display latency: %.2f ms",
+                        _gui_state.rcon.OUT_receive_to_display_latency_ms);
+            ImGui::SameLine(); _gui.HelpMarker(
+                "Time from DZSimulator receiving CS:GO's position and view\n"
+                "angles until a frame showing them is presented.");
+            if (_gui_state.rcon.OUT_num_dropped_lines > 0)
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f),
+                    "Dropped console lines: %llu",
+                    (unsigned long long)_gui_state.rcon.OUT_num_dropped_lines);
+
+            auto& rcon = _gui_state.rcon;
+            bool show_frame_pacing = ImGui::TreeNode("Frame pacing");
+            ImGui::SameLine(); _gui.HelpMarker(
+                ">>>> While DZSimulator's window is not focused, it waits\n"
+                "until CS:GO's next data update is expected to arrive and\n"
+                "draws a new frame right after it did.");
+            if (show_frame_pacing) {
+                if (rcon.OUT_predicted_update_interval_ms > 0.0f)
+                    ImGui::Text("Predicted update interval: %.2f ms",
+                                rcon.OUT_predicted_update_interval_ms);
+                else
+                    ImGui::Text("Predicted update interval: unknown");
+
+                ImGui::Text("Receive-to-display latency: median %.1f ms, p99 %.1f ms",
+                            rcon.OUT_latency_p50_ms, rcon.OUT_latency_p99_ms);
+                ImGui::PlotHistogram("##latency_hist",
+                    rcon.OUT_latency_hist.data(), (int)rcon.OUT_latency_hist.size(),
+                    0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+                ImGui::SameLine(); ImGui::Text("0 to %.0f ms", rcon.OUT_latency_hist_max_ms);
+
+                ImGui::Text("Main thread CPU usage: %.1f %%, median %.0f %%",
+                            rcon.OUT_cpu_usage_percent, rcon.OUT_cpu_usage_p50_percent);
+                ImGui::PlotHistogram("##cpu_usage_hist",
+                    rcon.OUT_cpu_usage_hist.data(), (int)rcon.OUT_cpu_usage_hist.size(),
+                    0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+                ImGui::SameLine(); ImGui::Text("0 to 100 %%");
+
+                if (ImGui::Button("Clear frame pacing stats"))
+                    rcon.IN_clear_frame_pacing_stats = true;
+                ImGui::TreePop();
+            }
+
+            bool show_extrapolation = ImGui::TreeNode("Player extrapolation");
+            ImGui::SameLine(); _gui.HelpMarker(
+                ">>>> CS:GO's server-side player position arrives with a delay.\n"
+                "DZSimulator can simulate the player's movement from the\n"
+                "latest received position up to the present, guessing which\n"
+                "movement keys are held.");
+            if (show_extrapolation) {
+                ImGui::Checkbox("Extrapolate player position", &rcon.IN_extrapolate_player);
+                ImGui::SliderFloat("Lead (ms)", &rcon.IN_extrapolation_lead_ms,
+                                   0.0f, 100.0f, "%.0f");
+                ImGui::SameLine(); _gui.HelpMarker(
+                    ">>>> Extrapolate this much further into the future, e.g.\n"
+                    "to make up for a slow connection to CS:GO.");
+
+                ImGui::Text("Mean prediction error: %.2f units (p99 %.2f)",
+                            rcon.OUT_extrapolation_error, rcon.OUT_extrapolation_error_p99);
+                ImGui::Text("Mean error without extrapolation: %.2f units",
+                            rcon.OUT_extrapolation_error_without);
+                ImGui::PlotHistogram("##extrapolation_error_hist",
+                    rcon.OUT_extrapolation_error_hist.data(),
+                    (int)rcon.OUT_extrapolation_error_hist.size(),
+                    0, nullptr, 0.0f, FLT_MAX, ImVec2(0.0f, 60.0f));
+                ImGui::SameLine(); ImGui::Text("0 to %.0f units",
+                                               rcon.OUT_extrapolation_error_hist_max);
+                ImGui::TreePop();
+            }
+        }
 
         ImGui::Text("");
 
@@ -910,6 +987,80 @@ void MenuWindow::DrawPerformanceStats()
     ImGui::Text("Game sim calculation time:  %.1f us",
                 _gui_state.perf.OUT_last_sim_calc_time_us);
 
+    ImGui::Separator();
+
+    auto& perf = _gui_state.perf;
+    ImGui::Text("Displacement collision caches:");
+    ImGui::RadioButton("Create when needed", (int*)&perf.IN_disp_cache_mode,
+                       perf.DISP_CACHE_LAZY);
+    ImGui::RadioButton("Create all on map load", (int*)&perf.IN_disp_cache_mode,
+                       perf.DISP_CACHE_PREBUILD);
+    ImGui::RadioButton("Create when needed, limit memory",
+                       (int*)&perf.IN_disp_cache_mode,
+                       perf.DISP_CACHE_LAZY_BUDGET);
+    if (perf.IN_disp_cache_mode == perf.DISP_CACHE_LAZY_BUDGET)
+        ImGui::SliderInt("Memory limit (KiB)", &perf.IN_disp_cache_budget_kib,
+                         64, 65536, "%d", ImGuiSliderFlags_Logarithmic);
+
+    ImGui::Text("Cached displacements: %zu (%.1f KiB)",
+                perf.OUT_disp_cache_num_cached,
+                perf.OUT_disp_cache_bytes / 1024.0f);
+    ImGui::Text("Caches created: %llu last tick, %llu total",
+                (unsigned long long)perf.OUT_disp_cache_builds_last_tick,
+                (unsigned long long)perf.OUT_disp_cache_builds_total);
+    ImGui::Text("Caches destroyed: %llu total",
+                (unsigned long long)perf.OUT_disp_cache_evictions_total);
+
+    ImGui::Separator();
+
+    ImGui::Text("Prop bevel planes:");
+    ImGui::RadioButton("Generate on every trace", (int*)&perf.IN_xprop_bevel_mode,
+                       perf.XPROP_BEVELS_ON_DEMAND);
+    ImGui::RadioButton("Precompute near spawns", (int*)&perf.IN_xprop_bevel_mode,
+                       perf.XPROP_BEVELS_NEAR_SPAWNS);
+    ImGui::RadioButton("Precompute all", (int*)&perf.IN_xprop_bevel_mode,
+                       perf.XPROP_BEVELS_PRECOMPUTE_ALL);
+    ImGui::Text("Precomputed bevel planes: %.1f KiB",
+                perf.OUT_xprop_bevel_bytes / 1024.0f);
+
+    ImGui::Separator();
+
+    ImGui::Text("Prop collision models:");
+    ImGui::SliderInt("Keep unused (MiB)", &perf.IN_coll_model_cache_budget_mib,
+                     0, 1024, "%d", ImGuiSliderFlags_Logarithmic);
+    ImGui::SameLine(); _gui.HelpMarker(
+        ">>>> Collision models of props are shared between maps. After\n"
+        "loading another map, collision models that only the previous map\n"
+        "used are kept in memory up to this size, so loading that map again\n"
+        "is faster. Takes effect when the next map is loaded.");
+#ifndef DZSIM_WEB_PORT
+    ImGui::Checkbox("Save collision models to disk",
+                    &perf.IN_coll_model_disk_cache);
+    ImGui::SameLine(); _gui.HelpMarker(
+        ">>>> Saves collision models of props in DZSimulator's config\n"
+        "directory, to load maps faster after restarting DZSimulator.\n"
+        "Takes effect when the next map is loaded.");
+#endif
+    ImGui::Text("Cached: %zu (%.1f KiB), unused: %zu (%.1f KiB)",
+                perf.OUT_coll_model_cache_num_models,
+                perf.OUT_coll_model_cache_bytes / 1024.0f,
+                perf.OUT_coll_model_cache_num_unused,
+                perf.OUT_coll_model_cache_unused_bytes / 1024.0f);
+    ImGui::Text("Reused: %llu from memory, %llu from disk. Parsed: %llu",
+                (unsigned long long)perf.OUT_coll_model_cache_memory_hits,
+                (unsigned long long)perf.OUT_coll_model_cache_disk_hits,
+                (unsigned long long)perf.OUT_coll_model_cache_misses);
+
+    ImGui::Separator();
+
+    ImGui::Checkbox("Compact world vertices", &perf.IN_compact_world_vertices);
+    ImGui::SameLine(); _gui.HelpMarker(
+        ">>>> Stores map geometry with half the GPU memory, which might\n"
+        "increase FPS. Positions are slightly less precise.\n"
+        "Takes effect when the next map is loaded.");
+    ImGui::Text("World vertex data: %.1f KiB (uncompressed: %.1f KiB)",
+                perf.OUT_world_vertex_bytes / 1024.0f,
+                perf.OUT_world_float_vertex_bytes / 1024.0f);
 }
 
 void MenuWindow::DrawVideoSettings()
@@ -1232,6 +1383,11 @@ void MenuWindow::DrawCollisionDebugging()
 #endif
 }
 
+void MenuWindow::DrawTraceProfiler()
+{
+    coll::TraceProfiler::DrawImGuiElements();
+}
+
 void MenuWindow::DrawTestSettings()
 {
 #ifndef NDEBUG
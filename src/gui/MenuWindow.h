@@ -37,6 +37,8 @@ namespace gui {
 
         void DrawMovementDebugging();
 
+        void DrawTraceProfiler();
+
         void DrawCollisionDebugging();
 
         void DrawTestSettings();
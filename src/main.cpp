@@ -1,6 +1,8 @@
 #include <Tracy.hpp>
 
+#include <Corrade/Containers/Optional.h>
 #include <Corrade/Containers/Pair.h>
+#include <Corrade/Containers/String.h>
 #include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Path.h>
 #include <Corrade/Utility/Resource.h>
@@ -28,14 +30,21 @@
 #include "build_info.h"
 #include "coll/Benchmark.h"
 #include "coll/CollidableWorld.h"
+#include "coll/CollisionModelCache.h"
 #include "coll/Trace.h"
+#include "coll/TraceProfiler.h"
 #include "common.h"
+#include "csgo_integration/Benchmark.h"
+#include "csgo_integration/FramePacer.h"
+#include "csgo_integration/PlayerExtrapolator.h"
 #include "csgo_integration/Handler.h"
 #include "csgo_integration/RemoteConsole.h"
+#include "csgo_integration/SessionRecording.h"
 #include "csgo_parsing/AssetFinder.h"
 #include "csgo_parsing/BspMapParsing.h"
 #include "coll/Debugger.h" // The build might break if this header is included in some other line. No idea what's wrong.
 #include "GitHubChecker.h"
+#include "GlidabilityReport.h"
 #include "GlobalVars.h"
 #include "gui/Gui.h"
 #include "InputHandler.h"
@@ -102,6 +111,21 @@ class DZSimApplication: public Platform::Application {
         csgo_integration::Handler _csgo_handler;
         csgo_integration::Handler::CsgoServerTickData _latest_csgo_server_data;
         csgo_integration::Handler::CsgoClientsideData _latest_csgo_client_data;
+        // Predicts the server-side player state of the present from received
+        // server ticks
+        csgo_integration::PlayerExtrapolator _csgo_player_extrapolator;
+        // Receive time of the latest client-side data that was drawn on screen
+        WallClock::time_point _last_drawn_csgo_client_data_time;
+        // Optional recording of received CSGO data, or replay of such a
+        // recording instead of receiving data from CSGO
+        csgo_integration::SessionRecorder _csgo_session_recorder;
+        csgo_integration::SessionReplayer _csgo_session_replayer;
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED
+        csgo_integration::IntegrationLoadTest _integration_load_test;
+#endif
+        // Decides when the main loop continues in sparing low latency draw mode
+        csgo_integration::FramePacer _frame_pacer;
+        bool _is_frame_pacing_enabled = false;
 
         GitHubChecker _update_checker;
 
@@ -159,6 +183,13 @@ class DZSimApplication: public Platform::Application {
         // For debugging purposes. Loads every map found in CSGO's maps folder.
         void _debug_LoadEveryMap();
 
+#ifndef DZSIM_WEB_PORT
+        // Loads every map found in CSGO's maps folder and writes a
+        // glidability report of each map into the given directory. Returns
+        // false if any map failed to load or any report failed to be written.
+        bool WriteGlidabilityReportOfEveryMap(const std::string& output_dir);
+#endif
+
         // Set extra keybindings that are checked _after_ the GUI and simulation
         // keybindings.
         void ConfigureExtraKeyBindings();
@@ -557,6 +588,60 @@ DZSimApplication::DZSimApplication(const Arguments& arguments)
 
     // Load embedded map on startup (if it exists)
     //LoadBspMap("embedded_maps/XXX.bsp", true);
+
+#ifndef DZSIM_WEB_PORT
+    std::string csgo_session_replay_path;
+    float csgo_session_replay_speed = 1.0f;
+
+    // Offline mode for batch jobs: Write glidability reports, then exit.
+    // Usage: --glidability-report-dir <output directory>
+    for (int i = 1; i + 1 < arguments.argc; i++) {
+        if (std::string(arguments.argv[i]) == "--glidability-report-dir") {
+            bool success = WriteGlidabilityReportOfEveryMap(arguments.argv[i + 1]);
+            exit(success ? 0 : 1); // Let batch jobs notice missing reports
+            break;
+        }
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED
+        // Usage: --console-parsing-benchmark <relay log file>
+        if (std::string(arguments.argv[i]) == "--console-parsing-benchmark") {
+            csgo_integration::Benchmark::ConsoleParsing(arguments.argv[i + 1]);
+            exit();
+            break;
+        }
+        // Measure throughput and latency of data sent by tools/FakeCsgoNetcon.py
+        // Usage: --integration-load-test <duration in seconds>
+        if (std::string(arguments.argv[i]) == "--integration-load-test") {
+            _gui_state.vis.IN_geo_vis_mode = _gui_state.vis.GLID_OF_CSGO_SESSION;
+            _gui_state.rcon.IN_start_connect = true;
+            _integration_load_test.Start(std::strtof(arguments.argv[i + 1], nullptr),
+                                         GSI_HOST, GSI_PORT, GSI_AUTH_TOKEN);
+        }
+#endif
+        // Usage: --load-map <.bsp file>
+        if (std::string(arguments.argv[i]) == "--load-map")
+            LoadBspMap(arguments.argv[i + 1]);
+        // Record all data received from CSGO into a session log.
+        // Usage: --record-csgo-session <output file>
+        if (std::string(arguments.argv[i]) == "--record-csgo-session")
+            _csgo_session_recorder.Start(arguments.argv[i + 1]);
+        // Replay a session log instead of receiving data from CSGO, then exit.
+        // Usage: --replay-csgo-session <session log> [--replay-speed <factor>]
+        if (std::string(arguments.argv[i]) == "--replay-csgo-session")
+            csgo_session_replay_path = arguments.argv[i + 1];
+        if (std::string(arguments.argv[i]) == "--replay-speed")
+            csgo_session_replay_speed = std::strtof(arguments.argv[i + 1], nullptr);
+    }
+
+    if (!csgo_session_replay_path.empty()) {
+        if (_csgo_session_replayer.Load(csgo_session_replay_path)) {
+            _gui_state.vis.IN_geo_vis_mode = _gui_state.vis.GLID_OF_CSGO_SESSION;
+            _csgo_session_replayer.Start(csgo_session_replay_speed);
+        }
+        else {
+            exit();
+        }
+    }
+#endif
 }
 
 DZSimApplication::~DZSimApplication()
@@ -785,6 +870,7 @@ bool DZSimApplication::LoadBspMap(std::string file_path,
 
     if (coll::Debugger::IS_ENABLED)
         coll::Debugger::Reset();
+    coll::TraceProfiler::Reset();
 
     // Deallocate previous map data to minimize peak RAM usage during parsing
     // RAM USAGE NOT REALLY TESTED YET!
@@ -842,11 +928,32 @@ bool DZSimApplication::LoadBspMap(std::string file_path,
     if (!bsp_parse_status.desc_msg.empty())
         _gui_state.popup.QueueMsgWarn(bsp_parse_status.desc_msg);
 
+    // Apply collision model cache settings before collision models get loaded
+    std::string coll_model_disk_cache_dir = "";
+#ifndef DZSIM_WEB_PORT
+    if (_gui_state.perf.IN_coll_model_disk_cache) {
+        Containers::Optional<Containers::String> cfg_dir =
+            Utility::Path::configurationDirectory("DZSimulator");
+        if (cfg_dir)
+            coll_model_disk_cache_dir =
+                Utility::Path::join(*cfg_dir, "CollisionModelCache");
+    }
+#endif
+    coll::CollisionModelCache::SetDiskCacheDirectory(coll_model_disk_cache_dir);
+    coll::CollisionModelCache::SetUnusedMemoryBudget(1024 * 1024 *
+        (size_t)Math::max(_gui_state.perf.IN_coll_model_cache_budget_mib, 0));
+
     std::string world_init_errors;
     auto initialized_worlds =
-        WorldCreator::InitFromBspMap(_bsp_map, &world_init_errors);
+        WorldCreator::InitFromBspMap(_bsp_map, &world_init_errors,
+                                     _gui_state.perf.IN_compact_world_vertices);
     _ren_world  = initialized_worlds.first;
     g_coll_world = initialized_worlds.second;
+    // Previous map's collision models are unused now if no other map uses them
+    coll::CollisionModelCache::Trim();
+    _gui_state.perf.OUT_world_vertex_bytes = _ren_world->vertex_buffer_bytes;
+    _gui_state.perf.OUT_world_float_vertex_bytes =
+        _ren_world->float_vertex_buffer_bytes;
 
     if (!world_init_errors.empty()) {
         Debug{} << world_init_errors.c_str();
@@ -861,6 +968,7 @@ bool DZSimApplication::LoadBspMap(std::string file_path,
         initial_worldstate.csgo_mv.m_vecViewAngles = playerSpawn.angles;
     }
     _csgo_game_sim.Start(SIM_TIME_STEP_SIZE, SIM_TIME_SCALE, initial_worldstate);
+    _csgo_player_extrapolator.Reset();
 
     // Init practice reset worldstate with map spawn position
     _sim_prac_reset_worldstate = initial_worldstate;
@@ -884,6 +992,51 @@ void DZSimApplication::_debug_LoadEveryMap() {
     }
 }
 
+#ifndef DZSIM_WEB_PORT
+bool DZSimApplication::WriteGlidabilityReportOfEveryMap(const std::string& output_dir)
+{
+    ZoneScoped;
+    if (!Utility::Path::make(output_dir)) {
+        Error{} << "ERROR: Failed to create glidability report directory:"
+            << output_dir.c_str();
+        return false;
+    }
+
+    sim::GlidabilityParams params =
+        sim::GlidabilityParams::FromConfig(g_csgo_game_sim_cfg);
+
+    size_t num_failed_maps   = 0;
+    size_t num_failed_writes = 0;
+
+    DoCsgoPathSearch(false);
+    csgo_parsing::AssetFinder::RefreshMapFileList();
+    for (const std::string& map_path : csgo_parsing::AssetFinder::GetMapFileList())
+    {
+        std::string abs_map_path = Corrade::Utility::Path::join(
+            { csgo_parsing::AssetFinder::GetCsgoPath(), "maps/", map_path });
+        if (!LoadBspMap(abs_map_path, false)) {
+            Error{} << "ERROR: Skipping glidability report of" << map_path.c_str();
+            num_failed_maps++;
+            continue;
+        }
+
+        GlidabilityReport report =
+            GlidabilityReport::Generate(*_bsp_map, *g_coll_world, params);
+        std::string out_path = Corrade::Utility::Path::join(
+            output_dir, report.map_name);
+        if (!report.WriteJsonFile  (out_path + ".json")) num_failed_writes++;
+        if (!report.WriteBinaryFile(out_path + ".bin"))  num_failed_writes++;
+    }
+
+    if (num_failed_maps == 0 && num_failed_writes == 0)
+        return true;
+    Error{} << "ERROR: Glidability reports are incomplete," << num_failed_maps
+        << "maps failed to load and" << num_failed_writes
+        << "report files failed to be written";
+    return false;
+}
+#endif
+
 void DZSimApplication::ConfigureExtraKeyBindings()
 {
     // Remove Bump Mines from map
@@ -925,6 +1078,7 @@ void DZSimApplication::ConfigureExtraKeyBindings()
 #if COLL_BENCHMARK_ENABLED
         coll::Benchmark::StaticPropHullTracing();
         //coll::Benchmark::StaticPropBevelPlaneGen();
+        //coll::Benchmark::TraceCacheVsBvhTraversal();
         return;
 #endif
 
@@ -1008,7 +1162,8 @@ void DZSimApplication::DoUpdate()
 #endif
 
     // When we're in "sparing low latency draw mode" the following happens:
-    //   - Targeted main loop frequency is set to 1000 Hz (i.e. tickEvent() rate)
+    //   - The main loop is paced by _frame_pacer: It waits until new data from
+    //     CSGO is expected to arrive and continues as soon as it landed
     //   - VSync is disabled, ignoring user setting
     //   - A new frame is only drawn when needed (e.g. once new data has arrived)
     //   - When frames are not required to be drawn frequently enough, they're
@@ -1084,6 +1239,29 @@ void DZSimApplication::DoUpdate()
         auto csgo_server_data_q = _csgo_handler.DequeNewCsgoServerTicksData();
         auto csgo_client_data_q = _csgo_handler.DequeNewCsgoClientsideData();
 
+        // A replayed CSGO session replaces live data
+        if (_csgo_session_replayer.IsReplaying()) {
+            csgo_server_data_q = _csgo_session_replayer.DequeNewCsgoServerTicksData();
+            csgo_client_data_q = _csgo_session_replayer.DequeNewCsgoClientsideData();
+            if (_csgo_session_replayer.IsFinished()) {
+                Debug{} << "[SessionReplayer] Replay finished, average receive-to-display latency:"
+                    << _gui_state.rcon.OUT_receive_to_display_latency_ms << "ms";
+                this->exit();
+            }
+        }
+        _csgo_session_recorder.Record(csgo_server_data_q);
+        _csgo_session_recorder.Record(csgo_client_data_q);
+
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED
+        if (_integration_load_test.IsRunning()) {
+            _integration_load_test.AddUpdate(csgo_server_data_q, csgo_client_data_q);
+            if (_integration_load_test.IsFinished()) {
+                _integration_load_test.Finish(_csgo_rcon.GetNumDroppedReadLines());
+                this->exit();
+            }
+        }
+#endif
+
         // In low latency draw mode, draw a new frame only when necessary
         if (is_sparing_low_latency_draw_mode_enabled)
             // Draw a new frame once we have new client-side position and view
@@ -1092,12 +1270,18 @@ void DZSimApplication::DoUpdate()
                 redraw_needed = true;
 
         // Process new CSGO server ticks
-        for (auto& server_tick_data : csgo_server_data_q)
+        for (auto& server_tick_data : csgo_server_data_q) {
+            _csgo_player_extrapolator.AddServerTick(server_tick_data,
+                _latest_csgo_client_data.player_angles,
+                _gui_state.game_cfg.IN_loadout);
             _latest_csgo_server_data = std::move(server_tick_data);
+        }
 
         // Process new CSGO client-side data
-        for (auto& clientside_data : csgo_client_data_q)
+        for (auto& clientside_data : csgo_client_data_q) {
+            _frame_pacer.AddArrival(clientside_data.receive_time);
             _latest_csgo_client_data = std::move(clientside_data);
+        }
     }
 
     bool esc_pressed = _inputs.GetKeyPressCountAndReset_keyboard("Escape");
@@ -1379,18 +1563,53 @@ void DZSimApplication::DoUpdate()
     _gui_state.rcon.OUT_has_connect_failed = _csgo_rcon.HasFailedToConnect();
     _gui_state.rcon.OUT_is_disconnecting = _csgo_rcon.IsDisconnecting();
     _gui_state.rcon.OUT_fail_msg = _csgo_rcon.GetLastErrorMessage();
+    _gui_state.rcon.OUT_num_dropped_lines = _csgo_rcon.GetNumDroppedReadLines();
+
+    // Update frame pacing stats for GUI
+    if (_gui_state.rcon.IN_clear_frame_pacing_stats) {
+        _gui_state.rcon.IN_clear_frame_pacing_stats = false;
+        _frame_pacer.ClearHistograms();
+    }
+    {
+        auto& rcon = _gui_state.rcon;
+        const auto& latency_hist = _frame_pacer.GetLatencyHistogram();
+        const auto& cpu_usage_hist = _frame_pacer.GetCpuUsageHistogram();
+        rcon.OUT_predicted_update_interval_ms = 1e-3f * std::chrono::duration_cast<
+            std::chrono::microseconds>(_frame_pacer.GetPredictedInterval()).count();
+        rcon.OUT_latency_hist = latency_hist.GetBucketCounts();
+        rcon.OUT_latency_hist_max_ms = latency_hist.GetMax();
+        rcon.OUT_latency_p50_ms = latency_hist.GetPercentile(0.5f);
+        rcon.OUT_latency_p99_ms = latency_hist.GetPercentile(0.99f);
+        rcon.OUT_cpu_usage_percent = _frame_pacer.GetCpuUsagePercent();
+        rcon.OUT_cpu_usage_hist = cpu_usage_hist.GetBucketCounts();
+        rcon.OUT_cpu_usage_p50_percent = cpu_usage_hist.GetPercentile(0.5f);
+    }
+
+    // Update player extrapolation stats for GUI
+    {
+        auto& rcon = _gui_state.rcon;
+        const auto& error_hist = _csgo_player_extrapolator.GetPositionErrorHistogram();
+        rcon.OUT_extrapolation_error = _csgo_player_extrapolator.GetMeanPositionError();
+        rcon.OUT_extrapolation_error_without =
+            _csgo_player_extrapolator.GetMeanPositionErrorWithoutExtrapolation();
+        rcon.OUT_extrapolation_error_p99 = error_hist.GetPercentile(0.99f);
+        rcon.OUT_extrapolation_error_hist = error_hist.GetBucketCounts();
+        rcon.OUT_extrapolation_error_hist_max = error_hist.GetMax();
+    }
 
 #ifndef DZSIM_WEB_PORT
     // Native builds only:
     // Set max main loop frequency (value only takes effect if VSync is off)
     if (is_sparing_low_latency_draw_mode_enabled) {
-        // Set targeted main loop frequency to 1000 Hz for low latency drawing
-        this->setMinimalLoopPeriod(1); // Not 0, don't want to hog the CPU!
+        // _frame_pacer waits in tickEvent() instead, so the main loop doesn't
+        // hog the CPU
+        this->setMinimalLoopPeriod(0);
     }
     else {
         // Respect user setting for the FPS limit
         this->setMinimalLoopPeriod(_gui_state.video.IN_min_loop_period);
     }
+    _is_frame_pacing_enabled = is_sparing_low_latency_draw_mode_enabled;
 #endif
 
 #ifndef DZSIM_WEB_PORT
@@ -1436,6 +1655,49 @@ void DZSimApplication::DoUpdate()
         }
     }
 
+    // Displacement collision cache and prop bevel plane handling
+    if (g_coll_world) {
+        using Policy = coll::CollidableWorld::DispCachePolicy;
+        auto& perf = _gui_state.perf;
+        Policy policy;
+        switch (perf.IN_disp_cache_mode) {
+            case gui::GuiState::Performance::DISP_CACHE_LAZY:        policy.mode = Policy::Mode::LAZY;        break;
+            case gui::GuiState::Performance::DISP_CACHE_PREBUILD:    policy.mode = Policy::Mode::PREBUILD;    break;
+            case gui::GuiState::Performance::DISP_CACHE_LAZY_BUDGET: policy.mode = Policy::Mode::LAZY_BUDGET; break;
+        }
+        policy.budget_bytes = 1024 * (size_t)Math::max(perf.IN_disp_cache_budget_kib, 0);
+        g_coll_world->SetDispCachePolicy(policy); // Does nothing if unchanged
+
+        const auto& stats = g_coll_world->GetDispCacheStats();
+        perf.OUT_disp_cache_builds_last_tick = stats.builds_last_tick;
+        perf.OUT_disp_cache_builds_total     = stats.builds_total;
+        perf.OUT_disp_cache_evictions_total  = stats.evictions_total;
+        perf.OUT_disp_cache_num_cached       = stats.num_cached;
+        perf.OUT_disp_cache_bytes            = stats.cache_bytes;
+
+        using BevelMode = coll::CollidableWorld::XPropBevelPlaneMode;
+        switch (perf.IN_xprop_bevel_mode) {
+            case gui::GuiState::Performance::XPROP_BEVELS_ON_DEMAND:
+                g_coll_world->SetXPropBevelPlaneMode(BevelMode::ON_DEMAND); break;
+            case gui::GuiState::Performance::XPROP_BEVELS_NEAR_SPAWNS:
+                g_coll_world->SetXPropBevelPlaneMode(BevelMode::PRECOMPUTE_NEAR_SPAWNS); break;
+            case gui::GuiState::Performance::XPROP_BEVELS_PRECOMPUTE_ALL:
+                g_coll_world->SetXPropBevelPlaneMode(BevelMode::PRECOMPUTE_ALL); break;
+        }
+        perf.OUT_xprop_bevel_bytes = g_coll_world->GetXPropBevelPlaneMemorySize();
+    }
+    {
+        auto& perf = _gui_state.perf;
+        const auto stats = coll::CollisionModelCache::GetStats();
+        perf.OUT_coll_model_cache_num_models   = stats.num_models;
+        perf.OUT_coll_model_cache_num_unused   = stats.num_unused_models;
+        perf.OUT_coll_model_cache_bytes        = stats.model_bytes;
+        perf.OUT_coll_model_cache_unused_bytes = stats.unused_model_bytes;
+        perf.OUT_coll_model_cache_memory_hits  = stats.memory_hits_total;
+        perf.OUT_coll_model_cache_disk_hits    = stats.disk_hits_total;
+        perf.OUT_coll_model_cache_misses       = stats.misses_total;
+    }
+
     // Use camera angles from local CSGO session
     if (_gui_state.vis.IN_geo_vis_mode == _gui_state.vis.GLID_OF_CSGO_SESSION)
         _cam_ang = _latest_csgo_client_data.player_angles;
@@ -1486,6 +1748,17 @@ void DZSimApplication::DoUpdate()
 #ifndef DZSIM_WEB_PORT
 // Called after processing all input events and before drawEvent()
 void DZSimApplication::tickEvent() {
+    // In sparing low latency draw mode, wait until new data from CSGO is
+    // about to arrive. Input events that occur meanwhile are processed in the
+    // next main loop iteration. The window is unfocused in this mode anyway.
+    if (_is_frame_pacing_enabled) {
+        _frame_pacer.WaitForNextArrival([this] {
+            if (_csgo_session_replayer.IsReplaying())
+                return _csgo_session_replayer.HasDueData();
+            return _csgo_rcon.HasNewReadLines();
+        });
+        _frame_pacer.UpdateCpuUsage();
+    }
     DoUpdate();
 }
 #endif
@@ -1555,8 +1828,19 @@ void DZSimApplication::drawEvent() {
     if (_gui_state.vis.IN_geo_vis_mode == _gui_state.vis.GLID_OF_CSGO_SESSION) {
         // World renderer needs server-side player position and velocity to
         // optimally visualize surface slidability
-        hori_player_speed = _latest_csgo_server_data.player_vel.xy().length();
-        player_feet_pos   = _latest_csgo_server_data.player_pos_feet;
+        if (_gui_state.rcon.IN_extrapolate_player && _csgo_player_extrapolator.HasServerTick()) {
+            // Hide the delay of server ticks by predicting the present
+            auto lead = std::chrono::microseconds(
+                (long long)(1000.0f * _gui_state.rcon.IN_extrapolation_lead_ms));
+            sim::WorldState extrapolated =
+                _csgo_player_extrapolator.GetExtrapolatedWorldState(WallClock::now() + lead);
+            hori_player_speed = extrapolated.csgo_mv.m_vecVelocity.xy().length();
+            player_feet_pos   = extrapolated.csgo_mv.m_vecAbsOrigin;
+        }
+        else {
+            hori_player_speed = _latest_csgo_server_data.player_vel.xy().length();
+            player_feet_pos   = _latest_csgo_server_data.player_pos_feet;
+        }
         // When we are in overlay mode, the client-side eye position makes for
         // a smoother overlay compared to the server-side eye position!
         cam_pos = _latest_csgo_client_data.player_pos_eye;
@@ -1664,6 +1948,26 @@ void DZSimApplication::drawEvent() {
 
     swapBuffers();
 
+    // Measure how long it took CSGO's client-side data to get on screen, from
+    // when the console line arrived until the frame that shows it got swapped
+    if (_gui_state.vis.IN_geo_vis_mode == _gui_state.vis.GLID_OF_CSGO_SESSION) {
+        WallClock::time_point recv_time = _latest_csgo_client_data.receive_time;
+        if (recv_time != WallClock::time_point{} &&
+            recv_time != _last_drawn_csgo_client_data_time) {
+            _last_drawn_csgo_client_data_time = recv_time;
+            float latency_ms = 1e-3f * std::chrono::duration_cast<
+                std::chrono::microseconds>(WallClock::now() - recv_time).count();
+            // Smooth out the displayed value
+            float& avg_latency_ms = _gui_state.rcon.OUT_receive_to_display_latency_ms;
+            avg_latency_ms = avg_latency_ms == 0.0f ?
+                latency_ms : 0.9f * avg_latency_ms + 0.1f * latency_ms;
+            _frame_pacer.AddReceiveToDisplayLatency(latency_ms);
+#if CSGO_INTEGRATION_BENCHMARK_ENABLED
+            _integration_load_test.AddDisplayLatency(latency_ms);
+#endif
+        }
+    }
+
     FrameMark; // Profiling
 }
 
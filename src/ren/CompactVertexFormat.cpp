@@ -0,0 +1,164 @@
+#include "ren/CompactVertexFormat.h"
+
+#include <algorithm>
+
+#include <Tracy.hpp>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+
+#include "coll/SimdMath.h"
+
+using namespace Magnum;
+using namespace ren;
+using namespace coll; // For SIMD functions
+
+// Largest value of a normalized signed short, read by the GPU as 1.0
+static const float SHORT_NORM_MAX = 32767.0f;
+
+// Returns |a|, lane-wise
+static COLL_SIMD_INLINE fltx4 AbsSIMD(const fltx4& a) {
+    return AndNotSIMD(ReplicateX4(-0.0f), a);
+}
+
+// Returns +1 or -1 with the sign of a, lane-wise. Zero counts as positive.
+static COLL_SIMD_INLINE fltx4 SignNotZeroSIMD(const fltx4& a) {
+    return OrSIMD(AndSIMD(ReplicateX4(-0.0f), a), Four_Ones());
+}
+
+// Returns a rounded to the nearest integer (halfway cases away from zero),
+// lane-wise, as int16. Values must be within the int16 range.
+static COLL_SIMD_INLINE void StoreRoundedShorts(const fltx4& a, int16_t dest[4]) {
+    alignas(16) float v[4];
+    StoreAlignedSIMD(v, AddSIMD(a, MulSIMD(SignNotZeroSIMD(a), ReplicateX4(0.5f))));
+    for (int i = 0; i < 4; i++)
+        dest[i] = (int16_t)v[i]; // Truncates
+}
+
+CompactVertexBuffer ren::EncodeCompactVertices(
+    std::span<const FlatIndexedMesh::Vertex> vertices)
+{
+    ZoneScoped;
+
+    CompactVertexBuffer result;
+    result.decoding.octahedral_normals = true;
+    if (vertices.empty())
+        return result;
+
+    const size_t NUM_VERTS = vertices.size();
+
+    // Gathers 4 vertices, starting at the given index. Lanes past the end
+    // repeat the last vertex.
+    auto load_4_vertices = [&](size_t first, FourVectors* pos, FourVectors* nrm) {
+        const FlatIndexedMesh::Vertex* v[4];
+        for (size_t lane = 0; lane < 4; lane++)
+            v[lane] = &vertices[std::min(first + lane, NUM_VERTS - 1)];
+        pos->LoadAndSwizzle(v[0]->position, v[1]->position,
+                            v[2]->position, v[3]->position);
+        nrm->LoadAndSwizzle(v[0]->normal, v[1]->normal,
+                            v[2]->normal, v[3]->normal);
+    };
+
+    // Bounding box of all positions
+    FourVectors mins4, maxs4;
+    mins4.DuplicateVector(vertices[0].position);
+    maxs4 = mins4;
+    for (size_t i = 0; i < NUM_VERTS; i += 4) {
+        FourVectors pos, nrm;
+        load_4_vertices(i, &pos, &nrm);
+        mins4 = minimum(mins4, pos);
+        maxs4 = maximum(maxs4, pos);
+    }
+    Vector3 mins = mins4.Vec(0);
+    Vector3 maxs = maxs4.Vec(0);
+    for (int lane = 1; lane < 4; lane++) {
+        mins = Math::min(mins, mins4.Vec(lane));
+        maxs = Math::max(maxs, maxs4.Vec(lane));
+    }
+
+    Vector3 center = 0.5f * (mins + maxs);
+    Vector3 half_extent = 0.5f * (maxs - mins);
+    for (int axis = 0; axis < 3; axis++)
+        if (!(half_extent[axis] > 0.0f)) // Flat along this axis
+            half_extent[axis] = 1.0f;
+    result.decoding.position_offset = center;
+    result.decoding.position_scale  = half_extent;
+
+    FourVectors center4, quant4;
+    center4.DuplicateVector(center);
+    quant4.DuplicateVector(SHORT_NORM_MAX / half_extent);
+    const fltx4 q_max = ReplicateX4(+SHORT_NORM_MAX);
+    const fltx4 q_min = ReplicateX4(-SHORT_NORM_MAX);
+    const fltx4 zero  = Four_Zeros();
+    const fltx4 one   = Four_Ones();
+
+    result.vertices.resize(NUM_VERTS);
+    for (size_t i = 0; i < NUM_VERTS; i += 4) {
+        FourVectors pos, nrm;
+        load_4_vertices(i, &pos, &nrm);
+
+        // Quantize positions relative to the bounding box
+        pos -= center4;
+        pos *= quant4;
+        pos = maximum(minimum(pos, FourVectors{ q_max, q_max, q_max }),
+                      FourVectors{ q_min, q_min, q_min });
+
+        // Octahedral normal encoding: Project onto the octahedron |x|+|y|+|z|=1,
+        // then fold the lower hemisphere over the upper one.
+        fltx4 l1_norm = AddSIMD(AddSIMD(AbsSIMD(nrm.x), AbsSIMD(nrm.y)),
+                                AbsSIMD(nrm.z));
+        fltx4 inv_l1_norm = DivSIMD(one, MaxSIMD(l1_norm, ReplicateX4(1e-20f)));
+        fltx4 oct_x = MulSIMD(nrm.x, inv_l1_norm);
+        fltx4 oct_y = MulSIMD(nrm.y, inv_l1_norm);
+        fltx4 oct_z = MulSIMD(nrm.z, inv_l1_norm);
+        fltx4 folded_x = MulSIMD(SubSIMD(one, AbsSIMD(oct_y)), SignNotZeroSIMD(oct_x));
+        fltx4 folded_y = MulSIMD(SubSIMD(one, AbsSIMD(oct_x)), SignNotZeroSIMD(oct_y));
+        fltx4 is_lower = CmpLtSIMD(oct_z, zero);
+        oct_x = MulSIMD(MaskedAssign(is_lower, folded_x, oct_x), q_max);
+        oct_y = MulSIMD(MaskedAssign(is_lower, folded_y, oct_y), q_max);
+
+        int16_t px[4], py[4], pz[4], nx[4], ny[4];
+        StoreRoundedShorts(pos.x, px);
+        StoreRoundedShorts(pos.y, py);
+        StoreRoundedShorts(pos.z, pz);
+        StoreRoundedShorts(oct_x, nx);
+        StoreRoundedShorts(oct_y, ny);
+
+        size_t num_lanes = std::min<size_t>(4, NUM_VERTS - i);
+        for (size_t lane = 0; lane < num_lanes; lane++) {
+            result.vertices[i + lane] = {
+                .position = { px[lane], py[lane], pz[lane] },
+                .padding  = 0,
+                .normal   = { nx[lane], ny[lane] }
+            };
+        }
+    }
+    return result;
+}
+
+// Same conversion as OpenGL's for normalized signed shorts
+static float ShortNormToFloat(int16_t s) {
+    return Math::max((float)s / SHORT_NORM_MAX, -1.0f);
+}
+
+Vector3 ren::DecodeCompactPosition(const CompactVertex& v,
+                                   const VertexDecoding& decoding)
+{
+    Vector3 p = { ShortNormToFloat(v.position[0]),
+                  ShortNormToFloat(v.position[1]),
+                  ShortNormToFloat(v.position[2]) };
+    return decoding.position_offset + decoding.position_scale * p;
+}
+
+Vector3 ren::DecodeOctahedralNormal(const CompactVertex& v)
+{
+    // Keep in sync with GlidabilityShader3D.vert
+    Vector3 n;
+    n.x() = ShortNormToFloat(v.normal[0]);
+    n.y() = ShortNormToFloat(v.normal[1]);
+    n.z() = 1.0f - Math::abs(n.x()) - Math::abs(n.y());
+    float t = Math::max(-n.z(), 0.0f);
+    n.x() += n.x() >= 0.0f ? -t : t;
+    n.y() += n.y() >= 0.0f ? -t : t;
+    return n.normalized();
+}
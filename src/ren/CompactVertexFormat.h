@@ -0,0 +1,55 @@
+#ifndef REN_COMPACTVERTEXFORMAT_H_
+#define REN_COMPACTVERTEXFORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "ren/MeshSimplification.h"
+
+namespace ren {
+
+// Vertex with position and normal, 12 bytes instead of 24 bytes.
+// Positions are quantized relative to the bounds of the mesh they belong to,
+// see VertexDecoding. Normals are octahedral-encoded.
+// Both are read by the GPU as normalized signed shorts, i.e. as floats in the
+// range [-1, 1].
+struct CompactVertex {
+    int16_t position[3];
+    int16_t padding; // Keeps the normal 4-byte aligned
+    int16_t normal[2];
+};
+static_assert(sizeof(CompactVertex) == 12);
+
+// Describes how GlidabilityShader3D turns vertex attributes of a mesh into
+// positions and normals. The default values are used for uncompressed meshes.
+struct VertexDecoding {
+    // position = position_offset + position_scale * position attribute
+    Magnum::Vector3 position_offset{ 0.0f };
+    Magnum::Vector3 position_scale { 1.0f };
+    // Whether the normal attribute holds an octahedral-encoded normal
+    bool octahedral_normals = false;
+};
+
+struct CompactVertexBuffer {
+    std::vector<CompactVertex> vertices;
+    VertexDecoding decoding;
+};
+
+// Encodes the given vertices. Their normals must be normalized.
+// Quantization error of positions is at most 1/65534 of the extent of the
+// vertices' bounding box on each axis. Encodes 4 vertices at once using SIMD.
+CompactVertexBuffer EncodeCompactVertices(
+    std::span<const FlatIndexedMesh::Vertex> vertices);
+
+// Scalar reference implementations of the shader's decoding.
+Magnum::Vector3 DecodeCompactPosition(const CompactVertex& v,
+                                      const VertexDecoding& decoding);
+Magnum::Vector3 DecodeOctahedralNormal(const CompactVertex& v);
+
+} // namespace ren
+
+#endif // REN_COMPACTVERTEXFORMAT_H_
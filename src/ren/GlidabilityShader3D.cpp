@@ -97,6 +97,10 @@ GlidabilityShader3D::GlidabilityShader3D(bool use_instanced_transformation,
     _uniform_max_vel = uniformLocation("max_vel");
     _uniform_standable_normal = uniformLocation("standable_normal");
 
+    _uniform_position_decode_offset = uniformLocation("position_decode_offset");
+    _uniform_position_decode_scale  = uniformLocation("position_decode_scale");
+    _uniform_octahedral_normals     = uniformLocation("octahedral_normals");
+
     // Set default values of uniform vars. Must happen outside shader code
     // because the web build does not support in-shader uniform initialization.
     SetFinalTransformationMatrix(Matrix4{ Math::IdentityInit });
@@ -113,6 +117,7 @@ GlidabilityShader3D::GlidabilityShader3D(bool use_instanced_transformation,
     SetMinNoGroundChecksVelZ(0.0f);
     SetMaxVelocity(999999.0f);
     SetStandableNormal(0.7f);
+    SetVertexDecoding(VertexDecoding{});
 }
 
 GlidabilityShader3D&
@@ -212,3 +217,12 @@ GlidabilityShader3D::SetStandableNormal(float normal_z)
     setUniform(_uniform_standable_normal, normal_z);
     return *this;
 }
+
+GlidabilityShader3D&
+GlidabilityShader3D::SetVertexDecoding(const VertexDecoding& decoding)
+{
+    setUniform(_uniform_position_decode_offset, decoding.position_offset);
+    setUniform(_uniform_position_decode_scale,  decoding.position_scale);
+    setUniform(_uniform_octahedral_normals,     decoding.octahedral_normals);
+    return *this;
+}
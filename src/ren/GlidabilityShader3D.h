@@ -6,6 +6,8 @@
 #include <Magnum/GL/AbstractShaderProgram.h>
 #include <Magnum/Shaders/GenericGL.h>
 
+#include "ren/CompactVertexFormat.h"
+
 namespace ren {
 
     class GlidabilityShader3D : public Magnum::GL::AbstractShaderProgram {
@@ -46,6 +48,9 @@ namespace ren {
         GlidabilityShader3D& SetMaxVelocity(float max_v_per_axis);
         GlidabilityShader3D& SetStandableNormal(float normal_z);
 
+        // Must match the vertex format of the drawn mesh
+        GlidabilityShader3D& SetVertexDecoding(const VertexDecoding& decoding);
+
 
     private:
         // Shader uniform locations
@@ -69,6 +74,10 @@ namespace ren {
         Magnum::Int _uniform_max_vel = -1;
         Magnum::Int _uniform_standable_normal = -1;
 
+        Magnum::Int _uniform_position_decode_offset = -1;
+        Magnum::Int _uniform_position_decode_scale = -1;
+        Magnum::Int _uniform_octahedral_normals = -1;
+
     };
 
 } // namespace ren
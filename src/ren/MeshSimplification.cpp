@@ -0,0 +1,528 @@
+#include "ren/MeshSimplification.h"
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <unordered_map>
+
+#include <Tracy.hpp>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+
+using namespace Magnum;
+using namespace ren;
+
+// Vertices that round to the same point of this grid get welded
+static const float WELD_GRID_SIZE = 1.0f / 64.0f;
+
+// Faces whose normals and plane distances round to the same point of these
+// grids are considered coplanar
+static const float PLANE_NORMAL_GRID_SIZE = 1.0f / 1024.0f;
+static const float PLANE_DIST_GRID_SIZE   = 1.0f / 16.0f;
+
+// A polygon corner is considered straight if the sine of its angle is smaller
+static const float STRAIGHT_CORNER_SINE = 1e-4f;
+
+namespace {
+
+struct GridKey {
+    int32_t x, y, z, w;
+    bool operator==(const GridKey& other) const = default;
+};
+
+struct GridKeyHash {
+    size_t operator()(const GridKey& k) const {
+        uint64_t h = (uint64_t)(uint32_t)k.x * 0x9E3779B97F4A7C15ULL;
+        h ^= (uint64_t)(uint32_t)k.y * 0xC2B2AE3D27D4EB4FULL;
+        h ^= (uint64_t)(uint32_t)k.z * 0x165667B19E3779F9ULL;
+        h ^= (uint64_t)(uint32_t)k.w * 0x27D4EB2F165667C5ULL;
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+// Directed polygon edge. Coplanar polygons facing in opposite directions
+// share edges too, so the plane is part of the key.
+struct EdgeKey {
+    uint32_t from_vert, to_vert, plane_idx;
+    bool operator==(const EdgeKey& other) const = default;
+};
+
+struct EdgeKeyHash {
+    size_t operator()(const EdgeKey& k) const {
+        return GridKeyHash{}({ (int32_t)k.from_vert, (int32_t)k.to_vert,
+                               (int32_t)k.plane_idx, 0 });
+    }
+};
+
+// Convex polygon with clockwise vertex winding
+struct Poly {
+    std::vector<uint32_t> verts; // Indices into welded positions
+    uint32_t plane_idx;
+    bool     alive; // False if it was merged into another polygon
+};
+
+enum class Corner { CONVEX, STRAIGHT, INVALID };
+
+} // namespace
+
+static int32_t Quantize(float val, float grid_size)
+{
+    return (int32_t)std::lround(val / grid_size);
+}
+
+static uint64_t PackPair(uint32_t a, uint32_t b)
+{
+    return ((uint64_t)a << 32) | b;
+}
+
+// Classifies the corner at cur of a polygon with clockwise vertex winding
+static Corner ClassifyCorner(const Vector3& prev, const Vector3& cur,
+                             const Vector3& next, const Vector3& normal)
+{
+    Vector3 prev_to_cur  = cur  - prev;
+    Vector3 prev_to_next = next - prev;
+    float sine = Math::dot(Math::cross(prev_to_next, prev_to_cur), normal)
+        / (prev_to_cur.length() * prev_to_next.length());
+    if (sine > STRAIGHT_CORNER_SINE)
+        return Corner::CONVEX;
+    if (sine < -STRAIGHT_CORNER_SINE)
+        return Corner::INVALID; // Concave
+    if (Math::dot(prev_to_cur, next - cur) > 0.0f)
+        return Corner::STRAIGHT;
+    return Corner::INVALID; // Polygon turns back on itself
+}
+
+// Tries to merge polygon p with polygon q that shares the edge from p's vertex
+// at idx p_edge to the next one. Returns false if the merged polygon wouldn't
+// be convex. num_poly_refs holds the number of polygons using each vertex.
+static bool TryMergePolys(const std::vector<uint32_t>& p, size_t p_edge,
+                          const std::vector<uint32_t>& q,
+                          const std::vector<Vector3>& positions,
+                          const std::vector<uint32_t>& num_poly_refs,
+                          const Vector3& normal,
+                          std::vector<uint32_t>& merged)
+{
+    const size_t n = p.size();
+    const size_t m = q.size();
+    uint32_t a = p[p_edge];
+    uint32_t b = p[(p_edge + 1) % n];
+
+    size_t q_edge = 0;
+    while (q_edge < m && !(q[q_edge] == b && q[(q_edge + 1) % m] == a))
+        q_edge++;
+    if (q_edge == m)
+        return false;
+
+    // p's vertices from b to a, followed by q's vertices between a and b
+    merged.clear();
+    for (size_t k = 0; k < n; k++)
+        merged.push_back(p[(p_edge + 1 + k) % n]);
+    for (size_t k = 2; k < m; k++)
+        merged.push_back(q[(q_edge + k) % m]);
+
+    // Reject polygons that touch themselves
+    std::vector<uint32_t> sorted_verts = merged;
+    std::sort(sorted_verts.begin(), sorted_verts.end());
+    if (std::adjacent_find(sorted_verts.begin(), sorted_verts.end()) != sorted_verts.end())
+        return false;
+
+    // Only the corners at a and b changed
+    const size_t idx_b = 0;
+    const size_t idx_a = n - 1;
+    Corner corner_a = ClassifyCorner(positions[merged[idx_a - 1]],
+                                     positions[merged[idx_a]],
+                                     positions[merged[idx_a + 1]], normal);
+    Corner corner_b = ClassifyCorner(positions[merged.back()],
+                                     positions[merged[idx_b]],
+                                     positions[merged[idx_b + 1]], normal);
+    if (corner_a == Corner::INVALID || corner_b == Corner::INVALID)
+        return false;
+
+    // Remove redundant vertices, a first since it comes after b. Vertices that
+    // polygons other than p and q use must stay, or they'd become T-junctions.
+    if (corner_a == Corner::STRAIGHT && num_poly_refs[a] <= 2)
+        merged.erase(merged.begin() + idx_a);
+    if (corner_b == Corner::STRAIGHT && num_poly_refs[b] <= 2)
+        merged.erase(merged.begin() + idx_b);
+    return merged.size() >= 3;
+}
+
+// Triangulates a convex polygon with clockwise vertex winding that might have
+// straight corners. Every vertex ends up in a non-degenerate triangle, so
+// other polygons that share a straight corner don't get a T-junction there.
+// The polygon's vertices are consumed.
+template<class EmitTriFunc>
+static void TriangulateConvexPoly(std::vector<uint32_t>& verts,
+                                  const std::vector<Vector3>& positions,
+                                  const Vector3& normal,
+                                  EmitTriFunc emit_tri)
+{
+    while (verts.size() >= 3) {
+        const size_t n = verts.size();
+        auto classify = [&](size_t i) {
+            return ClassifyCorner(positions[verts[(i + n - 1) % n]],
+                                  positions[verts[i]],
+                                  positions[verts[(i + 1) % n]], normal);
+        };
+
+        // Clip convex corners next to straight ones first. That turns the
+        // straight corners convex, instead of leaving them on a line with
+        // nothing left to form a triangle with.
+        size_t ear = n;
+        for (size_t i = 0; i < n; i++) {
+            if (classify(i) != Corner::CONVEX)
+                continue;
+            if (ear == n)
+                ear = i;
+            if (classify((i + n - 1) % n) == Corner::STRAIGHT ||
+                classify((i + 1)     % n) == Corner::STRAIGHT) {
+                ear = i;
+                break;
+            }
+        }
+        if (ear == n)
+            return; // No convex corner left, remaining polygon is degenerate
+
+        emit_tri(verts[(ear + n - 1) % n], verts[ear], verts[(ear + 1) % n]);
+        verts.erase(verts.begin() + ear);
+    }
+}
+
+FlatIndexedMesh ren::CreateSimplifiedFlatMesh(
+    const utils_3d::FaceBuffer& faces,
+    MeshSimplificationStats* stats)
+{
+    ZoneScoped;
+
+    MeshSimplificationStats s;
+    s.num_tris_before  = faces.NumTris();
+    s.num_verts_before = 3 * s.num_tris_before;
+
+    // ----- Weld vertices and group faces by plane
+    std::vector<Vector3> positions; // Welded
+    std::vector<Vector3> plane_normals;
+    std::unordered_map<GridKey, uint32_t, GridKeyHash> position_lut;
+    std::unordered_map<GridKey, uint32_t, GridKeyHash> plane_lut;
+    std::vector<Poly> polys;
+    polys.reserve(faces.NumFaces());
+    for (size_t face_idx = 0; face_idx < faces.NumFaces(); face_idx++) {
+        std::span<const Vector3> face = faces.GetFace(face_idx);
+        Poly poly{ .verts = {}, .plane_idx = 0, .alive = true };
+        for (const Vector3& v : face) {
+            GridKey key = { Quantize(v.x(), WELD_GRID_SIZE),
+                            Quantize(v.y(), WELD_GRID_SIZE),
+                            Quantize(v.z(), WELD_GRID_SIZE), 0 };
+            auto [it, inserted] = position_lut.try_emplace(key, (uint32_t)positions.size());
+            if (inserted)
+                positions.push_back(v);
+            if (poly.verts.empty() || poly.verts.back() != it->second)
+                poly.verts.push_back(it->second);
+        }
+        while (poly.verts.size() > 1 && poly.verts.front() == poly.verts.back())
+            poly.verts.pop_back();
+        if (poly.verts.size() < 3)
+            continue; // Collapsed by welding
+
+        // Area-weighted normal, robust against straight corners
+        const Vector3& v0 = positions[poly.verts[0]];
+        Vector3 normal_sum{ 0.0f };
+        for (size_t i = 2; i < poly.verts.size(); i++)
+            normal_sum += Math::cross(positions[poly.verts[i]] - v0,
+                                      positions[poly.verts[i - 1]] - v0);
+        float normal_len = normal_sum.length();
+        if (!(normal_len > 1e-6f))
+            continue; // Degenerate face
+        Vector3 normal = normal_sum / normal_len;
+
+        GridKey plane_key = { Quantize(normal.x(), PLANE_NORMAL_GRID_SIZE),
+                              Quantize(normal.y(), PLANE_NORMAL_GRID_SIZE),
+                              Quantize(normal.z(), PLANE_NORMAL_GRID_SIZE),
+                              Quantize(Math::dot(normal, v0), PLANE_DIST_GRID_SIZE) };
+        auto [it, inserted] = plane_lut.try_emplace(plane_key, (uint32_t)plane_normals.size());
+        if (inserted)
+            plane_normals.push_back(normal);
+        poly.plane_idx = it->second;
+        polys.push_back(std::move(poly));
+    }
+    position_lut = {};
+    plane_lut    = {};
+
+    // Number of polygons using each vertex, across all planes
+    std::vector<uint32_t> num_poly_refs(positions.size(), 0);
+    for (const Poly& poly : polys)
+        for (uint32_t v : poly.verts)
+            num_poly_refs[v]++;
+
+    // ----- Merge adjacent coplanar polygons
+    // Directed edge -> polygon. If multiple polygons share a directed edge
+    // (overlapping faces), only one of them is found, which is fine.
+    std::unordered_map<EdgeKey, uint32_t, EdgeKeyHash> edge_lut;
+    auto get_edge_key = [&](uint32_t poly_idx, size_t i) {
+        const std::vector<uint32_t>& verts = polys[poly_idx].verts;
+        return EdgeKey{ verts[i], verts[(i + 1) % verts.size()], polys[poly_idx].plane_idx };
+    };
+    auto add_edges = [&](uint32_t poly_idx) {
+        for (size_t i = 0; i < polys[poly_idx].verts.size(); i++)
+            edge_lut[get_edge_key(poly_idx, i)] = poly_idx;
+    };
+    auto remove_edges = [&](uint32_t poly_idx) {
+        for (size_t i = 0; i < polys[poly_idx].verts.size(); i++) {
+            auto it = edge_lut.find(get_edge_key(poly_idx, i));
+            if (it != edge_lut.end() && it->second == poly_idx)
+                edge_lut.erase(it);
+        }
+    };
+    for (uint32_t i = 0; i < polys.size(); i++)
+        add_edges(i);
+
+    std::vector<uint32_t> merged;
+    for (uint32_t p_idx = 0; p_idx < polys.size(); p_idx++) {
+        Poly& p = polys[p_idx];
+        // Keep merging neighbors into p until none fit anymore
+        bool merged_any = true;
+        while (merged_any) {
+            merged_any = false;
+            for (size_t i = 0; i < p.verts.size(); i++) {
+                uint32_t a = p.verts[i];
+                uint32_t b = p.verts[(i + 1) % p.verts.size()];
+                auto it = edge_lut.find(EdgeKey{ b, a, p.plane_idx });
+                if (it == edge_lut.end())
+                    continue;
+                uint32_t q_idx = it->second;
+                Poly& q = polys[q_idx];
+                if (q_idx == p_idx || !q.alive)
+                    continue;
+                if (!TryMergePolys(p.verts, i, q.verts, positions, num_poly_refs,
+                                   plane_normals[p.plane_idx], merged))
+                    continue;
+
+                for (uint32_t v : p.verts) num_poly_refs[v]--;
+                for (uint32_t v : q.verts) num_poly_refs[v]--;
+                for (uint32_t v : merged)  num_poly_refs[v]++;
+                remove_edges(p_idx);
+                remove_edges(q_idx);
+                q.alive = false;
+                q.verts = {};
+                p.verts = merged;
+                add_edges(p_idx);
+                merged_any = true;
+                break;
+            }
+        }
+    }
+    edge_lut = {};
+
+    // Straight corners that were kept during a merge might not be used by any
+    // other polygon anymore after later merges
+    for (Poly& poly : polys) {
+        if (!poly.alive)
+            continue;
+        std::vector<uint32_t>& verts = poly.verts;
+        const Vector3& normal = plane_normals[poly.plane_idx];
+        for (size_t i = 0; i < verts.size() && verts.size() > 3; ) {
+            const size_t n = verts.size();
+            Corner corner = ClassifyCorner(positions[verts[(i + n - 1) % n]],
+                                           positions[verts[i]],
+                                           positions[verts[(i + 1) % n]], normal);
+            if (corner == Corner::STRAIGHT && num_poly_refs[verts[i]] == 1) {
+                num_poly_refs[verts[i]]--;
+                verts.erase(verts.begin() + i);
+            }
+            else {
+                i++;
+            }
+        }
+    }
+
+    // ----- Triangulate, vertices are shared within each plane
+    FlatIndexedMesh mesh;
+    std::unordered_map<uint64_t, uint32_t> vertex_lut; // (position, plane) -> vertex
+    auto get_vertex = [&](uint32_t pos_idx, uint32_t plane_idx) {
+        auto [it, inserted] = vertex_lut.try_emplace(
+            PackPair(pos_idx, plane_idx), (uint32_t)mesh.vertices.size());
+        if (inserted)
+            mesh.vertices.push_back({ positions[pos_idx], plane_normals[plane_idx] });
+        return it->second;
+    };
+    for (Poly& poly : polys) {
+        if (!poly.alive)
+            continue;
+        TriangulateConvexPoly(poly.verts, positions, plane_normals[poly.plane_idx],
+            [&](uint32_t pos0, uint32_t pos1, uint32_t pos2) {
+                mesh.indices.push_back(get_vertex(pos0, poly.plane_idx));
+                mesh.indices.push_back(get_vertex(pos1, poly.plane_idx));
+                mesh.indices.push_back(get_vertex(pos2, poly.plane_idx));
+            });
+    }
+
+    OptimizeVertexCacheOrder(mesh.indices, mesh.vertices.size());
+    OptimizeVertexFetchOrder(mesh);
+
+    s.num_tris_after  = mesh.indices.size() / 3;
+    s.num_verts_after = mesh.vertices.size();
+    if (stats)
+        *stats = s;
+    return mesh;
+}
+
+// -------- start of Forsyth's vertex cache optimization --------
+// (see https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html)
+static const int   VCACHE_SIZE = 32;
+static const float VCACHE_DECAY_POWER   = 1.5f;
+static const float LAST_TRI_SCORE       = 0.75f;
+static const float VALENCE_BOOST_SCALE  = 2.0f;
+static const float VALENCE_BOOST_POWER  = 0.5f;
+
+static float CalcVertexScore(int cache_pos, uint32_t num_remaining_tris)
+{
+    if (num_remaining_tris == 0)
+        return -1.0f; // No triangle needs this vertex anymore
+
+    float score = 0.0f;
+    if (cache_pos >= 0) {
+        if (cache_pos < 3) {
+            // This vertex was used in the last triangle, so it has a fixed
+            // score, whichever of the three it's in.
+            score = LAST_TRI_SCORE;
+        }
+        else {
+            // Points for being high in the cache
+            const float scaler = 1.0f / (VCACHE_SIZE - 3);
+            score = 1.0f - (cache_pos - 3) * scaler;
+            score = std::pow(score, VCACHE_DECAY_POWER);
+        }
+    }
+    // Bonus points for having a low number of tris still to use the vertex,
+    // so we get rid of lone verts quickly
+    float valence_boost = std::pow((float)num_remaining_tris, -VALENCE_BOOST_POWER);
+    score += VALENCE_BOOST_SCALE * valence_boost;
+    return score;
+}
+// -------- end of Forsyth's vertex cache optimization --------
+
+void ren::OptimizeVertexCacheOrder(std::vector<uint32_t>& indices, size_t num_vertices)
+{
+    ZoneScoped;
+    const size_t num_tris = indices.size() / 3;
+    if (num_tris == 0)
+        return;
+
+    // Remaining triangles of each vertex, the first num_remaining_tris[v]
+    // entries of vertex v's range are the ones not emitted yet
+    std::vector<uint32_t> first_vert_tri(num_vertices + 1, 0);
+    for (uint32_t v : indices)
+        first_vert_tri[v + 1]++;
+    for (size_t v = 0; v < num_vertices; v++)
+        first_vert_tri[v + 1] += first_vert_tri[v];
+    std::vector<uint32_t> vert_tris(indices.size());
+    std::vector<uint32_t> num_remaining_tris(num_vertices, 0);
+    for (uint32_t t = 0; t < num_tris; t++) {
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = indices[3 * t + k];
+            vert_tris[first_vert_tri[v] + num_remaining_tris[v]++] = t;
+        }
+    }
+
+    std::vector<int>   cache_pos (num_vertices, -1);
+    std::vector<float> vert_score(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++)
+        vert_score[v] = CalcVertexScore(-1, num_remaining_tris[v]);
+    std::vector<float> tri_score(num_tris);
+    std::vector<bool>  tri_emitted(num_tris, false);
+    for (size_t t = 0; t < num_tris; t++)
+        tri_score[t] = vert_score[indices[3 * t + 0]]
+                     + vert_score[indices[3 * t + 1]]
+                     + vert_score[indices[3 * t + 2]];
+
+    // Updates a vertex's score and the scores of its remaining triangles
+    auto update_vertex = [&](uint32_t v) {
+        float new_score = CalcVertexScore(cache_pos[v], num_remaining_tris[v]);
+        float delta = new_score - vert_score[v];
+        vert_score[v] = new_score;
+        for (uint32_t i = 0; i < num_remaining_tris[v]; i++)
+            tri_score[vert_tris[first_vert_tri[v] + i]] += delta;
+    };
+
+    std::vector<uint32_t> new_indices;
+    new_indices.reserve(indices.size());
+    uint32_t cache[VCACHE_SIZE + 3];
+    uint32_t new_cache[VCACHE_SIZE + 3];
+    int cache_len = 0;
+    size_t next_unemitted_tri = 0; // For when no cached vertex has triangles left
+
+    int64_t best_tri = std::max_element(tri_score.begin(), tri_score.end()) - tri_score.begin();
+    for (size_t num_emitted = 0; num_emitted < num_tris; num_emitted++) {
+        if (best_tri < 0) {
+            while (tri_emitted[next_unemitted_tri])
+                next_unemitted_tri++;
+            best_tri = next_unemitted_tri;
+        }
+
+        // Emit triangle
+        tri_emitted[best_tri] = true;
+        const uint32_t* tri_verts = &indices[3 * best_tri];
+        for (int k = 0; k < 3; k++) {
+            uint32_t v = tri_verts[k];
+            new_indices.push_back(v);
+            // Remove triangle from the vertex's remaining triangles
+            uint32_t* remaining = &vert_tris[first_vert_tri[v]];
+            uint32_t* last = remaining + num_remaining_tris[v] - 1;
+            uint32_t* it = std::find(remaining, last + 1, (uint32_t)best_tri);
+            if (it != last + 1) {
+                std::swap(*it, *last);
+                num_remaining_tris[v]--;
+            }
+        }
+
+        // Move the triangle's vertices to the front of the LRU cache
+        int new_cache_len = 0;
+        for (int k = 0; k < 3; k++)
+            new_cache[new_cache_len++] = tri_verts[k];
+        for (int i = 0; i < cache_len; i++)
+            if (cache[i] != tri_verts[0] && cache[i] != tri_verts[1] && cache[i] != tri_verts[2])
+                new_cache[new_cache_len++] = cache[i];
+        for (int i = VCACHE_SIZE; i < new_cache_len; i++) { // Evicted vertices
+            cache_pos[new_cache[i]] = -1;
+            update_vertex(new_cache[i]);
+        }
+        cache_len = std::min(new_cache_len, VCACHE_SIZE);
+        for (int i = 0; i < cache_len; i++) {
+            cache[i] = new_cache[i];
+            cache_pos[cache[i]] = i;
+        }
+        for (int i = 0; i < cache_len; i++)
+            update_vertex(cache[i]);
+
+        // Next triangle is the best one that uses a cached vertex
+        best_tri = -1;
+        float best_score = -1.0f;
+        for (int i = 0; i < cache_len; i++) {
+            uint32_t v = cache[i];
+            for (uint32_t j = 0; j < num_remaining_tris[v]; j++) {
+                uint32_t t = vert_tris[first_vert_tri[v] + j];
+                if (tri_score[t] > best_score) {
+                    best_score = tri_score[t];
+                    best_tri = t;
+                }
+            }
+        }
+    }
+    indices = std::move(new_indices);
+}
+
+void ren::OptimizeVertexFetchOrder(FlatIndexedMesh& mesh)
+{
+    ZoneScoped;
+    std::vector<uint32_t> remap(mesh.vertices.size(), UINT32_MAX);
+    std::vector<FlatIndexedMesh::Vertex> new_vertices;
+    new_vertices.reserve(mesh.vertices.size());
+    for (uint32_t& idx : mesh.indices) {
+        if (remap[idx] == UINT32_MAX) {
+            remap[idx] = (uint32_t)new_vertices.size();
+            new_vertices.push_back(mesh.vertices[idx]);
+        }
+        idx = remap[idx];
+    }
+    mesh.vertices = std::move(new_vertices); // Drops unused vertices
+}
@@ -0,0 +1,55 @@
+#ifndef REN_MESHSIMPLIFICATION_H_
+#define REN_MESHSIMPLIFICATION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "utils_3d.h"
+
+namespace ren {
+
+// Indexed triangle mesh with one normal per vertex. Vertices are only shared
+// between triangles that lie in the same plane.
+struct FlatIndexedMesh {
+    struct Vertex { // Same layout as GenericGL3D Position + Normal attributes
+        Magnum::Vector3 position;
+        Magnum::Vector3 normal;
+    };
+    std::vector<Vertex>   vertices;
+    std::vector<uint32_t> indices; // 3 per triangle, clockwise vertex winding
+};
+
+struct MeshSimplificationStats {
+    size_t num_tris_before  = 0;
+    size_t num_verts_before = 0; // Of the unindexed mesh, 3 per triangle
+    size_t num_tris_after   = 0;
+    size_t num_verts_after  = 0;
+};
+
+// Creates an indexed mesh from convex faces with clockwise vertex winding,
+// e.g. from BspMap::GetBrushFaceVertices(). On the way:
+//   - Nearly identical vertices are welded
+//   - Adjacent coplanar faces are merged as long as they stay convex
+//   - Triangles are reordered for the GPU's post-transform vertex cache
+//   - Vertices are reordered by first use for better vertex fetch locality
+// When two faces get merged, the ends of their shared edge are removed if they
+// became redundant and no other face uses them. Vertices that other faces
+// still use are kept, so merging doesn't create new T-junctions.
+// Note that per-vertex shading gets interpolated across merged faces.
+FlatIndexedMesh CreateSimplifiedFlatMesh(
+    const utils_3d::FaceBuffer& faces,
+    MeshSimplificationStats* stats = nullptr);
+
+// Reorders triangles to reduce post-transform vertex cache misses, using
+// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+void OptimizeVertexCacheOrder(std::vector<uint32_t>& indices, size_t num_vertices);
+
+// Reorders vertices by the order of their first use in the index buffer.
+void OptimizeVertexFetchOrder(FlatIndexedMesh& mesh);
+
+} // namespace ren
+
+#endif // REN_MESHSIMPLIFICATION_H_
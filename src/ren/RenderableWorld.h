@@ -1,6 +1,7 @@
 #ifndef REN_RENDERABLEWORLD_H_
 #define REN_RENDERABLEWORLD_H_
 
+#include <cstddef>
 #include <map>
 #include <vector>
 
@@ -9,27 +10,42 @@
 #include <Magnum/Tags.h>
 
 #include "csgo_parsing/BrushSeparation.h"
+#include "ren/CompactVertexFormat.h"
 
 // Forward-declare WorldCreator outside namespace to avoid ambiguity
 class WorldCreator;
 
 namespace ren {
 
+// Mesh drawn with GlidabilityShader3D, with the info needed to decode its
+// vertices
+struct WorldMesh {
+    Magnum::GL::Mesh mesh{ Magnum::NoCreate };
+    VertexDecoding   decoding;
+    size_t num_vertices        = 0;
+    size_t vertex_buffer_bytes = 0;
+};
+
 class RenderableWorld { // Map-specific rendering-related data container
 public:
     // Mesh for each brush category
-    std::map<csgo_parsing::BrushSeparation::Category, Magnum::GL::Mesh>
+    std::map<csgo_parsing::BrushSeparation::Category, WorldMesh>
         brush_category_meshes;
 
     // Mesh of all trigger_push entities that can push players
-    Magnum::GL::Mesh trigger_push_meshes         { Magnum::NoCreate };
+    WorldMesh trigger_push_meshes;
 
     // Displacement meshes
-    Magnum::GL::Mesh mesh_displacements          { Magnum::NoCreate };
+    WorldMesh        mesh_displacements;
     Magnum::GL::Mesh mesh_displacement_boundaries{ Magnum::NoCreate };
 
     // Collision model meshes of solid props (static or dynamic)
-    std::vector<Magnum::GL::Mesh> instanced_xprop_meshes;
+    std::vector<WorldMesh> instanced_xprop_meshes;
+
+    // Total vertex buffer size of all WorldMesh objects, and what it would be
+    // with uncompressed float vertices
+    size_t vertex_buffer_bytes       = 0;
+    size_t float_vertex_buffer_bytes = 0;
 
 
 private:
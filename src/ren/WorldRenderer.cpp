@@ -113,7 +113,8 @@ void WorldRenderer::Draw(std::shared_ptr<RenderableWorld> ren_world,
         .SetOverrideColor(gui::CvtImguiCol4(_gui_state.vis.IN_col_solid_displacements))
         .SetColorOverrideEnabled(glidability_vis_globally_disabled)
         .SetDiffuseLightingEnabled(has_world_diffuse_lighting)
-        .draw(ren_world->mesh_displacements);
+        .SetVertexDecoding(ren_world->mesh_displacements.decoding)
+        .draw(ren_world->mesh_displacements.mesh);
 
     // Draw displacement boundaries
     if (_gui_state.vis.IN_draw_displacement_edges)
@@ -125,6 +126,7 @@ void WorldRenderer::Draw(std::shared_ptr<RenderableWorld> ren_world,
     // Draw bump mines - they're currently the only thing drawn with CCW vertex winding
     // TODO use instancing?
     GL::Renderer::setFrontFace(GL::Renderer::FrontFace::CounterClockWise);
+    _glid_shader_non_instanced.SetVertexDecoding(VertexDecoding{});
     for (const sim::Entities::BumpmineProjectile& bm : bump_mines) {
         Matrix4 model_transformation_1 =
             utils_3d::CalcModelTransformationMatrix(bm.position, bm.angles,
@@ -162,8 +164,10 @@ void WorldRenderer::Draw(std::shared_ptr<RenderableWorld> ren_world,
         .SetColorOverrideEnabled(glidability_vis_globally_disabled)
         .SetOverrideColor(gui::CvtImguiCol4(_gui_state.vis.IN_col_solid_xprops))
         .SetDiffuseLightingEnabled(has_world_diffuse_lighting);
-    for (GL::Mesh& instanced_xprop_mesh : ren_world->instanced_xprop_meshes) {
-        _glid_shader_instanced.draw(instanced_xprop_mesh);
+    for (WorldMesh& instanced_xprop_mesh : ren_world->instanced_xprop_meshes) {
+        _glid_shader_instanced
+            .SetVertexDecoding(instanced_xprop_mesh.decoding)
+            .draw(instanced_xprop_mesh.mesh);
     }
 
     // TRANSPARENT BRUSHES MUST BE THE LAST THINGS BEING DRAWN
@@ -228,7 +232,8 @@ void WorldRenderer::Draw(std::shared_ptr<RenderableWorld> ren_world,
             .SetOverrideColor(gui::CvtImguiCol4(b_col))
             .SetColorOverrideEnabled(visualize_glidability == false)
             .SetDiffuseLightingEnabled(has_brush_mesh_diffuse_lighting)
-            .draw(ren_world->brush_category_meshes[b_cat]);
+            .SetVertexDecoding(ren_world->brush_category_meshes[b_cat].decoding)
+            .draw(ren_world->brush_category_meshes[b_cat].mesh);
     }
 
     // ANYTHING BEING DRAWN AFTER HERE WILL NOT BE VISIBLE BEHIND
@@ -244,6 +249,7 @@ void WorldRenderer::Draw(std::shared_ptr<RenderableWorld> ren_world,
             .SetOverrideColor(gui::CvtImguiCol4(_gui_state.vis.IN_col_trigger_push))
             .SetColorOverrideEnabled(true)
             .SetDiffuseLightingEnabled(true)
-            .draw(ren_world->trigger_push_meshes);
+            .SetVertexDecoding(ren_world->trigger_push_meshes.decoding)
+            .draw(ren_world->trigger_push_meshes.mesh);
 
 }
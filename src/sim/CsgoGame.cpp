@@ -8,7 +8,9 @@
 #include <Magnum/Math/TimeStl.h>
 #include <Tracy.hpp>
 
+#include "coll/TraceProfiler.h"
 #include "common.h"
+#include "GlobalVars.h"
 #include "sim/PlayerInput.h"
 #include "sim/Sim.h"
 #include "sim/WorldState.h"
@@ -20,6 +22,16 @@ using namespace Magnum::Math::Literals;
 // Should be enabled, toggleable for debugging purposes
 const bool ENABLE_INTERPOLATION_OF_DRAWN_WORLDSTATE = true;
 
+// Must be called once whenever a game tick gets finalized. Game ticks are
+// simulated more than once (predictions get re-simulated with new player
+// input), so this can't be done in WorldState::AdvanceSimulation().
+static void OnGameTickFinalized()
+{
+    coll::TraceProfiler::OnTickFinished();
+    if (g_coll_world)
+        g_coll_world->OnSimulationTickFinished();
+}
+
 CsgoGame::CsgoGame()
     : m_simtime_step_size{ 0.0_sec } // 0 indicates that game isn't started
     , m_realtime_game_tick_interval{}
@@ -64,7 +76,7 @@ void CsgoGame::Start(SimTimeDur simtime_step_size, float simtime_scale,
     //               m_prev_predicted_game_tick as invalid and only simulate it
     //               on-demand inside ProcessNewPlayerInput().
     m_prev_predicted_game_tick = initial_worldstate;
-    m_prev_predicted_game_tick.AdvanceSimulation(simtime_step_size, {});
+    m_prev_predicted_game_tick.AdvanceSimulation(simtime_step_size, {, &m_player_trace_cache);
 
     m_prev_drawable_worldstate = initial_worldstate;
     m_prev_drawable_worldstate_timepoint = current_realtime;
@@ -87,7 +99,7 @@ void CsgoGame::ModifyWorldStateHarshly(const std::function<void(WorldState&)>& f
     //               m_prev_predicted_game_tick as invalid and only simulate it
     //               on-demand inside ProcessNewPlayerInput().
     m_prev_predicted_game_tick = m_prev_finalized_game_tick;
-    m_prev_predicted_game_tick.AdvanceSimulation(m_simtime_step_size, {});
+    m_prev_predicted_game_tick.AdvanceSimulation(m_simtime_step_size, {, &m_player_trace_cache);
 
     m_prev_drawable_worldstate = m_prev_finalized_game_tick;
     m_prev_drawable_worldstate_timepoint =
@@ -135,14 +147,16 @@ void CsgoGame::ProcessNewPlayerInput(const PlayerInput::State& new_input)
         m_prev_finalized_game_tick = std::move(m_prev_predicted_game_tick);
         m_prev_finalized_game_tick_id++;
         m_inputs_since_prev_finalized_game_tick.clear();
+        OnGameTickFinalized();
     }
 
     // Next, possibly advance by additional # of game ticks.
     // These additional game ticks have passed completely without any calls to
     // ProcessNewPlayerInput(), so they receive no player input.
     while (m_prev_finalized_game_tick_id < directly_preceding_game_tick_id) {
-        m_prev_finalized_game_tick.AdvanceSimulation(m_simtime_step_size, {});
+        m_prev_finalized_game_tick.AdvanceSimulation(m_simtime_step_size, {, &m_player_trace_cache);
         m_prev_finalized_game_tick_id++;
+        OnGameTickFinalized();
     }
     // NOTE: m_prev_predicted_game_tick has now become invalid if we advanced by
     //       one or more ticks.
@@ -153,7 +167,8 @@ void CsgoGame::ProcessNewPlayerInput(const PlayerInput::State& new_input)
 
     WorldState predicted_next_game_tick = m_prev_finalized_game_tick;
     predicted_next_game_tick.AdvanceSimulation(m_simtime_step_size,
-                                               m_inputs_since_prev_finalized_game_tick);
+                                               m_inputs_since_prev_finalized_game_tick,
+                                               &m_player_trace_cache);
 
     WallClock::time_point next_game_tick_timepoint =
         GetGameTickRealTimePoint(m_prev_finalized_game_tick_id + 1);
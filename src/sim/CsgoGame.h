@@ -6,6 +6,7 @@
 
 #include <Magnum/Math/Time.h>
 
+#include "coll/TraceCache.h"
 #include "common.h"
 #include "sim/PlayerInput.h"
 #include "sim/Sim.h"
@@ -88,6 +89,9 @@ private:
     // The most recent drawable worldstate and its realtime time point.
     WorldState            m_prev_drawable_worldstate;
     WallClock::time_point m_prev_drawable_worldstate_timepoint;
+
+    // Used for the player's movement traces of all simulated world states
+    coll::TraceCache m_player_trace_cache;
 };
 
 } // namespace sim
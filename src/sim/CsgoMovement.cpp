@@ -8,6 +8,7 @@
 #include <Magnum/Math/Functions.h>
 
 #include "coll/Trace.h"
+#include "coll/TraceProfiler.h"
 #include "GlobalVars.h"
 #include "sim/CsgoConstants.h"
 #include "sim/PlayerInput.h"
@@ -229,6 +230,16 @@ CsgoMovement::CsgoMovement()
     //memset(m_flStuckCheckTime, 0, sizeof(m_flStuckCheckTime));
 }
 
+void CsgoMovement::SetDuckStateInstantly(bool ducked)
+{
+    if (ducked) m_fFlags |=  FL_DUCKING;
+    else        m_fFlags &= ~FL_DUCKING;
+    m_bDucked = ducked;
+    m_bDucking = false;
+    m_flDucktime = 0.0f;
+    m_vecViewOffset = GetPlayerViewOffset(ducked);
+}
+
 Vector3 CsgoMovement::GetPlayerMins(bool ducked) const
 {
     // GENERAL REMINDER: When copying source-sdk-2013 code like `vec1 == vec2`,
@@ -722,6 +733,9 @@ void CsgoMovement::StayOnGround()
     // GENERAL REMINDER: When copying source-sdk-2013 code like `vec1 == vec2`,
     //                   replace it with `SourceSdkVectorEqual(vec1, vec2)`!
 
+    TraceProfiler::ScopedCallSite profiler_call_site{
+        TraceProfiler::CallSite::StayOnGround };
+
     Vector3 start = m_vecAbsOrigin;
     Vector3 end = m_vecAbsOrigin;
     start.z() += 2;
@@ -1130,6 +1144,9 @@ int CsgoMovement::TryPlayerMove(float frametime,
     // GENERAL REMINDER: When copying source-sdk-2013 code like `vec1 == vec2`,
     //                   replace it with `SourceSdkVectorEqual(vec1, vec2)`!
 
+    TraceProfiler::ScopedCallSite profiler_call_site{
+        TraceProfiler::CallSite::TryPlayerMove };
+
     int     bumpcount, numbumps;
     Vector3 dir;
     float   d;
@@ -1492,6 +1509,9 @@ std::tuple<bool, int16_t> CsgoMovement::TryTouchGroundInQuadrants(const Vector3&
     // GENERAL REMINDER: When copying source-sdk-2013 code like `vec1 == vec2`,
     //                   replace it with `SourceSdkVectorEqual(vec1, vec2)`!
 
+    TraceProfiler::ScopedCallSite profiler_call_site{
+        TraceProfiler::CallSite::TryTouchGroundInQuadrants };
+
     Vector3 mins, maxs;
     Vector3 minsSrc = GetPlayerMins();
     Vector3 maxsSrc = GetPlayerMaxs();
@@ -1553,6 +1573,9 @@ void CsgoMovement::CategorizePosition(float frametime)
     // GENERAL REMINDER: When copying source-sdk-2013 code like `vec1 == vec2`,
     //                   replace it with `SourceSdkVectorEqual(vec1, vec2)`!
 
+    TraceProfiler::ScopedCallSite profiler_call_site{
+        TraceProfiler::CallSite::CategorizePosition };
+
     // Reset this each time we-recategorize, otherwise we have bogus friction when we jump into water and plunge downward really quickly
     m_surfaceFriction = 1.0f;
 
@@ -1752,6 +1775,9 @@ void CsgoMovement::CheckFalling(void)
 
 bool CsgoMovement::CanUnduck()
 {
+    TraceProfiler::ScopedCallSite profiler_call_site{
+        TraceProfiler::CallSite::CanUnduck };
+
     Vector3 newOrigin = m_vecAbsOrigin;
 
     if (!m_hGroundEntity)
@@ -2299,7 +2325,7 @@ Trace CsgoMovement::TracePlayerBBox(const Vector3& start, const Vector3& end)
     //   collisionGroup == COLLISION_GROUP_PLAYER_MOVEMENT
 
     Trace tr{ start, end, GetPlayerMins(), GetPlayerMaxs() };
-    g_coll_world->DoTrace(&tr);
+    g_coll_world->DoTrace(&tr, m_traceCache);
     return tr;
 }
 
@@ -2313,7 +2339,7 @@ Trace CsgoMovement::TryTouchGround(const Vector3& start, const Vector3& end, con
     //   collisionGroup == COLLISION_GROUP_PLAYER_MOVEMENT
 
     Trace tr{ start, end, mins, maxs };
-    g_coll_world->DoTrace(&tr);
+    g_coll_world->DoTrace(&tr, m_traceCache);
     return tr;
 }
 
@@ -7,6 +7,7 @@
 #include <Magnum/Math/Vector3.h>
 
 #include "coll/Trace.h"
+#include "coll/TraceCache.h"
 #include "sim/Entities/Player.h"
 #include "sim/Sim.h"
 
@@ -105,12 +106,21 @@ public:
     
     float m_surfaceFriction = 1.0f;
 
+    // Optional, speeds up the many near-identical traces of this player's
+    // movement. Not owned, only set during WorldState::AdvanceSimulation().
+    coll::TraceCache* m_traceCache = nullptr;
+
 
     ////////////////////////////////////////////////////////////////////////////
     ////////////////////////////////////////////////////////////////////////////
 
     CsgoMovement();
 
+    // Instantly sets whether the player is fully ducked or fully unducked,
+    // without a ducking transition and without changing the player's origin.
+    // Useful to adopt a movement state observed in CSGO.
+    void SetDuckStateInstantly(bool ducked);
+
     Magnum::Vector3 GetPlayerMins(bool ducked) const;
     Magnum::Vector3 GetPlayerMaxs(bool ducked) const;
     Magnum::Vector3 GetPlayerViewOffset(bool ducked) const;
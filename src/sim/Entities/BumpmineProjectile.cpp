@@ -8,6 +8,7 @@
 
 #include "coll/CollidableWorld.h"
 #include "coll/Trace.h"
+#include "coll/TraceProfiler.h"
 #include "GlobalVars.h"
 #include "sim/CsgoConstants.h"
 #include "sim/Sim.h"
@@ -36,6 +37,8 @@ void BumpmineProjectile::AdvanceSimulation(SimTimeDur simtime_delta,
     if (!is_on_surface) {
         Vector3 pos_delta = time_delta_sec * velocity;
         coll::Trace tr{ position, position + pos_delta, BM_MINS, BM_MAXS };
+        coll::TraceProfiler::ScopedCallSite profiler_call_site{
+            coll::TraceProfiler::CallSite::BumpMine };
         g_coll_world->DoTrace(&tr); // FIXME Don't trace against player clips!
 
         if (!tr.results.DidHit()) { // If Bump Mine hasn't hit any surface
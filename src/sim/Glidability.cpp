@@ -0,0 +1,337 @@
+#include "sim/Glidability.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Tracy.hpp>
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector2.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "coll/SimdMath.h"
+#include "sim/CsgoConfig.h"
+#include "sim/CsgoConstants.h"
+
+using namespace sim;
+using namespace Magnum;
+using namespace coll; // For SIMD math
+
+// NOTE: Keep this code in sync with res/shaders/GlidabilityShader3D.vert !
+
+// How close post-collision z velocity must be to the ground check limit for
+// warn_amount to become non-zero, relative to the limit
+static const float WARN_ZONE = 0.6f;
+
+static const Glidability SLIDE_FAIL = {
+    .success = false, .glidability = 0.0f, .warn_amount = 0.0f
+};
+
+GlidabilityParams GlidabilityParams::FromConfig(const CsgoConfig& cfg)
+{
+    return {
+        .gravity                    = cfg.sv_gravity,
+        .min_no_ground_checks_vel_z = CSGO_MIN_NO_GROUND_CHECKS_VEL_Z,
+        .max_vel                    = cfg.sv_maxvelocity,
+        .standable_normal           = cfg.sv_standable_normal,
+    };
+}
+
+// -------- start of source-sdk-2013 code --------
+// (taken and modified from source-sdk-2013/<...>/src/game/shared/gamemovement.cpp)
+static Vector3 ClipVelocity(const Vector3& obj_vel, const Vector3& surface_normal)
+{
+    const float overbounce = 1.0f;
+
+    // Determine how far along plane to slide based on incoming direction.
+    float backoff = Math::dot(obj_vel, surface_normal) * overbounce;
+    Vector3 clipped_vel = obj_vel - (backoff * surface_normal);
+
+    // Iterate once to make sure we aren't still moving through the plane
+    float adjust = Math::dot(clipped_vel, surface_normal);
+    if (adjust < 0.0f)
+        clipped_vel -= adjust * surface_normal;
+
+    return clipped_vel;
+}
+// --------- end of source-sdk-2013 code ---------
+
+Glidability sim::EvaluateImpact(const GlidabilityParams& params,
+                                const Vector3& impact_vel,
+                                const Vector3& surface_normal)
+{
+    // If cosine of the angle between surface normal and incoming player
+    // direction is positive, the player approaches the surface from behind
+    if (Math::dot(impact_vel, surface_normal) > 0.0f)
+        return SLIDE_FAIL;
+
+    // Velocity vector of player after the collision
+    Vector3 post_coll_vel = ClipVelocity(impact_vel, surface_normal);
+
+    // We want to move upwards after surface collisions
+    if (post_coll_vel.z() < 0.0f)
+        return SLIDE_FAIL;
+
+    float warn_amount = 0.0f;
+
+    // If ground is standable
+    const float min_vel_z = params.min_no_ground_checks_vel_z;
+    if (surface_normal.z() > params.standable_normal) {
+        // If our z velocity is too small, the rampslide fails
+        if (post_coll_vel.z() < min_vel_z)
+            return SLIDE_FAIL;
+        // If we are close to being ground checked -> warning
+        if (post_coll_vel.z() < (1.0f + WARN_ZONE) * min_vel_z) {
+            warn_amount = 1.0f -
+                ((post_coll_vel.z() - min_vel_z) / (WARN_ZONE * min_vel_z));
+        }
+    }
+
+    float glidability = post_coll_vel.length() / impact_vel.length();
+    if (glidability > 1.0f)
+        glidability = 1.0f;
+    if (glidability < 0.2f)
+        glidability = 0.2f;
+
+    return { .success = true, .glidability = glidability,
+             .warn_amount = warn_amount };
+}
+
+Glidability sim::EvaluateTrajectory(const GlidabilityParams& params,
+                                    const Vector3& player_pos,
+                                    float player_speed_hori,
+                                    const Vector3& surface_pos,
+                                    const Vector3& surface_normal)
+{
+    // Calculate trajectory of player ending up in the surface position
+    Vector2 hori_vec = surface_pos.xy() - player_pos.xy();
+    float vert_dist = surface_pos.z() - player_pos.z();
+    float hori_dist = hori_vec.length();
+    if (hori_dist < 0.01f) // Avoid division by zero
+        return SLIDE_FAIL;
+    float impact_time = hori_dist / player_speed_hori;
+
+    float initial_upwards_speed =
+        (vert_dist + 0.5f * params.gravity * impact_time * impact_time)
+        / impact_time;
+
+    // Abort if vertical speed becomes illegally high
+    if (std::abs(initial_upwards_speed) > params.max_vel)
+        return SLIDE_FAIL;
+
+    Vector2 vel_hori = player_speed_hori * (hori_vec / hori_dist);
+    float impact_speed_vert = -params.gravity * impact_time + initial_upwards_speed;
+    Vector3 impact_vec = { vel_hori.x(), vel_hori.y(), impact_speed_vert };
+
+    return EvaluateImpact(params, impact_vec, surface_normal);
+}
+
+static COLL_SIMD_INLINE fltx4 Dot(const FourVectors& a, const FourVectors& b)
+{
+    return AddSIMD(AddSIMD(MulSIMD(a.x, b.x), MulSIMD(a.y, b.y)),
+                   MulSIMD(a.z, b.z));
+}
+
+// SIMD version of EvaluateImpact(). Lanes set in fail_mask are reported as
+// failures. Writes results of the first 'count' lanes.
+static void EvaluateImpactsX4(const GlidabilityParams& params,
+                              const FourVectors& impact_vel,
+                              const FourVectors& normal, fltx4 fail_mask,
+                              Glidability* results, size_t count)
+{
+    const fltx4 zero = Four_Zeros();
+    const fltx4 one  = Four_Ones();
+
+    // If cosine of the angle between surface normal and incoming player
+    // direction is positive, the player approaches the surface from behind
+    fltx4 backoff = Dot(impact_vel, normal);
+    fail_mask = OrSIMD(fail_mask, CmpGtSIMD(backoff, zero));
+
+    // ClipVelocity() with an overbounce of 1
+    FourVectors post_coll_vel = impact_vel;
+    post_coll_vel.x = SubSIMD(post_coll_vel.x, MulSIMD(backoff, normal.x));
+    post_coll_vel.y = SubSIMD(post_coll_vel.y, MulSIMD(backoff, normal.y));
+    post_coll_vel.z = SubSIMD(post_coll_vel.z, MulSIMD(backoff, normal.z));
+    fltx4 adjust = Dot(post_coll_vel, normal);
+    adjust = AndSIMD(CmpLtSIMD(adjust, zero), adjust); // Only if negative
+    post_coll_vel.x = SubSIMD(post_coll_vel.x, MulSIMD(adjust, normal.x));
+    post_coll_vel.y = SubSIMD(post_coll_vel.y, MulSIMD(adjust, normal.y));
+    post_coll_vel.z = SubSIMD(post_coll_vel.z, MulSIMD(adjust, normal.z));
+
+    // We want to move upwards after surface collisions
+    fail_mask = OrSIMD(fail_mask, CmpLtSIMD(post_coll_vel.z, zero));
+
+    // On standable ground, too small z velocities lead to ground checks
+    const fltx4 min_vel_z = ReplicateX4(params.min_no_ground_checks_vel_z);
+    fltx4 standable = CmpGtSIMD(normal.z, ReplicateX4(params.standable_normal));
+    fail_mask = OrSIMD(fail_mask,
+        AndSIMD(standable, CmpLtSIMD(post_coll_vel.z, min_vel_z)));
+
+    fltx4 warn_zone_end = MulSIMD(ReplicateX4(1.0f + WARN_ZONE), min_vel_z);
+    fltx4 in_warn_zone = AndSIMD(standable,
+                                 CmpLtSIMD(post_coll_vel.z, warn_zone_end));
+    fltx4 warn_amount = SubSIMD(one,
+        DivSIMD(SubSIMD(post_coll_vel.z, min_vel_z),
+                MulSIMD(ReplicateX4(WARN_ZONE), min_vel_z)));
+    warn_amount = AndSIMD(in_warn_zone, warn_amount);
+
+    fltx4 glidability = DivSIMD(SqrtSIMD(Dot(post_coll_vel, post_coll_vel)),
+                                SqrtSIMD(Dot(impact_vel, impact_vel)));
+    glidability = MaskedAssign(CmpGtSIMD(glidability, one), one, glidability);
+    glidability = MaskedAssign(CmpLtSIMD(glidability, ReplicateX4(0.2f)),
+                               ReplicateX4(0.2f), glidability);
+
+    alignas(16) float glid_vals[4];
+    alignas(16) float warn_vals[4];
+    StoreAlignedSIMD(glid_vals, glidability);
+    StoreAlignedSIMD(warn_vals, warn_amount);
+    int fail_bits = TestSignSIMD(fail_mask);
+    for (size_t lane = 0; lane < count; lane++) {
+        if (fail_bits & (1 << lane))
+            results[lane] = SLIDE_FAIL;
+        else
+            results[lane] = { .success = true, .glidability = glid_vals[lane],
+                              .warn_amount = warn_vals[lane] };
+    }
+}
+
+// Loads 4 vectors starting at idx. Missing vectors at the end are replaced by
+// the last vector.
+static FourVectors LoadFourVectors(std::span<const Vector3> vecs, size_t idx)
+{
+    size_t last = vecs.size() - 1;
+    FourVectors v;
+    v.LoadAndSwizzle(vecs[idx],
+                     vecs[idx + 1 <= last ? idx + 1 : last],
+                     vecs[idx + 2 <= last ? idx + 2 : last],
+                     vecs[idx + 3 <= last ? idx + 3 : last]);
+    return v;
+}
+
+void sim::EvaluateImpacts(const GlidabilityParams& params,
+                          std::span<const Vector3> impact_vels,
+                          std::span<const Vector3> surface_normals,
+                          std::span<Glidability> results)
+{
+    assert(impact_vels.size() == surface_normals.size());
+    assert(impact_vels.size() == results.size());
+
+    for (size_t i = 0; i < results.size(); i += 4) {
+        size_t count = results.size() - i < 4 ? results.size() - i : 4;
+        EvaluateImpactsX4(params,
+                          LoadFourVectors(impact_vels, i),
+                          LoadFourVectors(surface_normals, i),
+                          Four_Zeros(), &results[i], count);
+    }
+}
+
+void sim::EvaluateTrajectories(const GlidabilityParams& params,
+                               const Vector3& player_pos,
+                               float player_speed_hori,
+                               std::span<const Vector3> surface_positions,
+                               std::span<const Vector3> surface_normals,
+                               std::span<Glidability> results)
+{
+    assert(surface_positions.size() == surface_normals.size());
+    assert(surface_positions.size() == results.size());
+
+    const fltx4 zero        = Four_Zeros();
+    const fltx4 half_grav   = ReplicateX4(0.5f * params.gravity);
+    const fltx4 neg_grav    = ReplicateX4(-params.gravity);
+    const fltx4 max_vel     = ReplicateX4(params.max_vel);
+    const fltx4 speed_hori  = ReplicateX4(player_speed_hori);
+    FourVectors player;
+    player.DuplicateVector(player_pos);
+
+    for (size_t i = 0; i < results.size(); i += 4) {
+        size_t count = results.size() - i < 4 ? results.size() - i : 4;
+
+        // Calculate trajectory of player ending up in the surface position
+        FourVectors rel_pos = LoadFourVectors(surface_positions, i);
+        rel_pos -= player;
+        fltx4 hori_dist = SqrtSIMD(AddSIMD(MulSIMD(rel_pos.x, rel_pos.x),
+                                           MulSIMD(rel_pos.y, rel_pos.y)));
+        // Avoid division by zero
+        fltx4 fail_mask = CmpLtSIMD(hori_dist, ReplicateX4(0.01f));
+        fltx4 impact_time = DivSIMD(hori_dist, speed_hori);
+
+        fltx4 initial_upwards_speed = DivSIMD(
+            AddSIMD(rel_pos.z, MulSIMD(MulSIMD(half_grav, impact_time), impact_time)),
+            impact_time);
+
+        // Abort if vertical speed becomes illegally high
+        fltx4 abs_upwards_speed = MaxSIMD(initial_upwards_speed,
+                                          SubSIMD(zero, initial_upwards_speed));
+        fail_mask = OrSIMD(fail_mask, CmpGtSIMD(abs_upwards_speed, max_vel));
+
+        FourVectors impact_vel;
+        impact_vel.x = MulSIMD(speed_hori, DivSIMD(rel_pos.x, hori_dist));
+        impact_vel.y = MulSIMD(speed_hori, DivSIMD(rel_pos.y, hori_dist));
+        impact_vel.z = AddSIMD(MulSIMD(neg_grav, impact_time), initial_upwards_speed);
+
+        EvaluateImpactsX4(params, impact_vel,
+                          LoadFourVectors(surface_normals, i),
+                          fail_mask, &results[i], count);
+    }
+}
+
+Vector3 sim::GetHeadOnImpactVelocity(const Vector3& surface_normal,
+                                     float speed_hori, float speed_vert)
+{
+    Vector2 dir = -surface_normal.xy();
+    float len = dir.length();
+    // Horizontal direction doesn't matter for horizontal surfaces
+    dir = len > 0.0f ? dir / len : Vector2{ 1.0f, 0.0f };
+    return { speed_hori * dir.x(), speed_hori * dir.y(), speed_vert };
+}
+
+GlidabilityTable sim::BakeGlidabilityTable(const GlidabilityParams& params,
+                                           std::span<const Vector3> tri_normals,
+                                           float min_speed_hori,
+                                           float max_speed_hori,
+                                           uint32_t num_speeds,
+                                           float impact_speed_vert)
+{
+    ZoneScoped;
+    assert(min_speed_hori > 0.0f && max_speed_hori >= min_speed_hori);
+    assert(num_speeds > 0);
+
+    GlidabilityTable table;
+    table.num_tris          = tri_normals.size();
+    table.num_speeds        = num_speeds;
+    table.min_speed_hori    = min_speed_hori;
+    table.speed_step        = num_speeds > 1 ?
+        (max_speed_hori - min_speed_hori) / (num_speeds - 1) : 0.0f;
+    table.impact_speed_vert = impact_speed_vert;
+    table.glidability.resize((size_t)table.num_tris * num_speeds);
+    table.warn_amount.resize((size_t)table.num_tris * num_speeds);
+
+    std::vector<Vector3>     impact_vels(tri_normals.size());
+    std::vector<Glidability> results    (tri_normals.size());
+    for (uint32_t speed_idx = 0; speed_idx < num_speeds; speed_idx++) {
+        float speed_hori = table.GetSpeed(speed_idx);
+        for (size_t i = 0; i < tri_normals.size(); i++)
+            impact_vels[i] = GetHeadOnImpactVelocity(tri_normals[i], speed_hori,
+                                                     impact_speed_vert);
+
+        EvaluateImpacts(params, impact_vels, tri_normals, results);
+
+        for (uint32_t tri_idx = 0; tri_idx < table.num_tris; tri_idx++) {
+            const Glidability& r = results[tri_idx];
+            size_t idx = table.GetIdx(tri_idx, speed_idx);
+            if (!r.success) {
+                table.glidability[idx] = 0;
+                table.warn_amount[idx] = 0;
+                continue;
+            }
+            table.glidability[idx] =
+                (uint8_t)Math::max(1.0f, std::round(255.0f * r.glidability));
+            table.warn_amount[idx] = (uint8_t)std::round(255.0f * r.warn_amount);
+        }
+    }
+    return table;
+}
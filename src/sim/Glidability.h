@@ -0,0 +1,107 @@
+#ifndef SIM_GLIDABILITY_H_
+#define SIM_GLIDABILITY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Magnum/Math/Vector3.h>
+
+#include "sim/CsgoConfig.h"
+
+// CPU implementation of the rampslide evaluation that GlidabilityShader3D.vert
+// performs per vertex. Allows glidability analysis without a GPU.
+namespace sim {
+
+// Game settings that affect glidability. Same meaning as the game setting
+// uniforms of GlidabilityShader3D.
+struct GlidabilityParams {
+    float gravity;                    // sv_gravity
+    float min_no_ground_checks_vel_z; // See CSGO_MIN_NO_GROUND_CHECKS_VEL_Z
+    float max_vel;                    // sv_maxvelocity
+    float standable_normal;           // sv_standable_normal
+
+    static GlidabilityParams FromConfig(const CsgoConfig& cfg);
+};
+
+// Outcome of a player colliding with a surface
+struct Glidability {
+    bool  success;     // Whether the player keeps sliding after the collision
+    // Only valid if success is true:
+    float glidability; // Fraction of speed kept, clamped to [0.2, 1.0]
+    float warn_amount; // From 0 to 1, how close the player came to being
+                       // ground checked (which would end the rampslide)
+};
+
+// Evaluates a player colliding with a surface at the given velocity.
+Glidability EvaluateImpact(const GlidabilityParams& params,
+                           const Magnum::Vector3& impact_vel,
+                           const Magnum::Vector3& surface_normal);
+
+// Evaluates a player starting at player_pos and moving on a ballistic
+// trajectory with the given horizontal speed, such that they hit the surface
+// at surface_pos. Identical to the shader's evaluation of a vertex.
+Glidability EvaluateTrajectory(const GlidabilityParams& params,
+                               const Magnum::Vector3& player_pos,
+                               float player_speed_hori,
+                               const Magnum::Vector3& surface_pos,
+                               const Magnum::Vector3& surface_normal);
+
+// Batch versions of the functions above that evaluate 4 surfaces at a time
+// using SIMD. All spans must have the same size.
+void EvaluateImpacts(const GlidabilityParams& params,
+                     std::span<const Magnum::Vector3> impact_vels,
+                     std::span<const Magnum::Vector3> surface_normals,
+                     std::span<Glidability> results);
+void EvaluateTrajectories(const GlidabilityParams& params,
+                          const Magnum::Vector3& player_pos,
+                          float player_speed_hori,
+                          std::span<const Magnum::Vector3> surface_positions,
+                          std::span<const Magnum::Vector3> surface_normals,
+                          std::span<Glidability> results);
+
+// Glidability of many triangles at a range of horizontal speeds, quantized to
+// bytes. Suitable for lookups, e.g. as a texture.
+struct GlidabilityTable {
+    uint32_t num_tris = 0;
+    uint32_t num_speeds = 0;
+    float    min_speed_hori = 0.0f;
+    float    speed_step = 0.0f;
+    float    impact_speed_vert = 0.0f; // See BakeGlidabilityTable()
+
+    // Indexed by (tri_idx * num_speeds + speed_idx).
+    // glidability is 0 if the rampslide fails, otherwise the glidability
+    // scaled to [1, 255]. warn_amount is scaled to [0, 255].
+    std::vector<uint8_t> glidability;
+    std::vector<uint8_t> warn_amount;
+
+    float GetSpeed(uint32_t speed_idx) const {
+        return min_speed_hori + speed_idx * speed_step;
+    }
+    size_t GetIdx(uint32_t tri_idx, uint32_t speed_idx) const {
+        return (size_t)tri_idx * num_speeds + speed_idx;
+    }
+};
+
+// Bakes a glidability table of the given triangles at num_speeds horizontal
+// speeds, evenly spaced from min_speed_hori to max_speed_hori (both > 0).
+// Since the shader's results depend on the player's position, the bake
+// evaluates a position-independent collision instead: The player hits each
+// triangle head-on (horizontally against its normal) with a vertical speed of
+// impact_speed_vert.
+GlidabilityTable BakeGlidabilityTable(const GlidabilityParams& params,
+                                      std::span<const Magnum::Vector3> tri_normals,
+                                      float min_speed_hori,
+                                      float max_speed_hori,
+                                      uint32_t num_speeds,
+                                      float impact_speed_vert = 0.0f);
+
+// Returns the velocity of a player hitting a surface with the given normal
+// head-on, i.e. moving horizontally against the normal at speed_hori.
+Magnum::Vector3 GetHeadOnImpactVelocity(const Magnum::Vector3& surface_normal,
+                                        float speed_hori, float speed_vert);
+
+} // namespace sim
+
+#endif // SIM_GLIDABILITY_H_
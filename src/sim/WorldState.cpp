@@ -75,7 +75,8 @@ WorldState WorldState::Interpolate(const WorldState& stateA,
 }
 
 void WorldState::AdvanceSimulation(SimTimeDur simtime_delta,
-                                   std::span<const PlayerInput::State> chro_input)
+                                   std::span<const PlayerInput::State> chro_input,
+                                   coll::TraceCache* player_trace_cache)
 {
     ZoneScoped;
 
@@ -191,8 +192,10 @@ void WorldState::AdvanceSimulation(SimTimeDur simtime_delta,
     csgo_mv.m_flMaxSpeed =
         g_csgo_game_sim_cfg.GetMaxPlayerRunningSpeed(player.loadout);
 
+    csgo_mv.m_traceCache = player_trace_cache;
     csgo_mv.PlayerMove(time_delta_sec);
     csgo_mv.FinishMove();
+    csgo_mv.m_traceCache = nullptr; // Don't let copies of us use the cache
     // --------- end of source-sdk-2013 code ---------
 
     // For the next call of AdvanceSimulation(), remember what player inputs we
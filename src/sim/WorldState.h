@@ -7,6 +7,7 @@
 #include <Magnum/Math/Tags.h>
 #include <Magnum/Math/Time.h>
 
+#include "coll/TraceCache.h"
 #include "sim/CsgoMovement.h"
 #include "sim/Entities/BumpmineProjectile.h"
 #include "sim/Entities/Player.h"
@@ -43,9 +44,12 @@ public:
 
     // Advance this world state with the given chronological player input
     // forward in simulation time by the given duration.
+    // player_trace_cache is optional and used for the player's movement
+    // traces. It should be owned by whoever keeps advancing this player.
     // CAUTION: Must not be called on an interpolated worldstate!
     void AdvanceSimulation(SimTimeDur simtime_delta,
-                           std::span<const PlayerInput::State> chro_input);
+                           std::span<const PlayerInput::State> chro_input,
+                           coll::TraceCache* player_trace_cache = nullptr);
 
 };
 
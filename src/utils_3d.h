@@ -1,8 +1,11 @@
 #ifndef UTILS_3D_H_
 #define UTILS_3D_H_
 
+#include <cstddef>
 #include <cstdint>
+#include <initializer_list>
 #include <limits>
+#include <span>
 #include <vector>
 
 #include <Magnum/Magnum.h>
@@ -80,6 +83,48 @@ namespace utils_3d {
 
     void DebugTestProperties_TriMesh(const TriMesh& tri_mesh);
 
+    // List of polygons (faces) whose vertices are stored in one contiguous
+    // array, avoiding one heap allocation per face. Every face has at least 3
+    // vertices.
+    struct FaceBuffer {
+        std::vector<Vector3>  vertices;
+        // Face i consists of vertices [face_offsets[i], face_offsets[i + 1])
+        std::vector<uint32_t> face_offsets = { 0 };
+
+        size_t NumFaces() const { return face_offsets.size() - 1; }
+        // Number of triangles the faces turn into when triangulated as fans
+        size_t NumTris()  const { return vertices.size() - 2 * NumFaces(); }
+
+        std::span<const Vector3> GetFace(size_t face_idx) const {
+            return { vertices.data() + face_offsets[face_idx],
+                     vertices.data() + face_offsets[face_idx + 1] };
+        }
+        std::span<Vector3> GetFace(size_t face_idx) {
+            return { vertices.data() + face_offsets[face_idx],
+                     vertices.data() + face_offsets[face_idx + 1] };
+        }
+
+        void AddFace(std::span<const Vector3> face) {
+            vertices.insert(vertices.end(), face.begin(), face.end());
+            EndFace();
+        }
+        void AddFace(std::initializer_list<Vector3> face) {
+            vertices.insert(vertices.end(), face.begin(), face.end());
+            EndFace();
+        }
+        // Finishes a face whose vertices were pushed into vertices directly
+        void EndFace() { face_offsets.push_back((uint32_t)vertices.size()); }
+
+        void Reserve(size_t num_faces, size_t num_vertices) {
+            face_offsets.reserve(num_faces + 1);
+            vertices.reserve(num_vertices);
+        }
+        void Clear() {
+            vertices.clear();
+            face_offsets.resize(1);
+        }
+    };
+
 }
 
 #endif // UTILS_3D_H_
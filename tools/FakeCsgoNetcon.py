@@ -0,0 +1,384 @@
+# Purpose of this Python script:
+#
+#    Imitate a CSGO instance that was started with "-netconport 34755" and
+#    that hosts a local server, so that DZSimulator's CSGO integration can be
+#    tested without CSGO. After DZSimulator sets up its data relay, this script
+#    sends made-up game data in the data relay's version 2 output format (see
+#    res/csgo_integration/data_relay.nut) at a fixed tick rate, together with
+#    'getpos' responses. Lost and reordered console lines can be simulated.
+#
+#    Explicit 'getpos' commands are answered as well.
+#
+#    Optionally, GSI payloads are POSTed to DZSimulator's GSI http server at a
+#    fixed rate. Besides the usual CSGO GSI data, each payload carries the
+#    CLOCK_MONOTONIC time at which it was sent, in "dzs_loadtest"."sent_ns".
+#
+#    Together with DZSimulator's integration load test (see
+#    src/csgo_integration/Benchmark.h), this measures throughput and latency of
+#    the CSGO integration under load on a single machine. Relevant options are
+#    --tickrate (e.g. 64, 128 or 1000), --bump-mines and --gsi-rate.
+#
+#    Alternatively, the relay output of a number of ticks can be written to a
+#    file without any network connection, e.g. to get a relay log for
+#    DZSimulator's console parsing benchmark.
+#
+# Usage:
+#    python FakeCsgoNetcon.py [--port 34755] [--tickrate 64] [--ticks-per-print 2]
+#                             [--bump-mines 30] [--drop 0.0] [--reorder 0.0]
+#                             [--gsi-rate 0] [--gsi-port 34754]
+#    python FakeCsgoNetcon.py --write-log relay.log --ticks 10000
+#
+# NOTE: Keep the encoder in this script in sync with data_relay.nut!
+
+import argparse
+import http.client
+import json
+import math
+import random
+import socket
+import sys
+import threading
+import time
+
+HOST_SERVER_CHECK_RESPONSE = "dzs-hosting-server-check"
+GETPOS_CMD = "getpos"
+KEEP_ALIVE_VAR = "DZSDR2_KEEP_ALIVE_UNTIL<-"
+RELAY_START_CALL = "dzsdr2_start()"
+
+# Same as in data_relay.nut
+KEYFRAME_INTERVAL = 32
+MAX_PRINT_LEN = 1800
+
+
+def q(v, scale):
+    # Rounds to the nearest integer, halfway cases away from zero
+    v *= scale
+    return int(v - 0.5) if v < 0 else int(v + 0.5)
+
+
+class FakeGame:
+    # Made-up game data: A player running in circles while bump mines fly
+    # around, stick to the ground and disappear again
+
+    def __init__(self, num_bump_mines, tickrate):
+        self.tick = 0
+        self.tickrate = tickrate
+        self.num_bump_mines = num_bump_mines
+        self.bump_mines = {}  # entindex -> [spawn tick, start pos, velocity, angles]
+        self.next_bm_id = 100
+
+    def advance(self):
+        self.tick += 1
+        t = self.tick / self.tickrate
+        # Replace bump mines that existed long enough
+        for bm_id in [i for i, bm in self.bump_mines.items()
+                      if self.tick - bm[0] > 20 * self.tickrate]:
+            del self.bump_mines[bm_id]
+        while len(self.bump_mines) < self.num_bump_mines:
+            pos = [random.uniform(-3000, 3000), random.uniform(-3000, 3000), 200.0]
+            vel = [random.uniform(-600, 600), random.uniform(-600, 600), 300.0]
+            ang = [random.uniform(-90, 90), random.uniform(-180, 180), 0.0]
+            self.bump_mines[self.next_bm_id] = [self.tick, pos, vel, ang]
+            self.next_bm_id = 100 + (self.next_bm_id - 99) % 1900
+
+    def player(self):
+        t = self.tick / self.tickrate
+        feet = [1000 * math.cos(t * 0.5), 1000 * math.sin(t * 0.5), 64.03125]
+        vel = [-500 * math.sin(t * 0.5), 500 * math.cos(t * 0.5), 0.0]
+        crouched = int(t % 10 > 8)
+        eye_z = feet[2] + (46.0 if crouched else 64.0) + 0.062561
+        return feet, eye_z, crouched, vel
+
+    def bump_mine_states(self):
+        # Bump mines fly for 1 second, then they stick to where they landed
+        for bm_id, (spawn_tick, pos, vel, ang) in self.bump_mines.items():
+            fly_time = min(1.0, (self.tick - spawn_tick) / self.tickrate)
+            yield bm_id, [pos[i] + vel[i] * fly_time for i in range(3)], ang
+
+
+class RelayEncoder:
+    # Same output as data_relay.nut
+
+    def __init__(self, ticks_per_print):
+        self.ticks_per_print = ticks_per_print
+        self.seq = 0
+        self.msg = ""
+        self.ticks_in_msg = 0
+        self.prev_player = None
+        self.sent_bms = {}
+
+    def player_data(self, game, is_keyframe):
+        feet, eye_z, crouched, vel = game.player()
+        cur = [q(feet[0], 32), q(feet[1], 32), q(feet[2], 32), q(eye_z, 32),
+               crouched, q(vel[0], 32), q(vel[1], 32), q(vel[2], 32)]
+        prev = self.prev_player
+        self.prev_player = cur
+        if is_keyframe or prev is None:
+            return ",p" + "".join("," + str(v) for v in cur)
+        if cur == prev:
+            return ""
+        return ",d" + "".join("," + str(c - p) for c, p in zip(cur, prev))
+
+    def bm_data(self, game, is_keyframe):
+        msg = ""
+        sent = {}
+        states = list(game.bump_mine_states())
+        if is_keyframe:
+            msg += ",a," + str(len(states)) + "".join("," + str(i) for i, _, _ in states)
+            self.sent_bms = {}
+        for bm_id, pos, ang in states:
+            rec = "," + str(bm_id) + "".join("," + str(q(v, 32)) for v in pos) \
+                                   + "".join("," + str(q(v, 100)) for v in ang)
+            prev_rec = self.sent_bms.get(bm_id)
+            if rec != prev_rec and \
+               len(self.msg) + len(msg) + len(rec) < MAX_PRINT_LEN:
+                msg += ",b" + rec
+                sent[bm_id] = rec
+            elif prev_rec is not None:
+                sent[bm_id] = prev_rec
+        for bm_id in self.sent_bms:
+            if bm_id not in sent:
+                msg += ",r," + str(bm_id)
+        self.sent_bms = sent
+        return msg
+
+    def tick(self, game):
+        # Returns the printed line or None
+        is_keyframe = self.seq % KEYFRAME_INTERVAL == 0
+        tick_data = " " + str(self.seq) + (",k" if is_keyframe else ",d")
+        tick_data += self.player_data(game, is_keyframe)
+        tick_data += self.bm_data(game, is_keyframe)
+        self.msg += tick_data
+        self.ticks_in_msg += 1
+        self.seq = (self.seq + 1) % 65536
+        if self.ticks_in_msg >= self.ticks_per_print or len(self.msg) > MAX_PRINT_LEN // 2:
+            line = "dzsdr2" + self.msg
+            self.msg = ""
+            self.ticks_in_msg = 0
+            return line
+        return None
+
+
+def getpos_response(game):
+    feet, eye_z, _, _ = game.player()
+    t = game.tick / game.tickrate
+    return "setpos %f %f %f;setang %f %f %f" % (
+        feet[0], feet[1], eye_z, 10 * math.sin(t), math.degrees(t * 0.5) % 360 - 180, 0.0)
+
+
+def gsi_payload(game, auth_token):
+    feet, eye_z, _, _ = game.player()
+    t = game.tick / game.tickrate
+    fwd = [math.cos(t * 0.5), math.sin(t * 0.5), 0.0]
+    return json.dumps({
+        "provider": {"name": "Counter-Strike: Global Offensive", "appid": 730,
+                     "version": 13857, "timestamp": int(time.time())},
+        "map": {"name": "dz_blacksite", "phase": "live", "round": 0},
+        "player": {"position": "%.2f, %.2f, %.2f" % (feet[0], feet[1], eye_z),
+                   "forward": "%.5f, %.5f, %.5f" % tuple(fwd)},
+        "auth": {"token": auth_token},
+        "dzs_loadtest": {"sent_ns": time.monotonic_ns()},
+    })
+
+
+def post_gsi_payloads(game, args, stats):
+    # Runs on its own thread, like CSGO's GSI. One payload at a time over a
+    # persistent connection.
+    interval = 1.0 / args.gsi_rate
+    next_post_time = time.monotonic()
+    conn = None
+    while True:
+        now = time.monotonic()
+        if now < next_post_time:
+            time.sleep(next_post_time - now)
+        next_post_time = max(next_post_time + interval, time.monotonic() - interval)
+        try:
+            if conn is None:
+                conn = http.client.HTTPConnection("127.0.0.1", args.gsi_port, timeout=2.0)
+            start = time.monotonic()
+            # Body as bytes, so headers and body go out in one packet
+            conn.request("POST", "/", body=gsi_payload(game, args.gsi_auth).encode(),
+                         headers={"Content-Type": "application/json"})
+            conn.getresponse().read()
+            rtt = time.monotonic() - start
+            with stats["lock"]:
+                stats["gsi_posts"] += 1
+                stats["gsi_rtt_sum"] += rtt
+                stats["gsi_rtt_max"] = max(stats["gsi_rtt_max"], rtt)
+        except (OSError, http.client.HTTPException):
+            with stats["lock"]:
+                stats["gsi_errors"] += 1
+            if conn is not None:
+                conn.close()
+            conn = None
+            time.sleep(0.5)
+
+
+def write_log(path, num_ticks, args):
+    game = FakeGame(args.bump_mines, args.tickrate)
+    encoder = RelayEncoder(args.ticks_per_print)
+    with open(path, "w", newline="\n") as f:
+        for _ in range(num_ticks):
+            game.advance()
+            line = encoder.tick(game)
+            if line is not None:
+                f.write(line + "\n")
+            f.write("\n" + getpos_response(game) + "\n")
+    print("Wrote %d ticks to %s" % (num_ticks, path))
+
+
+def serve(args):
+    server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+    server.bind(("127.0.0.1", args.port))
+    server.listen(1)
+    print("Listening on port %d" % args.port)
+
+    stats = {"lock": threading.Lock(), "gsi_posts": 0, "gsi_errors": 0,
+             "gsi_rtt_sum": 0.0, "gsi_rtt_max": 0.0}
+    if args.gsi_rate > 0:
+        gsi_game = FakeGame(0, args.tickrate)
+        def advance_gsi_game():
+            while True:
+                gsi_game.advance()
+                time.sleep(1.0 / args.tickrate)
+        threading.Thread(target=advance_gsi_game, daemon=True).start()
+        threading.Thread(target=post_gsi_payloads, args=(gsi_game, args, stats),
+                         daemon=True).start()
+        print("Posting GSI payloads to port %d at %d Hz" % (args.gsi_port, args.gsi_rate))
+
+    while True:
+        conn, addr = server.accept()
+        print("Connected to", addr)
+        conn.setblocking(False)
+        conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        try:
+            run_session(conn, args, stats)
+        except (ConnectionError, OSError) as e:
+            print("Disconnected:", e)
+        conn.close()
+
+
+def run_session(conn, args, stats):
+    game = FakeGame(args.bump_mines, args.tickrate)
+    encoder = None
+    keep_alive_until = 0.0
+    recv_buf = b""
+    held_back_line = None  # For simulating reordering
+    tick_interval = 1.0 / args.tickrate
+    next_tick_time = time.monotonic()
+    num_lines = num_dropped = num_reordered = 0
+    num_ticks = num_bytes = 0
+    last_report_time = time.monotonic()
+
+    def send(text):
+        nonlocal num_bytes
+        data = text.encode()
+        # Blocks while DZSimulator doesn't read fast enough
+        conn.setblocking(True)
+        conn.sendall(data)
+        conn.setblocking(False)
+        num_bytes += len(data)
+
+    while True:
+        # Handle received console commands
+        try:
+            data = conn.recv(65536)
+            if not data:
+                print("Connection closed by DZSimulator")
+                return
+            recv_buf += data
+        except BlockingIOError:
+            pass
+        while b"\n" in recv_buf:
+            cmd, recv_buf = recv_buf.split(b"\n", 1)
+            cmd = cmd.decode(errors="replace").strip()
+            if HOST_SERVER_CHECK_RESPONSE in cmd:
+                send("\n" + HOST_SERVER_CHECK_RESPONSE + "\n")
+            elif cmd == GETPOS_CMD:
+                send(getpos_response(game) + "\n")
+            elif RELAY_START_CALL in cmd:
+                print("Data relay started")
+                encoder = RelayEncoder(args.ticks_per_print)
+                keep_alive_until = time.monotonic() + 10.0
+            elif KEEP_ALIVE_VAR in cmd:
+                expr = cmd.split(KEEP_ALIVE_VAR, 1)[1]
+                if expr.startswith("Time()+"):
+                    keep_alive_until = time.monotonic() + float(expr[len("Time()+"):])
+                else:
+                    keep_alive_until = 0.0
+                    print("Data relay stopped")
+
+        now = time.monotonic()
+        if now < next_tick_time:
+            time.sleep(min(0.001, next_tick_time - now))
+            continue
+        next_tick_time += tick_interval
+        game.advance()
+
+        if encoder is None or now > keep_alive_until:
+            continue
+
+        num_ticks += 1
+        line = encoder.tick(game)
+        if line is not None:
+            num_lines += 1
+            if random.random() < args.drop:
+                num_dropped += 1
+            elif held_back_line is None and random.random() < args.reorder:
+                held_back_line = line  # Send after the next line
+                num_reordered += 1
+            else:
+                send(line + "\n")
+                if held_back_line is not None:
+                    send(held_back_line + "\n")
+                    held_back_line = None
+        send("\n" + getpos_response(game) + "\n")
+
+        if now - last_report_time > 5.0:
+            secs = now - last_report_time
+            last_report_time = now
+            print("Sent %d relay lines, dropped %d, reordered %d. %.1f ticks/s, %.1f KiB/s"
+                  % (num_lines, num_dropped, num_reordered,
+                     num_ticks / secs, num_bytes / secs / 1024))
+            num_ticks = num_bytes = 0
+            with stats["lock"]:
+                if stats["gsi_posts"] > 0 or stats["gsi_errors"] > 0:
+                    print("Posted %d GSI payloads (%.1f/s), %d errors, RTT avg %.2f ms, max %.2f ms"
+                          % (stats["gsi_posts"], stats["gsi_posts"] / secs, stats["gsi_errors"],
+                             1e3 * stats["gsi_rtt_sum"] / max(1, stats["gsi_posts"]),
+                             1e3 * stats["gsi_rtt_max"]))
+                    stats.update(gsi_posts=0, gsi_errors=0, gsi_rtt_sum=0.0, gsi_rtt_max=0.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Fake CSGO netcon server")
+    parser.add_argument("--port", type=int, default=34755)
+    parser.add_argument("--tickrate", type=int, default=64)
+    parser.add_argument("--ticks-per-print", type=int, default=2)
+    parser.add_argument("--bump-mines", type=int, default=30)
+    parser.add_argument("--drop", type=float, default=0.0,
+                        help="Probability of dropping a relay line")
+    parser.add_argument("--reorder", type=float, default=0.0,
+                        help="Probability of delaying a relay line behind the next one")
+    parser.add_argument("--gsi-rate", type=int, default=0,
+                        help="GSI payloads per second, 0 disables GSI")
+    parser.add_argument("--gsi-port", type=int, default=34754)
+    parser.add_argument("--gsi-auth", default="VXsNuRfF8VQ",
+                        help="GSI auth token, see res/gsi/gamestate_integration_DZSimulator.cfg")
+    parser.add_argument("--seed", type=int, default=None)
+    parser.add_argument("--write-log", metavar="FILE",
+                        help="Write relay output to FILE instead of serving")
+    parser.add_argument("--ticks", type=int, default=10000,
+                        help="Number of ticks to write with --write-log")
+    args = parser.parse_args()
+    random.seed(args.seed)
+
+    if args.write_log:
+        write_log(args.write_log, args.ticks, args)
+    else:
+        serve(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())